@@ -0,0 +1,61 @@
+/**
+ * @file AtomicFile.cpp
+ * @brief Implementation of crash-safe file publication.
+ * @date October 2026
+ */
+#include "AtomicFile.h"
+
+#include <cstdio>     // for std::rename, std::remove
+#include <fcntl.h>    // for open
+#include <unistd.h>   // for fsync, close, getpid
+
+using namespace std;
+
+/**
+ * @brief Flushes one file or directory to disk.
+ * @param path File or directory name
+ * @param directory true if path is a directory
+ * @return true if fsync succeeded
+ */
+static bool syncPath(const string& path, bool directory) {
+    int flags = O_RDONLY;
+    if (directory) flags |= O_DIRECTORY;
+
+    int fd = ::open(path.c_str(), flags);
+    if (fd < 0) return false;
+
+    bool ok = (::fsync(fd) == 0);
+    ::close(fd);
+    return ok;
+}
+
+/**
+ * @brief Returns the directory part of a path ("." if there is none).
+ * @param path File name
+ * @return Directory containing the file
+ */
+static string parentDirectory(const string& path) {
+    size_t slash = path.find_last_of('/');
+    if (slash == string::npos) return ".";
+    if (slash == 0) return "/";
+    return path.substr(0, slash);
+}
+
+string tempPathFor(const string& finalPath) {
+    return finalPath + ".tmp." + to_string(static_cast<long>(::getpid()));
+}
+
+bool publishFile(const string& tempPath, const string& finalPath) {
+    // 1) The temp file must be durable before it becomes visible.
+    if (!syncPath(tempPath, false)) return false;
+
+    // 2) Atomic replace of the destination.
+    if (rename(tempPath.c_str(), finalPath.c_str()) != 0) return false;
+
+    // 3) Make the new directory entry durable too.
+    return syncPath(parentDirectory(finalPath), true);
+}
+
+void discardTemp(const string& tempPath) {
+    remove(tempPath.c_str());
+}
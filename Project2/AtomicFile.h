@@ -0,0 +1,52 @@
+/**
+ * @file AtomicFile.h
+ * @brief Crash-safe publication of output files (write temp, fsync, rename).
+ * @date October 2026
+ *
+ * Every output file (.len data, .idx index) is first written to a temporary
+ * file next to its destination. Only after the temporary file is complete
+ * and flushed to disk is it renamed over the destination.
+ *
+ * Why we do this:
+ * - rename() is atomic, so a reader opening the destination sees either the
+ *   complete old file or the complete new file, never a half-written one.
+ * - If the program crashes while writing, only the temporary file is left
+ *   behind and the old destination is still intact.
+ */
+#ifndef ATOMICFILE_H
+#define ATOMICFILE_H
+
+#include <string>
+
+/**
+ * @brief Returns the temporary path used while building a destination file.
+ *
+ * The name includes the process id so two writers never share a temp file.
+ * Example: "zipcode_data.len" -> "zipcode_data.len.tmp.4242"
+ *
+ * @param finalPath The destination file name
+ * @return Temporary file name in the same directory
+ */
+std::string tempPathFor(const std::string& finalPath);
+
+/**
+ * @brief Atomically replaces finalPath with the finished temporary file.
+ *
+ * Steps:
+ * 1) fsync the temporary file so its bytes are on disk
+ * 2) rename() it over the destination
+ * 3) fsync the directory so the rename itself survives a crash
+ *
+ * @param tempPath Fully written and closed temporary file
+ * @param finalPath Destination file name
+ * @return true if the file was published, false on any OS error
+ */
+bool publishFile(const std::string& tempPath, const std::string& finalPath);
+
+/**
+ * @brief Removes a temporary file after a failed write (errors ignored).
+ * @param tempPath Temporary file name
+ */
+void discardTemp(const std::string& tempPath);
+
+#endif
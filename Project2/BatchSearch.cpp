@@ -0,0 +1,112 @@
+/**
+ * @file BatchSearch.cpp
+ * @brief Scalar and AVX2 implementations of the batched binary search.
+ * @date October 2026
+ */
+#include "BatchSearch.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define BATCH_HAVE_X86 1
+#endif
+
+using namespace std;
+
+/**
+ * @brief Up to kBatchLanes searches in lockstep, one lane after another.
+ *
+ * The lanes do not depend on each other, so the loads of one step are
+ * all in flight together.
+ */
+static void lowerBoundLanes(const uint32_t* keys, size_t count, const uint32_t* queries,
+                            size_t lanes, size_t* positions) {
+    size_t base[kBatchLanes] = {0};
+    size_t len = count;
+    while (len > 1) {
+        const size_t half = len / 2;
+        for (size_t j = 0; j < lanes; j++)
+            base[j] += (keys[base[j] + half - 1] < queries[j]) ? half : 0;
+        len -= half;
+    }
+    for (size_t j = 0; j < lanes; j++)
+        positions[j] = base[j] + (keys[base[j]] < queries[j]);
+}
+
+#ifdef BATCH_HAVE_X86
+/**
+ * @brief kBatchLanes searches as two vectors of 8 lanes.
+ *
+ * AVX2 only compares signed integers, so keys and queries get their top
+ * bit flipped first; that keeps the unsigned order. Needs count < 2^31
+ * (the gather takes 32-bit signed indices).
+ */
+__attribute__((target("avx2")))
+static void lowerBoundAvx2(const uint32_t* keys, size_t count, const uint32_t* queries,
+                           size_t* positions) {
+    const int* table = reinterpret_cast<const int*>(keys);
+    const __m256i flip = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    const __m256i x0 = _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(queries)), flip);
+    const __m256i x1 = _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(queries + 8)), flip);
+    __m256i b0 = _mm256_setzero_si256();
+    __m256i b1 = _mm256_setzero_si256();
+
+    size_t len = count;
+    while (len > 1) {
+        const size_t half = len / 2;
+        const __m256i step = _mm256_set1_epi32(static_cast<int>(half));
+        const __m256i probe = _mm256_set1_epi32(static_cast<int>(half - 1));
+        __m256i k0 = _mm256_i32gather_epi32(table, _mm256_add_epi32(b0, probe), 4);
+        __m256i k1 = _mm256_i32gather_epi32(table, _mm256_add_epi32(b1, probe), 4);
+        // key < query  <=>  query > key
+        __m256i lt0 = _mm256_cmpgt_epi32(x0, _mm256_xor_si256(k0, flip));
+        __m256i lt1 = _mm256_cmpgt_epi32(x1, _mm256_xor_si256(k1, flip));
+        b0 = _mm256_add_epi32(b0, _mm256_and_si256(lt0, step));
+        b1 = _mm256_add_epi32(b1, _mm256_and_si256(lt1, step));
+        len -= half;
+    }
+    // Last compare: a lane whose key is still smaller moves one further
+    // (the compare mask is -1, so subtracting it adds 1).
+    __m256i k0 = _mm256_i32gather_epi32(table, b0, 4);
+    __m256i k1 = _mm256_i32gather_epi32(table, b1, 4);
+    b0 = _mm256_sub_epi32(b0, _mm256_cmpgt_epi32(x0, _mm256_xor_si256(k0, flip)));
+    b1 = _mm256_sub_epi32(b1, _mm256_cmpgt_epi32(x1, _mm256_xor_si256(k1, flip)));
+
+    uint32_t out[kBatchLanes];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), b0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 8), b1);
+    for (size_t j = 0; j < kBatchLanes; j++) positions[j] = out[j];
+}
+#endif
+
+bool batchSearchAvx2() {
+#ifdef BATCH_HAVE_X86
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+#else
+    return false;
+#endif
+}
+
+void lowerBoundBatch(const uint32_t* keys, size_t count, const uint32_t* queries,
+                     size_t queryCount, size_t* positions) {
+    if (count == 0) {
+        for (size_t i = 0; i < queryCount; i++) positions[i] = 0;
+        return;
+    }
+    size_t i = 0;
+#ifdef BATCH_HAVE_X86
+    if (batchSearchAvx2() && count < (1ULL << 31)) {
+        for (; i + kBatchLanes <= queryCount; i += kBatchLanes)
+            lowerBoundAvx2(keys, count, queries + i, positions + i);
+    }
+#endif
+    for (; i + kBatchLanes <= queryCount; i += kBatchLanes)
+        lowerBoundLanes(keys, count, queries + i, kBatchLanes, positions + i);
+    // The last, partial group.
+    if (i < queryCount)
+        lowerBoundLanes(keys, count, queries + i, queryCount - i, positions + i);
+}
@@ -0,0 +1,42 @@
+/**
+ * @file BatchSearch.h
+ * @brief Binary search of many keys at once in a sorted u32 array.
+ * @date October 2026
+ *
+ * One binary search over a big array is a chain of cache misses: the next
+ * probe is only known once the previous key has arrived. Searching 16 keys
+ * in lockstep gives the CPU 16 independent chains, so their misses overlap
+ * instead of queuing up one after another. All the searches halve the same
+ * length at every step, so they stay in lockstep without any bookkeeping.
+ *
+ * Each step has no branch (the base moves by half or by 0). On CPUs with
+ * AVX2 a group is handled as two vectors of 8 lanes, fetching the probed
+ * keys with a gather and comparing them in one instruction; elsewhere a
+ * plain loop over the lanes does the same steps. The choice is made at run
+ * time, as in Crc32c.cpp, so the program still runs on any x86-64.
+ */
+#ifndef BATCHSEARCH_H
+#define BATCHSEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+/// Keys searched in lockstep
+static const size_t kBatchLanes = 16;
+
+/**
+ * @brief lower_bound for every query.
+ * @param keys Sorted keys
+ * @param count Number of keys
+ * @param queries Keys to look for (any order)
+ * @param queryCount Number of queries
+ * @param positions Receives, per query, the index of the first key >= it
+ *        (count if there is none)
+ */
+void lowerBoundBatch(const uint32_t* keys, size_t count, const uint32_t* queries,
+                     size_t queryCount, size_t* positions);
+
+/// true if lowerBoundBatch() uses AVX2 on this CPU
+bool batchSearchAvx2();
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file BloomFilter.cpp
+ * @brief Implementation of the BloomFilter class.
+ * @date October 2026
+ */
+#include "BloomFilter.h"
+#include "AtomicFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+
+BloomFilter::BloomFilter() : keys_(0), hashes_(7) {}
+
+/**
+ * @brief 64-bit hash of a key (FNV-1a followed by a splitmix finalizer).
+ *
+ * FNV-1a alone mixes short keys like ZIP codes poorly in the high bits;
+ * the finalizer spreads every input bit over the whole 64-bit result.
+ */
+uint64_t BloomFilter::hashKey(const string& key) {
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+void BloomFilter::reset(uint64_t expectedKeys, unsigned bitsPerKey) {
+    uint64_t bits = max<uint64_t>(512, expectedKeys * bitsPerKey);
+    blocks_.assign((bits + 511) / 512, Block{});
+    keys_ = 0;
+    // Best number of hash functions is bitsPerKey * ln 2.
+    hashes_ = max(1u, static_cast<unsigned>(lround(bitsPerKey * 0.6931)));
+}
+
+void BloomFilter::add(const string& key) {
+    uint64_t h = hashKey(key);
+    // High half picks the block, low half the bits inside it.
+    Block& b = blocks_[((h >> 32) * blocks_.size()) >> 32];
+    uint32_t h1 = static_cast<uint32_t>(h);
+    uint32_t h2 = (h1 >> 17) | (h1 << 15);
+    for (uint32_t i = 0; i < hashes_; i++) {
+        uint32_t bit = (h1 + i * h2) & 511;
+        b.words[bit >> 6] |= (1ULL << (bit & 63));
+    }
+    keys_++;
+}
+
+bool BloomFilter::mayContain(const string& key) const {
+    if (blocks_.empty()) return true;   // no filter: cannot rule anything out
+    uint64_t h = hashKey(key);
+    const Block& b = blocks_[((h >> 32) * blocks_.size()) >> 32];
+    uint32_t h1 = static_cast<uint32_t>(h);
+    uint32_t h2 = (h1 >> 17) | (h1 << 15);
+    for (uint32_t i = 0; i < hashes_; i++) {
+        uint32_t bit = (h1 + i * h2) & 511;
+        if ((b.words[bit >> 6] & (1ULL << (bit & 63))) == 0) return false;
+    }
+    return true;
+}
+
+bool BloomFilter::save(const string& path, unsigned long long generation) const {
+    string tmp = tempPathFor(path);
+    {
+        ofstream out(tmp, ios::binary);
+        if (!out) return false;
+        uint64_t gen = generation;
+        uint64_t count = blocks_.size();
+        out.write("BLM1", 4);
+        out.write(reinterpret_cast<const char*>(&gen), sizeof(gen));
+        out.write(reinterpret_cast<const char*>(&keys_), sizeof(keys_));
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char*>(&hashes_), sizeof(hashes_));
+        out.write(reinterpret_cast<const char*>(blocks_.data()),
+                  static_cast<streamsize>(sizeBytes()));
+        if (!out) {
+            out.close();
+            discardTemp(tmp);
+            return false;
+        }
+    }
+    if (!publishFile(tmp, path)) {
+        discardTemp(tmp);
+        return false;
+    }
+    return true;
+}
+
+bool BloomFilter::load(const string& path, unsigned long long generation) {
+    blocks_.clear();
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+
+    char magic[4];
+    uint64_t gen = 0, keys = 0, count = 0;
+    uint32_t hashes = 0;
+    in.read(magic, 4);
+    in.read(reinterpret_cast<char*>(&gen), sizeof(gen));
+    in.read(reinterpret_cast<char*>(&keys), sizeof(keys));
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    in.read(reinterpret_cast<char*>(&hashes), sizeof(hashes));
+    if (!in || memcmp(magic, "BLM1", 4) != 0 || gen != generation ||
+        count == 0 || hashes == 0 || hashes > 32)
+        return false;
+
+    blocks_.resize(count);
+    in.read(reinterpret_cast<char*>(blocks_.data()),
+            static_cast<streamsize>(sizeBytes()));
+    if (!in) {
+        blocks_.clear();
+        return false;
+    }
+    keys_ = keys;
+    hashes_ = hashes;
+    return true;
+}
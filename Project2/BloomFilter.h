@@ -0,0 +1,91 @@
+/**
+ * @file BloomFilter.h
+ * @brief Bloom filter over the ZIP keys of an index, stored next to the .idx.
+ * @date October 2026
+ *
+ * A Bloom filter answers "is this key in the set?" with either
+ * "definitely not" or "maybe". Searches ask it first, so a ZIP that does
+ * not exist (like -Z99999) is rejected without probing the index and
+ * without reading the data file. With 10 bits per key about 1% of absent
+ * keys still get "maybe" and fall through to the normal lookup.
+ *
+ * This is a "blocked" Bloom filter: all bits for one key are in the same
+ * 64-byte block, so a lookup touches one cache line instead of seven.
+ *
+ * File "<index>.bloom" (binary, little-endian):
+ *   "BLM1" | generation (8 bytes) | key count (8) | block count (8) |
+ *   hash count (4) | blocks (64 bytes each)
+ */
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class BloomFilter
+ * @brief Cache-line blocked Bloom filter over string keys.
+ */
+class BloomFilter {
+public:
+    BloomFilter();
+
+    /**
+     * @brief Clears the filter and sizes it for a number of keys.
+     * @param expectedKeys Keys that will be added
+     * @param bitsPerKey Space per key (10 gives about 1% false positives)
+     */
+    void reset(uint64_t expectedKeys, unsigned bitsPerKey = 10);
+
+    /// Adds one key
+    void add(const std::string& key);
+
+    /// false means the key is definitely not in the set
+    bool mayContain(const std::string& key) const;
+
+    /// true once the filter has been sized or loaded
+    bool empty() const { return blocks_.empty(); }
+
+    /// Number of keys added (or stored in the loaded file)
+    uint64_t keyCount() const { return keys_; }
+
+    /// Size of the bit array in bytes
+    size_t sizeBytes() const { return blocks_.size() * sizeof(Block); }
+
+    /**
+     * @brief Writes the filter crash-safely (temp file + rename).
+     * @param path Output file
+     * @param generation Data file generation this filter belongs to
+     * @return true on success
+     */
+    bool save(const std::string& path, unsigned long long generation) const;
+
+    /**
+     * @brief Loads a filter, only if it belongs to the given generation.
+     * @param path Filter file
+     * @param generation Expected data file generation
+     * @return false if missing, damaged or from another generation
+     */
+    bool load(const std::string& path, unsigned long long generation);
+
+    /// 64-bit hash of a key (also used by the HyperLogLog sketch)
+    static uint64_t hashKey(const std::string& key);
+
+    /// The usual file name for an index's filter
+    static std::string pathFor(const std::string& idxFile) {
+        return idxFile + ".bloom";
+    }
+
+private:
+    /// One 512-bit block (a cache line)
+    struct Block {
+        uint64_t words[8];
+    };
+
+    std::vector<Block> blocks_;
+    uint64_t keys_;
+    uint32_t hashes_;
+};
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * @file Crc32c.cpp
+ * @brief Hardware (SSE4.2) and table-driven CRC32C implementations.
+ * @date October 2026
+ */
+#include "Crc32c.h"
+
+#include <cstring>    // for std::memcpy
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CRC32C_HAVE_X86 1
+#endif
+
+using namespace std;
+
+/// Reflected CRC32C polynomial (Castagnoli).
+static const uint32_t kPoly = 0x82F63B78u;
+
+/**
+ * @brief Builds the 256-entry table for the software fallback.
+ */
+struct Crc32cTable {
+    uint32_t t[256];
+
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? (c >> 1) ^ kPoly : (c >> 1);
+            t[i] = c;
+        }
+    }
+};
+
+/**
+ * @brief Table-driven CRC32C, one byte at a time.
+ */
+static uint32_t crc32cSoftware(const unsigned char* p, size_t n, uint32_t crc) {
+    static const Crc32cTable table;
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++)
+        crc = table.t[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+#ifdef CRC32C_HAVE_X86
+/**
+ * @brief CRC32C using the SSE4.2 crc32 instruction, 8 bytes at a time.
+ *
+ * Compiled for SSE4.2 only in this function, so the rest of the program
+ * still runs on CPUs without it (crc32cHardware() decides at runtime).
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32cSse42(const unsigned char* p, size_t n, uint32_t crc) {
+    crc = ~crc;
+#if defined(__x86_64__)
+    uint64_t c64 = crc;
+    while (n >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        c64 = _mm_crc32_u64(c64, v);
+        p += 8;
+        n -= 8;
+    }
+    crc = static_cast<uint32_t>(c64);
+#endif
+    while (n > 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+        n--;
+    }
+    return ~crc;
+}
+#endif
+
+bool crc32cHardware() {
+#ifdef CRC32C_HAVE_X86
+    static const bool has = __builtin_cpu_supports("sse4.2");
+    return has;
+#else
+    return false;
+#endif
+}
+
+uint32_t crc32c(const void* data, size_t length, uint32_t crc) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+#ifdef CRC32C_HAVE_X86
+    if (crc32cHardware()) return crc32cSse42(p, length, crc);
+#endif
+    return crc32cSoftware(p, length, crc);
+}
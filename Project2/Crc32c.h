@@ -0,0 +1,37 @@
+/**
+ * @file Crc32c.h
+ * @brief CRC32C (Castagnoli) checksums for .len records.
+ * @date October 2026
+ *
+ * CRC32C is the checksum used by iSCSI, ext4 and many storage engines.
+ * x86 CPUs with SSE4.2 compute it in hardware (the crc32 instruction),
+ * which is much faster than reading the data from disk. Other CPUs use a
+ * lookup table, which gives the same results, only slower.
+ */
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Computes (or continues) a CRC32C over a block of bytes.
+ *
+ * To checksum data in pieces, pass the previous result as crc:
+ *   uint32_t c = crc32c(a, na);
+ *   c = crc32c(b, nb, c);   // same as crc32c over a+b
+ *
+ * @param data Bytes to checksum
+ * @param length Number of bytes
+ * @param crc Result of the previous piece (0 to start)
+ * @return CRC32C value
+ */
+uint32_t crc32c(const void* data, size_t length, uint32_t crc = 0);
+
+/**
+ * @brief Tells whether crc32c() is using the hardware instruction.
+ * @return true if SSE4.2 crc32 is available on this CPU
+ */
+bool crc32cHardware();
+
+#endif
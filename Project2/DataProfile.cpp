@@ -0,0 +1,175 @@
+/**
+ * @file DataProfile.cpp
+ * @brief Implementation of the column profiles.
+ * @date October 2026
+ */
+#include "DataProfile.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+static const char kProfileMagic[8] = {'P', 'R', 'O', 'F', 'I', 'L', 'E', '1'};
+
+/// Field without surrounding spaces, tabs and line ends
+static string trimField(const string& s) {
+    size_t b = 0, e = s.size();
+    while (b < e && (s[b] == ' ' || s[b] == '\t' || s[b] == '\r' || s[b] == '\n')) b++;
+    while (e > b && (s[e - 1] == ' ' || s[e - 1] == '\t' || s[e - 1] == '\r' || s[e - 1] == '\n'))
+        e--;
+    return s.substr(b, e - b);
+}
+
+/// true (and the value) if all of text is one finite number
+static bool parseNumber(const string& text, double& value) {
+    char* end = nullptr;
+    value = strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size() && isfinite(value);
+}
+
+template <typename T>
+static void putRaw(string& out, const T& v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+static void putText(string& out, const string& s) {
+    putRaw(out, static_cast<uint32_t>(s.size()));
+    out += s;
+}
+
+template <typename T>
+static bool getRaw(const char*& p, const char* end, T& v) {
+    if (static_cast<size_t>(end - p) < sizeof(v)) return false;
+    memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return true;
+}
+
+static bool getText(const char*& p, const char* end, string& s) {
+    uint32_t n = 0;
+    if (!getRaw(p, end, n) || static_cast<size_t>(end - p) < n) return false;
+    s.assign(p, n);
+    p += n;
+    return true;
+}
+
+ColumnProfile::ColumnProfile(const string& columnName)
+    : name(columnName), values(0), nulls(0), nonNumeric(0),
+      minNumber(numeric_limits<double>::max()), maxNumber(numeric_limits<double>::lowest()) {}
+
+DataProfile::DataProfile() : rows_(0) {}
+
+void DataProfile::setColumns(const vector<string>& names) {
+    rows_ = 0;
+    columns_.clear();
+    for (const string& name : names) columns_.emplace_back(trimField(name));
+}
+
+void DataProfile::addRow(const vector<string>& fields) {
+    rows_++;
+    for (size_t i = 0; i < columns_.size(); i++) {
+        ColumnProfile& c = columns_[i];
+        const string value = i < fields.size() ? trimField(fields[i]) : string();
+        if (value.empty()) {
+            c.nulls++;
+            continue;
+        }
+        if (c.values == 0 || value < c.minText) c.minText = value;
+        if (c.values == 0 || value > c.maxText) c.maxText = value;
+        c.values++;
+        c.distinct.add(value);
+
+        double number;
+        if (parseNumber(value, number)) {
+            c.minNumber = min(c.minNumber, number);
+            c.maxNumber = max(c.maxNumber, number);
+        } else {
+            c.nonNumeric++;
+        }
+    }
+}
+
+bool DataProfile::merge(const DataProfile& other) {
+    if (other.columns_.size() != columns_.size()) return false;
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (columns_[i].distinct.precision() != other.columns_[i].distinct.precision())
+            return false;
+    }
+
+    rows_ += other.rows_;
+    for (size_t i = 0; i < columns_.size(); i++) {
+        ColumnProfile& c = columns_[i];
+        const ColumnProfile& o = other.columns_[i];
+        if (o.values > 0) {
+            if (c.values == 0 || o.minText < c.minText) c.minText = o.minText;
+            if (c.values == 0 || o.maxText > c.maxText) c.maxText = o.maxText;
+        }
+        c.values += o.values;
+        c.nulls += o.nulls;
+        c.nonNumeric += o.nonNumeric;
+        c.minNumber = min(c.minNumber, o.minNumber);
+        c.maxNumber = max(c.maxNumber, o.maxNumber);
+        c.distinct.merge(o.distinct);
+    }
+    return true;
+}
+
+size_t DataProfile::sizeBytes() const {
+    size_t n = sizeof(*this);
+    for (const ColumnProfile& c : columns_)
+        n += sizeof(c) + c.name.size() + c.minText.size() + c.maxText.size() +
+             c.distinct.sizeBytes();
+    return n;
+}
+
+void DataProfile::serialize(string& out) const {
+    out.append(kProfileMagic, sizeof(kProfileMagic));
+    putRaw(out, static_cast<uint64_t>(rows_));
+    putRaw(out, static_cast<uint32_t>(columns_.size()));
+    for (const ColumnProfile& c : columns_) {
+        putText(out, c.name);
+        putRaw(out, c.values);
+        putRaw(out, c.nulls);
+        putRaw(out, c.nonNumeric);
+        putRaw(out, c.minNumber);
+        putRaw(out, c.maxNumber);
+        putText(out, c.minText);
+        putText(out, c.maxText);
+        c.distinct.serialize(out);
+    }
+}
+
+bool DataProfile::looksSerialized(const string& data) {
+    return data.size() >= sizeof(kProfileMagic) &&
+           memcmp(data.data(), kProfileMagic, sizeof(kProfileMagic)) == 0;
+}
+
+bool DataProfile::deserialize(const string& in) {
+    rows_ = 0;
+    columns_.clear();
+    if (!looksSerialized(in)) return false;
+    const char* p = in.data() + sizeof(kProfileMagic);
+    const char* end = in.data() + in.size();
+
+    uint64_t rows = 0;
+    uint32_t count = 0;
+    if (!getRaw(p, end, rows) || !getRaw(p, end, count)) return false;
+    vector<ColumnProfile> columns;
+    for (uint32_t i = 0; i < count; i++) {
+        ColumnProfile c;
+        if (!getText(p, end, c.name) || !getRaw(p, end, c.values) ||
+            !getRaw(p, end, c.nulls) || !getRaw(p, end, c.nonNumeric) ||
+            !getRaw(p, end, c.minNumber) || !getRaw(p, end, c.maxNumber) ||
+            !getText(p, end, c.minText) || !getText(p, end, c.maxText) ||
+            !c.distinct.deserialize(p, end))
+            return false;
+        columns.push_back(std::move(c));
+    }
+    if (p != end) return false;
+    rows_ = rows;
+    columns_ = std::move(columns);
+    return true;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file DataProfile.h
+ * @brief Per-column profile of a record stream in bounded memory:
+ *        null rate, approximate distinct count, min and max.
+ * @date October 2026
+ *
+ * Every column keeps a few counters, its smallest and largest value (as
+ * text and, while every value parses as one, as a number) and a
+ * HyperLogLog sketch (see Sketch.h) instead of a set of its values. The
+ * memory is the same for a thousand rows or a billion.
+ *
+ * Profiles of separate inputs merge into the profile of all of them, and
+ * serialize() / deserialize() carry one between runs, so a feed can be
+ * profiled in pieces and combined later. Columns are matched by position
+ * (a CSV header and a .len header may spell them differently); the
+ * profile keeps the names it had first.
+ *
+ * Serialized form (native byte order):
+ *   "PROFILE1" | u64 rows | u32 columns | per column:
+ *   u32 length + name | u64 values | u64 nulls | u64 non-numeric |
+ *   f64 smallest number | f64 largest number |
+ *   u32 length + smallest text | u32 length + largest text | HyperLogLog
+ */
+#ifndef DATAPROFILE_H
+#define DATAPROFILE_H
+
+#include "Sketch.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @struct ColumnProfile
+ * @brief What is known about one column.
+ */
+struct ColumnProfile {
+    string name;
+    uint64_t values;       ///< non-empty values
+    uint64_t nulls;        ///< empty or missing
+    uint64_t nonNumeric;   ///< values that do not parse as a number
+    double minNumber;      ///< over the values that do
+    double maxNumber;
+    string minText;        ///< over all values, byte order
+    string maxText;
+    HyperLogLog distinct;
+
+    explicit ColumnProfile(const string& columnName = "");
+
+    /// true if there are values and all of them are numbers
+    bool numeric() const { return values > 0 && nonNumeric == 0; }
+};
+
+/**
+ * @class DataProfile
+ * @brief ColumnProfile of every column of a record stream.
+ */
+class DataProfile {
+public:
+    DataProfile();
+
+    /// Starts over with these column names
+    void setColumns(const vector<string>& names);
+
+    /**
+     * @brief Takes one row; missing trailing fields count as nulls, extra
+     *        fields are ignored.
+     */
+    void addRow(const vector<string>& fields);
+
+    /**
+     * @brief Folds in the profile of another input, column by column.
+     * @return false (nothing changes) unless it has as many columns
+     */
+    bool merge(const DataProfile& other);
+
+    /// Rows taken
+    uint64_t rows() const { return rows_; }
+
+    const vector<ColumnProfile>& columns() const { return columns_; }
+
+    /// Memory held, in bytes (about the same for any number of rows)
+    size_t sizeBytes() const;
+
+    /// Appends the serialized form to out
+    void serialize(string& out) const;
+
+    /**
+     * @brief Reads what serialize() wrote.
+     * @return false if damaged (the profile is then empty)
+     */
+    bool deserialize(const string& in);
+
+    /// true if data starts like a serialized profile
+    static bool looksSerialized(const string& data);
+
+private:
+    uint64_t rows_;
+    vector<ColumnProfile> columns_;
+};
+
+#endif
@@ -0,0 +1,422 @@
+/**
+ * @file DeltaFile.cpp
+ * @brief Implementation of the prefix-compressed record file.
+ * @date October 2026
+ */
+#include "DeltaFile.h"
+#include "AtomicFile.h"
+#include "HeaderBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static const char kDeltaMagic[8] = {'Z', 'I', 'P', 'D', 'L', 'T', '1', '\0'};
+static const size_t kDeltaHeaderBytes = 40;
+static const uint64_t kMaxFields = 1 << 16;
+
+static void putVarint(string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+static inline bool getVarint(const char*& p, const char* end, uint64_t& v) {
+    // Shared and suffix lengths nearly always fit one byte.
+    if (p < end && !(*p & 0x80)) {
+        v = static_cast<uint8_t>(*p++);
+        return true;
+    }
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && p < end; shift += 7) {
+        const uint8_t b = static_cast<uint8_t>(*p++);
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+/// Key order of a sparse index: shorter first, then byte by byte
+static bool keyLess(const string& a, const string& b) {
+    return a.size() != b.size() ? a.size() < b.size() : a < b;
+}
+
+static void writeDeltaHeader(ostream& out, unsigned long long generation, unsigned interval,
+                             uint64_t records, uint64_t textBytes) {
+    const uint64_t gen = generation;
+    const uint32_t restart = interval, unused = 0;
+    out.write(kDeltaMagic, sizeof(kDeltaMagic));
+    out.write(reinterpret_cast<const char*>(&gen), sizeof(gen));
+    out.write(reinterpret_cast<const char*>(&restart), sizeof(restart));
+    out.write(reinterpret_cast<const char*>(&unused), sizeof(unused));
+    out.write(reinterpret_cast<const char*>(&records), sizeof(records));
+    out.write(reinterpret_cast<const char*>(&textBytes), sizeof(textBytes));
+}
+
+/// A record as its CSV text plus where each field is in it
+struct DeltaFields {
+    string text;     ///< the first size bytes are the record
+    size_t size = 0;
+    vector<uint32_t> start;
+    vector<uint32_t> length;
+
+    void clear() {
+        text.clear();
+        size = 0;
+        start.clear();
+        length.clear();
+    }
+
+    /// Splits at every comma, like splitCsvSimple()
+    void split(const string& line) {
+        clear();
+        text = line;
+        size = line.size();
+        size_t b = 0;
+        for (size_t i = 0; i <= line.size(); i++) {
+            if (i == line.size() || line[i] == ',') {
+                start.push_back(static_cast<uint32_t>(b));
+                length.push_back(static_cast<uint32_t>(i - b));
+                b = i + 1;
+            }
+        }
+    }
+};
+
+/// Decodes records one after another from a restart point on
+class DeltaDecoder {
+public:
+    DeltaDecoder(const char* p, const char* end) : p_(p), end_(end), cur_(0) {}
+
+    /**
+     * @brief Decodes the next record.
+     * @param restart true if it is the first of a restart interval
+     * @return false if the bytes do not form a record
+     */
+    bool next(bool restart) {
+        const DeltaFields& prev = rec_[cur_];
+        DeltaFields& out = rec_[cur_ ^ 1];
+        uint64_t count = 0;
+        if (!getVarint(p_, end_, count) || count == 0 || count > kMaxFields) return false;
+        // Decoded straight into a buffer that only grows.
+        size_t used = 0;
+        out.start.resize(count);
+        out.length.resize(count);
+        for (uint64_t i = 0; i < count; i++) {
+            uint64_t shared = 0, n = 0;
+            if (!getVarint(p_, end_, shared) || !getVarint(p_, end_, n)) return false;
+            const uint64_t prevLength = (!restart && i < prev.length.size()) ? prev.length[i] : 0;
+            if (shared > prevLength || n > static_cast<uint64_t>(end_ - p_)) return false;
+            if (used + shared + n + 1 > out.text.size())
+                out.text.resize(max(2 * out.text.size(), used + shared + n + 64));
+            char* text = &out.text[0];
+            if (i > 0) text[used++] = ',';
+            out.start[i] = static_cast<uint32_t>(used);
+            if (shared > 0) memcpy(text + used, prev.text.data() + prev.start[i], shared);
+            memcpy(text + used + shared, p_, n);
+            used += shared + n;
+            out.length[i] = static_cast<uint32_t>(shared + n);
+            p_ += n;
+        }
+        out.size = used;
+        cur_ ^= 1;
+        return true;
+    }
+
+    /// The last record decoded
+    const char* data() const { return rec_[cur_].text.data(); }
+    size_t size() const { return rec_[cur_].size; }
+
+    const char* position() const { return p_; }
+
+private:
+    const char* p_;
+    const char* end_;
+    DeltaFields rec_[2];   ///< the last record and the one being decoded
+    int cur_;
+};
+
+bool DeltaFile::build(const string& csvFile, const string& path, unsigned restartInterval,
+                      BuildStats& stats, string& error, DuplicatePolicy policy) {
+    stats = BuildStats{0, 0, 0, 0, false, 0, 0, string()};
+    if (restartInterval < 1 || restartInterval > kMaxRestartInterval) {
+        error = "Restart interval must be 1.." + to_string(kMaxRestartInterval);
+        return false;
+    }
+    ifstream in(csvFile, ios::binary);
+    if (!in) {
+        error = "Cannot open CSV file '" + csvFile + "'";
+        return false;
+    }
+    string line;
+    if (!getline(in, line)) {
+        error = "CSV file is empty.";
+        return false;
+    }
+
+    // Pass 1: the ZIP (first field) of every row.
+    const streampos dataStart = in.tellg();
+    DuplicateKeys keys;
+    while (getline(in, line)) {
+        if (!line.empty()) keys.add(line.substr(0, line.find(',')));
+    }
+    keys.finish();
+    stats.duplicateKeys = keys.duplicateKeys();
+    if (keys.duplicateKeys() > 0) {
+        stats.duplicates = to_string(keys.duplicateKeys()) + " duplicate ZIP(s), " +
+                           to_string(keys.extraRows()) + " extra row(s): " + keys.examples();
+        if (policy == DuplicatePolicy::kError) {
+            error = stats.duplicates;
+            return false;
+        }
+    }
+    in.clear();
+    in.seekg(dataStart);
+
+    const string indexFile = indexPathFor(path);
+    const string tmp = tempPathFor(path);
+    const string tmpIndex = tempPathFor(indexFile);
+    ofstream out(tmp, ios::binary);
+    ofstream idx(tmpIndex);
+    if (!out || !idx) {
+        error = "Cannot create '" + (out ? tmpIndex : tmp) + "'";
+        out.close();
+        idx.close();
+        discardTemp(tmp);
+        discardTemp(tmpIndex);
+        return false;
+    }
+
+    const unsigned long long generation = HeaderBuffer::newGeneration();
+    writeDeltaHeader(out, generation, restartInterval, 0, 0);
+
+    // Both indexes are collected; which one is written is known at the end.
+    string dense, sparse, zip, lastZip;
+    bool sorted = true;
+    DeltaFields prev, cur;
+    string buf;
+    uint64_t offset = kDeltaHeaderBytes;
+    uint64_t restartOffset = offset;
+    while (getline(in, line)) {
+        if (line.empty()) continue;
+        if (!keys.keep(line.substr(0, line.find(',')), policy)) {
+            stats.dropped++;
+            continue;
+        }
+        zip = line.substr(0, line.find(','));
+        if (stats.records > 0 && !keyLess(lastZip, zip)) sorted = false;
+        lastZip = zip;
+        const uint64_t slot = stats.records % restartInterval;
+        if (slot == 0) {
+            restartOffset = offset;
+            prev.clear();
+            if (sorted) sparse += zip + ' ' + to_string(restartOffset) + '\n';
+        }
+        cur.split(line);
+
+        buf.clear();
+        putVarint(buf, cur.start.size());
+        for (size_t i = 0; i < cur.start.size(); i++) {
+            const char* field = cur.text.data() + cur.start[i];
+            uint32_t shared = 0;
+            if (i < prev.start.size()) {
+                const char* before = prev.text.data() + prev.start[i];
+                const uint32_t limit = min(cur.length[i], prev.length[i]);
+                while (shared < limit && field[shared] == before[shared]) shared++;
+            }
+            putVarint(buf, shared);
+            putVarint(buf, cur.length[i] - shared);
+            buf.append(field + shared, cur.length[i] - shared);
+        }
+        out.write(buf.data(), static_cast<streamsize>(buf.size()));
+        offset += buf.size();
+
+        dense += zip + ' ' + to_string(restartOffset) + ' ' + to_string(slot) + '\n';
+        stats.records++;
+        stats.textBytes += line.size();
+        swap(prev, cur);
+    }
+    stats.fileBytes = offset;
+    stats.sparseIndex = sorted;
+    stats.indexEntries = sorted ? (stats.records + restartInterval - 1) / restartInterval
+                                : stats.records;
+    idx << "DLTIDX,1," << HeaderBuffer::generationText(generation) << "," << restartInterval
+        << (sorted ? ",sparse\n" : "\n") << (sorted ? sparse : dense);
+
+    out.seekp(0);
+    writeDeltaHeader(out, generation, restartInterval, stats.records, stats.textBytes);
+    out.close();
+    idx.close();
+    // Data first: an index is only ever published for data that exists.
+    if (!out || !idx || !publishFile(tmp, path) || !publishFile(tmpIndex, indexFile)) {
+        error = "Failed to publish '" + path + "' and its index";
+        discardTemp(tmp);
+        discardTemp(tmpIndex);
+        return false;
+    }
+    return true;
+}
+
+DeltaFile::DeltaFile()
+    : generation_(0), interval_(0), records_(0), textBytes_(0), sparse_(false) {}
+
+bool DeltaFile::open(const string& path) {
+    path_ = path;
+    index_.clear();
+    blocks_.clear();
+    if (!map_.open(path)) {
+        lastError_ = "Cannot open delta file '" + path + "'";
+        return false;
+    }
+    const char* p = map_.data();
+    if (map_.size() < kDeltaHeaderBytes || memcmp(p, kDeltaMagic, sizeof(kDeltaMagic)) != 0) {
+        lastError_ = "'" + path + "' is not a delta file";
+        return false;
+    }
+    uint64_t gen = 0;
+    uint32_t restart = 0;
+    memcpy(&gen, p + 8, sizeof(gen));
+    memcpy(&restart, p + 16, sizeof(restart));
+    memcpy(&records_, p + 24, sizeof(records_));
+    memcpy(&textBytes_, p + 32, sizeof(textBytes_));
+    if (restart < 1 || restart > kMaxRestartInterval) {
+        lastError_ = "'" + path + "' has a bad restart interval";
+        return false;
+    }
+    generation_ = gen;
+    interval_ = restart;
+    return true;
+}
+
+bool DeltaFile::loadIndex() {
+    index_.clear();
+    blocks_.clear();
+    const string indexFile = indexPathFor(path_);
+    ifstream in(indexFile);
+    string first;
+    if (!in || !getline(in, first)) {
+        lastError_ = "Cannot open delta index '" + indexFile + "'";
+        return false;
+    }
+    const string expected = "DLTIDX,1," + HeaderBuffer::generationText(generation_) + "," +
+                            to_string(interval_);
+    if (first != expected && first != expected + ",sparse") {
+        lastError_ = "Delta index '" + indexFile + "' was not made for '" + path_ + "'";
+        return false;
+    }
+    sparse_ = (first != expected);
+
+    string zip;
+    uint64_t offset = 0;
+    uint32_t slot = 0;
+    if (sparse_) {
+        const uint64_t blocks = (records_ + interval_ - 1) / interval_;
+        while (in >> zip >> offset) {
+            if (offset < kDeltaHeaderBytes || offset >= map_.size() || blocks_.size() >= blocks ||
+                (!blocks_.empty() && !keyLess(blocks_.back().first, zip))) {
+                lastError_ = "Delta index '" + indexFile + "' is damaged at ZIP " + zip;
+                blocks_.clear();
+                return false;
+            }
+            blocks_.emplace_back(zip, offset);
+        }
+        if (blocks_.size() != blocks) {
+            lastError_ = "Delta index '" + indexFile + "' is missing restart points";
+            blocks_.clear();
+            return false;
+        }
+        return true;
+    }
+    while (in >> zip >> offset >> slot) {
+        if (offset < kDeltaHeaderBytes || offset >= map_.size() || slot >= interval_) {
+            lastError_ = "Delta index '" + indexFile + "' is damaged at ZIP " + zip;
+            index_.clear();
+            return false;
+        }
+        index_[zip] = make_pair(offset, slot);
+    }
+    return true;
+}
+
+bool DeltaFile::find(const string& zip, string& record, unsigned& decoded) {
+    decoded = 0;
+    lastError_.clear();
+    if (sparse_) return findSparse(zip, record, decoded);
+    auto it = index_.find(zip);
+    if (it == index_.end()) return false;
+
+    DeltaDecoder decoder(map_.data() + it->second.first, map_.data() + map_.size());
+    for (uint32_t k = 0; k <= it->second.second; k++) {
+        if (!decoder.next(k == 0)) {
+            lastError_ = "Damaged record near offset " + to_string(it->second.first);
+            return false;
+        }
+        decoded++;
+    }
+    record.assign(decoder.data(), decoder.size());
+    if (record.compare(0, zip.size(), zip) != 0 ||
+        (record.size() > zip.size() && record[zip.size()] != ',')) {
+        lastError_ = "Delta index does not match the data for ZIP " + zip;
+        return false;
+    }
+    return true;
+}
+
+bool DeltaFile::findSparse(const string& zip, string& record, unsigned& decoded) {
+    // The last restart point whose first ZIP is not after this one.
+    auto it = upper_bound(blocks_.begin(), blocks_.end(), zip,
+                          [](const string& z, const pair<string, uint64_t>& b) {
+                              return keyLess(z, b.first);
+                          });
+    if (it == blocks_.begin()) return false;
+    --it;
+    const uint64_t block = static_cast<uint64_t>(it - blocks_.begin());
+    const uint64_t count = min<uint64_t>(interval_, records_ - block * interval_);
+
+    DeltaDecoder decoder(map_.data() + it->second, map_.data() + map_.size());
+    string key;
+    for (uint64_t k = 0; k < count; k++) {
+        if (!decoder.next(k == 0)) {
+            lastError_ = "Damaged record near offset " + to_string(it->second);
+            return false;
+        }
+        decoded++;
+        const char* comma = static_cast<const char*>(memchr(decoder.data(), ',', decoder.size()));
+        key.assign(decoder.data(), comma ? static_cast<size_t>(comma - decoder.data())
+                                         : decoder.size());
+        if (k == 0 && key != it->first) {
+            lastError_ = "Delta index does not match the data for ZIP " + it->first;
+            return false;
+        }
+        if (key == zip) {
+            record.assign(decoder.data(), decoder.size());
+            return true;
+        }
+        if (keyLess(zip, key)) break;   // passed where it would be
+    }
+    return false;
+}
+
+bool DeltaFile::scan(const function<void(const char*, size_t)>& fn) {
+    map_.adviseSequential();
+    const char* end = map_.data() + map_.size();
+    DeltaDecoder decoder(map_.data() + kDeltaHeaderBytes, end);
+    for (uint64_t i = 0; i < records_; i++) {
+        if (!decoder.next(i % interval_ == 0)) {
+            lastError_ = "Damaged record #" + to_string(i + 1) + " in '" + path_ + "'";
+            return false;
+        }
+        fn(decoder.data(), decoder.size());
+    }
+    if (decoder.position() != end) {
+        lastError_ = "'" + path_ + "' has bytes after its last record";
+        return false;
+    }
+    return true;
+}
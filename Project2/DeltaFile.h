@@ -0,0 +1,161 @@
+/**
+ * @file DeltaFile.h
+ * @brief Prefix-compressed record file (.dlen): every record stored as its
+ *        difference to the one before, with restart points.
+ * @date October 2026
+ *
+ * In a key-sorted file neighbouring records mostly repeat each other: the
+ * same state, often the same county and place, ZIPs and coordinates that
+ * start with the same digits. As in the blocks of an SSTable, a record is
+ * stored as what it shares with the previous record plus the rest, here
+ * field by field:
+ *   varint fields | per field: varint shared | varint suffix length | suffix
+ * where "shared" counts the leading bytes the field has in common with the
+ * same field of the previous record. Every restartInterval records the
+ * chain restarts (the record is stored whole), so decoding can begin at
+ * any restart point without looking further back.
+ *
+ * File "<name>.dlen" (binary, native byte order):
+ *   "ZIPDLT1\0" | u64 generation | u32 restart interval | u32 0 |
+ *   u64 records | u64 text bytes (of the records as plain CSV) | records
+ *
+ * Its index "<name>.dlen.idx" is text like an .idx. When the ZIPs come in
+ * strictly increasing order (shorter first, then byte by byte, which is
+ * numeric order for ZIPs without leading zeros) it is sparse: one line per
+ * restart point, with the first ZIP stored there,
+ *   DLTIDX,1,<generation, 16 hex digits>,<restart interval>,sparse
+ *   56301 40960
+ * and a lookup binary-searches those keys. Otherwise it is dense: one line
+ * per record, giving the restart point before it and how many records
+ * follow it first,
+ *   DLTIDX,1,<generation, 16 hex digits>,<restart interval>
+ *   56301 40960 3
+ * Either way a lookup decodes at most one restart interval. A scan needs
+ * no index: it decodes the mapped file front to back, one buffer swap per
+ * record.
+ *
+ * The records are split at every comma, exactly like splitCsvSimple(), so
+ * any line comes back byte for byte; quoted fields just compress less.
+ */
+#ifndef DELTAFILE_H
+#define DELTAFILE_H
+
+#include "DuplicateKeys.h"
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class DeltaFile
+ * @brief Builds a .dlen file from a CSV; looks records up and scans them.
+ */
+class DeltaFile {
+public:
+    /// Records per restart interval unless asked otherwise
+    static const unsigned kDefaultRestartInterval = 16;
+
+    /// Largest restart interval accepted
+    static const unsigned kMaxRestartInterval = 4096;
+
+    /// What build() wrote
+    struct BuildStats {
+        uint64_t records;
+        uint64_t textBytes;   ///< the records as plain CSV lines, no newlines
+        uint64_t fileBytes;   ///< size of the .dlen file
+        uint64_t indexEntries;    ///< lines in the index, after its header
+        bool sparseIndex;         ///< one index line per restart point
+        uint64_t duplicateKeys;   ///< ZIPs found on more than one row
+        uint64_t dropped;         ///< rows left out by the duplicate policy
+        std::string duplicates;   ///< note on the duplicated ZIPs, if any
+    };
+
+    /**
+     * @brief Encodes the rows of a CSV file (its first line is the header)
+     *        into path and writes the index next to it. Both are written to
+     *        temp files and published (see AtomicFile.h). The CSV is read
+     *        twice: first the ZIPs alone, to find duplicated ones (see
+     *        DuplicateKeys.h), then the records.
+     * @param csvFile Input CSV, best sorted by key
+     * @param path Output .dlen file
+     * @param restartInterval Records per restart interval, 1..kMaxRestartInterval
+     * @param stats Receives the sizes and the duplicates found
+     * @param error Receives a message on failure
+     * @param policy With a policy only one row of a duplicated ZIP is
+     *        written, or under DuplicatePolicy::kError nothing is
+     * @return false on failure
+     */
+    static bool build(const std::string& csvFile, const std::string& path,
+                      unsigned restartInterval, BuildStats& stats, std::string& error,
+                      DuplicatePolicy policy = DuplicatePolicy::kKeepAll);
+
+    DeltaFile();
+
+    /**
+     * @brief Maps a .dlen file and checks its header.
+     * @return false (see lastError()) if missing or damaged
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Loads the index of the open file.
+     * @return false (see lastError()) if missing, damaged, or made for
+     *         another file
+     */
+    bool loadIndex();
+
+    /**
+     * @brief Looks a ZIP up through the index.
+     * @param zip Primary key
+     * @param record Receives the record text
+     * @param decoded Receives the number of records decoded to get it
+     * @return false if the ZIP is not indexed, or on damage (lastError()
+     *         is then set)
+     */
+    bool find(const std::string& zip, std::string& record, unsigned& decoded);
+
+    /**
+     * @brief Decodes every record in file order.
+     * @param fn Called with each record's text and length; the text is only
+     *        valid during the call
+     * @return false (see lastError()) if the file is damaged
+     */
+    bool scan(const std::function<void(const char*, size_t)>& fn);
+
+    const std::string& lastError() const { return lastError_; }
+
+    unsigned long long generation() const { return generation_; }
+    unsigned restartInterval() const { return interval_; }
+    uint64_t records() const { return records_; }
+    uint64_t textBytes() const { return textBytes_; }
+    size_t fileBytes() const { return map_.size(); }
+    size_t indexEntries() const { return sparse_ ? blocks_.size() : index_.size(); }
+    bool sparseIndex() const { return sparse_; }
+
+    /// The index of a .dlen file
+    static std::string indexPathFor(const std::string& path) { return path + ".idx"; }
+
+private:
+    /// find() through the sparse index
+    bool findSparse(const std::string& zip, std::string& record, unsigned& decoded);
+
+    std::string path_;
+    MappedFile map_;
+    unsigned long long generation_;
+    unsigned interval_;
+    uint64_t records_;
+    uint64_t textBytes_;
+    /// Dense index: ZIP → (offset of its restart point, records before it there)
+    std::unordered_map<std::string, std::pair<uint64_t, uint32_t>> index_;
+    /// Sparse index: (first ZIP, offset) of every restart point, in order
+    std::vector<std::pair<std::string, uint64_t>> blocks_;
+    bool sparse_;
+    std::string lastError_;
+};
+
+#endif
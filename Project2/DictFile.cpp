@@ -0,0 +1,426 @@
+/**
+ * @file DictFile.cpp
+ * @brief Implementation of the dictionary-encoded record file.
+ * @date October 2026
+ */
+#include "DictFile.h"
+#include "AtomicFile.h"
+#include "HeaderBuffer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+using namespace std;
+
+const char* const DictFile::kDictionaryColumns[3] = {"PlaceName", "State", "County"};
+
+static const char kDictMagic[8] = {'Z', 'I', 'P', 'D', 'I', 'C', 'T', '1'};
+static const size_t kDictHeaderBytes = 48;
+static const size_t kDictionaryHeaderBytes = 16;
+
+static void putVarint(string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+static inline bool getVarint(const char*& p, const char* end, uint64_t& v) {
+    // Ids and lengths nearly always fit one byte.
+    if (p < end && !(*p & 0x80)) {
+        v = static_cast<uint8_t>(*p++);
+        return true;
+    }
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && p < end; shift += 7) {
+        const uint8_t b = static_cast<uint8_t>(*p++);
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+template <typename T>
+static void putRaw(ostream& out, const T& v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+/// Fields of a line, split at every comma like splitCsvSimple()
+static void splitFields(const string& line, vector<string>& fields) {
+    fields.clear();
+    size_t b = 0;
+    for (size_t i = 0; i <= line.size(); i++) {
+        if (i == line.size() || line[i] == ',') {
+            fields.push_back(line.substr(b, i - b));
+            b = i + 1;
+        }
+    }
+}
+
+static bool sameName(const string& a, const char* b) {
+    size_t n = strlen(b);
+    if (a.size() != n) return false;
+    for (size_t i = 0; i < n; i++)
+        if (tolower(static_cast<unsigned char>(a[i])) != tolower(static_cast<unsigned char>(b[i])))
+            return false;
+    return true;
+}
+
+/// Bytes of a dictionary's offsets and text, padded to 8
+static uint64_t dictionaryBodyBytes(uint64_t entries, uint64_t textBytes) {
+    return (4 * (entries + 1) + textBytes + 7) / 8 * 8;
+}
+
+string DictRecord::text() const {
+    string out;
+    for (size_t i = 0; i < fields; i++) {
+        if (i > 0) out += ',';
+        out.append(field[i].data(), field[i].size());
+    }
+    return out;
+}
+
+bool DictFile::build(const string& csvFile, const string& path, BuildStats& stats,
+                     string& error, DuplicatePolicy policy) {
+    stats = BuildStats{0, 0, 0, 0, {}, 0, 0, string()};
+    ifstream in(csvFile, ios::binary);
+    if (!in) {
+        error = "Cannot open CSV file '" + csvFile + "'";
+        return false;
+    }
+    string line;
+    if (!getline(in, line)) {
+        error = "CSV file is empty.";
+        return false;
+    }
+    const streampos dataStart = in.tellg();
+
+    // The dictionary columns, by header name or else by position.
+    vector<string> fields;
+    splitFields(line, fields);
+    vector<size_t> columns;
+    vector<string> names;
+    for (const char* name : kDictionaryColumns) {
+        for (size_t i = 0; i < fields.size(); i++) {
+            if (sameName(fields[i], name)) {
+                columns.push_back(i);
+                names.push_back(name);
+                break;
+            }
+        }
+    }
+    if (columns.empty()) {
+        for (size_t i = 0; i < 3; i++) {
+            columns.push_back(i + 1);
+            names.push_back(kDictionaryColumns[i]);
+        }
+    }
+
+    // The ZIP (first field) of every row.
+    DuplicateKeys keys;
+    while (getline(in, line)) {
+        if (!line.empty()) keys.add(line.substr(0, line.find(',')));
+    }
+    keys.finish();
+    stats.duplicateKeys = keys.duplicateKeys();
+    if (keys.duplicateKeys() > 0) {
+        stats.duplicates = to_string(keys.duplicateKeys()) + " duplicate ZIP(s), " +
+                           to_string(keys.extraRows()) + " extra row(s): " + keys.examples();
+        if (policy == DuplicatePolicy::kError) {
+            error = stats.duplicates;
+            return false;
+        }
+    }
+    in.clear();
+    in.seekg(dataStart);
+
+    // Pass 1: how often each value occurs in the rows that are kept.
+    vector<unordered_map<string, uint64_t>> ids(columns.size());
+    vector<bool> kept;
+    while (getline(in, line)) {
+        if (line.empty()) continue;
+        kept.push_back(keys.keep(line.substr(0, line.find(',')), policy));
+        if (!kept.back()) {
+            stats.dropped++;
+            continue;
+        }
+        splitFields(line, fields);
+        if (fields.size() > DictRecord::kMaxFields) {
+            error = "Row " + to_string(stats.records + 1) + " has more than " +
+                    to_string(DictRecord::kMaxFields) + " fields";
+            return false;
+        }
+        for (size_t k = 0; k < columns.size(); k++)
+            if (columns[k] < fields.size()) ids[k][fields[columns[k]]]++;
+        stats.records++;
+        stats.textBytes += line.size();
+    }
+
+    // Most frequent first, so the common values get one-byte ids.
+    vector<vector<string>> values(columns.size());
+    uint64_t recordsOffset = kDictHeaderBytes;
+    for (size_t k = 0; k < columns.size(); k++) {
+        vector<pair<uint64_t, string>> byCount;
+        byCount.reserve(ids[k].size());
+        for (const auto& v : ids[k]) byCount.emplace_back(v.second, v.first);
+        sort(byCount.begin(), byCount.end(), [](const pair<uint64_t, string>& a,
+                                                const pair<uint64_t, string>& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+        uint64_t bytes = 0;
+        for (size_t id = 0; id < byCount.size(); id++) {
+            ids[k][byCount[id].second] = id;
+            bytes += byCount[id].second.size();
+            values[k].push_back(std::move(byCount[id].second));
+        }
+        if (bytes > UINT32_MAX) {
+            error = "Dictionary of " + names[k] + " is larger than 4 GB";
+            return false;
+        }
+        const uint64_t total = kDictionaryHeaderBytes + dictionaryBodyBytes(values[k].size(), bytes);
+        stats.dictionaries.push_back(DictionaryStats{names[k], values[k].size(), total});
+        recordsOffset += total;
+    }
+
+    const string indexFile = indexPathFor(path);
+    const string tmp = tempPathFor(path);
+    const string tmpIndex = tempPathFor(indexFile);
+    ofstream out(tmp, ios::binary);
+    ofstream idx(tmpIndex);
+    if (!out || !idx) {
+        error = "Cannot create '" + (out ? tmpIndex : tmp) + "'";
+        out.close();
+        idx.close();
+        discardTemp(tmp);
+        discardTemp(tmpIndex);
+        return false;
+    }
+
+    const unsigned long long generation = HeaderBuffer::newGeneration();
+    out.write(kDictMagic, sizeof(kDictMagic));
+    putRaw(out, static_cast<uint64_t>(generation));
+    putRaw(out, static_cast<uint32_t>(columns.size()));
+    putRaw(out, static_cast<uint32_t>(0));
+    putRaw(out, stats.records);
+    putRaw(out, stats.textBytes);
+    putRaw(out, recordsOffset);
+    for (size_t k = 0; k < columns.size(); k++) {
+        uint32_t offset = 0;
+        for (const string& v : values[k]) offset += static_cast<uint32_t>(v.size());
+        putRaw(out, static_cast<uint32_t>(columns[k]));
+        putRaw(out, static_cast<uint32_t>(values[k].size()));
+        putRaw(out, offset);
+        putRaw(out, static_cast<uint32_t>(0));
+        offset = 0;
+        putRaw(out, offset);
+        for (const string& v : values[k]) {
+            offset += static_cast<uint32_t>(v.size());
+            putRaw(out, offset);
+        }
+        for (const string& v : values[k]) out.write(v.data(), static_cast<streamsize>(v.size()));
+        const uint64_t pad = dictionaryBodyBytes(values[k].size(), offset) -
+                             4 * (values[k].size() + 1) - offset;
+        for (uint64_t i = 0; i < pad; i++) out.put('\0');
+    }
+    idx << "DCTIDX,1," << HeaderBuffer::generationText(generation) << "\n";
+
+    // Column → position in ids, for pass 2.
+    vector<int> dictionaryOf(DictRecord::kMaxFields, -1);
+    for (size_t k = 0; k < columns.size(); k++)
+        if (columns[k] < dictionaryOf.size()) dictionaryOf[columns[k]] = static_cast<int>(k);
+
+    // Pass 2: the records.
+    in.clear();
+    in.seekg(dataStart);
+    string buf;
+    uint64_t offset = recordsOffset;
+    size_t row = 0;
+    while (getline(in, line)) {
+        if (line.empty() || !kept[row++]) continue;
+        splitFields(line, fields);
+        buf.clear();
+        putVarint(buf, fields.size());
+        for (size_t i = 0; i < fields.size(); i++) {
+            if (dictionaryOf[i] >= 0) {
+                putVarint(buf, ids[dictionaryOf[i]].at(fields[i]));
+            } else {
+                putVarint(buf, fields[i].size());
+                buf += fields[i];
+            }
+        }
+        out.write(buf.data(), static_cast<streamsize>(buf.size()));
+        idx << fields[0] << ' ' << offset << '\n';
+        offset += buf.size();
+    }
+    stats.recordBytes = offset - recordsOffset;
+    stats.fileBytes = offset;
+
+    out.close();
+    idx.close();
+    // Data first: an index is only ever published for data that exists.
+    if (!out || !idx || !publishFile(tmp, path) || !publishFile(tmpIndex, indexFile)) {
+        error = "Failed to publish '" + path + "' and its index";
+        discardTemp(tmp);
+        discardTemp(tmpIndex);
+        return false;
+    }
+    return true;
+}
+
+DictFile::DictFile() : generation_(0), records_(0), textBytes_(0), recordsOffset_(0) {}
+
+bool DictFile::open(const string& path) {
+    path_ = path;
+    index_.clear();
+    dictionaries_.clear();
+    dictionaryOf_.assign(DictRecord::kMaxFields, -1);
+    if (!map_.open(path)) {
+        lastError_ = "Cannot open dictionary file '" + path + "'";
+        return false;
+    }
+    const char* base = map_.data();
+    const size_t size = map_.size();
+    if (size < kDictHeaderBytes || memcmp(base, kDictMagic, sizeof(kDictMagic)) != 0) {
+        lastError_ = "'" + path + "' is not a dictionary file";
+        return false;
+    }
+    uint64_t gen = 0;
+    uint32_t count = 0;
+    memcpy(&gen, base + 8, sizeof(gen));
+    memcpy(&count, base + 16, sizeof(count));
+    memcpy(&records_, base + 24, sizeof(records_));
+    memcpy(&textBytes_, base + 32, sizeof(textBytes_));
+    memcpy(&recordsOffset_, base + 40, sizeof(recordsOffset_));
+    generation_ = gen;
+
+    const string damaged = "'" + path + "' has a damaged dictionary";
+    uint64_t pos = kDictHeaderBytes;
+    for (uint32_t d = 0; d < count; d++) {
+        uint32_t column = 0, entries = 0, bytes = 0;
+        if (size - pos < kDictionaryHeaderBytes) {
+            lastError_ = damaged;
+            return false;
+        }
+        memcpy(&column, base + pos, sizeof(column));
+        memcpy(&entries, base + pos + 4, sizeof(entries));
+        memcpy(&bytes, base + pos + 8, sizeof(bytes));
+        pos += kDictionaryHeaderBytes;
+        const uint64_t body = dictionaryBodyBytes(entries, bytes);
+        if (column >= DictRecord::kMaxFields || dictionaryOf_[column] >= 0 || size - pos < body) {
+            lastError_ = damaged;
+            return false;
+        }
+        // 8-byte aligned in a page-aligned mapping, so read in place.
+        Dictionary dict;
+        dict.offsets = reinterpret_cast<const uint32_t*>(base + pos);
+        dict.text = base + pos + 4 * (uint64_t(entries) + 1);
+        dict.entries = entries;
+        if (dict.offsets[0] != 0 || dict.offsets[entries] != bytes) {
+            lastError_ = damaged;
+            return false;
+        }
+        for (uint32_t i = 0; i < entries; i++) {
+            if (dict.offsets[i] > dict.offsets[i + 1]) {
+                lastError_ = damaged;
+                return false;
+            }
+        }
+        dictionaryOf_[column] = static_cast<int>(dictionaries_.size());
+        dictionaries_.push_back(dict);
+        pos += body;
+    }
+    if (pos != recordsOffset_ || recordsOffset_ > size) {
+        lastError_ = damaged;
+        return false;
+    }
+    return true;
+}
+
+bool DictFile::loadIndex() {
+    index_.clear();
+    const string indexFile = indexPathFor(path_);
+    ifstream in(indexFile);
+    string first;
+    if (!in || !getline(in, first)) {
+        lastError_ = "Cannot open dictionary index '" + indexFile + "'";
+        return false;
+    }
+    if (first != "DCTIDX,1," + HeaderBuffer::generationText(generation_)) {
+        lastError_ = "Dictionary index '" + indexFile + "' was not made for '" + path_ + "'";
+        return false;
+    }
+
+    string zip;
+    uint64_t offset = 0;
+    while (in >> zip >> offset) {
+        if (offset < recordsOffset_ || offset >= map_.size()) {
+            lastError_ = "Dictionary index '" + indexFile + "' is damaged at ZIP " + zip;
+            index_.clear();
+            return false;
+        }
+        index_[zip] = offset;
+    }
+    return true;
+}
+
+bool DictFile::decode(const char*& p, const char* end, DictRecord& record) const {
+    uint64_t count = 0;
+    if (!getVarint(p, end, count) || count == 0 || count > DictRecord::kMaxFields) return false;
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t v = 0;
+        if (!getVarint(p, end, v)) return false;
+        const int d = dictionaryOf_[i];
+        if (d >= 0) {
+            const Dictionary& dict = dictionaries_[d];
+            if (v >= dict.entries) return false;
+            record.field[i] = string_view(dict.text + dict.offsets[v],
+                                          dict.offsets[v + 1] - dict.offsets[v]);
+        } else {
+            if (v > static_cast<uint64_t>(end - p)) return false;
+            record.field[i] = string_view(p, v);
+            p += v;
+        }
+    }
+    record.fields = count;
+    return true;
+}
+
+bool DictFile::find(const string& zip, DictRecord& record) {
+    lastError_.clear();
+    auto it = index_.find(zip);
+    if (it == index_.end()) return false;
+
+    const char* p = map_.data() + it->second;
+    if (!decode(p, map_.data() + map_.size(), record)) {
+        lastError_ = "Damaged record at offset " + to_string(it->second);
+        return false;
+    }
+    if (record.field[0] != zip) {
+        lastError_ = "Dictionary index does not match the data for ZIP " + zip;
+        return false;
+    }
+    return true;
+}
+
+bool DictFile::scan(const function<void(const DictRecord&)>& fn) {
+    map_.adviseSequential();
+    const char* p = map_.data() + recordsOffset_;
+    const char* end = map_.data() + map_.size();
+    DictRecord record;
+    for (uint64_t i = 0; i < records_; i++) {
+        if (!decode(p, end, record)) {
+            lastError_ = "Damaged record #" + to_string(i + 1) + " in '" + path_ + "'";
+            return false;
+        }
+        fn(record);
+    }
+    if (p != end) {
+        lastError_ = "'" + path_ + "' has bytes after its last record";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file DictFile.h
+ * @brief Dictionary-encoded record file (.dict): place, state and county
+ *        stored as ids into per-column dictionaries.
+ * @date October 2026
+ *
+ * PlaceName, State and County repeat heavily (41k rows have about 60
+ * states, 1,900 counties and 19,000 places). Each of those columns gets a
+ * dictionary of its distinct values, most frequent first, so the common
+ * values have the smallest ids. A record stores a varint id for such a
+ * field and the text of the others (ZIP, coordinates):
+ *   varint fields | per field: varint id, or varint length + text
+ * A typical record is then about 28 bytes instead of 55 in a .len file.
+ *
+ * File "<name>.dict" (binary, native byte order):
+ *   "ZIPDICT1" | u64 generation | u32 dictionaries | u32 0 | u64 records |
+ *   u64 text bytes (of the records as plain CSV) | u64 offset of records |
+ *   per dictionary: u32 column | u32 entries | u32 text bytes | u32 0 |
+ *                   u32 offsets[entries + 1] | text, padded to 8 bytes |
+ *   records
+ * The dictionaries come right after the header and stay mapped: a decoded
+ * field is a std::string_view into the mapping, so reading a record
+ * allocates nothing.
+ *
+ * Its index "<name>.dict.idx" is text like an .idx:
+ *   DCTIDX,1,<generation, 16 hex digits>
+ *   56301 40960
+ *
+ * Records are split at every comma, like splitCsvSimple(), so any line
+ * comes back byte for byte.
+ */
+#ifndef DICTFILE_H
+#define DICTFILE_H
+
+#include "DuplicateKeys.h"
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct DictRecord
+ * @brief One decoded record: views into the mapped file.
+ */
+struct DictRecord {
+    /// Most fields a record may have
+    static const size_t kMaxFields = 32;
+
+    std::string_view field[kMaxFields];
+    size_t fields = 0;
+
+    /// The record as a CSV line (this one allocates)
+    std::string text() const;
+};
+
+/**
+ * @class DictFile
+ * @brief Builds a .dict file from a CSV; looks records up and scans them.
+ */
+class DictFile {
+public:
+    /// Columns given a dictionary, by CSV header name (else 1, 2 and 3)
+    static const char* const kDictionaryColumns[3];
+
+    /// Size of one dictionary, for build()
+    struct DictionaryStats {
+        std::string column;
+        uint64_t entries;
+        uint64_t bytes;
+    };
+
+    /// What build() wrote
+    struct BuildStats {
+        uint64_t records;
+        uint64_t textBytes;     ///< the records as plain CSV lines, no newlines
+        uint64_t recordBytes;   ///< the encoded records
+        uint64_t fileBytes;     ///< size of the .dict file
+        std::vector<DictionaryStats> dictionaries;
+        uint64_t duplicateKeys;   ///< ZIPs found on more than one row
+        uint64_t dropped;         ///< rows left out by the duplicate policy
+        std::string duplicates;   ///< note on the duplicated ZIPs, if any
+    };
+
+    /**
+     * @brief Encodes the rows of a CSV file (its first line is the header)
+     *        into path and writes the index next to it. The CSV is read
+     *        three times: the ZIPs alone, to find duplicated ones (see
+     *        DuplicateKeys.h), then for the dictionaries, then for the
+     *        records. Both files are written to temp files and published
+     *        (see AtomicFile.h).
+     * @param csvFile Input CSV
+     * @param path Output .dict file
+     * @param stats Receives the sizes and the duplicates found
+     * @param error Receives a message on failure
+     * @param policy With a policy only one row of a duplicated ZIP is
+     *        written, or under DuplicatePolicy::kError nothing is
+     * @return false on failure
+     */
+    static bool build(const std::string& csvFile, const std::string& path, BuildStats& stats,
+                      std::string& error,
+                      DuplicatePolicy policy = DuplicatePolicy::kKeepAll);
+
+    DictFile();
+
+    /**
+     * @brief Maps a .dict file and checks its header and dictionaries.
+     * @return false (see lastError()) if missing or damaged
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Loads the index of the open file.
+     * @return false (see lastError()) if missing, damaged, or made for
+     *         another file
+     */
+    bool loadIndex();
+
+    /**
+     * @brief Looks a ZIP up through the index.
+     * @return false if the ZIP is not indexed, or on damage (lastError()
+     *         is then set)
+     */
+    bool find(const std::string& zip, DictRecord& record);
+
+    /**
+     * @brief Decodes every record in file order.
+     * @param fn Called with each record; its views stay valid while the
+     *        file is open
+     * @return false (see lastError()) if the file is damaged
+     */
+    bool scan(const std::function<void(const DictRecord&)>& fn);
+
+    const std::string& lastError() const { return lastError_; }
+
+    unsigned long long generation() const { return generation_; }
+    uint64_t records() const { return records_; }
+    uint64_t textBytes() const { return textBytes_; }
+    size_t fileBytes() const { return map_.size(); }
+
+    /// The index of a .dict file
+    static std::string indexPathFor(const std::string& path) { return path + ".idx"; }
+
+private:
+    /// One mapped dictionary
+    struct Dictionary {
+        const uint32_t* offsets;   ///< entries + 1, into text
+        const char* text;
+        uint32_t entries;
+    };
+
+    /// Decodes the record at p and moves p past it
+    bool decode(const char*& p, const char* end, DictRecord& record) const;
+
+    std::string path_;
+    MappedFile map_;
+    unsigned long long generation_;
+    uint64_t records_;
+    uint64_t textBytes_;
+    uint64_t recordsOffset_;
+    std::vector<Dictionary> dictionaries_;
+    std::vector<int> dictionaryOf_;   ///< column → dictionary, -1 for none
+    std::unordered_map<std::string, uint64_t> index_;   ///< ZIP → record offset
+    std::string lastError_;
+};
+
+#endif
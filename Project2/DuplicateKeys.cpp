@@ -0,0 +1,85 @@
+/**
+ * @file DuplicateKeys.cpp
+ * @brief Implementation of the duplicate key detection.
+ * @date October 2026
+ */
+#include "DuplicateKeys.h"
+#include "BloomFilter.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+bool parseDuplicatePolicy(const string& text, DuplicatePolicy& policy) {
+    if (text == "first") policy = DuplicatePolicy::kFirstWins;
+    else if (text == "last") policy = DuplicatePolicy::kLastWins;
+    else if (text == "error") policy = DuplicatePolicy::kError;
+    else return false;
+    return true;
+}
+
+const char* duplicatePolicyName(DuplicatePolicy policy) {
+    switch (policy) {
+    case DuplicatePolicy::kFirstWins: return "first wins";
+    case DuplicatePolicy::kLastWins: return "last wins";
+    case DuplicatePolicy::kError: return "error";
+    default: return "keep all";
+    }
+}
+
+DuplicateKeys::DuplicateKeys() : rows_(0), extraRows_(0) {}
+
+uint64_t DuplicateKeys::packKey(const string& key) {
+    if (key.size() > sizeof(uint64_t)) return BloomFilter::hashKey(key);
+    uint64_t packed = 0;
+    memcpy(&packed, key.data(), key.size());
+    return packed;
+}
+
+void DuplicateKeys::add(const string& key) {
+    keys_.push_back(packKey(key));
+    rows_++;
+}
+
+void DuplicateKeys::finish() {
+    sort(keys_.begin(), keys_.end());
+    for (size_t i = 0; i < keys_.size();) {
+        size_t j = i + 1;
+        while (j < keys_.size() && keys_[j] == keys_[i]) j++;
+        if (j - i > 1) {
+            counts_[keys_[i]] = j - i;
+            extraRows_ += j - i - 1;
+            if (sample_.size() < kExamples) sample_.push_back(keys_[i]);
+        }
+        i = j;
+    }
+    vector<uint64_t>().swap(keys_);
+}
+
+string DuplicateKeys::examples() const {
+    string out;
+    for (uint64_t packed : sample_) {
+        if (!out.empty()) out += ", ";
+        // A packed key is its own bytes (zero padded); a hash is not.
+        char text[sizeof(packed) + 1] = {0};
+        memcpy(text, &packed, sizeof(packed));
+        string key(text);
+        if (packKey(key) != packed) key = "(long key)";
+        out += key + " x" + to_string(counts_.at(packed));
+    }
+    return out;
+}
+
+bool DuplicateKeys::keep(const string& key, DuplicatePolicy policy) {
+    if (counts_.empty()) return true;
+    const uint64_t packed = packKey(key);
+    auto it = counts_.find(packed);
+    if (it == counts_.end()) return true;
+    const uint64_t n = ++seen_[packed];
+    switch (policy) {
+    case DuplicatePolicy::kFirstWins: return n == 1;
+    case DuplicatePolicy::kLastWins: return n == it->second;
+    default: return true;
+    }
+}
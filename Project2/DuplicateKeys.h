@@ -0,0 +1,92 @@
+/**
+ * @file DuplicateKeys.h
+ * @brief Duplicate primary keys at ingest: detection and a keep policy
+ *        (first wins, last wins, or reject).
+ * @date October 2026
+ *
+ * Two passes over the input, so it works for 100M rows:
+ * 1) add() every row's key. A key of up to 8 bytes (every ZIP) is packed
+ *    into one 64-bit integer exactly; a longer one is replaced by its
+ *    64-bit hash, so two long keys could in theory be taken as equal.
+ *    That is 8 bytes per row, and finish() sorts them and keeps only the
+ *    keys that occur more than once, with their counts.
+ * 2) keep() is asked for every row again, in the same order. It counts
+ *    the duplicated keys it has seen, so it knows whether a row is the
+ *    first or the last of its key.
+ *
+ * The index of a pair maps each ZIP to one record; with duplicates in the
+ * data, loading it used to keep whichever line came last without a word.
+ */
+#ifndef DUPLICATEKEYS_H
+#define DUPLICATEKEYS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// What to do with the rows of a duplicated key
+enum class DuplicatePolicy {
+    kKeepAll,     ///< report only; every row is kept
+    kFirstWins,   ///< keep the first row of each key
+    kLastWins,    ///< keep the last row of each key
+    kError        ///< reject the input
+};
+
+/**
+ * @brief Parses "first", "last" or "error".
+ * @return false for anything else
+ */
+bool parseDuplicatePolicy(const std::string& text, DuplicatePolicy& policy);
+
+/// Name of a policy, for output
+const char* duplicatePolicyName(DuplicatePolicy policy);
+
+/**
+ * @class DuplicateKeys
+ * @brief Finds duplicated keys in pass 1, decides rows in pass 2.
+ */
+class DuplicateKeys {
+public:
+    /// Duplicated keys listed by examples()
+    static const size_t kExamples = 5;
+
+    DuplicateKeys();
+
+    /// Pass 1: one row's key
+    void add(const std::string& key);
+
+    /// Ends pass 1 (frees the per-row keys)
+    void finish();
+
+    /// Rows added in pass 1
+    uint64_t rows() const { return rows_; }
+
+    /// Keys that occur more than once
+    uint64_t duplicateKeys() const { return counts_.size(); }
+
+    /// Rows beyond the first of each key
+    uint64_t extraRows() const { return extraRows_; }
+
+    /// Some duplicated keys and how often they occur, for messages
+    std::string examples() const;
+
+    /**
+     * @brief Pass 2: whether a row stays under a policy. Call once per row,
+     *        in pass 1 order. kError keeps every row (the caller stops).
+     */
+    bool keep(const std::string& key, DuplicatePolicy policy);
+
+private:
+    static uint64_t packKey(const std::string& key);
+
+    uint64_t rows_;
+    uint64_t extraRows_;
+    std::vector<uint64_t> keys_;                   ///< pass 1, one per row
+    std::unordered_map<uint64_t, uint64_t> counts_;  ///< duplicated key → rows
+    std::unordered_map<uint64_t, uint64_t> seen_;    ///< pass 2 progress
+    std::vector<uint64_t> sample_;                 ///< for examples()
+};
+
+#endif
@@ -0,0 +1,26 @@
+/**
+ * @file Eytzinger.cpp
+ * @brief Implementation of the Eytzinger layout.
+ * @date October 2026
+ */
+#include "Eytzinger.h"
+
+using namespace std;
+
+/**
+ * @brief In-order walk of the implicit tree: the walk visits the slots in
+ *        key order, so the i-th slot visited gets sorted element i.
+ */
+static void fillOrder(vector<size_t>& order, size_t& next, size_t k) {
+    if (k >= order.size()) return;
+    fillOrder(order, next, 2 * k);
+    order[k] = next++;
+    fillOrder(order, next, 2 * k + 1);
+}
+
+vector<size_t> eytzingerOrder(size_t count) {
+    vector<size_t> order(count + 1, 0);
+    size_t next = 0;
+    fillOrder(order, next, 1);
+    return order;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file Eytzinger.h
+ * @brief Sorted keys in Eytzinger (breadth-first) order, for a binary
+ *        search that does not wait for memory at every level.
+ * @date October 2026
+ *
+ * std::lower_bound over a big sorted array jumps half the array, then a
+ * quarter, and so on. Each of those probes lands on a different cache
+ * line, and it cannot be issued before the previous comparison is known.
+ *
+ * The Eytzinger layout stores the implicit binary search tree level by
+ * level: the root in slot 1, the children of slot k in 2k and 2k+1. The
+ * first levels of the tree then share a few cache lines that stay hot.
+ * Deeper down, the 16 descendants four levels below slot k sit in the
+ * slots 16k..16k+15, which is one 64-byte line of u32 keys. The search
+ * prefetches that line while it works through the next four levels. The
+ * step itself has no branch (k = 2k + (key at k < x)), so mispredictions
+ * do not flush that work either.
+ *
+ * Arrays have count + 1 slots; slot 0 is unused so that the slots 16k..
+ * 16k+15 start on a line boundary when the array is 64-byte aligned.
+ */
+#ifndef EYTZINGER_H
+#define EYTZINGER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief For each Eytzinger slot, the sorted position stored in it.
+ *
+ * order[k] (k = 1..count) is the index into the sorted array whose
+ * element belongs in slot k; order[0] is unused. Apply it to the keys
+ * and to any value array that goes with them.
+ *
+ * @param count Number of sorted elements
+ * @return count + 1 positions
+ */
+std::vector<size_t> eytzingerOrder(size_t count);
+
+/**
+ * @brief Finds the slot of the smallest key >= x.
+ *
+ * @param slots Keys in Eytzinger order (count + 1 slots, slot 0 unused)
+ * @param count Number of keys
+ * @param x Key to look for
+ * @return the slot, or 0 if every key is smaller than x
+ */
+inline size_t eytzingerLowerBound(const uint32_t* slots, size_t count, uint32_t x) {
+    size_t k = 1;
+    while (k <= count) {
+        // Four levels down; a prefetch past the end is ignored.
+        __builtin_prefetch(slots + k * 16);
+        k = 2 * k + (slots[k] < x);
+    }
+    // The answer is the last slot where the search went left. The bits
+    // of k below that turn are the right turns taken after it: shift
+    // them off together with the left turn itself.
+    k >>= __builtin_ffsll(static_cast<long long>(~k));
+    return k;
+}
+
+#endif
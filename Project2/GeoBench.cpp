@@ -0,0 +1,86 @@
+/**
+ * @file GeoBench.cpp
+ * @brief Implementation of the distance kernel benchmark.
+ * @date October 2026
+ */
+#include "GeoBench.h"
+#include "GeoIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+using namespace std;
+
+/// Haversine with libm, radians in, km out
+static double libmHaversine(double lat1, double lon1, double lat2, double lon2) {
+    const double s1 = sin((lat2 - lat1) / 2), s2 = sin((lon2 - lon1) / 2);
+    const double a = s1 * s1 + cos(lat1) * cos(lat2) * s2 * s2;
+    return 2 * GeoIndex::kEarthRadiusKm * asin(min(1.0, sqrt(a)));
+}
+
+void benchGeoKernels(size_t points, size_t queries, GeoBenchResult& result) {
+    result = GeoBenchResult();
+    result.points = points;
+    result.queries = queries;
+    if (points == 0 || queries == 0) return;
+
+    // Uniform on the sphere: latitude from asin of a uniform value.
+    mt19937_64 rng(4242);
+    uniform_real_distribution<double> unit(-1.0, 1.0);
+    const double pi = 3.14159265358979323846;
+    vector<double> lat(points), lon(points);
+    for (size_t i = 0; i < points; i++) {
+        lat[i] = asin(unit(rng));
+        lon[i] = unit(rng) * pi;
+    }
+    vector<double> qLat(queries), qLon(queries);
+    for (size_t q = 0; q < queries; q++) {
+        qLat[q] = asin(unit(rng));
+        qLon[q] = unit(rng) * pi;
+    }
+
+    vector<double> reference(points * queries), out(points);
+    auto t0 = chrono::steady_clock::now();
+    for (size_t q = 0; q < queries; q++) {
+        double* ref = reference.data() + q * points;
+        for (size_t i = 0; i < points; i++)
+            ref[i] = libmHaversine(qLat[q], qLon[q], lat[i], lon[i]);
+    }
+    const double total = static_cast<double>(points * queries);
+    result.libmNs = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / total;
+
+    const GeoIsa all[] = {GeoIsa::kScalar, GeoIsa::kAvx2, GeoIsa::kAvx512};
+    for (GeoIsa isa : all) {
+        if (!geoKernelSupported(isa)) continue;
+        GeoBenchRow row;
+        row.isa = isa;
+        row.maxErrorM = row.maxErrorNearM = 0;
+
+        double ns = 0;
+        for (size_t q = 0; q < queries; q++) {
+            auto t1 = chrono::steady_clock::now();
+            haversineBatch(lat.data(), lon.data(), points, qLat[q], qLon[q],
+                           GeoIndex::kEarthRadiusKm, out.data(), isa);
+            ns += chrono::duration<double, nano>(chrono::steady_clock::now() - t1).count();
+            const double* ref = reference.data() + q * points;
+            for (size_t i = 0; i < points; i++) {
+                const double error = fabs(out[i] - ref[i]) * 1000.0;
+                row.maxErrorM = max(row.maxErrorM, error);
+                if (ref[i] <= 1000.0) row.maxErrorNearM = max(row.maxErrorNearM, error);
+            }
+        }
+        row.haversineNs = ns / total;
+
+        ns = 0;
+        for (size_t q = 0; q < queries; q++) {
+            auto t1 = chrono::steady_clock::now();
+            equirectangularBatch(lat.data(), lon.data(), points, qLat[q], qLon[q],
+                                 GeoIndex::kEarthRadiusKm, out.data(), isa);
+            ns += chrono::duration<double, nano>(chrono::steady_clock::now() - t1).count();
+        }
+        row.equirectangularNs = ns / total;
+        result.rows.push_back(row);
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ * @file GeoBench.h
+ * @brief Times the distance kernels of GeoKernel.h against libm.
+ * @date October 2026
+ *
+ * Random points all over the globe (struct of arrays, radians) and a few
+ * query points. For each query every kernel computes the distances to all
+ * points, as a nearest-ZIP scan over the whole table would:
+ *   - haversine with libm's sin, cos and asin, one point at a time
+ *     (the reference for the error)
+ *   - haversineBatch() and equirectangularBatch() for every instruction
+ *     set this CPU supports
+ * The haversine error is the largest difference from the libm result, in
+ * meters: over all points, and over the points within 1000 km of the query
+ * (the distances radius and nearest queries work with). Near the
+ * antipode asin(sqrt(a)) magnifies the last bit of a, in libm as well, so
+ * the first number is mostly that and not the polynomials.
+ */
+#ifndef GEOBENCH_H
+#define GEOBENCH_H
+
+#include "GeoKernel.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @struct GeoBenchRow
+ * @brief Nanoseconds per distance for one instruction set.
+ */
+struct GeoBenchRow {
+    GeoIsa isa;
+    double haversineNs;
+    double equirectangularNs;
+    double maxErrorM;     ///< haversine, against libm
+    double maxErrorNearM; ///< the same, for distances up to 1000 km
+};
+
+/**
+ * @struct GeoBenchResult
+ * @brief All rows of one benchmark run.
+ */
+struct GeoBenchResult {
+    size_t points;        ///< points per scan
+    size_t queries;       ///< scans per kernel
+    double libmNs;        ///< libm haversine, per distance
+    std::vector<GeoBenchRow> rows;
+
+    GeoBenchResult() : points(0), queries(0), libmNs(0) {}
+};
+
+/**
+ * @brief Runs every supported kernel over the same points.
+ * @param points Number of points
+ * @param queries Number of query points (full scans per kernel)
+ * @param result Receives the timings
+ */
+void benchGeoKernels(size_t points, size_t queries, GeoBenchResult& result);
+
+#endif
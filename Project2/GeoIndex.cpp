@@ -0,0 +1,284 @@
+/**
+ * @file GeoIndex.cpp
+ * @brief Implementation of the GeoIndex class.
+ * @date October 2026
+ */
+#include "GeoIndex.h"
+#include "AtomicFile.h"
+#include "GeoKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+using namespace std;
+
+static const char kGeoMagic[8] = {'G', 'E', 'O', 'I', 'D', 'X', '2', 0};
+static const uint32_t kGrid = 1u << GeoIndex::kLevel;
+static const double kPi = 3.14159265358979323846;
+static const double kRadians = kPi / 180.0;
+
+/// Writes a u64 count and the elements of a vector
+template <typename Array>
+static void writeArray(ofstream& out, const Array& a) {
+    uint64_t count = a.size();
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char*>(a.data()),
+              static_cast<streamsize>(count * sizeof(a[0])));
+}
+
+/// Reads what writeArray() wrote; false unless it has exactly count elements
+template <typename Array>
+static bool readArray(ifstream& in, Array& a, uint64_t count) {
+    uint64_t stored = 0;
+    in.read(reinterpret_cast<char*>(&stored), sizeof(stored));
+    if (!in || stored != count) return false;
+    a.resize(static_cast<size_t>(count));
+    if (count > 0)
+        in.read(reinterpret_cast<char*>(&a[0]), static_cast<streamsize>(count * sizeof(a[0])));
+    return static_cast<bool>(in);
+}
+
+/// Grid column of a longitude
+static uint32_t gridX(double longitude) {
+    double g = floor((longitude + 180.0) / 360.0 * kGrid);
+    return static_cast<uint32_t>(min(max(g, 0.0), static_cast<double>(kGrid - 1)));
+}
+
+/// Grid row of a latitude
+static uint32_t gridY(double latitude) {
+    double g = floor((latitude + 90.0) / 180.0 * kGrid);
+    return static_cast<uint32_t>(min(max(g, 0.0), static_cast<double>(kGrid - 1)));
+}
+
+/// Position of grid cell (x, y) along the Hilbert curve
+static uint32_t hilbert(uint32_t x, uint32_t y) {
+    uint64_t d = 0;
+    for (uint32_t s = kGrid / 2; s > 0; s /= 2) {
+        const uint32_t rx = (x & s) ? 1 : 0;
+        const uint32_t ry = (y & s) ? 1 : 0;
+        d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+        // Turn the quadrant so the curve continues into it.
+        if (ry == 0) {
+            if (rx == 1) {
+                x = kGrid - 1 - x;
+                y = kGrid - 1 - y;
+            }
+            swap(x, y);
+        }
+    }
+    return static_cast<uint32_t>(d);
+}
+
+GeoIndex::GeoIndex() {}
+
+uint32_t GeoIndex::cellOf(double latitude, double longitude) {
+    return hilbert(gridX(longitude), gridY(latitude));
+}
+
+double GeoIndex::haversineKm(double lat1, double lon1, double lat2, double lon2) {
+    const double dLat = (lat2 - lat1) * kRadians;
+    const double dLon = (lon2 - lon1) * kRadians;
+    const double a = sin(dLat / 2) * sin(dLat / 2) +
+                     cos(lat1 * kRadians) * cos(lat2 * kRadians) * sin(dLon / 2) * sin(dLon / 2);
+    return 2 * kEarthRadiusKm * asin(min(1.0, sqrt(a)));
+}
+
+void GeoIndex::build(const vector<Record>& records) {
+    vector<uint32_t> cells(records.size());
+    for (size_t i = 0; i < records.size(); i++)
+        cells[i] = cellOf(records[i].latitude, records[i].longitude);
+    vector<size_t> order(records.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return cells[a] != cells[b] ? cells[a] < cells[b] : records[a].offset < records[b].offset;
+    });
+
+    cells_.resize(records.size());
+    offsets_.resize(records.size());
+    lat_.resize(records.size());
+    lon_.resize(records.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        const Record& r = records[order[i]];
+        cells_[i] = cells[order[i]];
+        offsets_[i] = r.offset;
+        lat_[i] = r.latitude * kRadians;
+        lon_[i] = r.longitude * kRadians;
+    }
+}
+
+void GeoIndex::near(double latitude, double longitude, double radiusKm, vector<Hit>& out,
+                    QueryStats& stats) const {
+    out.clear();
+    stats.ranges = stats.candidates = 0;
+    if (cells_.empty() || !(radiusKm >= 0)) return;
+
+    // ---- 1) Box(es) around the circle, in grid cells --------------------------
+    const double angle = radiusKm / kEarthRadiusKm;
+    const double dLat = angle / kRadians;
+    const double latLo = latitude - dLat, latHi = latitude + dLat;
+    struct Box {
+        uint32_t x0, x1, y0, y1;
+    };
+    vector<Box> boxes;
+    const uint32_t y0 = gridY(latLo), y1 = gridY(latHi);
+    const double reach = sin(min(angle, kPi / 2));
+    if (latLo <= -90.0 || latHi >= 90.0 || angle >= kPi / 2 ||
+        reach >= cos(latitude * kRadians)) {
+        boxes.push_back(Box{0, kGrid - 1, y0, y1});
+    } else {
+        // Widest longitude offset of the circle (at the latitude of its tangents).
+        const double dLon = asin(reach / cos(latitude * kRadians)) / kRadians;
+        const double lonLo = longitude - dLon, lonHi = longitude + dLon;
+        if (lonLo < -180.0) {
+            boxes.push_back(Box{gridX(lonLo + 360.0), kGrid - 1, y0, y1});
+            boxes.push_back(Box{0, gridX(lonHi), y0, y1});
+        } else if (lonHi > 180.0) {
+            boxes.push_back(Box{gridX(lonLo), kGrid - 1, y0, y1});
+            boxes.push_back(Box{0, gridX(lonHi - 360.0), y0, y1});
+        } else {
+            boxes.push_back(Box{gridX(lonLo), gridX(lonHi), y0, y1});
+        }
+    }
+
+    // ---- 2) Smallest blocks that need at most kMaxCoverCells ------------------
+    unsigned k = 0;
+    for (; k < kLevel; k++) {
+        size_t blocks = 0;
+        for (const Box& b : boxes)
+            blocks += static_cast<size_t>((b.x1 >> k) - (b.x0 >> k) + 1) *
+                      ((b.y1 >> k) - (b.y0 >> k) + 1);
+        if (blocks <= kMaxCoverCells) break;
+    }
+    vector<pair<uint64_t, uint64_t>> ranges;
+    const uint64_t span = 1ULL << (2 * k);
+    for (const Box& b : boxes) {
+        for (uint32_t bx = b.x0 >> k; bx <= (b.x1 >> k); bx++) {
+            for (uint32_t by = b.y0 >> k; by <= (b.y1 >> k); by++) {
+                const uint64_t first = hilbert(bx << k, by << k) & ~(span - 1);
+                ranges.emplace_back(first, first + span);
+            }
+        }
+    }
+    sort(ranges.begin(), ranges.end());
+    size_t merged = 0;
+    for (size_t i = 1; i < ranges.size(); i++) {
+        if (ranges[i].first <= ranges[merged].second)
+            ranges[merged].second = max(ranges[merged].second, ranges[i].second);
+        else
+            ranges[++merged] = ranges[i];
+    }
+    ranges.resize(merged + 1);
+    stats.ranges = ranges.size();
+
+    // ---- 3) + 4) Scan each range, keep the points within the radius -----------
+    const double lat = latitude * kRadians, lon = longitude * kRadians;
+    vector<double> distances;
+    for (const auto& r : ranges) {
+        const size_t i = lower_bound(cells_.begin(), cells_.end(), r.first,
+                                     [](uint32_t c, uint64_t v) { return c < v; }) -
+                         cells_.begin();
+        const size_t j = lower_bound(cells_.begin() + i, cells_.end(), r.second,
+                                     [](uint32_t c, uint64_t v) { return c < v; }) -
+                         cells_.begin();
+        if (i == j) continue;
+        stats.candidates += j - i;
+        distances.resize(j - i);
+        haversineBatch(lat_.data() + i, lon_.data() + i, j - i, lat, lon, kEarthRadiusKm,
+                       distances.data());
+        for (size_t t = 0; t < j - i; t++) {
+            if (distances[t] <= radiusKm) out.push_back(Hit{offsets_[i + t], distances[t]});
+        }
+    }
+    sort(out.begin(), out.end(), [](const Hit& a, const Hit& b) {
+        return a.distanceKm != b.distanceKm ? a.distanceKm < b.distanceKm : a.offset < b.offset;
+    });
+}
+
+void GeoIndex::nearest(double latitude, double longitude, size_t k, vector<Hit>& out,
+                       QueryStats& stats) const {
+    out.clear();
+    stats.ranges = stats.candidates = 0;
+    if (k == 0 || cells_.empty()) return;
+
+    // Every record within the radius is found, so once there are k the
+    // first k are the k nearest. Half the circumference reaches everything.
+    const double farthest = kPi * kEarthRadiusKm;
+    for (double radius = kNearestStartKm;; radius *= 4) {
+        QueryStats step;
+        near(latitude, longitude, min(radius, farthest), out, step);
+        stats.ranges += step.ranges;
+        stats.candidates += step.candidates;
+        if (out.size() >= k || radius >= farthest) break;
+    }
+    if (out.size() > k) out.resize(k);
+}
+
+size_t GeoIndex::sizeBytes() const {
+    return cells_.size() * (sizeof(uint32_t) + sizeof(uint64_t) + 2 * sizeof(double));
+}
+
+bool GeoIndex::save(const string& path, unsigned long long generation, long long lastSeq,
+                    size_t liveRecords) const {
+    string tmp = tempPathFor(path);
+    {
+        ofstream out(tmp, ios::binary);
+        if (!out) return false;
+        uint64_t gen = generation;
+        int64_t seq = lastSeq;
+        uint64_t live = liveRecords;
+        out.write(kGeoMagic, sizeof(kGeoMagic));
+        out.write(reinterpret_cast<const char*>(&gen), sizeof(gen));
+        out.write(reinterpret_cast<const char*>(&seq), sizeof(seq));
+        out.write(reinterpret_cast<const char*>(&live), sizeof(live));
+        writeArray(out, cells_);
+        writeArray(out, offsets_);
+        writeArray(out, lat_);
+        writeArray(out, lon_);
+        if (!out) {
+            out.close();
+            discardTemp(tmp);
+            return false;
+        }
+    }
+    if (!publishFile(tmp, path)) {
+        discardTemp(tmp);
+        return false;
+    }
+    return true;
+}
+
+bool GeoIndex::load(const string& path, unsigned long long generation, long long lastSeq,
+                    size_t liveRecords) {
+    cells_.clear();
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+
+    char magic[sizeof(kGeoMagic)];
+    uint64_t gen = 0, live = 0;
+    int64_t seq = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&gen), sizeof(gen));
+    in.read(reinterpret_cast<char*>(&seq), sizeof(seq));
+    in.read(reinterpret_cast<char*>(&live), sizeof(live));
+    if (!in || memcmp(magic, kGeoMagic, sizeof(magic)) != 0 || gen != generation ||
+        seq != lastSeq || live != liveRecords)
+        return false;
+
+    // One entry per live record, in every array.
+    vector<uint32_t> cells;
+    vector<uint64_t> offsets;
+    vector<double> lat, lon;
+    if (!readArray(in, cells, live) || !readArray(in, offsets, live) ||
+        !readArray(in, lat, live) || !readArray(in, lon, live) ||
+        !is_sorted(cells.begin(), cells.end()))
+        return false;
+
+    cells_ = std::move(cells);
+    offsets_ = std::move(offsets);
+    lat_ = std::move(lat);
+    lon_ = std::move(lon);
+    return true;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file GeoIndex.h
+ * @brief Cell index over record coordinates, for "ZIPs within R km of a
+ *        point".
+ * @date October 2026
+ *
+ * The globe is cut into a 65536 x 65536 grid of latitude / longitude
+ * cells, and each cell is numbered along a Hilbert curve. Along that curve,
+ * cells that are close in number are close on the map, and every square
+ * block of 2^k x 2^k cells (aligned to its size) is one range of numbers.
+ * The index is the records sorted by the number of their cell.
+ *
+ * A radius query:
+ * 1) takes the latitude / longitude box around the circle (the whole
+ *    longitude range near a pole, two boxes across the date line)
+ * 2) picks the finest block size at which the box spans at most
+ *    kMaxCoverCells blocks, and turns each block into its range of cell
+ *    numbers; neighbouring ranges are merged
+ * 3) finds each range with a binary search and takes the records in it
+ *    as candidates
+ * 4) keeps the candidates within the radius
+ *
+ * For step 4 the records' latitudes and longitudes (radians) are kept in
+ * two arrays in cell order, so the candidates of a range are contiguous
+ * and go to the SIMD haversine kernel (see GeoKernel.h) in one call.
+ *
+ * A nearest-k query is a radius query that grows (x4 from kNearestStartKm)
+ * until it finds at least k records.
+ *
+ * File "<index file>.geo" (binary, native byte order):
+ *   "GEOIDX2\0" | u64 generation | u64 last sequence | u64 live records |
+ *   u64 count + array, for: cells (u32), offsets (u64), latitudes,
+ *   longitudes (f64, radians)
+ *
+ * --build-index writes it next to the index. It is stamped like the other
+ * sidecars built from a pair's live records (see PlaceTrie.h), and --near
+ * rebuilds it when the pair has changed since.
+ */
+#ifndef GEOINDEX_H
+#define GEOINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class GeoIndex
+ * @brief Records sorted by Hilbert cell, with a radius query.
+ *
+ * Queries only read, so any number of threads may call near().
+ */
+class GeoIndex {
+public:
+    /// Grid cells per axis, as a power of two
+    static const unsigned kLevel = 16;
+
+    /// Most blocks a query box is covered with
+    static const size_t kMaxCoverCells = 64;
+
+    /// Mean earth radius in km
+    static constexpr double kEarthRadiusKm = 6371.0088;
+
+    /// First radius a nearest-k query tries
+    static constexpr double kNearestStartKm = 10.0;
+
+    /// Position of one live record
+    struct Record {
+        double latitude;
+        double longitude;
+        uint64_t offset;
+    };
+
+    /// One answer of near()
+    struct Hit {
+        uint64_t offset;
+        double distanceKm;
+    };
+
+    /// What a query did
+    struct QueryStats {
+        size_t ranges;       ///< cell number ranges scanned
+        size_t candidates;   ///< records in those ranges
+    };
+
+    GeoIndex();
+
+    /**
+     * @brief Hilbert cell number of a coordinate.
+     * @param latitude Degrees, -90..90
+     * @param longitude Degrees, -180..180
+     */
+    static uint32_t cellOf(double latitude, double longitude);
+
+    /// Great-circle distance in km (haversine formula)
+    static double haversineKm(double lat1, double lon1, double lat2, double lon2);
+
+    /**
+     * @brief Builds the index, replacing any previous contents.
+     * @param records One entry per live record
+     */
+    void build(const std::vector<Record>& records);
+
+    /**
+     * @brief Records within a radius of a point, nearest first.
+     * @param latitude Center, degrees
+     * @param longitude Center, degrees
+     * @param radiusKm Radius in km
+     * @param out Receives the hits
+     * @param stats Receives the work done
+     */
+    void near(double latitude, double longitude, double radiusKm, std::vector<Hit>& out,
+              QueryStats& stats) const;
+
+    /**
+     * @brief The k records nearest to a point, nearest first.
+     * @param latitude Point, degrees
+     * @param longitude Point, degrees
+     * @param k Number of records (fewer if the index has fewer)
+     * @param out Receives the hits
+     * @param stats Receives the work done, over all radii tried
+     */
+    void nearest(double latitude, double longitude, size_t k, std::vector<Hit>& out,
+                 QueryStats& stats) const;
+
+    /**
+     * @brief Writes the index crash-safely (temp file + rename).
+     * @return true on success
+     */
+    bool save(const std::string& path, unsigned long long generation,
+              long long lastSeq, size_t liveRecords) const;
+
+    /**
+     * @brief Reads an index made for exactly this state of the data.
+     * @return false if missing, damaged, or stale (the index is then empty)
+     */
+    bool load(const std::string& path, unsigned long long generation,
+              long long lastSeq, size_t liveRecords);
+
+    size_t size() const { return cells_.size(); }
+
+    /// Size of all arrays in bytes
+    size_t sizeBytes() const;
+
+    /// The usual name for an index file's geo index
+    static std::string pathFor(const std::string& indexFile) {
+        return indexFile + ".geo";
+    }
+
+private:
+    std::vector<uint32_t> cells_;     ///< sorted
+    std::vector<uint64_t> offsets_;
+    std::vector<double> lat_, lon_;   ///< radians, same order
+};
+
+#endif
@@ -0,0 +1,330 @@
+/**
+ * @file GeoKernel.cpp
+ * @brief Scalar, AVX2 and AVX-512 distance kernels.
+ * @date October 2026
+ *
+ * The three versions do the same operations in the same order; only the
+ * width differs. The rounding trick below needs no float -> int vector
+ * conversion, which AVX2 lacks for 64-bit lanes.
+ */
+#include "GeoKernel.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define GEO_HAVE_X86 1
+#endif
+
+using namespace std;
+
+static const double kPi = 3.14159265358979323846;
+static const double kInvPi = 1.0 / kPi;
+// pi in two parts, so r = x - k * pi stays exact for the k we see.
+static const double kPiHi = 3.141592653589793116;
+static const double kPiLo = 1.2246467991473532e-16;
+// Adding 1.5 * 2^52 rounds to an integer and leaves it in the low bits.
+static const double kRoundMagic = 6755399441055744.0;
+
+/// Taylor coefficients of sin r / r in r^2, from r^2 up to r^14
+static const double kSin[7] = {
+    -1.0 / 6, 1.0 / 120, -1.0 / 5040, 1.0 / 362880, -1.0 / 39916800,
+    1.0 / 6227020800.0, -1.0 / 1307674368000.0};
+
+/// Taylor coefficients of asin s / s in s^2 (s^2 up to s^32)
+struct AsinCoefficients {
+    double c[16];
+    AsinCoefficients() {
+        // c_n = (2n)! / (4^n (n!)^2 (2n + 1))
+        double central = 1.0;   // (2n)! / (4^n (n!)^2)
+        for (int n = 1; n <= 16; n++) {
+            central *= (2.0 * n - 1) / (2.0 * n);
+            c[n - 1] = central / (2.0 * n + 1);
+        }
+    }
+};
+static const AsinCoefficients kAsin;
+
+// ---------------------------------------------------------------------------
+// Scalar
+// ---------------------------------------------------------------------------
+
+static double fastSin(double x) {
+    const double t = x * kInvPi + kRoundMagic;
+    const double k = t - kRoundMagic;
+    const double r = (x - k * kPiHi) - k * kPiLo;
+    const double r2 = r * r;
+    double p = kSin[6];
+    for (int i = 5; i >= 0; i--) p = p * r2 + kSin[i];
+    double s = r + r * r2 * p;
+
+    // Odd k: flip the sign (k's low bit is the low mantissa bit of t).
+    uint64_t tb, sb;
+    memcpy(&tb, &t, sizeof(tb));
+    memcpy(&sb, &s, sizeof(sb));
+    sb ^= tb << 63;
+    memcpy(&s, &sb, sizeof(s));
+    return s;
+}
+
+static double fastAsin(double s) {
+    const bool high = s > 0.5;
+    const double z = high ? sqrt((1.0 - s) * 0.5) : s;
+    const double z2 = z * z;
+    double p = kAsin.c[15];
+    for (int i = 14; i >= 0; i--) p = p * z2 + kAsin.c[i];
+    const double a = z + z * z2 * p;
+    return high ? kPi / 2 - 2 * a : a;
+}
+
+static void haversineScalar(const double* lat, const double* lon, size_t n, double qLat,
+                            double qLon, double radius, double* out) {
+    const double cq = fastSin(qLat + kPi / 2);
+    for (size_t i = 0; i < n; i++) {
+        const double s1 = fastSin((lat[i] - qLat) * 0.5);
+        const double s2 = fastSin((lon[i] - qLon) * 0.5);
+        const double c1 = fastSin(lat[i] + kPi / 2);
+        double a = s1 * s1 + cq * c1 * s2 * s2;
+        a = a < 1.0 ? a : 1.0;
+        out[i] = 2 * radius * fastAsin(sqrt(a));
+    }
+}
+
+static void equirectangularScalar(const double* lat, const double* lon, size_t n,
+                                  double qLat, double qLon, double radius, double* out) {
+    for (size_t i = 0; i < n; i++) {
+        double dLon = lon[i] - qLon;
+        // Across the date line the short way round.
+        dLon -= 2 * kPi * ((dLon * (0.5 * kInvPi) + kRoundMagic) - kRoundMagic);
+        const double x = dLon * fastSin((lat[i] + qLat) * 0.5 + kPi / 2);
+        const double y = lat[i] - qLat;
+        out[i] = radius * sqrt(x * x + y * y);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 (+ FMA), 4 lanes
+// ---------------------------------------------------------------------------
+
+#ifdef GEO_HAVE_X86
+__attribute__((target("avx2,fma")))
+static inline __m256d sin4(__m256d x) {
+    const __m256d magic = _mm256_set1_pd(kRoundMagic);
+    const __m256d t = _mm256_fmadd_pd(x, _mm256_set1_pd(kInvPi), magic);
+    const __m256d k = _mm256_sub_pd(t, magic);
+    __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(kPiHi), x);
+    r = _mm256_fnmadd_pd(k, _mm256_set1_pd(kPiLo), r);
+    const __m256d r2 = _mm256_mul_pd(r, r);
+    __m256d p = _mm256_set1_pd(kSin[6]);
+    for (int i = 5; i >= 0; i--) p = _mm256_fmadd_pd(p, r2, _mm256_set1_pd(kSin[i]));
+    const __m256d s = _mm256_fmadd_pd(_mm256_mul_pd(r, r2), p, r);
+    const __m256i sign = _mm256_slli_epi64(_mm256_castpd_si256(t), 63);
+    return _mm256_xor_pd(s, _mm256_castsi256_pd(sign));
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256d asin4(__m256d s) {
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d high = _mm256_cmp_pd(s, half, _CMP_GT_OQ);
+    const __m256d folded = _mm256_sqrt_pd(_mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(1.0), s), half));
+    const __m256d z = _mm256_blendv_pd(s, folded, high);
+    const __m256d z2 = _mm256_mul_pd(z, z);
+    __m256d p = _mm256_set1_pd(kAsin.c[15]);
+    for (int i = 14; i >= 0; i--) p = _mm256_fmadd_pd(p, z2, _mm256_set1_pd(kAsin.c[i]));
+    const __m256d a = _mm256_fmadd_pd(_mm256_mul_pd(z, z2), p, z);
+    const __m256d unfolded = _mm256_fnmadd_pd(_mm256_set1_pd(2.0), a, _mm256_set1_pd(kPi / 2));
+    return _mm256_blendv_pd(a, unfolded, high);
+}
+
+__attribute__((target("avx2,fma")))
+static void haversineAvx2(const double* lat, const double* lon, size_t n, double qLat,
+                          double qLon, double radius, double* out) {
+    const __m256d vqLat = _mm256_set1_pd(qLat), vqLon = _mm256_set1_pd(qLon);
+    const __m256d half = _mm256_set1_pd(0.5), quarter = _mm256_set1_pd(kPi / 2);
+    const __m256d cq = _mm256_set1_pd(fastSin(qLat + kPi / 2));
+    const __m256d one = _mm256_set1_pd(1.0), scale = _mm256_set1_pd(2 * radius);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d la = _mm256_loadu_pd(lat + i), lo = _mm256_loadu_pd(lon + i);
+        const __m256d s1 = sin4(_mm256_mul_pd(_mm256_sub_pd(la, vqLat), half));
+        const __m256d s2 = sin4(_mm256_mul_pd(_mm256_sub_pd(lo, vqLon), half));
+        const __m256d c1 = sin4(_mm256_add_pd(la, quarter));
+        __m256d a = _mm256_fmadd_pd(_mm256_mul_pd(cq, c1), _mm256_mul_pd(s2, s2),
+                                    _mm256_mul_pd(s1, s1));
+        a = _mm256_min_pd(a, one);
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(scale, asin4(_mm256_sqrt_pd(a))));
+    }
+    haversineScalar(lat + i, lon + i, n - i, qLat, qLon, radius, out + i);
+}
+
+__attribute__((target("avx2,fma")))
+static void equirectangularAvx2(const double* lat, const double* lon, size_t n, double qLat,
+                                double qLon, double radius, double* out) {
+    const __m256d vqLat = _mm256_set1_pd(qLat), vqLon = _mm256_set1_pd(qLon);
+    const __m256d half = _mm256_set1_pd(0.5), quarter = _mm256_set1_pd(kPi / 2);
+    const __m256d magic = _mm256_set1_pd(kRoundMagic);
+    const __m256d turn = _mm256_set1_pd(2 * kPi), perTurn = _mm256_set1_pd(0.5 * kInvPi);
+    const __m256d vr = _mm256_set1_pd(radius);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d la = _mm256_loadu_pd(lat + i);
+        __m256d dLon = _mm256_sub_pd(_mm256_loadu_pd(lon + i), vqLon);
+        const __m256d turns = _mm256_sub_pd(_mm256_fmadd_pd(dLon, perTurn, magic), magic);
+        dLon = _mm256_fnmadd_pd(turns, turn, dLon);
+        const __m256d c = sin4(_mm256_fmadd_pd(_mm256_add_pd(la, vqLat), half, quarter));
+        const __m256d x = _mm256_mul_pd(dLon, c);
+        const __m256d y = _mm256_sub_pd(la, vqLat);
+        const __m256d d2 = _mm256_fmadd_pd(x, x, _mm256_mul_pd(y, y));
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(vr, _mm256_sqrt_pd(d2)));
+    }
+    equirectangularScalar(lat + i, lon + i, n - i, qLat, qLon, radius, out + i);
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512, 8 lanes
+// ---------------------------------------------------------------------------
+
+// GCC 12 warns about the placeholder inside its own unmasked AVX-512
+// intrinsics (_mm512_undefined_*); the value is never used.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f")))
+static inline __m512d sin8(__m512d x) {
+    const __m512d magic = _mm512_set1_pd(kRoundMagic);
+    const __m512d t = _mm512_fmadd_pd(x, _mm512_set1_pd(kInvPi), magic);
+    const __m512d k = _mm512_sub_pd(t, magic);
+    __m512d r = _mm512_fnmadd_pd(k, _mm512_set1_pd(kPiHi), x);
+    r = _mm512_fnmadd_pd(k, _mm512_set1_pd(kPiLo), r);
+    const __m512d r2 = _mm512_mul_pd(r, r);
+    __m512d p = _mm512_set1_pd(kSin[6]);
+    for (int i = 5; i >= 0; i--) p = _mm512_fmadd_pd(p, r2, _mm512_set1_pd(kSin[i]));
+    const __m512d s = _mm512_fmadd_pd(_mm512_mul_pd(r, r2), p, r);
+    const __m512i sign = _mm512_slli_epi64(_mm512_castpd_si512(t), 63);
+    return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(s), sign));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d asin8(__m512d s) {
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __mmask8 high = _mm512_cmp_pd_mask(s, half, _CMP_GT_OQ);
+    const __m512d folded = _mm512_sqrt_pd(_mm512_mul_pd(_mm512_sub_pd(_mm512_set1_pd(1.0), s), half));
+    const __m512d z = _mm512_mask_blend_pd(high, s, folded);
+    const __m512d z2 = _mm512_mul_pd(z, z);
+    __m512d p = _mm512_set1_pd(kAsin.c[15]);
+    for (int i = 14; i >= 0; i--) p = _mm512_fmadd_pd(p, z2, _mm512_set1_pd(kAsin.c[i]));
+    const __m512d a = _mm512_fmadd_pd(_mm512_mul_pd(z, z2), p, z);
+    const __m512d unfolded = _mm512_fnmadd_pd(_mm512_set1_pd(2.0), a, _mm512_set1_pd(kPi / 2));
+    return _mm512_mask_blend_pd(high, a, unfolded);
+}
+
+__attribute__((target("avx512f")))
+static void haversineAvx512(const double* lat, const double* lon, size_t n, double qLat,
+                            double qLon, double radius, double* out) {
+    const __m512d vqLat = _mm512_set1_pd(qLat), vqLon = _mm512_set1_pd(qLon);
+    const __m512d half = _mm512_set1_pd(0.5), quarter = _mm512_set1_pd(kPi / 2);
+    const __m512d cq = _mm512_set1_pd(fastSin(qLat + kPi / 2));
+    const __m512d one = _mm512_set1_pd(1.0), scale = _mm512_set1_pd(2 * radius);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512d la = _mm512_loadu_pd(lat + i), lo = _mm512_loadu_pd(lon + i);
+        const __m512d s1 = sin8(_mm512_mul_pd(_mm512_sub_pd(la, vqLat), half));
+        const __m512d s2 = sin8(_mm512_mul_pd(_mm512_sub_pd(lo, vqLon), half));
+        const __m512d c1 = sin8(_mm512_add_pd(la, quarter));
+        __m512d a = _mm512_fmadd_pd(_mm512_mul_pd(cq, c1), _mm512_mul_pd(s2, s2),
+                                    _mm512_mul_pd(s1, s1));
+        a = _mm512_min_pd(a, one);
+        _mm512_storeu_pd(out + i, _mm512_mul_pd(scale, asin8(_mm512_sqrt_pd(a))));
+    }
+    haversineScalar(lat + i, lon + i, n - i, qLat, qLon, radius, out + i);
+}
+
+__attribute__((target("avx512f")))
+static void equirectangularAvx512(const double* lat, const double* lon, size_t n,
+                                  double qLat, double qLon, double radius, double* out) {
+    const __m512d vqLat = _mm512_set1_pd(qLat), vqLon = _mm512_set1_pd(qLon);
+    const __m512d half = _mm512_set1_pd(0.5), quarter = _mm512_set1_pd(kPi / 2);
+    const __m512d magic = _mm512_set1_pd(kRoundMagic);
+    const __m512d turn = _mm512_set1_pd(2 * kPi), perTurn = _mm512_set1_pd(0.5 * kInvPi);
+    const __m512d vr = _mm512_set1_pd(radius);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512d la = _mm512_loadu_pd(lat + i);
+        __m512d dLon = _mm512_sub_pd(_mm512_loadu_pd(lon + i), vqLon);
+        const __m512d turns = _mm512_sub_pd(_mm512_fmadd_pd(dLon, perTurn, magic), magic);
+        dLon = _mm512_fnmadd_pd(turns, turn, dLon);
+        const __m512d c = sin8(_mm512_fmadd_pd(_mm512_add_pd(la, vqLat), half, quarter));
+        const __m512d x = _mm512_mul_pd(dLon, c);
+        const __m512d y = _mm512_sub_pd(la, vqLat);
+        const __m512d d2 = _mm512_fmadd_pd(x, x, _mm512_mul_pd(y, y));
+        _mm512_storeu_pd(out + i, _mm512_mul_pd(vr, _mm512_sqrt_pd(d2)));
+    }
+    equirectangularScalar(lat + i, lon + i, n - i, qLat, qLon, radius, out + i);
+}
+#pragma GCC diagnostic pop
+#endif
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+bool geoKernelSupported(GeoIsa isa) {
+#ifdef GEO_HAVE_X86
+    static const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    static const bool avx512 = __builtin_cpu_supports("avx512f");
+    if (isa == GeoIsa::kAvx2) return avx2;
+    if (isa == GeoIsa::kAvx512) return avx512;
+#else
+    if (isa != GeoIsa::kScalar) return false;
+#endif
+    return true;
+}
+
+GeoIsa geoKernelIsa() {
+    static const GeoIsa best = geoKernelSupported(GeoIsa::kAvx512) ? GeoIsa::kAvx512
+                               : geoKernelSupported(GeoIsa::kAvx2) ? GeoIsa::kAvx2
+                                                                   : GeoIsa::kScalar;
+    return best;
+}
+
+const char* geoIsaName(GeoIsa isa) {
+    switch (isa) {
+    case GeoIsa::kAvx2: return "AVX2";
+    case GeoIsa::kAvx512: return "AVX-512";
+    default: return "scalar";
+    }
+}
+
+void haversineBatch(const double* lat, const double* lon, size_t n, double qLat,
+                    double qLon, double radius, double* out, GeoIsa isa) {
+#ifdef GEO_HAVE_X86
+    if (isa == GeoIsa::kAvx512) {
+        haversineAvx512(lat, lon, n, qLat, qLon, radius, out);
+        return;
+    }
+    if (isa == GeoIsa::kAvx2) {
+        haversineAvx2(lat, lon, n, qLat, qLon, radius, out);
+        return;
+    }
+#endif
+    (void)isa;
+    haversineScalar(lat, lon, n, qLat, qLon, radius, out);
+}
+
+void equirectangularBatch(const double* lat, const double* lon, size_t n, double qLat,
+                          double qLon, double radius, double* out, GeoIsa isa) {
+#ifdef GEO_HAVE_X86
+    if (isa == GeoIsa::kAvx512) {
+        equirectangularAvx512(lat, lon, n, qLat, qLon, radius, out);
+        return;
+    }
+    if (isa == GeoIsa::kAvx2) {
+        equirectangularAvx2(lat, lon, n, qLat, qLon, radius, out);
+        return;
+    }
+#endif
+    (void)isa;
+    equirectangularScalar(lat, lon, n, qLat, qLon, radius, out);
+}
@@ -0,0 +1,71 @@
+/**
+ * @file GeoKernel.h
+ * @brief Distances from one point to many, over separate latitude and
+ *        longitude arrays, with AVX2 / AVX-512 and a scalar fallback.
+ * @date October 2026
+ *
+ * Radius and nearest-ZIP queries (see GeoIndex.h) end with "how far is
+ * each of these candidates from the query point". The candidates' latitudes
+ * and longitudes are kept in two plain arrays (struct of arrays), so a
+ * vector register holds 4 (AVX2) or 8 (AVX-512) of them and the whole
+ * formula runs on all lanes at once.
+ *
+ * libm's sin, cos and asin are scalar calls, which would undo that, so the
+ * kernels use their own polynomials:
+ * - sin(x): x is reduced to r in [-pi/2, pi/2] by a multiple k of pi
+ *   (sin x = (-1)^k sin r), then the Taylor series up to r^15. The
+ *   truncation error is below (pi/2)^17 / 17! = 6.1e-12.
+ * - cos(x) = sin(x + pi/2).
+ * - asin(s) for s in [0, 1]: the Taylor series up to s^33 for s <= 1/2,
+ *   and asin(s) = pi/2 - 2 asin(sqrt((1 - s) / 2)) above, so the series
+ *   is never used past 1/2. The truncation error is below 1e-12.
+ * Up to 1000 km, distances are within a few micrometers of the libm
+ * result. Towards the antipode asin(sqrt(a)) turns the last bit of a into
+ * up to 0.1 m, in libm as well. The scalar fallback uses the same
+ * polynomials, so every CPU gives the same answers to the last few bits.
+ * --bench-geo measures the error.
+ *
+ * All angles are in radians.
+ */
+#ifndef GEOKERNEL_H
+#define GEOKERNEL_H
+
+#include <cstddef>
+
+/// Instruction sets the kernels are written for
+enum class GeoIsa { kScalar, kAvx2, kAvx512 };
+
+/// The best instruction set this CPU supports
+GeoIsa geoKernelIsa();
+
+/// true if this CPU can run kernels for isa
+bool geoKernelSupported(GeoIsa isa);
+
+/// Name of an instruction set, for output
+const char* geoIsaName(GeoIsa isa);
+
+/**
+ * @brief Great-circle (haversine) distances from one point.
+ * @param lat Latitudes (radians)
+ * @param lon Longitudes (radians)
+ * @param n Number of points
+ * @param qLat Query latitude (radians)
+ * @param qLon Query longitude (radians)
+ * @param radius Sphere radius; the distances come out in its unit
+ * @param out Receives n distances
+ * @param isa Kernel to use (must be supported)
+ */
+void haversineBatch(const double* lat, const double* lon, size_t n, double qLat,
+                    double qLon, double radius, double* out, GeoIsa isa = geoKernelIsa());
+
+/**
+ * @brief Equirectangular distances from one point: the cheaper flat-earth
+ *        approximation, close to haversine for points a few hundred km apart.
+ *
+ * Same parameters as haversineBatch().
+ */
+void equirectangularBatch(const double* lat, const double* lon, size_t n, double qLat,
+                          double qLon, double radius, double* out,
+                          GeoIsa isa = geoKernelIsa());
+
+#endif
@@ -11,6 +11,10 @@
 #include <iostream>
 #include <iomanip>
 #include <cctype>
+#include <chrono>
+#include <random>
+#include <cerrno>
+#include <cstdlib>
 
 using namespace std;
 
@@ -29,25 +33,128 @@ HeaderBuffer::HeaderBuffer() {}
  *
  * @param indexFileName Name of the primary key index file.
  * @param recordCount Number of records stored in the data file.
+ * @param generation Id written into both the data file and its index.
+ * @param checksumType "none" or "crc32c" (records followed by a CRC32C).
  */
 
-void HeaderBuffer::buildDefault(const string& indexFileName, long recordCount) {
+void HeaderBuffer::buildDefault(const string& indexFileName, long recordCount,
+                                unsigned long long generation,
+                                const string& checksumType) {
     header_.fileType = "ZipLenFile";
-    header_.version = 2;
+    header_.version = 4;
     header_.recordSizeByteCount = 22; //minimum record size (State is 2 chars)
     header_.sizeFormatType = 'A';
     header_.sizeOfSizes = 10; //10 digits in ASCII
     header_.sizeIncludesItself = true; //based on how header size is calculated
     header_.indexFileName = indexFileName;
     header_.recordCount = recordCount;
+    header_.generation = generation;
+    header_.checksumType = checksumType;
     header_.primaryKeyFieldIndex = 0;
     header_.staleIndex = false;
     header_.fieldNames = {"ZipCode", "PlaceName", "State", "County", //continued
-                          "Longitude", "Latitude"};
-    header_.fieldTypes = {"int","string","string","string","double","double"}
+                          "Latitude", "Longitude"};
+    header_.fieldTypes = {"int","string","string","string","double","double"};
     header_.fieldCount = (int)header_.fieldNames.size();
     header_.headerSizeBytes = (int)serialize().size();
 }
+/**
+ * @brief Parses header text that the caller already read from a file.
+ *
+ * Useful when the caller reads the header record with its own
+ * length-indicated reader and only needs the parsed fields.
+ *
+ * @param text Header record text (starting with "HDR").
+ * @return True if the header was successfully parsed.
+ */
+bool HeaderBuffer::parse(const string& text) {
+    return deserialize(text);
+}
+
+/**
+ * @brief Tells whether records in this file carry a CRC32C.
+ * @return True if the checksum type is "crc32c".
+ */
+bool HeaderBuffer::hasChecksum() const {
+    return header_.checksumType == "crc32c";
+}
+
+/**
+ * @brief Makes a new generation id for a freshly written data file.
+ *
+ * The id only has to differ between two builds of the same file, so a
+ * random value mixed with the current time is enough. Zero is reserved
+ * for "no generation" (files written before version 3).
+ *
+ * @return Nonzero generation id.
+ */
+unsigned long long HeaderBuffer::newGeneration() {
+    random_device rd;
+    unsigned long long g = (static_cast<unsigned long long>(rd()) << 32) ^ rd();
+    g ^= static_cast<unsigned long long>(
+        chrono::steady_clock::now().time_since_epoch().count());
+    return g == 0 ? 1 : g;
+}
+
+/**
+ * @brief Formats a generation id as exactly 16 hex digits.
+ *
+ * The fixed width keeps the header size the same no matter which id is
+ * stored, so the header can be rewritten in place.
+ *
+ * @param generation Generation id.
+ * @return 16-character hex string.
+ */
+string HeaderBuffer::generationText(unsigned long long generation) {
+    ostringstream ss;
+    ss << hex << setw(16) << setfill('0') << generation;
+    return ss.str();
+}
+
+/**
+ * @brief Parses a generation id written by generationText().
+ * @param text Hex text.
+ * @return Generation id, or 0 if the text is not valid hex.
+ */
+unsigned long long HeaderBuffer::parseGeneration(const string& text) {
+    if (text.empty() || text.size() > 16) return 0;
+    for (char c : text)
+        if (!isxdigit(static_cast<unsigned char>(c))) return 0;
+    return stoull(text, nullptr, 16);
+}
+
+/**
+ * @brief Parses a header number field without throwing.
+ *
+ * A damaged header must make deserialize() fail, not abort the program,
+ * so the whole field has to be one number.
+ *
+ * @param text Field text.
+ * @param value Receives the number.
+ * @return True if text is one whole number that fits in a long.
+ */
+static bool parseWhole(const string& text, long& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    value = strtol(text.c_str(), &end, 10);
+    return *end == '\0' && errno == 0;
+}
+
+/**
+ * @brief Tells an old header that parse() cannot read from a damaged one.
+ *
+ * Version 1 files wrote each field as "Name:type" (or no field list at
+ * all). Their records are still readable; only the header is not checked.
+ *
+ * @param text Header record text.
+ * @return True if text starts "HDR,ZipLenFile,1," or "HDR,ZipLenFile,2,".
+ */
+bool HeaderBuffer::isOldFormat(const string& text) {
+    return text.rfind("HDR,ZipLenFile,1,", 0) == 0 ||
+           text.rfind("HDR,ZipLenFile,2,", 0) == 0;
+}
+
 /**
  * @brief Retrieves the current file header.
  *
@@ -96,11 +203,13 @@ void HeaderBuffer::print() const {
     cout<<"Size counts itself: "<<(header_.sizeIncludesItself?"yes":"no")<<"\n";
     cout << "Index file:\t    " << header_.indexFileName << "\n";
     cout << "Record count:\t    " << header_.recordCount << "\n";
+    cout << "Generation:\t    " << generationText(header_.generation) << "\n";
+    cout << "Checksum:\t    " << header_.checksumType << "\n";
     cout << "Field count:\t    " << header_.fieldCount << "\n";
     cout << "Primary key field:  " << header_.primaryKeyFieldIndex << "\n";
     cout << "Stale index:\t    " << (header_.staleIndex ? "yes" : "no") << "\n";
     for (int i = 0; i < (int)header_.fieldCount; i++) {
-        cout << "Field[" << i << "]:\t    " << header_.fieldNames[i];
+        cout << "Field[" << i << "]:\t    " << header_.fieldNames[i]
              << " (" << header_.fieldTypes[i] << ")\n";
     }
 }
@@ -109,7 +218,12 @@ void HeaderBuffer::print() const {
  *
  * The serialized string begins with the identifier "HDR" followed
  * by all metadata values and field definitions.
- * 
+ *
+ * The record count is written as 10 fixed digits and the generation as
+ * 16 hex digits. The header is written once before the records (count
+ * still unknown) and rewritten in place afterwards, so its size must not
+ * depend on those values.
+ *
  * @return Serialized header string.
  */
 string HeaderBuffer::serialize() const {
@@ -122,10 +236,12 @@ string HeaderBuffer::serialize() const {
        << "," << header_.sizeOfSizes
        << "," << (header_.sizeIncludesItself ? "1" : "0")
        << "," << header_.indexFileName
-       << "," << header_.recordCount
+       << "," << setw(10) << setfill('0') << header_.recordCount
        << "," << header_.fieldCount
        << "," << header_.primaryKeyFieldIndex
-       << "," << (header_.staleIndex ? "1" : "0");
+       << "," << (header_.staleIndex ? "1" : "0")
+       << "," << generationText(header_.generation)
+       << "," << header_.checksumType;
     for (const string& f : header_.fieldNames)
         ss << "," << f;
     for (const string& f : header_.fieldTypes)
@@ -138,6 +254,11 @@ string HeaderBuffer::serialize() const {
  * Parses the comma separated metadata and reconstructs the
  * FileHeader structure including field descriptors.
  *
+ * Version 3 headers carry the generation id right after the stale index
+ * flag, and version 4 adds the checksum type after it. Older headers have
+ * no generation (reported as 0) and no checksums ("none").
+ * A number field that is not a number makes the parse fail.
+ *
  * @param s Serialized header string.
  * @return True if the header was successfully parsed.
  */
@@ -146,24 +267,38 @@ bool HeaderBuffer::deserialize(const string& s) {
     string tok;
     vector<string> parts;
     while (getline(ss, tok, ',')) parts.push_back(tok);
-    if (parts.size() < 14 || (parts.size() % 2 == 1)) return false;
+    if (parts.size() < 14) return false;
     if (parts[0] != "HDR") return false;
+    long version, recordSize, sizeOfSizes, recordCount, fieldCount, primaryKey;
+    if (!parseWhole(parts[2], version)) return false;
     header_.fileType             = parts[1];
-    header_.version              = stoi(parts[2]);
-    header_.recordSizeByteCount  = stoi(parts[3]);
-    header_.sizeFormatType       = parts[4].at(0);
-    header_.sizeOfSizes          = stoi(parts[5]);
+    header_.version              = static_cast<int>(version);
+    int fieldsStart = 12;
+    if (header_.version >= 3) fieldsStart = 13;
+    if (header_.version >= 4) fieldsStart = 14;
+    if ((int)parts.size() < fieldsStart) return false;
+    if (!parseWhole(parts[3], recordSize) || parts[4].empty() ||
+        !parseWhole(parts[5], sizeOfSizes) || !parseWhole(parts[8], recordCount) ||
+        !parseWhole(parts[9], fieldCount) || !parseWhole(parts[10], primaryKey))
+        return false;
+    if (fieldCount < 0 || fieldCount > (long)parts.size()) return false;
+    header_.recordSizeByteCount  = static_cast<int>(recordSize);
+    header_.sizeFormatType       = parts[4][0];
+    header_.sizeOfSizes          = static_cast<int>(sizeOfSizes);
     header_.sizeIncludesItself   = (parts[6] == "1");
     header_.indexFileName        = parts[7];
-    header_.recordCount          = stol(parts[8]);
-    header_.fieldCount           = stoi(parts[9]);
-    header_.primaryKeyFieldIndex = stoi(parts[10]);
+    header_.recordCount          = recordCount;
+    header_.fieldCount           = static_cast<int>(fieldCount);
+    header_.primaryKeyFieldIndex = static_cast<int>(primaryKey);
     header_.staleIndex           = (parts[11] == "1");
+    header_.generation           = (fieldsStart >= 13)
+                                   ? parseGeneration(parts[12]) : 0;
+    header_.checksumType         = (fieldsStart >= 14) ? parts[13] : "none";
     header_.fieldNames.clear();
     header_.fieldTypes.clear();
-    if (header_.fieldCount * 2 + 12 != parts.size()) return false;
-    int typesStart = header_.fieldCount + 12;
-    for (int i = 12; i < typesStart; i++)
+    if (header_.fieldCount * 2 + fieldsStart != (int)parts.size()) return false;
+    int typesStart = header_.fieldCount + fieldsStart;
+    for (int i = fieldsStart; i < typesStart; i++)
         header_.fieldNames.push_back(parts[i]);
     for (int i = typesStart; i < (int)parts.size(); i++)
         header_.fieldTypes.push_back(parts[i]);
@@ -198,7 +333,7 @@ bool HeaderBuffer::readLenLine(ifstream& in, string& text) {
         if (!isdigit((unsigned char)buf[i])) return false;
     char sp;
     if (!in.get(sp) || sp != ' ') return false;
-    int len = stoi(string(buf, 10));
+    long long len = stoll(string(buf, 10));
     text.resize(len);
     if (!in.read(&text[0], len)) return false;
     if (in.peek() == '\r') in.get();
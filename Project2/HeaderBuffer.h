@@ -23,13 +23,15 @@ struct FileHeader {
     bool sizeIncludesItself;  ///< true if size counts itself
     bool staleIndex;          ///< true if index may be out of date
     char sizeFormatType;      ///< 'A' for ASCII, 'b' for binary
-    int version;              ///< format version number, currently 2
+    int version;              ///< format version number, currently 4
     int sizeOfSizes;          ///< number of bytes used for record length
     int headerSizeBytes;      ///< size of header record in bytes
     int recordSizeByteCount;  ///< bytes used for each record size integer
     int fieldCount;           ///< number of fields in each record
     int primaryKeyFieldIndex; ///< 0-based index of the primary key field
     long recordCount;         ///< total number of data records
+    unsigned long long generation; ///< id shared with the matching .idx file
+    string checksumType;      ///< "none", or "crc32c" if records carry a CRC
     string fileType;          ///< name of file type, e.g. "ZipLenFile"
     string indexFileName;     ///< name of the .idx file
     vector<string> fieldNames;///< the names of every field, e.g. "PlaceName"
@@ -45,7 +47,9 @@ public:
     HeaderBuffer();
 
     /// Build a default header for the ZIP code file
-    void buildDefault(const string& indexFileName, long recordCount);
+    void buildDefault(const string& indexFileName, long recordCount,
+                      unsigned long long generation,
+                      const string& checksumType = "none");
 
     /// Write header to an open output stream
     bool write(ofstream& out);
@@ -53,12 +57,31 @@ public:
     /// Read header from an open input stream
     bool read(ifstream& in);
 
+    /// Parse header text that was already read as a length-indicated record
+    bool parse(const string& text);
+
+    /// true if every record is followed by a CRC32C
+    bool hasChecksum() const;
+
     /// Get the loaded header data
     const FileHeader& getHeader() const;
 
     /// Print header contents to cout
     void print() const;
 
+    /// Make a new (random, nonzero) generation id for a freshly written file
+    static unsigned long long newGeneration();
+
+    /// Format a generation id as 16 hex digits, as stored in .len and .idx
+    static string generationText(unsigned long long generation);
+
+    /// Parse 16 hex digits back into a generation id (0 if invalid)
+    static unsigned long long parseGeneration(const string& text);
+
+    /// true if text is a ZipLenFile header of version 1 or 2 in a form
+    /// parse() does not read (e.g. "Name:type" fields)
+    static bool isOldFormat(const string& text);
+
 private:
     FileHeader header_;
 
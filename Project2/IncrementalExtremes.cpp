@@ -0,0 +1,208 @@
+/**
+ * @file IncrementalExtremes.cpp
+ * @brief Implementation of the IncrementalExtremes class.
+ * @date October 2026
+ */
+#include "IncrementalExtremes.h"
+#include "AtomicFile.h"
+
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+using namespace std;
+
+static const char kExtMagic[8] = {'E', 'X', 'T', 'A', 'G', 'G', '1', 0};
+
+/// One point as stored in the file
+struct ExtEntry {
+    int32_t zip;
+    uint32_t state;
+    double latitude;
+    double longitude;
+};
+
+/// Writes a u64 count and the elements of a vector or string
+template <typename Array>
+static void writeArray(ofstream& out, const Array& a) {
+    uint64_t count = a.size();
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char*>(a.data()),
+              static_cast<streamsize>(count * sizeof(a[0])));
+}
+
+/// Reads what writeArray() wrote; false if short or longer than maxCount
+template <typename Array>
+static bool readArray(ifstream& in, Array& a, uint64_t maxCount) {
+    uint64_t count = 0;
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!in || count > maxCount) return false;
+    a.resize(static_cast<size_t>(count));
+    if (count > 0)
+        in.read(reinterpret_cast<char*>(&a[0]), static_cast<streamsize>(count * sizeof(a[0])));
+    return static_cast<bool>(in);
+}
+
+IncrementalExtremes::IncrementalExtremes() {}
+
+void IncrementalExtremes::clear() {
+    names_.clear();
+    numbers_.clear();
+    states_.clear();
+    points_.clear();
+}
+
+uint32_t IncrementalExtremes::stateNumber(const string& state) {
+    auto it = numbers_.find(state);
+    if (it != numbers_.end()) return it->second;
+    const uint32_t n = static_cast<uint32_t>(names_.size());
+    names_.push_back(state);
+    numbers_[state] = n;
+    return n;
+}
+
+void IncrementalExtremes::add(int zipCode, const Point& p) {
+    erase(zipCode);
+    Axes& axes = states_[names_[p.state]];
+    axes.longitude.insert(Key{p.longitude, zipCode});
+    axes.latitude.insert(Key{p.latitude, zipCode});
+    points_[zipCode] = p;
+}
+
+void IncrementalExtremes::insert(const ZipCodeRecord& record) {
+    add(record.zipCode, Point{stateNumber(record.state), record.latitude, record.longitude});
+}
+
+bool IncrementalExtremes::erase(int zipCode) {
+    auto it = points_.find(zipCode);
+    if (it == points_.end()) return false;
+    const Point& p = it->second;
+    auto state = states_.find(names_[p.state]);
+    state->second.longitude.erase(Key{p.longitude, zipCode});
+    state->second.latitude.erase(Key{p.latitude, zipCode});
+    if (state->second.longitude.empty()) states_.erase(state);
+    points_.erase(it);
+    return true;
+}
+
+void IncrementalExtremes::merge(const IncrementalExtremes& other) {
+    for (const auto& entry : other.points_) {
+        Point p = entry.second;
+        p.state = stateNumber(other.names_[p.state]);
+        add(entry.first, p);
+    }
+}
+
+bool IncrementalExtremes::extremes(const string& state, StateExtremes& out) const {
+    auto it = states_.find(state);
+    if (it == states_.end()) return false;
+    const Axes& axes = it->second;
+
+    // Minimum: the first key. Maximum: the first key with the last key's
+    // coordinate, so ties still go to the smaller ZIP.
+    const Key& minLon = *axes.longitude.begin();
+    const Key& maxLon =
+        *axes.longitude.lower_bound(Key{prev(axes.longitude.end())->coord, INT_MIN});
+    const Key& minLat = *axes.latitude.begin();
+    const Key& maxLat =
+        *axes.latitude.lower_bound(Key{prev(axes.latitude.end())->coord, INT_MIN});
+
+    // Same field meaning as updateStateExtremes().
+    out = StateExtremes();
+    out.minLongitude = minLon.coord;
+    out.easternmost = minLon.zip;
+    out.maxLongitude = maxLon.coord;
+    out.westernmost = maxLon.zip;
+    out.minLatitude = minLat.coord;
+    out.southernmost = minLat.zip;
+    out.maxLatitude = maxLat.coord;
+    out.northernmost = maxLat.zip;
+    return true;
+}
+
+void IncrementalExtremes::snapshot(map<string, StateExtremes>& out) const {
+    out.clear();
+    for (const auto& entry : states_) extremes(entry.first, out[entry.first]);
+}
+
+bool IncrementalExtremes::save(const string& path, unsigned long long generation,
+                               long long lastSeq, size_t liveRecords) const {
+    string names;
+    for (const string& name : names_) names += name + "\n";
+    vector<ExtEntry> entries;
+    entries.reserve(points_.size());
+    for (const auto& entry : points_) {
+        const Point& p = entry.second;
+        entries.push_back(ExtEntry{entry.first, p.state, p.latitude, p.longitude});
+    }
+
+    string tmp = tempPathFor(path);
+    {
+        ofstream out(tmp, ios::binary);
+        if (!out) return false;
+        uint64_t gen = generation;
+        int64_t seq = lastSeq;
+        uint64_t live = liveRecords;
+        out.write(kExtMagic, sizeof(kExtMagic));
+        out.write(reinterpret_cast<const char*>(&gen), sizeof(gen));
+        out.write(reinterpret_cast<const char*>(&seq), sizeof(seq));
+        out.write(reinterpret_cast<const char*>(&live), sizeof(live));
+        writeArray(out, names);
+        writeArray(out, entries);
+        if (!out) {
+            out.close();
+            discardTemp(tmp);
+            return false;
+        }
+    }
+    if (!publishFile(tmp, path)) {
+        discardTemp(tmp);
+        return false;
+    }
+    return true;
+}
+
+bool IncrementalExtremes::load(const string& path, unsigned long long generation,
+                               long long lastSeq, size_t liveRecords) {
+    clear();
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+
+    char magic[sizeof(kExtMagic)];
+    uint64_t gen = 0, live = 0;
+    int64_t seq = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&gen), sizeof(gen));
+    in.read(reinterpret_cast<char*>(&seq), sizeof(seq));
+    in.read(reinterpret_cast<char*>(&live), sizeof(live));
+    if (!in || memcmp(magic, kExtMagic, sizeof(magic)) != 0 || gen != generation ||
+        seq != lastSeq || live != liveRecords)
+        return false;
+
+    // One entry per live record, and at most one state name per entry.
+    string names;
+    vector<ExtEntry> entries;
+    if (!readArray(in, names, 256 * (live + 1)) || !readArray(in, entries, live) ||
+        entries.size() != live)
+        return false;
+    size_t lines = 0;
+    for (size_t start = 0; start < names.size(); lines++) {
+        const size_t end = names.find('\n', start);
+        if (end == string::npos) break;
+        stateNumber(names.substr(start, end - start));
+        start = end + 1;
+    }
+    if ((!names.empty() && names.back() != '\n') || names_.size() != lines) {
+        clear();   // cut short, or a name twice
+        return false;
+    }
+    for (const ExtEntry& e : entries) {
+        if (e.state >= names_.size() || points_.count(e.zip)) {
+            clear();
+            return false;
+        }
+        add(e.zip, Point{e.state, e.latitude, e.longitude});
+    }
+    return true;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file IncrementalExtremes.h
+ * @brief State extremes that follow inserts, updates and deletes in
+ *        O(log n) each, instead of a rescan.
+ * @date October 2026
+ *
+ * A StateExtremes table (see StateExtremes.h) only keeps the winners, so
+ * deleting the easternmost ZIP means scanning every record again for the
+ * runner-up. Here every state keeps all of its points in two ordered sets,
+ * one per axis, keyed by (coordinate, ZIP):
+ * - the smallest coordinate with the smallest ZIP is the first element
+ * - the largest coordinate with the smallest ZIP is found with one
+ *   lower_bound on the last element's coordinate
+ * which is the same smaller-ZIP tie rule as updateStateExtremes(), so
+ * snapshot() gives exactly the table a full scan would. A ZIP → point map
+ * finds the set entries to remove when a ZIP changes or goes away.
+ *
+ * File "<index file>.ext" (binary, native byte order):
+ *   "EXTAGG1\0" | u64 generation | u64 last sequence | u64 live records |
+ *   u64 length + state names ('\n' after each) |
+ *   u64 count + count x (i32 zip | u32 state number | f64 latitude |
+ *   f64 longitude)
+ *
+ * It is stamped like the other sidecars built from a pair's live records
+ * (see PlaceTrie.h). --update and --delete apply their change to a current
+ * one and save it with the new stamp, so it never needs a rescan; any
+ * other change makes it stale and --extremes rebuilds it.
+ */
+#ifndef INCREMENTALEXTREMES_H
+#define INCREMENTALEXTREMES_H
+
+#include "StateExtremes.h"
+#include "ZipCodeBuffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @class IncrementalExtremes
+ * @brief Per-state extremes with O(log n) insert and erase.
+ */
+class IncrementalExtremes {
+public:
+    IncrementalExtremes();
+
+    /// Removes every point
+    void clear();
+
+    /**
+     * @brief Adds a record's point, replacing the ZIP's previous one if any.
+     * @param record One ZIP record
+     */
+    void insert(const ZipCodeRecord& record);
+
+    /**
+     * @brief Removes a ZIP's point.
+     * @return false if the ZIP was not there
+     */
+    bool erase(int zipCode);
+
+    /**
+     * @brief Adds every point of another set (its version of a ZIP wins),
+     *        e.g. to combine the shards of a sharded dataset.
+     */
+    void merge(const IncrementalExtremes& other);
+
+    /**
+     * @brief The extremes of one state.
+     * @return false if the state has no points
+     */
+    bool extremes(const string& state, StateExtremes& out) const;
+
+    /// The extremes of every state, as updateStateExtremes() would give them
+    void snapshot(map<string, StateExtremes>& out) const;
+
+    /// Number of ZIPs
+    size_t size() const { return points_.size(); }
+
+    /// Number of states with at least one ZIP
+    size_t stateCount() const { return states_.size(); }
+
+    /**
+     * @brief Writes the points crash-safely (temp file + rename).
+     * @return true on success
+     */
+    bool save(const string& path, unsigned long long generation, long long lastSeq,
+              size_t liveRecords) const;
+
+    /**
+     * @brief Reads points saved for exactly this state of the data.
+     * @return false if missing, damaged, or stale (the set is then empty)
+     */
+    bool load(const string& path, unsigned long long generation, long long lastSeq,
+              size_t liveRecords);
+
+    /// The usual name for an index file's extremes
+    static string pathFor(const string& indexFile) { return indexFile + ".ext"; }
+
+private:
+    /// Set key: coordinate first, then the smaller ZIP
+    struct Key {
+        double coord;
+        int zip;
+        bool operator<(const Key& o) const {
+            return coord != o.coord ? coord < o.coord : zip < o.zip;
+        }
+    };
+
+    struct Axes {
+        set<Key> longitude;
+        set<Key> latitude;
+    };
+
+    struct Point {
+        uint32_t state;   ///< number in names_
+        double latitude;
+        double longitude;
+    };
+
+    uint32_t stateNumber(const string& state);
+    void add(int zipCode, const Point& p);
+
+    vector<string> names_;              ///< state number → name
+    map<string, uint32_t> numbers_;     ///< name → state number
+    map<string, Axes> states_;          ///< states with points only
+    unordered_map<int, Point> points_;  ///< ZIP → point
+};
+
+#endif
@@ -0,0 +1,160 @@
+/**
+ * @file IndexBench.cpp
+ * @brief Implementation of the index layout benchmark.
+ * @date October 2026
+ */
+#include "IndexBench.h"
+#include "Eytzinger.h"
+#include "BatchSearch.h"
+#include "LearnedIndex.h"
+#include "Succinct.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+/// Rough bytes per entry of an unordered_map<uint32_t, uint32_t>
+static const size_t kMapBytesPerKey = 48;
+
+/**
+ * @brief Times fn(key) over all lookup keys.
+ * @return nanoseconds per lookup; sum receives the summed results
+ */
+template <typename Fn>
+static double timeLookups(const vector<uint32_t>& probes, Fn fn, uint64_t& sum) {
+    auto t0 = chrono::steady_clock::now();
+    uint64_t s = 0;
+    for (uint32_t key : probes) s += fn(key);
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+    sum = s;
+    return probes.empty() ? 0.0 : ns / static_cast<double>(probes.size());
+}
+
+bool benchIndexLayouts(size_t keys, size_t lookups, IndexBenchResult& result) {
+    result = IndexBenchResult();
+    result.keys = keys;
+    result.lookups = lookups;
+    if (keys == 0) return true;
+
+    // Distinct keys spread over the u32 range, denser in some regions than
+    // in others (like ZIPs), so the learned model has to use several lines.
+    // The largest gap is below 4 x meanGap + 1, so the keys fit in u32.
+    mt19937_64 rng(12345);
+    const uint64_t meanGap = max<uint64_t>(1, 0xFFFFFFFFULL / static_cast<uint64_t>(keys) / 5);
+    vector<uint32_t> sorted(keys);
+    uint64_t key = 0;
+    uint64_t span = meanGap;
+    for (size_t i = 0; i < keys; i++) {
+        if (i % 4096 == 0) span = max<uint64_t>(1, meanGap * (1 + rng() % 39) / 10);
+        key += 1 + rng() % span;
+        sorted[i] = static_cast<uint32_t>(key);
+    }
+
+    vector<uint32_t> probes(lookups);
+    for (size_t i = 0; i < lookups; i++) probes[i] = sorted[rng() % keys];
+
+    // The value of a key is its sorted position; every structure returns
+    // it, so the sums must agree.
+    uint64_t expected = 0;
+    result.sortedNs = timeLookups(probes, [&](uint32_t key) {
+        return static_cast<uint64_t>(lower_bound(sorted.begin(), sorted.end(), key)
+                                     - sorted.begin());
+    }, expected);
+
+    {
+        LearnedIndex model;
+        model.build(sorted.data(), keys);
+        result.modelBytes = model.sizeBytes();
+        result.modelSegments = model.segmentCount();
+        uint64_t sum = 0;
+        result.learnedNs = timeLookups(probes, [&](uint32_t key) {
+            return static_cast<uint64_t>(model.lowerBound(sorted.data(), keys, key));
+        }, sum);
+        if (sum != expected) return false;
+    }
+
+    {
+        vector<uint64_t> words;
+        {
+            vector<uint64_t> values(sorted.begin(), sorted.end());
+            EliasFano::encode(values.data(), keys, words);
+        }
+        EliasFano ef;
+        ef.attach(words.data(), words.size());
+        result.eliasFanoBitsPerKey =
+            static_cast<double>(words.size() * 64) / static_cast<double>(keys);
+        uint64_t sum = 0;
+        result.eliasFanoNs = timeLookups(probes, [&](uint32_t key) {
+            return static_cast<uint64_t>(ef.lowerBound(key));
+        }, sum);
+        if (sum != expected) return false;
+
+        auto t0 = chrono::steady_clock::now();
+        uint64_t check = 0;
+        for (EliasFano::Cursor c = ef.at(0); c.valid(); c.next()) check += c.value();
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+        result.eliasFanoScanNs = ns / static_cast<double>(keys);
+        uint64_t total = 0;
+        for (uint32_t k : sorted) total += k;
+        if (check != total) return false;
+    }
+
+    {
+        vector<size_t> positions(lookups);
+        auto t0 = chrono::steady_clock::now();
+        lowerBoundBatch(sorted.data(), keys, probes.data(), lookups, positions.data());
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+        result.batchNs = lookups ? ns / static_cast<double>(lookups) : 0.0;
+        uint64_t sum = 0;
+        for (size_t p : positions) sum += p;
+        if (sum != expected) return false;
+    }
+
+    {
+        vector<size_t> order = eytzingerOrder(keys);
+        // 64-byte aligned, so the prefetched slots 16k..16k+15 are one line.
+        size_t bytes = ((keys + 1) * sizeof(uint32_t) + 63) & ~static_cast<size_t>(63);
+        uint32_t* slots = static_cast<uint32_t*>(aligned_alloc(64, bytes));
+        if (slots == nullptr) return false;
+        vector<uint32_t> values(keys + 1, 0);
+        slots[0] = 0;
+        for (size_t k = 1; k <= keys; k++) {
+            slots[k] = sorted[order[k]];
+            values[k] = static_cast<uint32_t>(order[k]);
+        }
+        order.clear();
+        order.shrink_to_fit();
+
+        uint64_t sum = 0;
+        result.eytzingerNs = timeLookups(probes, [&](uint32_t key) {
+            return static_cast<uint64_t>(values[eytzingerLowerBound(slots, keys, key)]);
+        }, sum);
+        free(slots);
+        if (sum != expected) return false;
+    }
+
+    long long availPages = sysconf(_SC_AVPHYS_PAGES);
+    long long pageSize = sysconf(_SC_PAGESIZE);
+    double avail = static_cast<double>(availPages) * static_cast<double>(pageSize);
+    if (static_cast<double>(keys) * kMapBytesPerKey > avail / 2) {
+        result.mapSkipped = true;
+        return true;
+    }
+
+    unordered_map<uint32_t, uint32_t> map;
+    map.reserve(keys);
+    for (size_t i = 0; i < keys; i++) map[sorted[i]] = static_cast<uint32_t>(i);
+    uint64_t sum = 0;
+    result.mapNs = timeLookups(probes, [&](uint32_t key) {
+        return static_cast<uint64_t>(map.find(key)->second);
+    }, sum);
+    return sum == expected;
+}
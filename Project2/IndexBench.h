@@ -0,0 +1,63 @@
+/**
+ * @file IndexBench.h
+ * @brief Compares the lookup structures an index can use in memory.
+ * @date October 2026
+ *
+ * For a given number of random, distinct u32 keys (with denser and sparser
+ * regions, like ZIPs), times random lookups
+ * (all hits) in:
+ *   - std::unordered_map  (what ZipDataStore builds from an .idx)
+ *   - std::lower_bound over the sorted keys  (a sorted index segment)
+ *   - the Eytzinger layout  (an "<index>.eyt" segment, see Eytzinger.h)
+ *   - the learned model over the sorted keys  (a sorted segment's
+ *     "<segment>.pgm", see LearnedIndex.h)
+ *   - Elias-Fano encoded keys  (a compressed segment, see Succinct.h); also
+ *     its size and the cost of walking all keys in order
+ *   - lowerBoundBatch() over the sorted keys, all lookups in one call
+ *     (a sorted segment answering a many-ZIP request, see BatchSearch.h)
+ *
+ * The lookup keys are in random order, as with real queries, so the large
+ * sizes measure cache and TLB misses rather than the comparisons.
+ * A hash map takes about 10x the RAM of the arrays. If it would not fit
+ * into half of the available memory it is skipped.
+ */
+#ifndef INDEXBENCH_H
+#define INDEXBENCH_H
+
+#include <cstddef>
+
+/**
+ * @struct IndexBenchResult
+ * @brief Average nanoseconds per lookup for one key count.
+ */
+struct IndexBenchResult {
+    size_t keys;          ///< keys in each structure
+    size_t lookups;       ///< lookups timed per structure
+    bool mapSkipped;      ///< hash map not built (too big for RAM)
+    double mapNs;
+    double sortedNs;
+    double eytzingerNs;
+    double learnedNs;
+    double eliasFanoNs;
+    double batchNs;
+    double eliasFanoBitsPerKey;  ///< size of the encoded keys
+    double eliasFanoScanNs;      ///< per key, walking them in order
+    size_t modelBytes;    ///< size of the learned model
+    size_t modelSegments; ///< its bottom-level segments
+
+    IndexBenchResult()
+        : keys(0), lookups(0), mapSkipped(false), mapNs(0), sortedNs(0),
+          eytzingerNs(0), learnedNs(0), eliasFanoNs(0), batchNs(0),
+          eliasFanoBitsPerKey(0), eliasFanoScanNs(0), modelBytes(0), modelSegments(0) {}
+};
+
+/**
+ * @brief Builds the structures over the same keys and times them.
+ * @param keys Number of keys
+ * @param lookups Number of lookups per structure
+ * @param result Receives the timings
+ * @return false if a structure returned a wrong answer
+ */
+bool benchIndexLayouts(size_t keys, size_t lookups, IndexBenchResult& result);
+
+#endif
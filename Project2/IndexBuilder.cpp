@@ -7,57 +7,112 @@
  */
 #include "IndexBuilder.h"
 #include "LenFileReader.h"
+#include "HeaderBuffer.h"
+#include "AtomicFile.h"
+#include "BloomFilter.h"
+#include "IndexSegment.h"
+#include "GeoIndex.h"
 
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 using namespace std;
 
 /**
- * @brief Builds an index file for the provided .len file.
+ * @brief Builds an index file for the provided .len file, quietly.
  *
  * Important detail:
  * - We record the offset BEFORE reading the record.
  * - That offset points to the start of the record length field.
+ * - The file is read twice: once for the ZIPs alone, to find duplicated
+ *   ones (see DuplicateKeys.h), and once to write the index.
  *
  * @param lenFile Input .len data file
  * @param indexFile Output .idx file
+ * @param entries Receives the entry count
+ * @param error Receives the error message
+ * @param policy Which record of a duplicated ZIP is indexed
+ * @param duplicates Receives a note on duplicated ZIPs, if given
+ * @return 0 on success, else an exit code
  */
-void buildIndex(const string& lenFile, const string& indexFile)
+int buildIndexFile(const string& lenFile, const string& indexFile,
+                   long long& entries, string& error,
+                   DuplicatePolicy policy, string* duplicates)
 {
+    entries = 0;
+    if (duplicates) duplicates->clear();
     ifstream in(lenFile);
     if (!in) {
-        cout << "Error: Cannot open LEN file: " << lenFile << "\n";
-        return;
-    }
-
-    ofstream out(indexFile);
-    if (!out) {
-        cout << "Error: Cannot create index file: " << indexFile << "\n";
-        return;
+        error = "Cannot open LEN file '" + lenFile + "'";
+        return 2;
     }
 
     // Read the LEN header record first (we skip it for indexing records).
     string header;
     if (!readLenRecord(in, header)) {
-        cout << "Error: LEN file has no header or bad format.\n";
-        return;
+        error = "LEN file is missing header or is corrupted.";
+        return 4;
     }
 
-    // Optional index file header (helps identify it)
-    out << "IDX,1\n";
+    // Old headers do not parse or have no generation; index gets 0 then.
+    HeaderBuffer hbuf;
+    unsigned long long generation = 0;
+    bool hasChecksum = false;
+    if (hbuf.parse(header)) {
+        generation = hbuf.getHeader().generation;
+        hasChecksum = hbuf.hasChecksum();
+    }
 
-    long long count = 0;
+    // Pass 1: ZIPs only.
+    const streampos dataStart = in.tellg();
+    DuplicateKeys keys;
+    string record;
+    while (readLenRecord(in, record, hasChecksum)) {
+        size_t comma = record.find(',');
+        if (comma != string::npos) keys.add(record.substr(0, comma));
+    }
+    keys.finish();
+    if (keys.duplicateKeys() > 0) {
+        string note = to_string(keys.duplicateKeys()) + " duplicate ZIP(s) in " + lenFile +
+                      " (" + keys.examples() + ")";
+        if (policy == DuplicatePolicy::kError) {
+            error = note;
+            return 6;
+        }
+        if (duplicates) {
+            *duplicates = note + "; " + duplicatePolicyName(policy);
+            if (policy != DuplicatePolicy::kKeepAll)
+                *duplicates += ", " + to_string(keys.extraRows()) + " record(s) not indexed";
+        }
+    }
+    in.clear();
+    in.seekg(dataStart);
 
+    string tmpFile = tempPathFor(indexFile);
+    ofstream out(tmpFile);
+    if (!out) {
+        error = "Cannot create index file '" + tmpFile + "'";
+        return 3;
+    }
+
+    // The header line counts the records left out as dead, so it is written
+    // after the entries are known.
+    string lines;
+    long long excluded = 0, excludedBytes = 0;
+    vector<string> zipKeys;
+    unordered_map<string, long long> index;   // for the Eytzinger segment
+    vector<pair<string, GeoIndex::Record>> points;   // for the geo index
     while (true)
     {
         // Save the start offset of the next record
         streampos pos = in.tellg();
 
         // Read record text
-        string record;
-        if (!readLenRecord(in, record))
+        if (!readLenRecord(in, record, hasChecksum))
             break; // reached EOF
 
         // ZIP is the first field before comma
@@ -68,11 +123,91 @@ void buildIndex(const string& lenFile, const string& indexFile)
         }
 
         string zip = record.substr(0, comma); // keep leading zeros if any
+        if (!keys.keep(zip, policy)) {
+            // Dead space, as if superseded by --update (see ZipDataStore.h).
+            excluded++;
+            excludedBytes += static_cast<long long>(in.tellg() - pos);
+            continue;
+        }
 
         // Write: ZIP offset
-        out << zip << " " << static_cast<long long>(pos) << "\n";
-        count++;
+        lines += zip + " " + to_string(static_cast<long long>(pos)) + "\n";
+        zipKeys.push_back(zip);
+        index[zip] = static_cast<long long>(pos);
+        entries++;
+
+        // Latitude and longitude are the last two fields.
+        size_t lonComma = record.rfind(',');
+        size_t latComma = (lonComma == string::npos || lonComma == 0)
+                              ? string::npos : record.rfind(',', lonComma - 1);
+        if (latComma != string::npos && latComma > comma) {
+            const char* lat = record.c_str() + latComma + 1;
+            const char* lon = record.c_str() + lonComma + 1;
+            char* latEnd = nullptr;
+            char* lonEnd = nullptr;
+            GeoIndex::Record point{strtod(lat, &latEnd), strtod(lon, &lonEnd),
+                                   static_cast<uint64_t>(pos)};
+            if (latEnd != lat && lonEnd != lon) points.emplace_back(zip, point);
+        }
+    }
+
+    // The filter is optional for readers, so failing to write it is not fatal.
+    BloomFilter bloom;
+    bloom.reset(zipKeys.size());
+    for (const string& zip : zipKeys) bloom.add(zip);
+    if (!bloom.save(BloomFilter::pathFor(indexFile), generation)) {
+        cerr << "Warning: could not write Bloom filter "
+             << BloomFilter::pathFor(indexFile) << "\n";
+    }
+
+    // Same for the Eytzinger segment (needs numeric ZIPs; see IndexSegment.h).
+    unsigned long long version = 0;
+    string eytError;
+    if (!IndexSegment::publish(index, generation, 0, IndexSegment::eytzingerPathFor(indexFile),
+                               version, eytError, IndexSegment::kEytzinger)) {
+        cerr << "Warning: could not write Eytzinger index: " << eytError << "\n";
+    }
+
+    // And the geo index over the latest record of each ZIP (see GeoIndex.h).
+    vector<GeoIndex::Record> live;
+    live.reserve(index.size());
+    for (const auto& p : points) {
+        if (index[p.first] == static_cast<long long>(p.second.offset)) live.push_back(p.second);
+    }
+    GeoIndex geo;
+    geo.build(live);
+    if (!geo.save(GeoIndex::pathFor(indexFile), generation, 0, index.size())) {
+        cerr << "Warning: could not write geo index " << GeoIndex::pathFor(indexFile) << "\n";
+    }
+
+    out << "IDX,2," << HeaderBuffer::generationText(generation);
+    if (excluded > 0) out << "," << excluded << "," << excludedBytes << ",0";
+    out << "\n" << lines;
+    out.close();
+    if (!out || !publishFile(tmpFile, indexFile)) {
+        error = "Failed to publish index file '" + indexFile + "'";
+        discardTemp(tmpFile);
+        return 5;
+    }
+    return 0;
+}
+
+/**
+ * @brief Builds an index file for the provided .len file.
+ *
+ * @param lenFile Input .len data file
+ * @param indexFile Output .idx file
+ */
+void buildIndex(const string& lenFile, const string& indexFile)
+{
+    long long count = 0;
+    string error, duplicates;
+    if (buildIndexFile(lenFile, indexFile, count, error, DuplicatePolicy::kLastWins,
+                       &duplicates) != 0) {
+        cout << "Error: " << error << "\n";
+        return;
     }
+    if (!duplicates.empty()) cout << "Warning: " << duplicates << "\n";
 
     cout << "Index created: " << indexFile << " (entries=" << count << ")\n";
-}
\ No newline at end of file
+}
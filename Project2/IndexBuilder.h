@@ -15,6 +15,21 @@
  * Meaning:
  * - ZIP 56301 starts at byte 120 in the data file.
  *
+ * The first line is "IDX,2,<generation>" (the generation id of the .len
+ * header), and a Bloom filter over all ZIPs is written to <index>.bloom.
+ * The same keys are also written as an index segment in Eytzinger order,
+ * <index>.eyt (see IndexSegment.h), which read-only modes accept in place
+ * of the .idx. The coordinates of the records go into a geo index,
+ * <index>.geo (see GeoIndex.h).
+ *
+ * Every ZIP gets one index line. If the data holds a ZIP more than once,
+ * a duplicate policy (see DuplicateKeys.h) picks the record it points to:
+ * by default the last one, which is also what loading an index with
+ * repeated lines used to do. The records left out are dead space, like
+ * records superseded by --update: the first line then reads
+ * "IDX,2,<generation>,<dead records>,<dead bytes>,0" (see ZipDataStore.h),
+ * and --verify and --compact account for them.
+ *
  * Why we do this:
  * - During search, we load the index into RAM (allowed).
  * - Then we can jump directly to a ZIP record using seekg(offset).
@@ -23,8 +38,33 @@
 #ifndef INDEXBUILDER_H
 #define INDEXBUILDER_H
 
+#include "DuplicateKeys.h"
+
 #include <string>
 
+/**
+ * @brief Builds an index file (and its Bloom filter) without printing.
+ *
+ * The index is written to a temp file and published with publishFile(),
+ * so a reader never sees a half-written index. Used by --build-index and
+ * by the shard builder, which indexes several shards at once.
+ *
+ * @param lenFile Path to the length-indicated data file
+ * @param indexFile Path to the output index file
+ * @param entries Receives the number of index entries written
+ * @param error Receives a message when the build fails
+ * @param policy Which record of a duplicated ZIP is indexed
+ * @param duplicates If given, receives a note on duplicated ZIPs
+ *        (empty when there are none)
+ * @return 0 on success, else 2 (cannot open), 3 (cannot create),
+ *         4 (bad header), 5 (cannot publish) or 6 (duplicate ZIPs under
+ *         DuplicatePolicy::kError)
+ */
+int buildIndexFile(const std::string& lenFile, const std::string& indexFile,
+                   long long& entries, std::string& error,
+                   DuplicatePolicy policy = DuplicatePolicy::kLastWins,
+                   std::string* duplicates = nullptr);
+
 /**
  * @brief Builds an index file from a .len file.
  *
@@ -36,6 +76,7 @@
  *    - reads the record
  *    - extracts ZIP (first field before comma)
  *    - writes ZIP and offset into the index file
+ * 4) Prints the number of entries (or the error) and any duplicated ZIPs
  *
  * @param lenFile Path to the length-indicated data file
  * @param indexFile Path to the output index file
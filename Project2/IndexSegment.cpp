@@ -0,0 +1,338 @@
+/**
+ * @file IndexSegment.cpp
+ * @brief Implementation of the IndexSegment class.
+ * @date October 2026
+ */
+#include "IndexSegment.h"
+#include "AtomicFile.h"
+#include "BatchSearch.h"
+#include "Eytzinger.h"
+#include "Succinct.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+/// The fixed 64-byte header at the start of a segment
+struct SegmentHeader {
+    char magic[8];
+    uint64_t version;
+    uint64_t generation;
+    uint64_t count;
+    uint64_t keysOffset;
+    uint64_t offsetsOffset;
+    uint64_t lastSeq;
+    uint64_t layout;
+};
+static_assert(sizeof(SegmentHeader) == 64, "segment header must be 64 bytes");
+
+static const char kSegmentMagic[8] = {'Z', 'I', 'P', 'S', 'E', 'G', '0', '1'};
+
+/// First word of a compressed segment's offsets: how they are encoded
+static const uint64_t kOffsetsPacked = 0;
+static const uint64_t kOffsetsEliasFano = 1;
+
+/**
+ * @brief Converts a ZIP string to its key, if it is a plain number.
+ *
+ * The data file stores ZIPs without leading zeros ("501"), so "00501" is
+ * a different key that is not in the index; it gets no number here.
+ */
+static bool zipKey(const string& zip, uint32_t& key) {
+    if (zip.empty() || zip.size() > 9 || (zip[0] == '0' && zip.size() > 1))
+        return false;
+    uint32_t v = 0;
+    for (char c : zip) {
+        if (c < '0' || c > '9') return false;
+        v = v * 10 + static_cast<uint32_t>(c - '0');
+    }
+    key = v;
+    return true;
+}
+
+/**
+ * @brief Reads the header of the segment file at path.
+ */
+static bool readHeader(const string& path, SegmentHeader& h) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    ssize_t got = pread(fd, &h, sizeof(h), 0);
+    ::close(fd);
+    return got == static_cast<ssize_t>(sizeof(h)) &&
+           memcmp(h.magic, kSegmentMagic, sizeof(kSegmentMagic)) == 0;
+}
+
+IndexSegment::IndexSegment()
+    : keys_(nullptr), offsets_(nullptr), count_(0), layout_(kSorted), version_(0),
+      generation_(0), lastSeq_(0) {}
+
+bool IndexSegment::fail(const string& message) {
+    error_ = message;
+    return false;
+}
+
+bool IndexSegment::isSegmentFile(const string& path) {
+    SegmentHeader h;
+    return readHeader(path, h);
+}
+
+bool IndexSegment::publish(const unordered_map<string, long long>& index,
+                           unsigned long long generation, long long lastSeq,
+                           const string& path, unsigned long long& version,
+                           string& error, Layout layout) {
+    vector<pair<uint32_t, int64_t>> entries;
+    entries.reserve(index.size());
+    for (const auto& e : index) {
+        uint32_t key;
+        if (!zipKey(e.first, key)) {
+            error = "ZIP '" + e.first + "' is not a plain number; "
+                    "a segment can only hold numeric ZIP keys.";
+            return false;
+        }
+        entries.push_back({key, static_cast<int64_t>(e.second)});
+    }
+    sort(entries.begin(), entries.end());
+
+    SegmentHeader old;
+    version = readHeader(path, old) ? old.version + 1 : 1;
+
+    // The two arrays, as the bytes the layout stores.
+    string keyBytes, offsetBytes;
+    if (layout == kCompressed) {
+        vector<uint64_t> values(entries.size());
+        for (size_t i = 0; i < entries.size(); i++) values[i] = entries[i].first;
+        vector<uint64_t> words;
+        EliasFano::encode(values.data(), values.size(), words);
+        keyBytes.assign(reinterpret_cast<const char*>(words.data()),
+                        words.size() * sizeof(uint64_t));
+
+        // Offsets follow the data file order only if it is sorted by ZIP.
+        bool ascending = true;
+        for (size_t i = 0; i < entries.size(); i++) {
+            values[i] = static_cast<uint64_t>(entries[i].second);
+            if (i > 0 && values[i] < values[i - 1]) ascending = false;
+        }
+        words.assign(1, ascending ? kOffsetsEliasFano : kOffsetsPacked);
+        vector<uint64_t> encoded;
+        if (ascending) EliasFano::encode(values.data(), values.size(), encoded);
+        else PackedArray::encode(values.data(), values.size(), encoded);
+        words.insert(words.end(), encoded.begin(), encoded.end());
+        offsetBytes.assign(reinterpret_cast<const char*>(words.data()),
+                           words.size() * sizeof(uint64_t));
+    } else {
+        // The file order: sorted, or the sorted position for each tree slot.
+        vector<size_t> order;
+        if (layout == kEytzinger) {
+            order = eytzingerOrder(entries.size());
+        } else {
+            order.resize(entries.size());
+            for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        }
+
+        vector<uint32_t> keys(order.size(), 0);
+        vector<int64_t> offsets(order.size(), 0);
+        for (size_t i = (layout == kEytzinger ? 1 : 0); i < order.size(); i++) {
+            keys[i] = entries[order[i]].first;
+            offsets[i] = entries[order[i]].second;
+        }
+        keyBytes.assign(reinterpret_cast<const char*>(keys.data()),
+                        keys.size() * sizeof(uint32_t));
+        offsetBytes.assign(reinterpret_cast<const char*>(offsets.data()),
+                           offsets.size() * sizeof(int64_t));
+
+        // The model goes first, stamped with the new version, so it is in
+        // place when the segment appears. It is optional: without it lookups
+        // fall back to lower_bound.
+        if (layout == kSorted) {
+            LearnedIndex model;
+            model.build(keys.data(), keys.size());
+            model.save(LearnedIndex::pathFor(path), generation, version);
+        }
+    }
+
+    SegmentHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, kSegmentMagic, sizeof(kSegmentMagic));
+    h.version = version;
+    h.generation = generation;
+    h.count = entries.size();
+    h.keysOffset = sizeof(SegmentHeader);
+    // The offsets array starts 8-byte aligned.
+    h.offsetsOffset = (h.keysOffset + keyBytes.size() + 7) & ~7ULL;
+    h.lastSeq = static_cast<uint64_t>(lastSeq);
+    h.layout = static_cast<uint64_t>(layout);
+
+    string tmp = tempPathFor(path);
+    {
+        ofstream out(tmp, ios::binary);
+        if (!out) {
+            error = "Cannot create segment file '" + tmp + "'";
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write(keyBytes.data(), static_cast<streamsize>(keyBytes.size()));
+        static const char pad[8] = {0};
+        out.write(pad, static_cast<streamsize>(h.offsetsOffset - h.keysOffset - keyBytes.size()));
+        out.write(offsetBytes.data(), static_cast<streamsize>(offsetBytes.size()));
+        if (!out) {
+            out.close();
+            discardTemp(tmp);
+            error = "Cannot write segment file '" + tmp + "'";
+            return false;
+        }
+    }
+    if (!publishFile(tmp, path)) {
+        discardTemp(tmp);
+        error = "Cannot publish segment file '" + path + "'";
+        return false;
+    }
+    return true;
+}
+
+bool IndexSegment::attach(const string& path) {
+    detach();
+    if (!map_.open(path)) return fail("Cannot map index segment: " + path);
+
+    SegmentHeader h;
+    if (map_.size() < sizeof(h)) {
+        map_.close();
+        return fail("Index segment is too short: " + path);
+    }
+    memcpy(&h, map_.data(), sizeof(h));
+    const uint64_t slots = (h.layout == kEytzinger) ? h.count + 1 : h.count;
+    bool valid = memcmp(h.magic, kSegmentMagic, sizeof(kSegmentMagic)) == 0 &&
+                 h.layout <= kCompressed && h.keysOffset == sizeof(h) &&
+                 h.offsetsOffset % 8 == 0 && h.offsetsOffset <= map_.size();
+    if (valid && h.layout == kCompressed) {
+        const uint64_t* keyWords = reinterpret_cast<const uint64_t*>(map_.data() + h.keysOffset);
+        const uint64_t* offsetWords =
+            reinterpret_cast<const uint64_t*>(map_.data() + h.offsetsOffset);
+        const size_t offsetWordCount = (map_.size() - h.offsetsOffset) / sizeof(uint64_t);
+        valid = h.offsetsOffset >= h.keysOffset &&
+                keyEf_.attach(keyWords, (h.offsetsOffset - h.keysOffset) / sizeof(uint64_t)) &&
+                keyEf_.size() == h.count && offsetWordCount > 1;
+        if (valid && offsetWords[0] == kOffsetsEliasFano)
+            valid = offsetEf_.attach(offsetWords + 1, offsetWordCount - 1) &&
+                    offsetEf_.size() == h.count;
+        else if (valid)
+            valid = offsetWords[0] == kOffsetsPacked &&
+                    offsetPacked_.attach(offsetWords + 1, offsetWordCount - 1) &&
+                    offsetPacked_.size() == h.count;
+    } else if (valid) {
+        valid = h.offsetsOffset >= h.keysOffset + slots * sizeof(uint32_t) &&
+                map_.size() >= h.offsetsOffset + slots * sizeof(int64_t);
+    }
+    if (!valid) {
+        detach();
+        return fail("Not a valid index segment: " + path);
+    }
+
+    path_ = path;
+    if (h.layout != kCompressed) {
+        keys_ = reinterpret_cast<const uint32_t*>(map_.data() + h.keysOffset);
+        offsets_ = reinterpret_cast<const int64_t*>(map_.data() + h.offsetsOffset);
+    }
+    count_ = static_cast<size_t>(h.count);
+    layout_ = static_cast<Layout>(h.layout);
+    version_ = h.version;
+    generation_ = h.generation;
+    lastSeq_ = static_cast<long long>(h.lastSeq);
+    if (layout_ == kSorted)
+        model_.load(LearnedIndex::pathFor(path), generation_, version_, count_);
+    return true;
+}
+
+void IndexSegment::detach() {
+    map_.close();
+    model_ = LearnedIndex();
+    keyEf_ = EliasFano();
+    offsetEf_ = EliasFano();
+    offsetPacked_ = PackedArray();
+    keys_ = nullptr;
+    offsets_ = nullptr;
+    count_ = 0;
+    layout_ = kSorted;
+    version_ = generation_ = 0;
+    lastSeq_ = 0;
+}
+
+bool IndexSegment::find(const string& zip, long long& offset) const {
+    uint32_t key;
+    if (!attached() || !zipKey(zip, key)) return false;
+    if (layout_ == kCompressed) {
+        size_t i = keyEf_.lowerBound(key);
+        if (i == count_ || keyEf_.access(i) != key) return false;
+        offset = compressedOffset(i);
+        return true;
+    }
+    if (layout_ == kEytzinger) {
+        size_t k = eytzingerLowerBound(keys_, count_, key);
+        if (k == 0 || keys_[k] != key) return false;
+        offset = static_cast<long long>(offsets_[k]);
+        return true;
+    }
+    const size_t p = model_.empty()
+                         ? static_cast<size_t>(lower_bound(keys_, keys_ + count_, key) - keys_)
+                         : model_.lowerBound(keys_, count_, key);
+    if (p == count_ || keys_[p] != key) return false;
+    offset = static_cast<long long>(offsets_[p]);
+    return true;
+}
+
+void IndexSegment::findBatch(const vector<string>& zips, vector<long long>& offsets) const {
+    offsets.assign(zips.size(), -1);
+    if (!attached()) return;
+    if (layout_ != kSorted) {
+        // No lockstep version: an Eytzinger descent already prefetches
+        // ahead, and a compressed lookup is mostly bit scans in cache.
+        for (size_t i = 0; i < zips.size(); i++) find(zips[i], offsets[i]);
+        return;
+    }
+
+    // Only numeric ZIPs can be in the segment.
+    vector<uint32_t> queries;
+    vector<size_t> which;
+    queries.reserve(zips.size());
+    which.reserve(zips.size());
+    for (size_t i = 0; i < zips.size(); i++) {
+        uint32_t key;
+        if (!zipKey(zips[i], key)) continue;
+        queries.push_back(key);
+        which.push_back(i);
+    }
+
+    vector<size_t> positions(queries.size());
+    lowerBoundBatch(keys_, count_, queries.data(), queries.size(), positions.data());
+    for (size_t j = 0; j < queries.size(); j++) {
+        size_t p = positions[j];
+        if (p < count_ && keys_[p] == queries[j])
+            offsets[which[j]] = static_cast<long long>(offsets_[p]);
+    }
+}
+
+bool IndexSegment::entry(size_t i, string& zip, long long& offset) const {
+    if (i >= count_) return false;
+    if (layout_ == kCompressed) {
+        zip = to_string(keyEf_.access(i));
+        offset = compressedOffset(i);
+        return true;
+    }
+    if (layout_ == kEytzinger) i++;   // entry 0 is unused
+    zip = to_string(keys_[i]);
+    offset = static_cast<long long>(offsets_[i]);
+    return true;
+}
+
+bool IndexSegment::replaced() const {
+    SegmentHeader h;
+    // A compaction publishes a segment of its own, for a new generation.
+    return attached() && readHeader(path_, h) &&
+           (h.version != version_ || h.generation != generation_);
+}
@@ -0,0 +1,187 @@
+/**
+ * @file IndexSegment.h
+ * @brief The index as one read-only, memory-mapped file that many
+ *        processes share.
+ * @date October 2026
+ *
+ * Every process that opens an .idx builds its own unordered_map, so ten
+ * worker processes hold ten copies of the same index. A segment is built
+ * once by a loader (--publish-segment) and then mapped read-only by every
+ * worker. All of them share the same page-cache pages, and attaching is
+ * just an open + mmap, with nothing to parse.
+ *
+ * Put the segment in /dev/shm (tmpfs) to keep it in RAM only, like a POSIX
+ * shared-memory object; on a normal file system it works the same way
+ * and also survives a reboot.
+ *
+ * File layout (native byte order; a segment is only shared on one host):
+ *   64-byte header:
+ *     "ZIPSEG01" | u64 version | u64 generation | u64 key count |
+ *     u64 keys offset | u64 offsets offset | u64 last WAL seq | u64 layout
+ *   keys:    ZIP as a u32 number, in the order given by the layout
+ *   offsets: i64 record offset of the key at the same place
+ *   (layout 2 stores both regions as encoded u64 words instead)
+ *
+ * Layouts:
+ *   0 sorted      key count entries, ascending; found through the learned
+ *                 model "<segment>.pgm" written with it (see LearnedIndex.h),
+ *                 or with lower_bound if that is missing or out of date
+ *   1 Eytzinger   key count + 1 entries in breadth-first tree order, entry 0
+ *                 unused (see Eytzinger.h); --build-index writes one next to
+ *                 the index as "<index>.eyt"
+ *   2 compressed  keys Elias-Fano encoded; offsets as u64 0 + bit-packed, or
+ *                 u64 1 + Elias-Fano when the data file is sorted by ZIP (see
+ *                 Succinct.h); a few bytes per key for tens of millions of keys
+ *
+ * The segment is written from the live index (the .idx with the WAL
+ * applied). Updates made after that are not in it until the loader
+ * publishes again.
+ *
+ * Hot swap: the loader writes a new segment under a temp name and renames
+ * it over the old one (see AtomicFile.h), with the version stamp one
+ * higher. A worker that already mapped the old file keeps a complete,
+ * consistent old version until it re-attaches; replaced() tells it that
+ * a newer version is there. The generation is the data file's (see
+ * HeaderBuffer), so a segment is never used with the wrong .len file.
+ */
+#ifndef INDEXSEGMENT_H
+#define INDEXSEGMENT_H
+
+#include "LearnedIndex.h"
+#include "MappedFile.h"
+#include "Succinct.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class IndexSegment
+ * @brief Publishes and attaches shared index segments.
+ *
+ * Lookups only read the mapping, so any number of threads may call find().
+ */
+class IndexSegment {
+public:
+    IndexSegment();
+
+    /// Order of the keys in the file
+    enum Layout { kSorted = 0, kEytzinger = 1, kCompressed = 2 };
+
+    /**
+     * @brief Writes a segment crash-safely and renames it into place.
+     * @param index ZIP -> offset (ZIPs must be plain numbers, no leading zero)
+     * @param generation Generation of the data file the index belongs to
+     * @param lastSeq Last WAL sequence number included
+     * @param path Segment file
+     * @param version Receives the new version stamp (old version + 1)
+     * @param error Receives a message when it fails
+     * @param layout Order of the keys in the file
+     * @return true on success
+     */
+    static bool publish(const std::unordered_map<std::string, long long>& index,
+                        unsigned long long generation, long long lastSeq,
+                        const std::string& path, unsigned long long& version,
+                        std::string& error, Layout layout = kSorted);
+
+    /// The Eytzinger segment --build-index writes next to an index
+    static std::string eytzingerPathFor(const std::string& indexFile) {
+        return indexFile + ".eyt";
+    }
+
+    /// true if the file starts with the segment magic
+    static bool isSegmentFile(const std::string& path);
+
+    /**
+     * @brief Maps a segment read-only and checks its header.
+     * @param path Segment file
+     * @return false if missing or damaged (see lastError())
+     */
+    bool attach(const std::string& path);
+
+    /// Unmaps the segment
+    void detach();
+
+    bool attached() const { return map_.data() != nullptr; }
+
+    /**
+     * @brief Looks up the record offset of a ZIP (binary search in the
+     *        segment's layout).
+     * @param zip ZIP as stored in the data file
+     * @param offset Receives the offset
+     * @return true if found
+     */
+    bool find(const std::string& zip, long long& offset) const;
+
+    /**
+     * @brief Looks up many ZIPs at once (see BatchSearch.h).
+     *
+     * A sorted segment searches the keys in lockstep groups, which is
+     * several times faster than calling find() for each one.
+     *
+     * @param zips ZIPs as stored in the data file
+     * @param offsets Receives one offset per ZIP, -1 if not found
+     */
+    void findBatch(const std::vector<std::string>& zips,
+                   std::vector<long long>& offsets) const;
+
+    /**
+     * @brief The i-th entry in file order (key order for a sorted segment).
+     * @return false if i is out of range
+     */
+    bool entry(size_t i, std::string& zip, long long& offset) const;
+
+    /**
+     * @brief Whether the loader has published a newer version at the path.
+     *
+     * Reads only the 64-byte header of the file now at the path.
+     */
+    bool replaced() const;
+
+    /// Starts reading the whole segment into memory (MADV_WILLNEED)
+    void prefetch() const { map_.adviseWillNeed(); }
+
+    /// Locks the segment's pages in RAM; false if refused
+    bool lock() const { return map_.lock(); }
+
+    /// Size of the mapping in bytes
+    size_t mappedBytes() const { return map_.size(); }
+
+    /// The learned model of a sorted segment (empty if none was loaded)
+    const LearnedIndex& model() const { return model_; }
+
+    Layout layout() const { return layout_; }
+    unsigned long long version() const { return version_; }
+    unsigned long long generation() const { return generation_; }
+    long long lastSeq() const { return lastSeq_; }
+    size_t size() const { return count_; }
+    const std::string& path() const { return path_; }
+    const std::string& lastError() const { return error_; }
+
+private:
+    MappedFile map_;
+    LearnedIndex model_;
+    std::string path_;
+    const uint32_t* keys_;      ///< layouts 0 and 1
+    const int64_t* offsets_;
+    EliasFano keyEf_;           ///< layout 2
+    EliasFano offsetEf_;
+    PackedArray offsetPacked_;
+    size_t count_;
+    Layout layout_;
+    unsigned long long version_;
+    unsigned long long generation_;
+    long long lastSeq_;
+    std::string error_;
+
+    bool fail(const std::string& message);
+
+    /// Record offset of entry i of a compressed segment
+    long long compressedOffset(size_t i) const {
+        return static_cast<long long>(offsetEf_.size() ? offsetEf_.access(i)
+                                                       : offsetPacked_.get(i));
+    }
+};
+
+#endif
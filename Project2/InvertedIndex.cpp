@@ -0,0 +1,353 @@
+/**
+ * @file InvertedIndex.cpp
+ * @brief Implementation of the InvertedIndex class.
+ * @date October 2026
+ */
+#include "InvertedIndex.h"
+#include "AtomicFile.h"
+#include "PlaceTrie.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <queue>
+
+using namespace std;
+
+static const char kInvMagic[8] = {'I', 'N', 'V', 'I', 'D', 'X', '1', 0};
+
+/// Appends v as a varint (7 bits per byte, high bit = more bytes follow)
+static void putVarint(vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+/// Reads a varint and moves p past it
+static uint64_t getVarint(const uint8_t*& p) {
+    uint64_t v = 0;
+    unsigned shift = 0;
+    while ((*p & 0x80) && shift < 63) {
+        v |= static_cast<uint64_t>(*p++ & 0x7F) << shift;
+        shift += 7;
+    }
+    return v | (static_cast<uint64_t>(*p++) << shift);
+}
+
+/// Writes a u64 count and the elements of a vector or string
+template <typename Array>
+static void writeArray(ofstream& out, const Array& a) {
+    uint64_t count = a.size();
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char*>(a.data()),
+              static_cast<streamsize>(count * sizeof(a[0])));
+}
+
+/// Reads what writeArray() wrote; false if short or longer than maxCount
+template <typename Array>
+static bool readArray(ifstream& in, Array& a, uint64_t maxCount) {
+    uint64_t count = 0;
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!in || count > maxCount) return false;
+    a.resize(static_cast<size_t>(count));
+    if (count > 0)
+        in.read(reinterpret_cast<char*>(&a[0]), static_cast<streamsize>(count * sizeof(a[0])));
+    return static_cast<bool>(in);
+}
+
+/// State code as used in terms: trimmed, upper case
+static string stateCode(const string& state) {
+    string out;
+    for (char c : state) {
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+        out += (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+    }
+    return out;
+}
+
+string InvertedIndex::stateTerm(const string& state) {
+    return "s:" + stateCode(state);
+}
+
+string InvertedIndex::countyTerm(const string& state, const string& county) {
+    return "c:" + stateCode(state) + ":" + PlaceTrie::normalize(county);
+}
+
+string InvertedIndex::placeTerm(const string& place) {
+    return "p:" + PlaceTrie::normalize(place);
+}
+
+InvertedIndex::InvertedIndex() {}
+
+void InvertedIndex::build(const vector<Record>& records) {
+    terms_.clear();
+    names_.clear();
+    skips_.clear();
+    bytes_.clear();
+
+    map<string, vector<uint64_t>> lists;
+    for (const Record& r : records) {
+        lists[stateTerm(r.state)].push_back(r.offset);
+        lists[countyTerm(r.state, r.county)].push_back(r.offset);
+        lists[placeTerm(r.place)].push_back(r.offset);
+    }
+
+    for (auto& entry : lists) {
+        vector<uint64_t>& v = entry.second;
+        sort(v.begin(), v.end());
+        v.erase(unique(v.begin(), v.end()), v.end());
+
+        Term t;
+        t.name = static_cast<uint32_t>(names_.size());
+        t.nameLen = static_cast<uint32_t>(entry.first.size());
+        t.count = static_cast<uint32_t>(v.size());
+        t.skip = static_cast<uint32_t>(skips_.size());
+        t.first = v[0];
+        t.bytes = bytes_.size();
+        names_ += entry.first;
+
+        // A block's first posting is only in the skip table, not a gap.
+        for (size_t i = 1; i < v.size(); i++) {
+            if (i % kBlock == 0) skips_.push_back(Skip{v[i], bytes_.size()});
+            else putVarint(bytes_, v[i] - v[i - 1]);
+        }
+        terms_.push_back(t);
+    }
+}
+
+size_t InvertedIndex::findTerm(const string& term) const {
+    size_t lo = 0, hi = terms_.size();
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const Term& t = terms_[mid];
+        if (names_.compare(t.name, t.nameLen, term) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < terms_.size() && names_.compare(terms_[lo].name, terms_[lo].nameLen, term) == 0)
+        return lo;
+    return terms_.size();
+}
+
+size_t InvertedIndex::postingCount(const string& term) const {
+    size_t t = findTerm(term);
+    return t < terms_.size() ? terms_[t].count : 0;
+}
+
+size_t InvertedIndex::postingTotal() const {
+    size_t n = 0;
+    for (const Term& t : terms_) n += t.count;
+    return n;
+}
+
+size_t InvertedIndex::sizeBytes() const {
+    return terms_.size() * sizeof(Term) + names_.size() + skips_.size() * sizeof(Skip) +
+           bytes_.size();
+}
+
+// ---------------------------------------------------------------------------
+// Cursor
+// ---------------------------------------------------------------------------
+
+InvertedIndex::Cursor::Cursor()
+    : index_(nullptr), term_(0), i_(0), count_(0), value_(0), p_(nullptr) {}
+
+bool InvertedIndex::open(const string& term, Cursor& cursor) const {
+    cursor = Cursor();
+    const size_t t = findTerm(term);
+    if (t == terms_.size()) return false;
+    cursor.index_ = this;
+    cursor.term_ = t;
+    cursor.count_ = terms_[t].count;
+    cursor.value_ = terms_[t].first;
+    cursor.p_ = bytes_.data() + terms_[t].bytes;
+    return true;
+}
+
+void InvertedIndex::Cursor::enterBlock(size_t block) {
+    const Skip& s = index_->skips_[index_->terms_[term_].skip + block - 1];
+    i_ = block * kBlock;
+    value_ = s.value;
+    p_ = index_->bytes_.data() + s.bytes;
+}
+
+void InvertedIndex::Cursor::next() {
+    if (++i_ >= count_) return;
+    if (i_ % kBlock == 0) enterBlock(i_ / kBlock);
+    else value_ += getVarint(p_);
+}
+
+void InvertedIndex::Cursor::skipTo(uint64_t x) {
+    if (!valid() || value_ >= x) return;
+
+    // The last later block that starts at or before x, if any.
+    const Skip* skips = index_->skips_.data() + index_->terms_[term_].skip;
+    size_t lo = i_ / kBlock + 1;
+    size_t hi = (count_ - 1) / kBlock + 1;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (skips[mid - 1].value <= x) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo - 1 > i_ / kBlock) enterBlock(lo - 1);
+
+    while (valid() && value_ < x) next();
+}
+
+// ---------------------------------------------------------------------------
+// Queries
+// ---------------------------------------------------------------------------
+
+void InvertedIndex::intersect(const vector<string>& terms, vector<uint64_t>& out,
+                              size_t& steps) const {
+    out.clear();
+    steps = 0;
+    if (terms.empty()) return;
+
+    vector<Cursor> c(terms.size());
+    for (size_t i = 0; i < terms.size(); i++)
+        if (!open(terms[i], c[i])) return;
+    // The shortest list proposes, the others confirm.
+    sort(c.begin(), c.end(), [](const Cursor& a, const Cursor& b) { return a.size() < b.size(); });
+
+    while (c[0].valid()) {
+        const uint64_t x = c[0].value();
+        bool all = true;
+        for (size_t j = 1; j < c.size(); j++) {
+            c[j].skipTo(x);
+            steps++;
+            if (!c[j].valid()) return;
+            if (c[j].value() > x) {
+                c[0].skipTo(c[j].value());
+                steps++;
+                all = false;
+                break;
+            }
+        }
+        if (all) {
+            out.push_back(x);
+            c[0].next();
+            steps++;
+        }
+    }
+}
+
+void InvertedIndex::unite(const vector<string>& terms, vector<uint64_t>& out,
+                          size_t& steps) const {
+    out.clear();
+    steps = 0;
+
+    vector<Cursor> c(terms.size());
+    // Smallest value on top.
+    typedef pair<uint64_t, size_t> Head;
+    priority_queue<Head, vector<Head>, greater<Head>> heap;
+    for (size_t i = 0; i < terms.size(); i++) {
+        if (open(terms[i], c[i])) heap.push(Head(c[i].value(), i));
+    }
+    while (!heap.empty()) {
+        const Head h = heap.top();
+        heap.pop();
+        if (out.empty() || out.back() != h.first) out.push_back(h.first);
+        Cursor& cur = c[h.second];
+        cur.next();
+        steps++;
+        if (cur.valid()) heap.push(Head(cur.value(), h.second));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// File
+// ---------------------------------------------------------------------------
+
+bool InvertedIndex::save(const string& path, unsigned long long generation,
+                         long long lastSeq, size_t liveRecords) const {
+    string tmp = tempPathFor(path);
+    {
+        ofstream out(tmp, ios::binary);
+        if (!out) return false;
+        uint64_t gen = generation;
+        int64_t seq = lastSeq;
+        uint64_t live = liveRecords;
+        out.write(kInvMagic, sizeof(kInvMagic));
+        out.write(reinterpret_cast<const char*>(&gen), sizeof(gen));
+        out.write(reinterpret_cast<const char*>(&seq), sizeof(seq));
+        out.write(reinterpret_cast<const char*>(&live), sizeof(live));
+        writeArray(out, terms_);
+        writeArray(out, names_);
+        writeArray(out, skips_);
+        writeArray(out, bytes_);
+        if (!out) {
+            out.close();
+            discardTemp(tmp);
+            return false;
+        }
+    }
+    if (!publishFile(tmp, path)) {
+        discardTemp(tmp);
+        return false;
+    }
+    return true;
+}
+
+bool InvertedIndex::load(const string& path, unsigned long long generation,
+                         long long lastSeq, size_t liveRecords) {
+    terms_.clear();
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+
+    char magic[sizeof(kInvMagic)];
+    uint64_t gen = 0, live = 0;
+    int64_t seq = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&gen), sizeof(gen));
+    in.read(reinterpret_cast<char*>(&seq), sizeof(seq));
+    in.read(reinterpret_cast<char*>(&live), sizeof(live));
+    if (!in || memcmp(magic, kInvMagic, sizeof(magic)) != 0 || gen != generation ||
+        seq != lastSeq || live != liveRecords)
+        return false;
+
+    // Three terms per record at most; names and gaps are bounded by bytes.
+    const uint64_t limit = 3 * (live + 1);
+    vector<Term> terms;
+    string names;
+    vector<Skip> skips;
+    vector<uint8_t> bytes;
+    if (!readArray(in, terms, limit) || !readArray(in, names, 256 * limit) ||
+        !readArray(in, skips, limit) || !readArray(in, bytes, 30 * limit))
+        return false;
+
+    // Every list must be sorted terms apart and decode inside the gap bytes.
+    bytes.push_back(0);   // stops a damaged varint at the end
+    for (size_t i = 0; i < terms.size(); i++) {
+        const Term& t = terms[i];
+        const uint64_t blocks = t.count == 0 ? 0 : (t.count - 1) / kBlock;
+        if (t.count == 0 || static_cast<uint64_t>(t.name) + t.nameLen > names.size() ||
+            static_cast<uint64_t>(t.skip) + blocks > skips.size() || t.bytes >= bytes.size())
+            return false;
+        if (i > 0 && names.compare(terms[i - 1].name, terms[i - 1].nameLen, names, t.name,
+                                   t.nameLen) >= 0)
+            return false;
+        const uint8_t* p = bytes.data() + t.bytes;
+        const uint8_t* end = bytes.data() + bytes.size() - 1;
+        for (uint32_t k = 1; k < t.count; k++) {
+            if (k % kBlock == 0) {
+                const Skip& s = skips[t.skip + k / kBlock - 1];
+                if (s.bytes > bytes.size() - 1) return false;
+                p = bytes.data() + s.bytes;
+            } else {
+                if (p >= end) return false;
+                getVarint(p);
+                if (p > end) return false;
+            }
+        }
+    }
+    bytes.pop_back();
+
+    terms_ = std::move(terms);
+    names_ = std::move(names);
+    skips_ = std::move(skips);
+    bytes_ = std::move(bytes);
+    return true;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file InvertedIndex.h
+ * @brief Inverted index from states, (state, county) pairs and place names
+ *        to the records that carry them.
+ * @date October 2026
+ *
+ * "ZIPs in Hennepin county, MN" would otherwise read every record. Here
+ * each term has a posting list: the sorted data file offsets of the live
+ * records with that term. A query combines lists, and only the records in
+ * the result are read.
+ *
+ * Terms (values normalized as in PlaceTrie.h, states upper case):
+ *   "s:MN"               state
+ *   "c:MN:hennepin"      county within a state
+ *   "p:minneapolis"      place name, any state
+ *
+ * Posting lists are compressed: the gaps between offsets are written as
+ * varints (7 bits per byte). Records of one county or place tend to be
+ * close together in the file, so most gaps take one or two bytes. Every
+ * 128th posting also goes into a skip table (its value and where its
+ * block starts), so a cursor can jump over whole blocks. An intersection
+ * walks the shortest list and asks the others to skip to each of its
+ * values (and the other way round when they overshoot), so its cost
+ * follows the shortest list, not the longest. A union merges the lists.
+ *
+ * File "<index file>.inv" (binary, native byte order):
+ *   "INVIDX1\0" | u64 generation | u64 last sequence | u64 live records |
+ *   u64 count + array, for: terms, term characters, skips, posting bytes
+ *
+ * Like the place trie it is built from the live records of a pair and is
+ * stamped with the generation, last WAL sequence and live record count.
+ */
+#ifndef INVERTEDINDEX_H
+#define INVERTEDINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class InvertedIndex
+ * @brief Term -> compressed sorted list of record offsets.
+ *
+ * Lookups only read, so any number of threads may query it.
+ */
+class InvertedIndex {
+public:
+    /// Postings between skip table entries
+    static const size_t kBlock = 128;
+
+    /// Fields of one live record
+    struct Record {
+        std::string state;
+        std::string county;
+        std::string place;
+        uint64_t offset;
+    };
+
+    /// Term for a state
+    static std::string stateTerm(const std::string& state);
+
+    /// Term for a county of a state
+    static std::string countyTerm(const std::string& state, const std::string& county);
+
+    /// Term for a place name
+    static std::string placeTerm(const std::string& place);
+
+    InvertedIndex();
+
+    /**
+     * @brief Builds the index, replacing any previous contents.
+     * @param records One entry per live record
+     */
+    void build(const std::vector<Record>& records);
+
+    /**
+     * @class Cursor
+     * @brief Walks one posting list in order.
+     */
+    class Cursor {
+    public:
+        Cursor();
+
+        bool valid() const { return i_ < count_; }
+        uint64_t value() const { return value_; }
+        size_t size() const { return count_; }
+
+        /// Moves to the next posting
+        void next();
+
+        /// Moves to the first posting >= x (never backwards)
+        void skipTo(uint64_t x);
+
+    private:
+        friend class InvertedIndex;
+
+        const InvertedIndex* index_;
+        size_t term_;
+        size_t i_;
+        size_t count_;
+        uint64_t value_;
+        const uint8_t* p_;   ///< next gap
+
+        void enterBlock(size_t block);
+    };
+
+    /**
+     * @brief Cursor over the postings of a term.
+     * @return false if the term is not in the index (the cursor is then empty)
+     */
+    bool open(const std::string& term, Cursor& cursor) const;
+
+    /// Number of postings of a term (0 if absent)
+    size_t postingCount(const std::string& term) const;
+
+    /**
+     * @brief Offsets of the records that have all of the terms.
+     * @param terms Terms to intersect (none gives no records)
+     * @param out Receives the sorted offsets
+     * @param steps Receives the number of postings visited (cost)
+     */
+    void intersect(const std::vector<std::string>& terms, std::vector<uint64_t>& out,
+                   size_t& steps) const;
+
+    /**
+     * @brief Offsets of the records that have any of the terms.
+     * @param terms Terms to unite
+     * @param out Receives the sorted offsets (no duplicates)
+     * @param steps Receives the number of postings visited (cost)
+     */
+    void unite(const std::vector<std::string>& terms, std::vector<uint64_t>& out,
+               size_t& steps) const;
+
+    /**
+     * @brief Writes the index crash-safely (temp file + rename).
+     * @return true on success
+     */
+    bool save(const std::string& path, unsigned long long generation,
+              long long lastSeq, size_t liveRecords) const;
+
+    /**
+     * @brief Reads an index made for exactly this state of the data.
+     * @return false if missing, damaged, or stale (the index is then empty)
+     */
+    bool load(const std::string& path, unsigned long long generation,
+              long long lastSeq, size_t liveRecords);
+
+    bool empty() const { return terms_.empty(); }
+    size_t termCount() const { return terms_.size(); }
+
+    /// Postings over all terms
+    size_t postingTotal() const;
+
+    /// Size of all arrays in bytes
+    size_t sizeBytes() const;
+
+    /// The usual name for an index file's inverted index
+    static std::string pathFor(const std::string& indexFile) {
+        return indexFile + ".inv";
+    }
+
+private:
+    /// One term, in sorted term order
+    struct Term {
+        uint32_t name;       ///< characters in names_
+        uint32_t nameLen;
+        uint32_t count;      ///< postings
+        uint32_t skip;       ///< skip entry of the second block (if any)
+        uint64_t first;      ///< first posting
+        uint64_t bytes;      ///< gaps in bytes_, from the second posting on
+    };
+
+    /// Start of block b >= 1 of a term
+    struct Skip {
+        uint64_t value;      ///< posting b * kBlock
+        uint64_t bytes;      ///< first gap after it, in bytes_
+    };
+
+    std::vector<Term> terms_;
+    std::string names_;
+    std::vector<Skip> skips_;
+    std::vector<uint8_t> bytes_;
+
+    /// Position of a term in terms_, or terms_.size()
+    size_t findTerm(const std::string& term) const;
+};
+
+#endif
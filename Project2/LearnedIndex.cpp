@@ -0,0 +1,208 @@
+/**
+ * @file LearnedIndex.cpp
+ * @brief Implementation of the LearnedIndex class.
+ * @date October 2026
+ */
+#include "LearnedIndex.h"
+#include "AtomicFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+using namespace std;
+
+/**
+ * @brief First position in [lo, hi) that is not before the answer
+ *        (hi if all are), without branches on the comparisons.
+ *
+ * The window is small and its keys are in cache, so the time goes into
+ * mispredicted branches, not memory; each step here is a conditional move.
+ *
+ * @param before true for positions before the answer (a prefix of the window)
+ */
+template <typename Before>
+static size_t firstNotBefore(Before before, size_t lo, size_t hi) {
+    size_t len = hi - lo;
+    if (len == 0) return lo;
+    while (len > 1) {
+        const size_t half = len / 2;
+        lo += before(lo + half - 1) ? half : 0;
+        len -= half;
+    }
+    return lo + before(lo);
+}
+
+LearnedIndex::LearnedIndex() : epsilon_(kDefaultEpsilon), keyCount_(0) {}
+
+vector<LearnedIndex::Segment> LearnedIndex::fit(const uint32_t* keys, size_t count,
+                                                unsigned epsilon) {
+    vector<Segment> out;
+    const double eps = static_cast<double>(epsilon);
+    size_t i = 0;
+    while (i < count) {
+        // Slopes that keep every key since keys[i] within epsilon.
+        double lo = 0.0;
+        double hi = numeric_limits<double>::infinity();
+        size_t j = i + 1;
+        for (; j < count; j++) {
+            double dx = static_cast<double>(keys[j]) - static_cast<double>(keys[i]);
+            double dy = static_cast<double>(j - i);
+            double l = (dy - eps) / dx;
+            double h = (dy + eps) / dx;
+            if (l > hi || h < lo) break;
+            lo = max(lo, l);
+            hi = min(hi, h);
+        }
+        Segment s;
+        s.key = keys[i];
+        s.start = static_cast<uint32_t>(i);
+        s.slope = (hi == numeric_limits<double>::infinity()) ? lo : (lo + hi) / 2;
+        out.push_back(s);
+        i = j;
+    }
+    return out;
+}
+
+void LearnedIndex::build(const uint32_t* keys, size_t count, unsigned epsilon) {
+    levels_.clear();
+    epsilon_ = epsilon;
+    keyCount_ = count;
+    if (count == 0) return;
+
+    levels_.push_back(fit(keys, count, epsilon));
+    // Every segment covers at least epsilon + 1 entries, so this ends.
+    while (levels_.back().size() > 1) {
+        vector<uint32_t> firsts;
+        firsts.reserve(levels_.back().size());
+        for (const Segment& s : levels_.back()) firsts.push_back(s.key);
+        levels_.push_back(fit(firsts.data(), firsts.size(), kUpperEpsilon));
+    }
+}
+
+void LearnedIndex::window(const vector<Segment>& level, size_t s, size_t size,
+                          unsigned epsilon, uint32_t x, size_t& lo, size_t& hi) const {
+    const Segment& seg = level[s];
+    const size_t end = (s + 1 < level.size()) ? level[s + 1].start : size;
+    double p = static_cast<double>(seg.start) +
+               seg.slope * (static_cast<double>(x) - static_cast<double>(seg.key));
+
+    // Past the segment's last key the answer is at most its end.
+    size_t pos;
+    if (p <= static_cast<double>(seg.start)) pos = seg.start;
+    else if (p >= static_cast<double>(end)) pos = end;
+    else pos = static_cast<size_t>(p);
+
+    // epsilon, plus one for the rounding down and one for a key that
+    // falls between two keys (or is the first of the next segment).
+    const size_t margin = epsilon + 2;
+    lo = (pos > seg.start + margin) ? pos - margin : seg.start;
+    hi = min(end, pos + margin + 1);
+}
+
+size_t LearnedIndex::lowerBound(const uint32_t* keys, size_t count, uint32_t x) const {
+    if (levels_.empty() || count != keyCount_)
+        return static_cast<size_t>(lower_bound(keys, keys + count, x) - keys);
+
+    // The top level is a single segment starting at the smallest key.
+    if (x < levels_.back()[0].key) return 0;
+    size_t s = 0;
+    for (size_t level = levels_.size() - 1; level > 0; level--) {
+        const Segment* below = levels_[level - 1].data();
+        size_t lo, hi;
+        window(levels_[level], s, levels_[level - 1].size(), kUpperEpsilon, x, lo, hi);
+        // The last segment below that starts at or before x.
+        s = firstNotBefore([below, x](size_t i) { return below[i].key <= x; }, lo, hi) - 1;
+    }
+
+    size_t lo, hi;
+    window(levels_[0], s, count, epsilon_, x, lo, hi);
+    return firstNotBefore([keys, x](size_t i) { return keys[i] < x; }, lo, hi);
+}
+
+size_t LearnedIndex::sizeBytes() const {
+    size_t n = 0;
+    for (const auto& level : levels_) n += level.size() * sizeof(Segment);
+    return n;
+}
+
+bool LearnedIndex::save(const string& path, unsigned long long generation,
+                        unsigned long long version) const {
+    string tmp = tempPathFor(path);
+    {
+        ofstream out(tmp, ios::binary);
+        if (!out) return false;
+        uint32_t eps = epsilon_;
+        uint64_t gen = generation;
+        uint64_t ver = version;
+        uint64_t keys = keyCount_;
+        uint32_t levels = static_cast<uint32_t>(levels_.size());
+        out.write("PGM1", 4);
+        out.write(reinterpret_cast<const char*>(&eps), sizeof(eps));
+        out.write(reinterpret_cast<const char*>(&gen), sizeof(gen));
+        out.write(reinterpret_cast<const char*>(&ver), sizeof(ver));
+        out.write(reinterpret_cast<const char*>(&keys), sizeof(keys));
+        out.write(reinterpret_cast<const char*>(&levels), sizeof(levels));
+        for (const auto& level : levels_) {
+            uint64_t count = level.size();
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            out.write(reinterpret_cast<const char*>(level.data()),
+                      static_cast<streamsize>(count * sizeof(Segment)));
+        }
+        if (!out) {
+            out.close();
+            discardTemp(tmp);
+            return false;
+        }
+    }
+    if (!publishFile(tmp, path)) {
+        discardTemp(tmp);
+        return false;
+    }
+    return true;
+}
+
+bool LearnedIndex::load(const string& path, unsigned long long generation,
+                        unsigned long long version, size_t keyCount) {
+    levels_.clear();
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+
+    char magic[4];
+    uint32_t eps = 0, levels = 0;
+    uint64_t gen = 0, ver = 0, keys = 0;
+    in.read(magic, 4);
+    in.read(reinterpret_cast<char*>(&eps), sizeof(eps));
+    in.read(reinterpret_cast<char*>(&gen), sizeof(gen));
+    in.read(reinterpret_cast<char*>(&ver), sizeof(ver));
+    in.read(reinterpret_cast<char*>(&keys), sizeof(keys));
+    in.read(reinterpret_cast<char*>(&levels), sizeof(levels));
+    if (!in || memcmp(magic, "PGM1", 4) != 0 || gen != generation ||
+        ver != version || keys != keyCount || levels == 0 || levels > 32)
+        return false;
+
+    // Each level must index exactly the entries of the one below it.
+    vector<vector<Segment>> loaded(levels);
+    size_t below = keyCount;
+    for (uint32_t l = 0; l < levels; l++) {
+        uint64_t count = 0;
+        in.read(reinterpret_cast<char*>(&count), sizeof(count));
+        if (!in || count == 0 || count > below) return false;
+        loaded[l].resize(count);
+        in.read(reinterpret_cast<char*>(loaded[l].data()),
+                static_cast<streamsize>(count * sizeof(Segment)));
+        if (!in || loaded[l][0].start != 0) return false;
+        for (size_t i = 1; i < count; i++) {
+            if (loaded[l][i].start <= loaded[l][i - 1].start || loaded[l][i].start >= below)
+                return false;
+        }
+        below = count;
+    }
+    if (loaded.back().size() != 1) return false;
+
+    levels_ = std::move(loaded);
+    epsilon_ = eps;
+    keyCount_ = keyCount;
+    return true;
+}
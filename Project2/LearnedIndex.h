@@ -0,0 +1,131 @@
+/**
+ * @file LearnedIndex.h
+ * @brief Piecewise-linear model (PGM-style learned index) that predicts
+ *        where a key sits in a sorted u32 array.
+ * @date October 2026
+ *
+ * ZIPs grow nearly evenly within a region, so "position = a + b * key"
+ * is already close over long stretches of the sorted keys. The model cuts
+ * the keys into segments, each with its own line, such that the line is
+ * never more than epsilon positions off for a key of that segment. A
+ * lookup evaluates one line and then searches only 2 * epsilon + a few
+ * keys around the prediction: one or two cache lines instead of the
+ * log2(n) scattered probes of a binary search.
+ *
+ * Segments are found the same way. Their first keys get a model of their
+ * own, and so on up to a single segment. With a few thousand segments
+ * this is two or three levels, and the whole model is a few KB.
+ *
+ * Building: one pass with a "shrinking cone". A segment starts at a key.
+ * Every further key narrows the range of slopes that keep all keys so far
+ * within epsilon. When the range becomes empty, the segment ends before
+ * that key.
+ *
+ * File "<index file>.pgm" (binary, native byte order):
+ *   "PGM1" | u32 epsilon | u64 generation | u64 version | u64 key count |
+ *   u32 levels | per level, bottom first: u64 segment count, segments
+ *   (u32 first key, u32 first position, f64 slope)
+ */
+#ifndef LEARNEDINDEX_H
+#define LEARNEDINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class LearnedIndex
+ * @brief Multi-level piecewise-linear position model over sorted keys.
+ *
+ * The model does not hold the keys; lookups are given the same array it
+ * was built from. Lookups only read, so any number of threads may call
+ * lowerBound().
+ */
+class LearnedIndex {
+public:
+    /// Maximum prediction error on the keys (bottom level)
+    static const unsigned kDefaultEpsilon = 32;
+
+    /// Maximum prediction error in the upper levels
+    static const unsigned kUpperEpsilon = 8;
+
+    LearnedIndex();
+
+    /**
+     * @brief Fits the model to sorted, distinct keys.
+     * @param keys Sorted keys
+     * @param count Number of keys
+     * @param epsilon Maximum error (in positions) on the bottom level
+     */
+    void build(const uint32_t* keys, size_t count, unsigned epsilon = kDefaultEpsilon);
+
+    /**
+     * @brief Index of the first key >= x in the array the model was built from.
+     * @param keys The same sorted keys given to build()
+     * @param count Their number
+     * @param x Key to look for
+     * @return position (count if every key is smaller)
+     */
+    size_t lowerBound(const uint32_t* keys, size_t count, uint32_t x) const;
+
+    /**
+     * @brief Writes the model crash-safely (temp file + rename).
+     * @param path Output file
+     * @param generation Data file generation of the keys
+     * @param version Version of the key file (e.g. segment version)
+     * @return true on success
+     */
+    bool save(const std::string& path, unsigned long long generation,
+              unsigned long long version) const;
+
+    /**
+     * @brief Reads a model written for exactly these keys.
+     * @return false if missing, damaged, or made for another generation,
+     *         version or key count (the model is then empty)
+     */
+    bool load(const std::string& path, unsigned long long generation,
+              unsigned long long version, size_t keyCount);
+
+    /// true if there is no model (lookups must not use it)
+    bool empty() const { return levels_.empty(); }
+
+    /// Segments on the bottom level
+    size_t segmentCount() const { return levels_.empty() ? 0 : levels_[0].size(); }
+
+    /// Levels, bottom included
+    size_t levelCount() const { return levels_.size(); }
+
+    /// Size of the model in bytes
+    size_t sizeBytes() const;
+
+    unsigned epsilon() const { return epsilon_; }
+
+    /// The usual model name for a sorted key file
+    static std::string pathFor(const std::string& keyFile) {
+        return keyFile + ".pgm";
+    }
+
+private:
+    /// One line: position = start + slope * (key - key of the segment)
+    struct Segment {
+        uint32_t key;
+        uint32_t start;
+        double slope;
+    };
+
+    unsigned epsilon_;
+    size_t keyCount_;
+    std::vector<std::vector<Segment>> levels_;   ///< bottom level first
+
+    static std::vector<Segment> fit(const uint32_t* keys, size_t count, unsigned epsilon);
+
+    /**
+     * @brief Predicted window [lo, hi) of a key inside segment s of a level.
+     * @param size Number of entries the level indexes
+     */
+    void window(const std::vector<Segment>& level, size_t s, size_t size,
+                unsigned epsilon, uint32_t x, size_t& lo, size_t& hi) const;
+};
+
+#endif
@@ -0,0 +1,303 @@
+/**
+ * @file LenCompactor.cpp
+ * @brief Implementation of the LenCompactor class.
+ * @date October 2026
+ */
+#include "LenCompactor.h"
+#include "ZipDataStore.h"
+#include "HeaderBuffer.h"
+#include "LenFileWriter.h"
+#include "AtomicFile.h"
+#include "BloomFilter.h"
+#include "IndexSegment.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * @brief Orders ZIP strings numerically ("501" before "1001").
+ */
+static bool zipLess(const string& a, const string& b) {
+    if (a.size() != b.size()) return a.size() < b.size();
+    return a < b;
+}
+
+/**
+ * @brief Returns the size of a file, or -1 if it cannot be read.
+ */
+static long long fileSize(const string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return -1;
+    return static_cast<long long>(st.st_size);
+}
+
+LenCompactor::LenCompactor()
+    : running_(false), copied_(0), total_(0), caughtUp_(0),
+      bytesBefore_(0), bytesAfter_(0), ok_(false) {}
+
+LenCompactor::~LenCompactor() {
+    if (worker_.joinable()) worker_.join();
+}
+
+bool LenCompactor::fail(const string& message) {
+    error_ = message;
+    ok_ = false;
+    return false;
+}
+
+bool LenCompactor::start(const string& lenFile, const string& idxFile) {
+    if (running_) return fail("A compaction is already running.");
+    if (worker_.joinable()) worker_.join();
+
+    lenFile_ = lenFile;
+    idxFile_ = idxFile;
+    copied_ = 0;
+    caughtUp_ = 0;
+    bytesBefore_ = fileSize(lenFile);
+    bytesAfter_ = 0;
+    ok_ = false;
+    error_.clear();
+
+    running_ = true;
+    worker_ = thread(&LenCompactor::run, this);
+    return true;
+}
+
+bool LenCompactor::wait() {
+    if (worker_.joinable()) worker_.join();
+    return ok_;
+}
+
+void LenCompactor::run() {
+    // ---- 1) Snapshot: the index (plus WAL) as it is now, no lock ----------
+    // The store keeps the old data file open, so its records stay readable
+    // even after the new file is renamed over it.
+    unique_ptr<ZipDataStore> old(new ZipDataStore());
+    if (!old->open(lenFile_, idxFile_, false)) {
+        fail(old->lastError());
+        running_ = false;
+        return;
+    }
+    if (!old->headerParsed()) {
+        fail("Compaction needs a version 3+ header; recreate the file with --make-len.");
+        running_ = false;
+        return;
+    }
+    const unordered_map<string, long long> snapshot = old->index();
+    total_ = static_cast<long long>(snapshot.size());
+
+    const FileHeader oldHeader = old->header();
+    const bool withChecksum = (oldHeader.checksumType == "crc32c");
+    const unsigned long long generation = HeaderBuffer::newGeneration();
+
+    vector<string> keys;
+    keys.reserve(snapshot.size());
+    for (const auto& e : snapshot) keys.push_back(e.first);
+    sort(keys.begin(), keys.end(), zipLess);
+
+    // ---- 2) Copy live records in ZIP order, indexing while streaming -------
+    string tmpData = tempPathFor(lenFile_);
+    ofstream out(tmpData);
+    if (!out) {
+        fail("Cannot create " + tmpData);
+        running_ = false;
+        return;
+    }
+
+    HeaderBuffer hbuf;
+    hbuf.buildDefault(oldHeader.indexFileName, static_cast<long>(total_),
+                      generation, oldHeader.checksumType);
+    hbuf.write(out);
+
+    unordered_map<string, long long> newIndex;
+    newIndex.reserve(snapshot.size());
+    vector<long long> copiedAt;   // offsets of the copies, ascending
+    copiedAt.reserve(snapshot.size());
+    string record;
+    for (const string& zip : keys) {
+        LenStatus st = old->readRecordAt(snapshot.at(zip), record);
+        if (st != LenStatus::Ok) {
+            out.close();
+            discardTemp(tmpData);
+            fail("Record for ZIP " + zip + " cannot be read ("
+                 + lenStatusText(st) + "); run --verify");
+            running_ = false;
+            return;
+        }
+        newIndex[zip] = static_cast<long long>(out.tellp());
+        copiedAt.push_back(newIndex[zip]);
+        writeLenRecord(out, record, withChecksum);
+        copied_++;
+    }
+    const long long copyEnd = static_cast<long long>(out.tellp());
+
+    // Size of the copy at offset (the next copy starts where it ends).
+    auto copiedBytes = [&](long long offset) {
+        auto next = upper_bound(copiedAt.begin(), copiedAt.end(), offset);
+        return (next == copiedAt.end() ? copyEnd : *next) - offset;
+    };
+
+    // ---- 3) Swap under the update lock ---------------------------------------
+    int lockFd = ::open((lenFile_ + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+    if (lockFd < 0 || flock(lockFd, LOCK_EX) != 0) {
+        if (lockFd >= 0) ::close(lockFd);
+        out.close();
+        discardTemp(tmpData);
+        fail("Cannot lock " + lenFile_ + ".lock");
+        running_ = false;
+        return;
+    }
+
+    auto abandon = [&](const string& message) {
+        out.close();
+        discardTemp(tmpData);
+        ::close(lockFd);
+        fail(message);
+        running_ = false;
+    };
+
+    // Changes committed since the snapshot (updates by other processes).
+    ZipDataStore current;
+    if (!current.open(lenFile_, idxFile_, false)) {
+        abandon(current.lastError());
+        return;
+    }
+    if (current.header().generation != oldHeader.generation) {
+        abandon("Data file was replaced during compaction; nothing published.");
+        return;
+    }
+    // The copies they replace or delete stay in the new file as dead
+    // records, counted in the new index header like an update's.
+    long long deadRecords = 0, deadBytes = 0;
+    for (const auto& e : current.index()) {
+        auto snap = snapshot.find(e.first);
+        if (snap != snapshot.end() && snap->second == e.second) continue;
+        if (current.readRecordAt(e.second, record) != LenStatus::Ok) {
+            abandon("Updated record for ZIP " + e.first + " cannot be read.");
+            return;
+        }
+        if (snap != snapshot.end()) {
+            deadRecords++;
+            deadBytes += copiedBytes(newIndex[e.first]);
+        }
+        newIndex[e.first] = static_cast<long long>(out.tellp());
+        writeLenRecord(out, record, withChecksum);
+        caughtUp_++;
+    }
+    for (const auto& e : snapshot) {
+        if (current.index().count(e.first) != 0) continue;
+        deadRecords++;
+        deadBytes += copiedBytes(newIndex[e.first]);
+        newIndex.erase(e.first);
+    }
+    const long long lastSeq = current.lastSequence();
+    current.close();
+
+    // Final record count, rewritten in place (fixed-size header).
+    hbuf.buildDefault(oldHeader.indexFileName,
+                      static_cast<long>(newIndex.size()), generation,
+                      oldHeader.checksumType);
+    out.seekp(0);
+    hbuf.write(out);
+    out.close();
+    if (!out) {
+        abandon("Cannot write " + tmpData);
+        return;
+    }
+
+    vector<pair<long long, const string*>> entries;
+    entries.reserve(newIndex.size());
+    for (const auto& e : newIndex) entries.push_back({e.second, &e.first});
+    sort(entries.begin(), entries.end());
+
+    string tmpIdx = tempPathFor(idxFile_);
+    {
+        ofstream idx(tmpIdx);
+        idx << "IDX,2," << HeaderBuffer::generationText(generation) << ","
+            << deadRecords << "," << deadBytes << "," << lastSeq << "\n";
+        for (const auto& e : entries) idx << *e.second << " " << e.first << "\n";
+        if (!idx) {
+            idx.close();
+            discardTemp(tmpIdx);
+            abandon("Cannot write " + tmpIdx);
+            return;
+        }
+    }
+
+    // The filter, the index and an Eytzinger segment, if the index has one,
+    // go under their pending names first; readers of the old pair do not
+    // look there.
+    const string bloomPath = BloomFilter::pathFor(idxFile_);
+    const string pendingBloom = ZipDataStore::pendingPathFor(bloomPath);
+    BloomFilter bloom;
+    bloom.reset(newIndex.size());
+    for (const auto& e : newIndex) bloom.add(e.first);
+    if (!bloom.save(pendingBloom, generation)) {
+        discardTemp(tmpIdx);
+        remove(pendingBloom.c_str());
+        abandon("Cannot write " + pendingBloom);
+        return;
+    }
+
+    const string pendingIdx = ZipDataStore::pendingPathFor(idxFile_);
+    const string eyt = IndexSegment::eytzingerPathFor(idxFile_);
+    const string pendingEyt = ZipDataStore::pendingPathFor(eyt);
+    const bool withEyt = access(eyt.c_str(), F_OK) == 0;
+    unsigned long long version = 0;
+    string eytError;
+    if (!publishFile(tmpIdx, pendingIdx)) {
+        discardTemp(tmpIdx);
+        remove(pendingBloom.c_str());
+        abandon("Cannot publish " + pendingIdx);
+        return;
+    }
+    if (withEyt && !IndexSegment::publish(newIndex, generation, 0, pendingEyt, version,
+                                          eytError, IndexSegment::kEytzinger)) {
+        remove(pendingIdx.c_str());
+        remove(pendingBloom.c_str());
+        abandon(eytError);
+        return;
+    }
+
+    // The data file's rename is the commit point: from here on, opening
+    // the pair finds the new index under the pending name if it is not in
+    // place yet (see ZipDataStore::loadIndex()).
+    if (!publishFile(tmpData, lenFile_)) {
+        remove(pendingIdx.c_str());
+        remove(pendingBloom.c_str());
+        if (withEyt) remove(pendingEyt.c_str());
+        abandon("Cannot publish " + lenFile_);
+        return;
+    }
+    // The filter moves before the index, so a pending filter is always
+    // found next to the pending index it belongs to.
+    if (!publishFile(pendingBloom, bloomPath) || !publishFile(pendingIdx, idxFile_) ||
+        (withEyt && !publishFile(pendingEyt, eyt))) {
+        ::close(lockFd);
+        fail("Data file published but the index is still " + pendingIdx +
+             "; the next open for update moves it into place.");
+        running_ = false;
+        return;
+    }
+
+    // The old WAL belongs to the old generation and is no longer needed.
+    remove((lenFile_ + ".wal").c_str());
+    ::close(lockFd);
+
+    bytesAfter_ = fileSize(lenFile_);
+    ok_ = true;
+    running_ = false;
+}
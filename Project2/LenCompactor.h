@@ -0,0 +1,100 @@
+/**
+ * @file LenCompactor.h
+ * @brief Rewrites a .len file with only its live records (vacuum).
+ * @date October 2026
+ *
+ * Updates (see ZipDataStore.h) leave old record versions behind as dead
+ * space. Compaction writes a new data file holding only the records the
+ * index points at, in ZIP order, and builds the new index while writing.
+ *
+ * How searches keep working while compaction runs:
+ * 1) start() launches a background thread, which first takes a snapshot:
+ *    the index as it is right now (with the WAL applied). No lock needed.
+ * 2) The thread copies the snapshot's records into temp files.
+ *    Readers and updaters use the old files the whole time.
+ * 3) To finish, the thread takes the update lock (<data>.len.lock). It
+ *    copies any record changed by an update made after the snapshot, then
+ *    publishes the new files with atomic renames (see AtomicFile.h) and
+ *    removes the old WAL. Deleted ZIPs (tombstones) are simply not copied.
+ *
+ * The new files get a new generation id, and the swap has one commit
+ * point. The Bloom filter (keyed by generation) and the index are
+ * published first under ZipDataStore::pendingPathFor(); then the data file
+ * is renamed over the old one; then the filter and the index are renamed
+ * into place. A reader that opens the new data file before the last
+ * renames finds them under the pending names and uses them (an updater, or the
+ * next one after a crash, finishes the rename). A reader that opened the
+ * old data file and then finds the new index opens again. So nobody reads
+ * a half-swapped pair, and no open waits for the compaction. Processes
+ * that already have the old files open keep reading the old (now
+ * unlinked) files until they reopen.
+ */
+#ifndef LENCOMPACTOR_H
+#define LENCOMPACTOR_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+/**
+ * @class LenCompactor
+ * @brief Runs one compaction of a data/index pair on a background thread.
+ */
+class LenCompactor {
+public:
+    LenCompactor();
+    ~LenCompactor();
+
+    LenCompactor(const LenCompactor&) = delete;
+    LenCompactor& operator=(const LenCompactor&) = delete;
+
+    /**
+     * @brief Starts the background snapshot, copy and swap.
+     * @param lenFile Data file (.len)
+     * @param idxFile Index file (.idx)
+     * @return false if a compaction is already running
+     */
+    bool start(const std::string& lenFile, const std::string& idxFile);
+
+    /**
+     * @brief Waits for the background thread to finish.
+     * @return true if the new files were published
+     */
+    bool wait();
+
+    /// true while the background thread is still working
+    bool running() const { return running_; }
+
+    /// Records copied so far (for progress reports)
+    long long recordsCopied() const { return copied_; }
+
+    /// Live records in the snapshot
+    long long recordsTotal() const { return total_; }
+
+    /// Records re-copied because they were updated during compaction
+    long long recordsCaughtUp() const { return caughtUp_; }
+
+    /// Data file size before and after
+    long long bytesBefore() const { return bytesBefore_; }
+    long long bytesAfter() const { return bytesAfter_; }
+
+    const std::string& lastError() const { return error_; }
+
+private:
+    std::string lenFile_;
+    std::string idxFile_;
+    std::thread worker_;
+    std::atomic<bool> running_;
+    std::atomic<long long> copied_;
+    std::atomic<long long> total_;
+    long long caughtUp_;
+    long long bytesBefore_;
+    long long bytesAfter_;
+    bool ok_;
+    std::string error_;
+
+    void run();
+    bool fail(const std::string& message);
+};
+
+#endif
@@ -6,10 +6,74 @@
  * @date March 2026
  */
 #include "LenFileReader.h"
+#include "Crc32c.h"
 #include <cctype>    // for std::isdigit
 
 using namespace std;
 
+const char* lenStatusText(LenStatus status)
+{
+    switch (status) {
+    case LenStatus::Ok:           return "ok";
+    case LenStatus::EndOfFile:    return "end of file";
+    case LenStatus::BadLength:    return "length field is not 10 digits";
+    case LenStatus::BadSeparator: return "missing space separator";
+    case LenStatus::Truncated:    return "record is truncated";
+    case LenStatus::BadChecksum:  return "checksum mismatch";
+    }
+    return "unknown error";
+}
+
+bool parseCrcHex(const char* hex, uint32_t& crc)
+{
+    crc = 0;
+    for (int i = 0; i < 8; i++) {
+        char c = hex[i];
+        uint32_t v;
+        if (c >= '0' && c <= '9')      v = c - '0';
+        else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+        else return false;
+        crc = (crc << 4) | v;
+    }
+    return true;
+}
+
+LenStatus frameLenRecord(const char* base, size_t size, size_t pos,
+                         bool hasChecksum, LenRecordView& view)
+{
+    if (pos >= size) return LenStatus::EndOfFile;
+    if (size - pos < 11) return LenStatus::Truncated;
+
+    const char* p = base + pos;
+    size_t length = 0;
+    for (int i = 0; i < 10; i++) {
+        if (!isdigit(static_cast<unsigned char>(p[i]))) return LenStatus::BadLength;
+        length = length * 10 + static_cast<size_t>(p[i] - '0');
+    }
+    if (p[10] != ' ') return LenStatus::BadSeparator;
+
+    view.start = pos;
+    view.textOffset = pos + 11;
+    view.textLength = length;
+    view.storedCrc = 0;
+    view.crcReadable = true;
+    if (length > size - view.textOffset) return LenStatus::Truncated;
+
+    size_t q = view.textOffset + length;
+    if (hasChecksum) {
+        if (size - q < 9) return LenStatus::Truncated;
+        if (base[q] != ' ') return LenStatus::BadSeparator;
+        view.crcReadable = parseCrcHex(base + q + 1, view.storedCrc);
+        q += 9;
+    }
+
+    if (q < size && base[q] == '\r') q++;
+    if (q < size && base[q] == '\n') q++;
+    view.next = q;
+    return LenStatus::Ok;
+}
+
 /**
  * @brief Reads one length-indicated record from the input stream.
  *
@@ -21,43 +85,60 @@ using namespace std;
  *
  * @param in Input stream
  * @param recordLine Output record data (CSV-style text)
+ * @param hasChecksum true if records carry a CRC32C
  * @return true if successful, false if EOF or bad format
  */
-bool readLenRecord(ifstream& in, string& recordLine)
+bool readLenRecord(istream& in, string& recordLine, bool hasChecksum)
+{
+    return readLenRecordChecked(in, recordLine, hasChecksum) == LenStatus::Ok;
+}
+
+LenStatus readLenRecordChecked(istream& in, string& recordLine,
+                               bool hasChecksum)
 {
     recordLine.clear();
 
     // 1) Read 10 bytes for length
     char lenBuf[10];
     if (!in.read(lenBuf, 10)) {
-        // likely EOF or stream error
-        return false;
+        // EOF exactly at a record start is normal; anything else is not
+        return in.gcount() == 0 ? LenStatus::EndOfFile : LenStatus::Truncated;
     }
 
     // 2) Validate they are digits (simple safety check)
     for (int i = 0; i < 10; i++) {
         if (!isdigit(static_cast<unsigned char>(lenBuf[i]))) {
-            return false; // bad format
+            return LenStatus::BadLength;
         }
     }
 
     // 3) Read the space after length
     char space;
     if (!in.get(space) || space != ' ') {
-        return false; // bad format
+        return LenStatus::BadSeparator;
     }
 
     // Convert length buffer into integer
-    int length = stoi(string(lenBuf, 10));
-    if (length < 0) return false;
+    long long length = stoll(string(lenBuf, 10));
 
     // 4) Read exactly "length" characters of record data
-    recordLine.resize(length);
-    if (!in.read(&recordLine[0], length)) {
-        return false; // truncated file
+    recordLine.resize(static_cast<size_t>(length));
+    if (length > 0 && !in.read(&recordLine[0], length)) {
+        return LenStatus::Truncated;
     }
 
-    // 5) Consume newline if present (supports \n or \r\n)
+    // 5) Checksum suffix: " XXXXXXXX"
+    if (hasChecksum) {
+        char crcBuf[9];
+        if (!in.read(crcBuf, 9)) return LenStatus::Truncated;
+        if (crcBuf[0] != ' ') return LenStatus::BadSeparator;
+        uint32_t stored;
+        if (!parseCrcHex(crcBuf + 1, stored)) return LenStatus::BadChecksum;
+        if (stored != crc32c(recordLine.data(), recordLine.size()))
+            return LenStatus::BadChecksum;
+    }
+
+    // 6) Consume newline if present (supports \n or \r\n)
     if (in.peek() == '\n') {
         in.get();
     } else if (in.peek() == '\r') {
@@ -65,5 +146,5 @@ bool readLenRecord(ifstream& in, string& recordLine)
         if (in.peek() == '\n') in.get();
     }
 
-    return true;
+    return LenStatus::Ok;
 }
\ No newline at end of file
@@ -10,6 +10,10 @@
  * Example:
  * 0000000042 56301,St Cloud,MN,Stearns,45.5579,-94.1632
  *
+ * If the file header says "crc32c", every record also carries a checksum:
+ * [10 ASCII digits length][space][record text][space][8 hex CRC32C][newline]
+ * The length still counts only the record text. The CRC covers the text.
+ *
  * This reader helps the program follow the RAM rule:
  * - Only ONE record is read at a time.
  * - The entire data file is not loaded into memory.
@@ -18,7 +22,28 @@
 #define LENFILEREADER_H
 
 #include <string>
-#include <fstream>
+#include <istream>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Result of reading one record, so callers can report exact errors.
+ */
+enum class LenStatus {
+    Ok,           ///< record read (and checksum matched, if any)
+    EndOfFile,    ///< no more bytes at the record start
+    BadLength,    ///< the 10 length bytes are not all digits
+    BadSeparator, ///< no space after the length (or before the checksum)
+    Truncated,    ///< file ends inside the record
+    BadChecksum   ///< stored CRC32C does not match the record text
+};
+
+/**
+ * @brief Short text for a LenStatus, used in error messages.
+ * @param status Read result
+ * @return e.g. "checksum mismatch"
+ */
+const char* lenStatusText(LenStatus status);
 
 /**
  * @brief Reads one length-indicated record from a .len file.
@@ -28,12 +53,63 @@
  * 2) Convert them to an integer
  * 3) Read 1 space character
  * 4) Read exactly "length" characters into recordLine
- * 5) Optionally consume newline at the end
+ * 5) If hasChecksum, read the space and 8 hex digits and check the CRC32C
+ * 6) Optionally consume newline at the end
  *
  * @param in Input file stream (must already be open)
  * @param recordLine Output string that receives the record data text
+ * @param hasChecksum true if the file header says records carry a CRC32C
  * @return true if a record was read successfully, false if EOF or format error
  */
-bool readLenRecord(std::ifstream& in, std::string& recordLine);
+bool readLenRecord(std::istream& in, std::string& recordLine,
+                   bool hasChecksum = false);
+
+/**
+ * @brief Same as readLenRecord(), but tells the caller what went wrong.
+ * @param in Input stream
+ * @param recordLine Output record text
+ * @param hasChecksum true if records carry a CRC32C
+ * @return LenStatus::Ok on success, otherwise the reason for failure
+ */
+LenStatus readLenRecordChecked(std::istream& in, std::string& recordLine,
+                               bool hasChecksum);
+
+/**
+ * @brief Where one record sits inside an in-memory (mapped) .len file.
+ */
+struct LenRecordView {
+    size_t start;        ///< offset of the 10-digit length field
+    size_t textOffset;   ///< offset of the first record text byte
+    size_t textLength;   ///< number of record text bytes
+    uint32_t storedCrc;  ///< checksum from the file (0 if none)
+    bool crcReadable;    ///< false if the stored checksum is not 8 hex digits
+    size_t next;         ///< offset where the next record starts
+};
+
+/**
+ * @brief Frames one record in a memory buffer without copying it.
+ *
+ * Checks the length digits, separators and that the record fits in the
+ * buffer. The checksum is parsed but NOT compared, so the caller can
+ * decide when (and on which thread) to spend time on CRC32C. A damaged
+ * checksum field does not break framing; it only clears crcReadable.
+ *
+ * @param base First byte of the file
+ * @param size File size
+ * @param pos Offset of the record start
+ * @param hasChecksum true if records carry a CRC32C
+ * @param view Receives the record position
+ * @return LenStatus::Ok, or the framing problem found
+ */
+LenStatus frameLenRecord(const char* base, size_t size, size_t pos,
+                         bool hasChecksum, LenRecordView& view);
+
+/**
+ * @brief Parses the 8 hex digits of a stored checksum.
+ * @param hex Pointer to 8 characters
+ * @param crc Receives the value
+ * @return false if any character is not a hex digit
+ */
+bool parseCrcHex(const char* hex, uint32_t& crc);
 
 #endif
\ No newline at end of file
@@ -8,6 +8,7 @@
  * This file contains the code that writes the length-indicated format.
  */
 #include "LenFileWriter.h"
+#include "Crc32c.h"
 #include <fstream>
 #include <iostream>
 #include <iomanip>
@@ -22,19 +23,27 @@ using namespace std;
  *
  * Example:
  * 0000000005 hello
+ * 0000000005 hello 9a71bb4c   (withChecksum)
  *
  * @param out Output stream (file)
  * @param text The text to write (this is the record data)
+ * @param withChecksum true to append the CRC32C of text
  * @return true if writing succeeded, false otherwise
  */
-static bool writeLenLine(ostream& out, const string& text) {
+bool writeLenRecord(ostream& out, const string& text, bool withChecksum) {
     // If the record text is empty, we choose not to write it.
     if (text.empty()) return false;
 
     // Write length as 10 digits with leading zeros.
     // Example: 42 becomes 0000000042
     out << setw(10) << setfill('0') << text.size()
-        << ' ' << text << '\n';
+        << ' ' << text;
+
+    if (withChecksum) {
+        out << ' ' << hex << setw(8) << setfill('0')
+            << crc32c(text.data(), text.size()) << dec;
+    }
+    out << '\n';
 
     // Return whether the stream is still good.
     return static_cast<bool>(out);
@@ -78,7 +87,7 @@ void makeLenFile(const string& csvFile, const string& lenFile)
     // This record itself also uses the LEN format.
     // Example header text: HDR,ZipLenFile,1,SIZEFMT=ASCII,SIZEWIDTH=10
     string lenHeaderText = "HDR,ZipLenFile,1,SIZEFMT=ASCII,SIZEWIDTH=10";
-    if (!writeLenLine(out, lenHeaderText)) {
+    if (!writeLenRecord(out, lenHeaderText)) {
         cout << "Error: Failed writing LEN header record.\n";
         return;
     }
@@ -90,7 +99,7 @@ void makeLenFile(const string& csvFile, const string& lenFile)
     while (getline(in, line)) {
         if (line.empty()) continue; // skip empty lines
 
-        if (!writeLenLine(out, line)) {
+        if (!writeLenRecord(out, line)) {
             cout << "Warning: Skipped a line that could not be written.\n";
             continue;
         }
@@ -17,6 +17,11 @@
  * - It tells how many characters are in the CSV text after the space.
  * - The CSV text is still comma-separated.
  *
+ * Optional checksum (header checksum type "crc32c"):
+ * 0000000042 56301,St Cloud,MN,Stearns,45.5579,-94.1632 1c2b9f07
+ * - The 8 hex digits are the CRC32C of the CSV text.
+ * - The length still counts only the CSV text.
+ *
  * Why we do this:
  * - Later, we will build an index that stores ZIP -> file position (offset).
  * - Then we can jump directly to a ZIP record without reading the whole file.
@@ -25,6 +30,21 @@
 #define LENFILEWRITER_H
 
 #include <string>
+#include <ostream>
+
+/**
+ * @brief Writes one length-indicated record to an output stream.
+ *
+ * Format: [10 digits length][space][text][newline], or with a checksum
+ * [10 digits length][space][text][space][8 hex CRC32C][newline].
+ *
+ * @param out Output stream (file)
+ * @param text The record text (must not be empty)
+ * @param withChecksum true to append the CRC32C of text
+ * @return true if writing succeeded, false otherwise
+ */
+bool writeLenRecord(std::ostream& out, const std::string& text,
+                    bool withChecksum = false);
 
 /**
  * @brief Creates a .len file from a CSV file.
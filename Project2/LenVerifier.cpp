@@ -0,0 +1,490 @@
+/**
+ * @file LenVerifier.cpp
+ * @brief Implementation of the --verify mode.
+ * @date October 2026
+ */
+#include "LenVerifier.h"
+#include "LenFileReader.h"
+#include "HeaderBuffer.h"
+#include "MappedFile.h"
+#include "Crc32c.h"
+#include "ZipDataStore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief One problem found, kept with the file offset it belongs to so
+ *        the final report is in file order no matter which thread found it.
+ */
+struct Problem {
+    size_t offset;   ///< data file offset (or index line number for index problems)
+    string message;  ///< human readable description
+};
+
+/**
+ * @brief Parses one "ZIP offset" line of the index file, as `>> zip >>
+ *        offset` would (leading blanks skipped, anything after ignored).
+ * @return false if the line has no ZIP or no number after it
+ */
+static bool parseIndexLine(const char* p, const char* end, string& zip,
+                           long long& offset) {
+    auto blank = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+    while (p < end && blank(*p)) p++;
+    const char* zipStart = p;
+    while (p < end && !blank(*p)) p++;
+    if (p == zipStart) return false;
+    zip.assign(zipStart, p);
+    while (p < end && blank(*p)) p++;
+    bool negative = (p < end && *p == '-');
+    if (negative || (p < end && *p == '+')) p++;
+    const char* digits = p;
+    long long value = 0;
+    while (p < end && *p >= '0' && *p <= '9' && p - digits < 18)
+        value = value * 10 + (*p++ - '0');
+    if (p == digits) return false;
+    offset = negative ? -value : value;
+    return true;
+}
+
+/**
+ * @brief Splits [0, count) into one contiguous range per worker and runs
+ *        work(begin, end, workerNumber) on each in its own thread.
+ */
+template <typename Work>
+static void runParallel(size_t count, unsigned threads, Work work) {
+    if (threads <= 1 || count < 2 * threads) {
+        work(size_t(0), count, 0u);
+        return;
+    }
+    vector<thread> pool;
+    size_t chunk = (count + threads - 1) / threads;
+    for (unsigned t = 0; t < threads; t++) {
+        size_t begin = t * chunk;
+        size_t end = min(count, begin + chunk);
+        if (begin >= end) break;
+        pool.emplace_back(work, begin, end, t);
+    }
+    for (thread& th : pool) th.join();
+}
+
+/**
+ * @brief Checks the fields of one record: field count, numeric ZIP and
+ *        numeric latitude / longitude (fields 4 and 5).
+ * @param text Record text
+ * @param length Record text length
+ * @param fieldCount Expected number of fields
+ * @param message Receives the problem, if any
+ * @return true if the record looks valid
+ */
+static bool checkFields(const char* text, size_t length, int fieldCount,
+                        string& message) {
+    int fields = 1;
+    bool inQuotes = false;
+    size_t coordStart[2] = {0, 0}, coordEnd[2] = {0, 0};
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == '"') inQuotes = !inQuotes;
+        else if (text[i] == ',' && !inQuotes) {
+            if (fields == 5 || fields == 6) coordEnd[fields - 5] = i;
+            fields++;
+            if (fields == 5 || fields == 6) coordStart[fields - 5] = i + 1;
+        }
+    }
+    if (fields == 6) coordEnd[1] = length;
+    if (fields != fieldCount) {
+        message = "has " + to_string(fields) + " fields, expected "
+                + to_string(fieldCount);
+        return false;
+    }
+
+    size_t i = 0;
+    while (i < length && text[i] != ',') {
+        if (text[i] < '0' || text[i] > '9') {
+            message = "ZIP field is not numeric";
+            return false;
+        }
+        i++;
+    }
+    if (i == 0) {
+        message = "ZIP field is empty";
+        return false;
+    }
+
+    // Analytics read a non-number as 0, so it must not pass as valid.
+    if (fieldCount == 6) {
+        static const char* const names[2] = {"latitude", "longitude"};
+        for (int c = 0; c < 2; c++) {
+            string value(text + coordStart[c], coordEnd[c] - coordStart[c]);
+            char* end = nullptr;
+            strtod(value.c_str(), &end);
+            if (value.empty() || *end != '\0') {
+                message = string(names[c]) + " field is not a number";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the ZIP (text before the first comma) of a mapped record.
+ */
+static string recordZip(const char* base, const LenRecordView& v) {
+    const char* text = base + v.textOffset;
+    const char* comma = static_cast<const char*>(
+        memchr(text, ',', v.textLength));
+    size_t n = comma ? static_cast<size_t>(comma - text) : v.textLength;
+    return string(text, n);
+}
+
+/**
+ * @brief Tells whether a mapped record's ZIP is zip, without a copy.
+ */
+static bool recordZipIs(const char* base, const LenRecordView& v, const string& zip) {
+    const char* text = base + v.textOffset;
+    return (v.textLength == zip.size() ||
+            (v.textLength > zip.size() && text[zip.size()] == ','))
+        && memcmp(text, zip.data(), zip.size()) == 0;
+}
+
+/**
+ * @brief Prints problems in order, at most limit of them.
+ */
+static void printProblems(const char* title, vector<Problem>& problems,
+                          size_t limit) {
+    if (problems.empty()) return;
+    sort(problems.begin(), problems.end(),
+         [](const Problem& a, const Problem& b) { return a.offset < b.offset; });
+    cout << title << " (" << problems.size() << "):\n";
+    for (size_t i = 0; i < problems.size() && i < limit; i++)
+        cout << "  " << problems[i].message << "\n";
+    if (problems.size() > limit)
+        cout << "  ... and " << (problems.size() - limit) << " more\n";
+}
+
+int verifyLenFile(const string& lenFile, const string& idxFile,
+                  unsigned threads) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    auto startTime = chrono::steady_clock::now();
+
+    MappedFile data;
+    if (!data.open(lenFile)) {
+        cerr << "Error: Cannot open LEN data file: " << lenFile << "\n";
+        return 2;
+    }
+    data.adviseSequential();
+    const char* base = data.data();
+    const size_t size = data.size();
+
+    vector<Problem> headerProblems;
+    vector<Problem> recordProblems;
+    vector<Problem> indexProblems;
+
+    // ---- 1) Header --------------------------------------------------------
+    LenRecordView hv;
+    if (frameLenRecord(base, size, 0, false, hv) != LenStatus::Ok) {
+        cerr << "Error: LEN data file header missing or corrupted.\n";
+        return 4;
+    }
+    HeaderBuffer hbuf;
+    bool headerOk = hbuf.parse(string(base + hv.textOffset, hv.textLength));
+    const FileHeader& header = hbuf.getHeader();
+    bool hasChecksum = headerOk && hbuf.hasChecksum();
+    int fieldCount = headerOk ? header.fieldCount : 6;
+    if (!headerOk) {
+        headerProblems.push_back({0, "header record cannot be parsed; "
+                                     "using defaults"});
+    } else {
+        if (header.fileType != "ZipLenFile")
+            headerProblems.push_back({0, "unexpected file type '" + header.fileType + "'"});
+        if (header.checksumType != "none" && header.checksumType != "crc32c")
+            headerProblems.push_back({0, "unknown checksum type '" + header.checksumType + "'"});
+        if (header.generation == 0)
+            headerProblems.push_back({0, "header has no generation id"});
+    }
+
+    // ---- 2) Read the index (its offsets also help resync after damage) ----
+    // Mid-compaction the index of this data file may be the pending one.
+    const string idxPath = ZipDataStore::indexPathFor(idxFile, headerOk ? header.generation : 0);
+    if (idxPath != idxFile)
+        cout << "Note: compaction not finished; using its pending index " << idxPath << "\n";
+    // Read once from a mapping; the store reuses these entries below.
+    MappedFile idxMap;
+    if (!idxMap.open(idxPath)) {
+        cerr << "Error: Cannot open index file: " << idxFile << "\n";
+        return 3;
+    }
+    idxMap.adviseSequential();
+    const char* idxPos = idxMap.data();
+    const char* const idxEnd = idxPos + idxMap.size();
+    auto nextLine = [&](const char*& lineEnd) {
+        const char* start = idxPos;
+        lineEnd = static_cast<const char*>(memchr(start, '\n', idxEnd - start));
+        if (lineEnd == nullptr) lineEnd = idxEnd;
+        idxPos = (lineEnd < idxEnd) ? lineEnd + 1 : idxEnd;
+        return start;
+    };
+    ZipDataStore::ParsedIndex parsed;
+    parsed.path = idxPath;
+    const char* lineEnd = nullptr;
+    if (idxPos < idxEnd) {
+        const char* start = nextLine(lineEnd);
+        parsed.firstLine.assign(start, lineEnd);
+    }
+    const string& firstLine = parsed.firstLine;
+    unsigned long long idxGeneration = 0;
+    long long declaredDead = 0;   // superseded records (see ZipDataStore.h)
+    if (firstLine.rfind("IDX,2,", 0) == 0) {
+        idxGeneration = HeaderBuffer::parseGeneration(firstLine.substr(6, 16));
+        size_t comma = firstLine.find(',', 6);
+        if (comma != string::npos) declaredDead = atoll(firstLine.c_str() + comma + 1);
+    } else if (firstLine != "IDX,1")
+        indexProblems.push_back({1, "index line 1: not an index header"});
+    if (headerOk && idxGeneration != header.generation) {
+        indexProblems.push_back({1, "index line 1: generation "
+            + HeaderBuffer::generationText(idxGeneration)
+            + " does not match data file generation "
+            + HeaderBuffer::generationText(header.generation)});
+    }
+
+    vector<pair<string, long long>>& entries = parsed.entries;
+    vector<size_t> entryLine;   // 1-based .idx line of each entry
+    entries.reserve(idxMap.size() / 12);
+    entryLine.reserve(idxMap.size() / 12);
+    string zip;
+    long long offset = 0;
+    size_t lineNo = 1;
+    while (idxPos < idxEnd) {
+        const char* start = nextLine(lineEnd);
+        lineNo++;
+        if (start == lineEnd) continue;
+        if (!parseIndexLine(start, lineEnd, zip, offset)) {
+            indexProblems.push_back({lineNo, "index line " + to_string(lineNo)
+                                             + ": cannot be parsed"});
+            continue;
+        }
+        entries.emplace_back(zip, offset);
+        entryLine.push_back(lineNo);
+    }
+
+    // ---- 3) Walk the length fields to find every record start -------------
+    // After a framing error the walk continues at the next offset that the
+    // index claims is a record start and that frames correctly.
+    vector<size_t> resync;
+    resync.reserve(entries.size());
+    for (const auto& e : entries)
+        if (e.second >= 0) resync.push_back(static_cast<size_t>(e.second));
+    sort(resync.begin(), resync.end());
+
+    vector<LenRecordView> records;
+    size_t pos = hv.next;
+    while (pos < size) {
+        LenRecordView v;
+        LenStatus st = frameLenRecord(base, size, pos, hasChecksum, v);
+        if (st == LenStatus::Ok) {
+            records.push_back(v);
+            pos = v.next;
+            continue;
+        }
+
+        size_t bad = pos;
+        pos = size;
+        for (auto it = upper_bound(resync.begin(), resync.end(), bad);
+             it != resync.end(); ++it) {
+            if (frameLenRecord(base, size, *it, hasChecksum, v) == LenStatus::Ok) {
+                pos = *it;
+                break;
+            }
+        }
+        recordProblems.push_back({bad, "offset " + to_string(bad) + ": "
+            + lenStatusText(st) + "; skipped " + to_string(pos - bad)
+            + " bytes" + (pos < size ? " to the next indexed record" : " to end of file")});
+    }
+
+    // The live index is the .idx with the WAL replayed on top (see
+    // ZipDataStore.h); without it (e.g. generations differ, reported below)
+    // the .idx entries are taken as they are.
+    ZipDataStore store;
+    const bool storeOpen = store.open(lenFile, idxFile, false, &parsed);
+    // A generation mismatch is already reported above; anything else that
+    // stops the open (e.g. a damaged index header) is an index problem.
+    if (!storeOpen && !(headerOk && idxGeneration != header.generation))
+        indexProblems.push_back({1, "index line 1: " + store.lastError()});
+    // Sorted, for binary search. With no WAL changes and no repeated ZIP
+    // the live index is exactly the .idx entries, which --build-index
+    // writes in file order already.
+    vector<long long> liveOffsets;
+    if (storeOpen && (store.walEntriesReplayed() > 0 ||
+                      store.index().size() != entries.size())) {
+        liveOffsets.reserve(store.index().size());
+        for (const auto& e : store.index()) liveOffsets.push_back(e.second);
+    } else {
+        liveOffsets.reserve(entries.size());
+        for (const auto& e : entries) liveOffsets.push_back(e.second);
+    }
+    if (!is_sorted(liveOffsets.begin(), liveOffsets.end()))
+        sort(liveOffsets.begin(), liveOffsets.end());
+    const long long deadBudget = storeOpen ? store.deadRecords() : declaredDead;
+
+    // Updates append records and deletes remove none, so the file holds the
+    // header's records plus at most one per dead record.
+    const long long extra = static_cast<long long>(records.size()) - header.recordCount;
+    if (headerOk && (extra < 0 || extra > deadBudget)) {
+        headerProblems.push_back({0, "header record count "
+            + to_string(header.recordCount) + " but file has "
+            + to_string(records.size()) + " records, "
+            + to_string(deadBudget) + " of them dead"});
+    }
+
+    // ---- 4) Checksums and fields, in parallel -------------------------------
+    vector<vector<Problem>> perThread(threads);
+    runParallel(records.size(), threads,
+        [&](size_t begin, size_t end, unsigned t) {
+            string message;
+            for (size_t i = begin; i < end; i++) {
+                const LenRecordView& v = records[i];
+                const char* text = base + v.textOffset;
+                if (hasChecksum && !v.crcReadable) {
+                    perThread[t].push_back({v.start, "record at offset "
+                        + to_string(v.start) + ": checksum field is not 8 hex digits"});
+                } else if (hasChecksum &&
+                    crc32c(text, v.textLength) != v.storedCrc) {
+                    perThread[t].push_back({v.start, "record at offset "
+                        + to_string(v.start) + ": checksum mismatch"});
+                } else if (!checkFields(text, v.textLength, fieldCount, message)) {
+                    perThread[t].push_back({v.start, "record at offset "
+                        + to_string(v.start) + ": " + message});
+                }
+            }
+        });
+    for (auto& list : perThread) {
+        recordProblems.insert(recordProblems.end(), list.begin(), list.end());
+        list.clear();
+    }
+
+    // ---- 5) Every index entry must point at the start of its record ------
+    // Each entry resolves to a record number, or -1 if it is broken.
+    vector<long long> target(entries.size(), -1);
+    runParallel(entries.size(), threads,
+        [&](size_t begin, size_t end, unsigned t) {
+            for (size_t i = begin; i < end; i++) {
+                const string& entryZip = entries[i].first;
+                const long long entryOffset = entries[i].second;
+                const size_t line = entryLine[i];
+                // Built only for the entries that have a problem.
+                auto where = [&]() {
+                    return "index line " + to_string(line) + ": ZIP " + entryZip
+                         + " -> offset " + to_string(entryOffset);
+                };
+                size_t off = static_cast<size_t>(entryOffset);
+                if (entryOffset < 0 || off >= size) {
+                    perThread[t].push_back({line, where() + " is past the end of the data file"});
+                    continue;
+                }
+                auto it = lower_bound(records.begin(), records.end(), off,
+                    [](const LenRecordView& v, size_t o) { return v.start < o; });
+                if (it != records.end() && it->start == off) {
+                    if (!recordZipIs(base, *it, entryZip)) {
+                        perThread[t].push_back({line, where()
+                            + " points at the record for ZIP " + recordZip(base, *it)});
+                    } else {
+                        target[i] = it - records.begin();
+                    }
+                    continue;
+                }
+                if (off < hv.next) {
+                    perThread[t].push_back({line, where()
+                        + " is not a record start (inside the header)"});
+                } else if (it == records.begin() || off >= (it - 1)->next) {
+                    // Before the first framed record, or in a gap after one.
+                    perThread[t].push_back({line, where()
+                        + " points into damaged bytes that do not frame as a record"});
+                } else {
+                    const LenRecordView& prev = *(it - 1);
+                    perThread[t].push_back({line, where()
+                        + " is not a record start (inside record at "
+                        + to_string(prev.start) + ", +"
+                        + to_string(off - prev.start) + " bytes)"});
+                }
+            }
+        });
+    for (auto& list : perThread)
+        indexProblems.insert(indexProblems.end(), list.begin(), list.end());
+
+    // Duplicates and records that no index entry reaches.
+    vector<size_t> hits(records.size(), 0);
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (target[i] < 0) continue;
+        if (hits[target[i]]++ > 0) {
+            indexProblems.push_back({entryLine[i], "index line "
+                + to_string(entryLine[i]) + ": ZIP " + entries[i].first
+                + " is listed more than once"});
+        }
+    }
+    // Of those, the ones whose ZIP is indexed at another record: left out
+    // by --build-index's duplicate policy, or superseded by --update.
+    long long unindexed = 0, repeated = 0;
+    for (const LenRecordView& v : records) {
+        if (binary_search(liveOffsets.begin(), liveOffsets.end(),
+                          static_cast<long long>(v.start)))
+            continue;
+        unindexed++;
+        long long other = 0;
+        if (storeOpen && store.find(recordZip(base, v), other)) repeated++;
+    }
+
+    // Superseded and deleted versions left by --update / --delete are
+    // expected, not damage.
+    long long dead = min(unindexed, deadBudget);
+    unindexed -= dead;
+
+    // ---- 6) Report ------------------------------------------------------------
+    double seconds = chrono::duration<double>(
+        chrono::steady_clock::now() - startTime).count();
+
+    cout << "Verifying data file: " << lenFile << "\n";
+    cout << "Verifying index file: " << idxFile << "\n";
+    cout << "Records: " << records.size() << ", index entries: "
+         << entries.size() << "\n";
+    cout << "Checksums: " << (hasChecksum ? "crc32c" : "none");
+    if (hasChecksum) cout << (crc32cHardware() ? " (hardware)" : " (software)");
+    cout << "\n";
+    cout << "Threads: " << threads << ", time: " << fixed << setprecision(3)
+         << seconds << " s, " << setprecision(1)
+         << (seconds > 0 ? size / seconds / 1e6 : 0.0) << " MB/s\n"
+         << defaultfloat;
+
+    printProblems("Header problems", headerProblems, 50);
+    printProblems("Record problems", recordProblems, 50);
+    printProblems("Index problems", indexProblems, 50);
+    if (dead > 0)
+        cout << "Dead records (superseded, deleted, or a duplicate ZIP left out of the "
+             << "index; reclaimable by compaction): " << dead << "\n";
+    if (repeated > 0)
+        cout << "Records repeating a ZIP indexed at another record: " << repeated << "\n";
+    if (unindexed > 0)
+        cout << "Records with no index entry: " << unindexed << "\n";
+
+    if (storeOpen && store.pendingWalEntries() > 0)
+        cout << "Note: " << store.pendingWalEntries() << " update(s) in " << lenFile
+             << ".wal are not yet in the index; they were replayed for this check "
+             << "(run --checkpoint to include them)\n";
+
+    size_t total = headerProblems.size() + recordProblems.size()
+                 + indexProblems.size() + unindexed;
+    if (total == 0) {
+        cout << "OK: no problems found\n";
+        return 0;
+    }
+    cout << "FAILED: " << total << " problem(s) found\n";
+    return 6;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file LenVerifier.h
+ * @brief Integrity check of a .len data file and its .idx index.
+ * @date October 2026
+ *
+ * The verifier checks, in one run:
+ * - the header record (parses, field list is consistent, record count
+ *   matches the number of records actually in the file)
+ * - every record (length framing, CRC32C if the header says "crc32c",
+ *   field count, a numeric ZIP code and numeric coordinates)
+ * - the index (same generation as the header, every entry points at the
+ *   start of a record holding that ZIP, no duplicates, no missing records)
+ *
+ * Which records are live is taken from the index with the WAL replayed on
+ * top (see ZipDataStore.h), so updates and deletes not yet checkpointed
+ * count as dead records, not as records missing from the index.
+ *
+ * How it stays fast:
+ * - The data file and the index are memory-mapped and read front to back
+ *   once. The parsed index entries are handed to ZipDataStore::open, so
+ *   the index is not parsed a second time for the WAL replay.
+ * - Live records are found by binary search in the sorted live offsets.
+ * - Walking the length fields to find record starts is cheap and done by
+ *   one thread. The expensive part (checksums and field checks) and the
+ *   index checks are split across worker threads.
+ *
+ * An index entry that does not point at a record start is reported with
+ * the record it lands inside, e.g.
+ *   index line 12: ZIP 1001 -> offset 226 is not a record start
+ *   (inside record at 213, +13 bytes)
+ */
+#ifndef LENVERIFIER_H
+#define LENVERIFIER_H
+
+#include <string>
+
+/**
+ * @brief Verifies a .len file and its index, printing every problem found.
+ * @param lenFile Data file (.len)
+ * @param idxFile Index file (.idx)
+ * @param threads Worker threads (0 = one per CPU)
+ * @return exit code: 0 if clean, 6 if problems were found, 2-4 if a file
+ *         could not be opened or the header is unreadable
+ */
+int verifyLenFile(const std::string& lenFile, const std::string& idxFile,
+                  unsigned threads);
+
+#endif
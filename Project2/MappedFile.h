@@ -0,0 +1,62 @@
+/**
+ * @file MappedFile.h
+ * @brief Read-only memory mapping of a whole file.
+ * @date October 2026
+ *
+ * Mapping a file lets the operating system page it in on demand, so a
+ * scan over a large .len file costs no more RAM than the pages currently
+ * being looked at, and the bytes are never copied into a std::string.
+ */
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @class MappedFile
+ * @brief Owns one read-only mapping; unmapped in the destructor.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps the file at path (closing any previous mapping).
+     * @param path File name
+     * @return false if the file cannot be opened or mapped
+     */
+    bool open(const std::string& path);
+
+    /// Unmaps the file
+    void close();
+
+    /// First byte of the file (nullptr if nothing is mapped or size is 0)
+    const char* data() const { return data_; }
+
+    /// File size in bytes
+    size_t size() const { return size_; }
+
+    /// Hint that the file will be read front to back
+    void adviseSequential() const;
+
+    /// Asks the kernel to start reading the whole file into memory now
+    void adviseWillNeed() const;
+
+    /**
+     * @brief Locks the mapped pages in RAM (mlock), so they are never
+     *        paged out. Limited by RLIMIT_MEMLOCK.
+     * @return false if the lock was refused
+     */
+    bool lock() const;
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+#endif
@@ -0,0 +1,323 @@
+/**
+ * @file PlaceTrie.cpp
+ * @brief Implementation of the PlaceTrie class.
+ * @date October 2026
+ */
+#include "PlaceTrie.h"
+#include "AtomicFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <queue>
+#include <tuple>
+
+using namespace std;
+
+static const char kTrieMagic[8] = {'T', 'R', 'I', 'E', '1', 0, 0, 0};
+
+/// Writes a u64 count and the elements of a vector or string
+template <typename Array>
+static void writeArray(ofstream& out, const Array& a) {
+    uint64_t count = a.size();
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char*>(a.data()),
+              static_cast<streamsize>(count * sizeof(a[0])));
+}
+
+/// Reads what writeArray() wrote; false if short or longer than maxCount
+template <typename Array>
+static bool readArray(ifstream& in, Array& a, uint64_t maxCount) {
+    uint64_t count = 0;
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!in || count > maxCount) return false;
+    a.resize(static_cast<size_t>(count));
+    if (count > 0)
+        in.read(reinterpret_cast<char*>(&a[0]), static_cast<streamsize>(count * sizeof(a[0])));
+    return static_cast<bool>(in);
+}
+
+PlaceTrie::PlaceTrie() {}
+
+string PlaceTrie::normalize(const string& text, bool keepTrailingSpace) {
+    string out;
+    out.reserve(text.size());
+    bool gap = false;
+    for (char ch : text) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        // Bytes of UTF-8 sequences are kept as they are.
+        bool word = (c >= 0x80) || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+                    (c >= 'A' && c <= 'Z');
+        if (!word) {
+            gap = true;
+            continue;
+        }
+        if (gap && !out.empty()) out += ' ';
+        gap = false;
+        out += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : ch;
+    }
+    if (keepTrailingSpace && gap && !out.empty()) out += ' ';
+    return out;
+}
+
+void PlaceTrie::build(const vector<PlaceZip>& records) {
+    nodes_.clear();
+    labels_.clear();
+    places_.clear();
+    names_.clear();
+    zips_.clear();
+
+    // (normalized name, state, ZIP, record): sorted, each place is one run.
+    vector<tuple<string, string, uint32_t, size_t>> rows;
+    rows.reserve(records.size());
+    for (size_t i = 0; i < records.size(); i++) {
+        string key = normalize(records[i].place);
+        if (!key.empty()) rows.emplace_back(std::move(key), records[i].state, records[i].zip, i);
+    }
+    sort(rows.begin(), rows.end());
+
+    vector<string> keys;            // distinct normalized names
+    vector<uint32_t> keyPlaces;     // first place of each, then the place count
+    zips_.reserve(rows.size());
+    for (size_t i = 0; i < rows.size();) {
+        const string& key = get<0>(rows[i]);
+        const string& state = get<1>(rows[i]);
+        if (keys.empty() || keys.back() != key) {
+            keys.push_back(key);
+            keyPlaces.push_back(static_cast<uint32_t>(places_.size()));
+        }
+
+        const string& display = records[get<3>(rows[i])].place;
+        Place p;
+        p.name = static_cast<uint32_t>(names_.size());
+        p.nameLen = static_cast<uint16_t>(min<size_t>(display.size(), 0xFFFF));
+        p.state[0] = state.size() > 0 ? state[0] : ' ';
+        p.state[1] = state.size() > 1 ? state[1] : ' ';
+        p.firstZip = static_cast<uint32_t>(zips_.size());
+        names_.append(display, 0, p.nameLen);
+
+        for (; i < rows.size() && get<0>(rows[i]) == key && get<1>(rows[i]) == state; i++)
+            zips_.push_back(get<2>(rows[i]));
+        p.zipCount = static_cast<uint32_t>(zips_.size() - p.firstZip);
+        places_.push_back(p);
+    }
+    keyPlaces.push_back(static_cast<uint32_t>(places_.size()));
+
+    nodes_.push_back(Node{0, 0, 0, 0, 0, 0, 0, 0, 0});
+    buildNode(0, keys, keyPlaces, 0, keys.size(), 0);
+}
+
+/**
+ * @brief Fills in a node whose names are keys[lo, hi), all sharing their
+ *        first depth characters, and then its subtree.
+ */
+void PlaceTrie::buildNode(uint32_t node, const vector<string>& keys,
+                          const vector<uint32_t>& keyPlaces, size_t lo, size_t hi,
+                          size_t depth) {
+    nodes_[node].placeLow = keyPlaces[lo];
+    nodes_[node].placeEnd = keyPlaces[hi];
+    uint32_t zipCount = 0, best = 0;
+
+    // Sorted, so a name that ends here comes first.
+    if (lo < hi && keys[lo].size() == depth) {
+        nodes_[node].ownPlaces = keyPlaces[lo + 1] - keyPlaces[lo];
+        for (uint32_t p = keyPlaces[lo]; p < keyPlaces[lo + 1]; p++) {
+            zipCount += places_[p].zipCount;
+            best = max(best, places_[p].zipCount);
+        }
+        lo++;
+    }
+
+    // One child per next character; children are allocated side by side.
+    vector<pair<size_t, size_t>> groups;
+    for (size_t i = lo; i < hi;) {
+        size_t j = i + 1;
+        while (j < hi && keys[j][depth] == keys[i][depth]) j++;
+        groups.emplace_back(i, j);
+        i = j;
+    }
+    const uint32_t first = static_cast<uint32_t>(nodes_.size());
+    nodes_[node].firstChild = first;
+    nodes_[node].childCount = static_cast<uint16_t>(groups.size());
+    nodes_.resize(nodes_.size() + groups.size(), Node{0, 0, 0, 0, 0, 0, 0, 0, 0});
+
+    for (size_t g = 0; g < groups.size(); g++) {
+        // The names of a sorted run share what its first and last share.
+        const string& a = keys[groups[g].first];
+        const string& b = keys[groups[g].second - 1];
+        size_t end = depth + 1;
+        while (end < a.size() && end < b.size() && a[end] == b[end]) end++;
+
+        const uint32_t child = first + static_cast<uint32_t>(g);
+        nodes_[child].label = static_cast<uint32_t>(labels_.size());
+        nodes_[child].labelLen = static_cast<uint16_t>(end - depth);
+        labels_.append(a, depth, end - depth);
+        buildNode(child, keys, keyPlaces, groups[g].first, groups[g].second, end);
+        zipCount += nodes_[child].zipCount;
+        best = max(best, nodes_[child].best);
+    }
+    nodes_[node].zipCount = zipCount;
+    nodes_[node].best = best;
+}
+
+void PlaceTrie::complete(const string& prefix, const string& state, size_t k,
+                         vector<Completion>& out, size_t& matchPlaces,
+                         size_t& matchZips) const {
+    out.clear();
+    matchPlaces = matchZips = 0;
+    if (nodes_.empty()) return;
+
+    // Walk the prefix down; it may end inside an edge.
+    const string key = normalize(prefix, true);
+    uint32_t n = 0;
+    size_t pos = 0;
+    while (pos < key.size()) {
+        const Node& cur = nodes_[n];
+        uint32_t next = 0;
+        for (uint32_t c = cur.firstChild; c < cur.firstChild + cur.childCount; c++) {
+            if (labels_[nodes_[c].label] == key[pos]) {
+                next = c;
+                break;
+            }
+        }
+        if (next == 0) return;
+        const Node& child = nodes_[next];
+        const size_t len = min<size_t>(child.labelLen, key.size() - pos);
+        if (labels_.compare(child.label, len, key, pos, len) != 0) return;
+        pos += len;
+        n = next;
+    }
+    if (state.empty()) {
+        matchPlaces = nodes_[n].placeEnd - nodes_[n].placeLow;
+        matchZips = nodes_[n].zipCount;
+    } else {
+        // The places under a node are contiguous; count that state's.
+        for (uint32_t p = nodes_[n].placeLow; p < nodes_[n].placeEnd; p++) {
+            if (state.compare(0, string::npos, places_[p].state, 2) != 0) continue;
+            matchPlaces++;
+            matchZips += places_[p].zipCount;
+        }
+    }
+
+    // Best-first: a node's key (biggest place below, first place below) is
+    // never behind the key of a place under it, so places come out in order.
+    struct Item {
+        uint32_t count;
+        uint32_t low;
+        uint32_t index;
+        bool place;
+        bool operator<(const Item& o) const {
+            return count != o.count ? count < o.count : low > o.low;
+        }
+    };
+    priority_queue<Item> queue;
+    queue.push(Item{nodes_[n].best, nodes_[n].placeLow, n, false});
+    while (!queue.empty() && out.size() < k) {
+        const Item item = queue.top();
+        queue.pop();
+        if (item.place) {
+            const Place& p = places_[item.index];
+            out.push_back(Completion{names_.substr(p.name, p.nameLen), string(p.state, 2),
+                                     zips_.data() + p.firstZip, p.zipCount});
+            continue;
+        }
+        const Node& node = nodes_[item.index];
+        for (uint32_t p = node.placeLow; p < node.placeLow + node.ownPlaces; p++) {
+            if (!state.empty() && state.compare(0, string::npos, places_[p].state, 2) != 0)
+                continue;
+            queue.push(Item{places_[p].zipCount, p, p, true});
+        }
+        for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++)
+            queue.push(Item{nodes_[c].best, nodes_[c].placeLow, c, false});
+    }
+}
+
+size_t PlaceTrie::sizeBytes() const {
+    return nodes_.size() * sizeof(Node) + labels_.size() + places_.size() * sizeof(Place) +
+           names_.size() + zips_.size() * sizeof(uint32_t);
+}
+
+bool PlaceTrie::save(const string& path, unsigned long long generation,
+                     long long lastSeq, size_t liveZips) const {
+    string tmp = tempPathFor(path);
+    {
+        ofstream out(tmp, ios::binary);
+        if (!out) return false;
+        uint64_t gen = generation;
+        int64_t seq = lastSeq;
+        uint64_t live = liveZips;
+        out.write(kTrieMagic, sizeof(kTrieMagic));
+        out.write(reinterpret_cast<const char*>(&gen), sizeof(gen));
+        out.write(reinterpret_cast<const char*>(&seq), sizeof(seq));
+        out.write(reinterpret_cast<const char*>(&live), sizeof(live));
+        writeArray(out, nodes_);
+        writeArray(out, labels_);
+        writeArray(out, places_);
+        writeArray(out, names_);
+        writeArray(out, zips_);
+        if (!out) {
+            out.close();
+            discardTemp(tmp);
+            return false;
+        }
+    }
+    if (!publishFile(tmp, path)) {
+        discardTemp(tmp);
+        return false;
+    }
+    return true;
+}
+
+bool PlaceTrie::load(const string& path, unsigned long long generation,
+                     long long lastSeq, size_t liveZips) {
+    nodes_.clear();
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+
+    char magic[sizeof(kTrieMagic)];
+    uint64_t gen = 0, live = 0;
+    int64_t seq = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&gen), sizeof(gen));
+    in.read(reinterpret_cast<char*>(&seq), sizeof(seq));
+    in.read(reinterpret_cast<char*>(&live), sizeof(live));
+    if (!in || memcmp(magic, kTrieMagic, sizeof(magic)) != 0 || gen != generation ||
+        seq != lastSeq || live != liveZips)
+        return false;
+
+    // Every array is bounded by the ZIP count (names by their bytes).
+    const uint64_t limit = 64 * (live + 1);
+    vector<Node> nodes;
+    string labels, names;
+    vector<Place> places;
+    vector<uint32_t> zips;
+    if (!readArray(in, nodes, limit) || !readArray(in, labels, limit) ||
+        !readArray(in, places, limit) || !readArray(in, names, limit) ||
+        !readArray(in, zips, limit) || nodes.empty() || zips.size() > live)
+        return false;
+
+    // Children come after their parent, so a walk always ends.
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const Node& n = nodes[i];
+        if ((n.childCount > 0 && n.firstChild <= i) ||
+            static_cast<uint64_t>(n.label) + n.labelLen > labels.size() ||
+            static_cast<uint64_t>(n.firstChild) + n.childCount > nodes.size() ||
+            n.placeLow > n.placeEnd || n.placeEnd > places.size() ||
+            n.ownPlaces > n.placeEnd - n.placeLow)
+            return false;
+        for (uint32_t c = n.firstChild; c < n.firstChild + n.childCount; c++)
+            if (nodes[c].labelLen == 0) return false;
+    }
+    for (const Place& p : places) {
+        if (static_cast<uint64_t>(p.name) + p.nameLen > names.size() ||
+            static_cast<uint64_t>(p.firstZip) + p.zipCount > zips.size())
+            return false;
+    }
+
+    nodes_ = std::move(nodes);
+    labels_ = std::move(labels);
+    places_ = std::move(places);
+    names_ = std::move(names);
+    zips_ = std::move(zips);
+    return true;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file PlaceTrie.h
+ * @brief Compact trie over normalized place names, for type-ahead
+ *        ("Sai" -> Saint Paul, MN; Saint Louis, MO; ...).
+ * @date October 2026
+ *
+ * A place is one (place name, state) pair with the ZIPs that carry it.
+ * Names are normalized before they go into the trie: ASCII letters are
+ * lowercased, and every run of other characters becomes a single space
+ * ("St. Paul" -> "st paul"). Queries are normalized the same way.
+ *
+ * The trie is a radix tree: an edge holds as many characters as the names
+ * below it share, so there are fewer nodes than distinct names. Nodes are
+ * stored in one array, children of a node next to each other and sorted by
+ * their first character, and places are numbered in the same (alphabetic)
+ * order as a walk of the tree. That makes the places below any node one
+ * range [place low, place end), so every node carries:
+ * - its places, as that range, and its own places (those with exactly the
+ *   node's name) at the start of it
+ * - the number of ZIPs below it
+ * - the ZIP count of the biggest place below it
+ *
+ * A completion walks the prefix down (one edge compare per node) and then
+ * takes the top-k places below it, biggest first, with a best-first search
+ * ordered by that last count. Only the nodes on the way to the k answers
+ * are opened, so a short prefix with thousands of places below it costs
+ * about as much as a long one.
+ *
+ * File "<index file>.trie" (binary, native byte order):
+ *   "TRIE1\0\0\0" | u64 generation | u64 last sequence | u64 live ZIPs |
+ *   u64 count + array, for: nodes, edge characters, places, display
+ *   names, ZIPs
+ *
+ * The trie is built from the live records of a data/index pair (WAL
+ * changes and deletes included), so it is stamped with the data file
+ * generation, the last applied WAL sequence and the number of live ZIPs.
+ * Any update or delete makes it stale, and --complete then rebuilds it.
+ */
+#ifndef PLACETRIE_H
+#define PLACETRIE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class PlaceTrie
+ * @brief Read-mostly prefix index from place names to places and ZIPs.
+ *
+ * Lookups only read, so any number of threads may call complete().
+ */
+class PlaceTrie {
+public:
+    /// One record's contribution to the trie
+    struct PlaceZip {
+        std::string place;   ///< place name as stored
+        std::string state;   ///< two-letter state
+        uint32_t zip;
+    };
+
+    /// One answer of complete(); pointers stay valid while the trie lives
+    struct Completion {
+        std::string name;        ///< place name (as stored, smallest ZIP's spelling)
+        std::string state;
+        const uint32_t* zips;    ///< sorted ZIPs of the place
+        size_t zipCount;
+    };
+
+    PlaceTrie();
+
+    /**
+     * @brief Normalizes a place name or a typed prefix.
+     * @param text Name as stored or typed
+     * @param keepTrailingSpace true for a prefix, so "San " does not also
+     *        match "Sanford"
+     */
+    static std::string normalize(const std::string& text, bool keepTrailingSpace = false);
+
+    /**
+     * @brief Builds the trie, replacing any previous contents.
+     * @param records One entry per ZIP (names that normalize to "" are skipped)
+     */
+    void build(const std::vector<PlaceZip>& records);
+
+    /**
+     * @brief Top places whose normalized name starts with the prefix.
+     * @param prefix Typed text (normalized here)
+     * @param state Only places in this state ("" for all)
+     * @param k Maximum number of answers
+     * @param out Receives the answers, most ZIPs first (ties alphabetic)
+     * @param matchPlaces Receives the number of places under the prefix (in
+     *        that state, if one is given)
+     * @param matchZips Receives the number of ZIPs of those places
+     */
+    void complete(const std::string& prefix, const std::string& state, size_t k,
+                  std::vector<Completion>& out, size_t& matchPlaces,
+                  size_t& matchZips) const;
+
+    /**
+     * @brief Writes the trie crash-safely (temp file + rename).
+     * @return true on success
+     */
+    bool save(const std::string& path, unsigned long long generation,
+              long long lastSeq, size_t liveZips) const;
+
+    /**
+     * @brief Reads a trie made for exactly this state of the data.
+     * @return false if missing, damaged, or stale (the trie is then empty)
+     */
+    bool load(const std::string& path, unsigned long long generation,
+              long long lastSeq, size_t liveZips);
+
+    bool empty() const { return nodes_.empty(); }
+    size_t nodeCount() const { return nodes_.size(); }
+    size_t placeCount() const { return places_.size(); }
+    size_t zipCount() const { return zips_.size(); }
+
+    /// Size of all arrays in bytes
+    size_t sizeBytes() const;
+
+    /// The usual trie name for an index file
+    static std::string pathFor(const std::string& indexFile) {
+        return indexFile + ".trie";
+    }
+
+private:
+    /// Radix tree node; the edge into it is label_[label, label + labelLen)
+    struct Node {
+        uint32_t label;
+        uint16_t labelLen;
+        uint16_t childCount;
+        uint32_t firstChild;
+        uint32_t placeLow;     ///< first place below the node
+        uint32_t placeEnd;     ///< one past the last place below the node
+        uint32_t ownPlaces;    ///< places with exactly this name, from placeLow
+        uint32_t zipCount;     ///< ZIPs below the node
+        uint32_t best;         ///< ZIPs of the biggest place below the node
+    };
+
+    /// A (name, state) pair; its ZIPs are zips_[firstZip, firstZip + zipCount)
+    struct Place {
+        uint32_t name;         ///< display name in names_
+        uint16_t nameLen;
+        char state[2];
+        uint32_t firstZip;
+        uint32_t zipCount;
+    };
+
+    std::vector<Node> nodes_;      ///< root first
+    std::string labels_;
+    std::vector<Place> places_;
+    std::string names_;
+    std::vector<uint32_t> zips_;
+
+    void buildNode(uint32_t node, const std::vector<std::string>& keys,
+                   const std::vector<uint32_t>& keyPlaces, size_t lo, size_t hi,
+                   size_t depth);
+};
+
+#endif
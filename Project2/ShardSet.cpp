@@ -0,0 +1,523 @@
+/**
+ * @file ShardSet.cpp
+ * @brief Implementation of the shard manifest, shard builder and
+ *        scatter-gather analysis.
+ * @date October 2026
+ */
+#include "ShardSet.h"
+#include "AtomicFile.h"
+#include "HeaderBuffer.h"
+#include "IndexBuilder.h"
+#include "LenFileWriter.h"
+#include "ZipDataStore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+/* ============================================================================
+ *  Small helpers
+ * ============================================================================
+ */
+
+/**
+ * @brief Directory part of a path, with its trailing '/' ("" if none).
+ */
+static string dirOf(const string& path) {
+    size_t slash = path.rfind('/');
+    return (slash == string::npos) ? "" : path.substr(0, slash + 1);
+}
+
+/**
+ * @brief Removes whitespace (and a CR) from both ends.
+ */
+static string trimField(const string& str) {
+    size_t start = str.find_first_not_of(" \t\r\n");
+    if (start == string::npos) return "";
+    size_t end = str.find_last_not_of(" \t\r\n");
+    return str.substr(start, end - start + 1);
+}
+
+/**
+ * @brief Splits a CSV line into fields (basic quote support).
+ */
+static vector<string> splitCsvFields(const string& line) {
+    vector<string> fields;
+    string cur;
+    bool inQuotes = false;
+
+    for (char c : line) {
+        if (c == '"') {
+            inQuotes = !inQuotes;
+        } else if (c == ',' && !inQuotes) {
+            fields.push_back(cur);
+            cur.clear();
+        } else {
+            cur.push_back(c);
+        }
+    }
+    fields.push_back(cur);
+    return fields;
+}
+
+/**
+ * @brief Parses record text in the usual field order into a ZipCodeRecord.
+ * @return false if a field is missing or not a number where one is needed
+ */
+static bool parseRecordText(const string& text, ZipCodeRecord& record) {
+    vector<string> f = splitCsvFields(text);
+    if (f.size() < 6) return false;
+    try {
+        record.zipCode = stoi(trimField(f[0]));
+        record.placeName = trimField(f[1]);
+        record.state = trimField(f[2]);
+        record.county = trimField(f[3]);
+        record.latitude = stod(trimField(f[4]));
+        record.longitude = stod(trimField(f[5]));
+        return true;
+    } catch (const exception&) {
+        return false;
+    }
+}
+
+/**
+ * @brief Runs work(i) for i in [0, count) on up to `threads` threads.
+ *
+ * Shards can differ a lot in size, so threads take the next shard from a
+ * shared counter instead of getting fixed ranges.
+ */
+template <typename Work>
+static void forEachShard(size_t count, unsigned threads, Work work) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    threads = static_cast<unsigned>(min<size_t>(threads, count));
+    atomic<size_t> next(0);
+    auto loop = [&]() {
+        for (size_t i = next++; i < count; i = next++) work(i);
+    };
+    if (threads <= 1) {
+        loop();
+        return;
+    }
+    vector<thread> pool;
+    for (unsigned t = 0; t < threads; t++) pool.emplace_back(loop);
+    for (thread& th : pool) th.join();
+}
+
+/* ============================================================================
+ *  ShardManifest
+ * ============================================================================
+ */
+
+ShardManifest::ShardManifest() : scheme_("zip") {}
+
+bool ShardManifest::validScheme(const string& scheme) {
+    return scheme == "zip" || scheme == "state";
+}
+
+int ShardManifest::zipShard(int zip, int shardCount) {
+    if (zip < 0) zip = 0;
+    if (zip > 99999) zip = 99999;
+    return static_cast<int>(static_cast<long long>(zip) * shardCount / 100000);
+}
+
+int ShardManifest::stateShard(const string& state, int shardCount) {
+    // FNV-1a: fixed, so the same state maps to the same shard on every run.
+    unsigned long long h = 1469598103934665603ULL;
+    for (unsigned char c : state) {
+        h ^= static_cast<unsigned char>(toupper(c));
+        h *= 1099511628211ULL;
+    }
+    return static_cast<int>(h % static_cast<unsigned long long>(shardCount));
+}
+
+bool ShardManifest::load(const string& manifestFile) {
+    shards_.clear();
+    error_.clear();
+
+    ifstream in(manifestFile);
+    if (!in) {
+        error_ = "Cannot open shard manifest '" + manifestFile + "'";
+        return false;
+    }
+
+    string first;
+    getline(in, first);
+    vector<string> head = splitCsvFields(trimField(first));
+    if (head.size() != 4 || head[0] != "SHARDS" || head[1] != "1" ||
+        !validScheme(head[2])) {
+        error_ = "'" + manifestFile + "' is not a shard manifest.";
+        return false;
+    }
+    scheme_ = head[2];
+    int count = atoi(head[3].c_str());
+
+    const string dir = dirOf(manifestFile);
+    string line;
+    while (getline(in, line)) {
+        if (trimField(line).empty()) continue;
+        istringstream fields(line);
+        ShardEntry e;
+        if (!(fields >> e.id >> e.key >> e.lenFile >> e.idxFile) ||
+            e.id != static_cast<int>(shards_.size())) {
+            error_ = "Bad shard line in '" + manifestFile + "': " + line;
+            shards_.clear();
+            return false;
+        }
+        if (e.lenFile[0] != '/') e.lenFile = dir + e.lenFile;
+        if (e.idxFile[0] != '/') e.idxFile = dir + e.idxFile;
+        shards_.push_back(e);
+    }
+
+    if (count <= 0 || static_cast<int>(shards_.size()) != count) {
+        error_ = "Shard manifest '" + manifestFile + "' lists "
+                 + to_string(shards_.size()) + " shards, header says "
+                 + head[3];
+        shards_.clear();
+        return false;
+    }
+    return true;
+}
+
+bool ShardManifest::save(const string& manifestFile) {
+    const string dir = dirOf(manifestFile);
+    auto relative = [&](const string& path) {
+        if (!dir.empty() && path.compare(0, dir.size(), dir) == 0)
+            return path.substr(dir.size());
+        return path;
+    };
+
+    string tmp = tempPathFor(manifestFile);
+    {
+        ofstream out(tmp);
+        out << "SHARDS,1," << scheme_ << "," << shards_.size() << "\n";
+        for (const ShardEntry& e : shards_) {
+            out << e.id << " " << e.key << " " << relative(e.lenFile) << " "
+                << relative(e.idxFile) << "\n";
+        }
+        if (!out) {
+            out.close();
+            discardTemp(tmp);
+            error_ = "Cannot write '" + tmp + "'";
+            return false;
+        }
+    }
+    if (!publishFile(tmp, manifestFile)) {
+        discardTemp(tmp);
+        error_ = "Cannot publish '" + manifestFile + "'";
+        return false;
+    }
+    return true;
+}
+
+int ShardManifest::shardForZip(const string& zip) const {
+    if (scheme_ != "zip" || shards_.empty()) return -1;
+    int value;
+    try {
+        value = stoi(zip);
+    } catch (const exception&) {
+        return -1;
+    }
+    return zipShard(value, static_cast<int>(shards_.size()));
+}
+
+/* ============================================================================
+ *  Building shards from a CSV file
+ * ============================================================================
+ */
+
+int makeShards(const string& csvFile, const string& manifestFile,
+               int shardCount, const string& scheme, bool withChecksum,
+               long long& records, string& error,
+               DuplicatePolicy policy, string* duplicates) {
+    records = 0;
+    if (duplicates) duplicates->clear();
+    if (shardCount < 1 || shardCount > 100) {
+        error = "Shard count must be between 1 and 100.";
+        return 1;
+    }
+    if (!ShardManifest::validScheme(scheme)) {
+        error = "Unknown shard scheme '" + scheme + "' (use zip or state).";
+        return 1;
+    }
+
+    ifstream in(csvFile);
+    if (!in) {
+        error = "Cannot open CSV file '" + csvFile + "'";
+        return 2;
+    }
+
+    // ---- Find the columns by header name --------------------------------------
+    string headerLine;
+    if (!getline(in, headerLine)) {
+        error = "CSV file is empty.";
+        return 4;
+    }
+    // Output order: ZipCode, PlaceName, State, County, Lat, Long
+    const vector<vector<string>> names = {
+        {"zipcode", "zip", "zip_code"}, {"placename", "place", "city"},
+        {"state"}, {"county"}, {"lat", "latitude"},
+        {"long", "longitude", "lon"}};
+    vector<int> col(names.size(), -1);
+    vector<string> headerFields = splitCsvFields(headerLine);
+    for (size_t i = 0; i < headerFields.size(); i++) {
+        string name = trimField(headerFields[i]);
+        transform(name.begin(), name.end(), name.begin(),
+                  [](unsigned char c) { return static_cast<char>(tolower(c)); });
+        for (size_t k = 0; k < names.size(); k++) {
+            if (find(names[k].begin(), names[k].end(), name) != names[k].end())
+                col[k] = static_cast<int>(i);
+        }
+    }
+    if (*min_element(col.begin(), col.end()) < 0) {
+        error = "CSV header must name ZIP, place, state, county, lat and long columns.";
+        return 4;
+    }
+    const int maxCol = *max_element(col.begin(), col.end());
+
+    // ---- Pass 1: the ZIP of every row ------------------------------------------
+    const streampos dataStart = in.tellg();
+    DuplicateKeys keys;
+    string line;
+    while (getline(in, line)) {
+        if (trimField(line).empty()) continue;
+        vector<string> f = splitCsvFields(line);
+        if (static_cast<int>(f.size()) > maxCol) keys.add(trimField(f[col[0]]));
+    }
+    keys.finish();
+    string note;
+    if (keys.duplicateKeys() > 0) {
+        note = to_string(keys.duplicateKeys()) + " duplicate ZIP(s), " +
+               to_string(keys.extraRows()) + " extra row(s): " + keys.examples();
+        if (policy == DuplicatePolicy::kError) {
+            error = note;
+            return 7;
+        }
+    }
+    in.clear();
+    in.seekg(dataStart);
+
+    // ---- Open one temp .len per shard -----------------------------------------
+    const string checksumType = withChecksum ? "crc32c" : "none";
+    const string dir = dirOf(manifestFile);
+    const string base = manifestFile.substr(dir.size());
+
+    ShardManifest manifest;
+    manifest.setScheme(scheme);
+    vector<ShardEntry>& shards = manifest.shards();
+    vector<unique_ptr<ofstream>> outs;
+    vector<string> tmps;
+    vector<HeaderBuffer> headers(shardCount);
+    vector<unsigned long long> generations(shardCount);
+    vector<long long> counts(shardCount, 0);
+    vector<set<string>> statesIn(shardCount);
+
+    auto abandon = [&]() {
+        for (auto& o : outs) o->close();
+        for (const string& t : tmps) discardTemp(t);
+    };
+
+    for (int i = 0; i < shardCount; i++) {
+        char suffix[24];
+        snprintf(suffix, sizeof(suffix), ".shard%02d", i);
+        ShardEntry e;
+        e.id = i;
+        e.lenFile = dir + base + suffix + ".len";
+        e.idxFile = dir + base + suffix + ".idx";
+        if (scheme == "zip") {
+            char range[16];
+            snprintf(range, sizeof(range), "%05d-%05d",
+                     static_cast<int>(100000LL * i / shardCount),
+                     static_cast<int>(100000LL * (i + 1) / shardCount - 1));
+            e.key = range;
+        }
+        shards.push_back(e);
+
+        tmps.push_back(tempPathFor(e.lenFile));
+        outs.emplace_back(new ofstream(tmps.back()));
+        generations[i] = HeaderBuffer::newGeneration();
+        headers[i].buildDefault(base + suffix + ".idx", 0, generations[i],
+                                checksumType);
+        if (!*outs.back() || !headers[i].write(*outs.back())) {
+            error = "Cannot create shard file '" + tmps.back() + "'";
+            abandon();
+            return 3;
+        }
+    }
+
+    // ---- Pass 2: each record to its shard ------------------------------------
+    long long skipped = 0, dropped = 0;
+    while (getline(in, line)) {
+        if (trimField(line).empty()) continue;
+        vector<string> f = splitCsvFields(line);
+        if (static_cast<int>(f.size()) <= maxCol) {
+            skipped++;
+            continue;
+        }
+
+        if (!keys.keep(trimField(f[col[0]]), policy)) {
+            dropped++;
+            continue;
+        }
+
+        string text;
+        for (size_t k = 0; k < col.size(); k++) {
+            string value = trimField(f[col[k]]);
+            if (k > 0) text += ',';
+            if (value.find(',') != string::npos) text += '"' + value + '"';
+            else text += value;
+        }
+
+        const string state = trimField(f[col[2]]);
+        int shard;
+        if (scheme == "zip") {
+            int zip;
+            try {
+                zip = stoi(trimField(f[col[0]]));
+            } catch (const exception&) {
+                skipped++;
+                continue;
+            }
+            shard = ShardManifest::zipShard(zip, shardCount);
+        } else {
+            shard = ShardManifest::stateShard(state, shardCount);
+            statesIn[shard].insert(state);
+        }
+
+        if (!writeLenRecord(*outs[shard], text, withChecksum)) {
+            error = "Cannot write shard file '" + tmps[shard] + "'";
+            abandon();
+            return 3;
+        }
+        counts[shard]++;
+        records++;
+    }
+    if (skipped > 0) {
+        cerr << "Warning: skipped " << skipped
+             << " CSV lines that could not be parsed.\n";
+    }
+
+    // ---- Final headers, then publish every shard -----------------------------
+    for (int i = 0; i < shardCount; i++) {
+        headers[i].buildDefault(shards[i].idxFile.substr(dir.size()),
+                                static_cast<long>(counts[i]), generations[i],
+                                checksumType);
+        outs[i]->seekp(0);
+        bool ok = headers[i].write(*outs[i]);
+        outs[i]->close();
+        if (!ok || !*outs[i]) {
+            error = "Cannot write shard file '" + tmps[i] + "'";
+            abandon();
+            return 6;
+        }
+        if (scheme == "state") {
+            string key;
+            for (const string& s : statesIn[i]) key += (key.empty() ? "" : "|") + s;
+            shards[i].key = key.empty() ? "-" : key;
+        }
+    }
+    for (int i = 0; i < shardCount; i++) {
+        if (!publishFile(tmps[i], shards[i].lenFile)) {
+            error = "Cannot publish shard file '" + shards[i].lenFile + "'";
+            for (int j = i; j < shardCount; j++) discardTemp(tmps[j]);
+            return 6;
+        }
+    }
+
+    // ---- Index all shards in parallel ------------------------------------------
+    vector<int> rcs(shardCount, 0);
+    vector<string> errors(shardCount);
+    vector<string> notes(shardCount);
+    forEachShard(static_cast<size_t>(shardCount), 0, [&](size_t i) {
+        long long entries = 0;
+        rcs[i] = buildIndexFile(shards[i].lenFile, shards[i].idxFile,
+                                entries, errors[i], DuplicatePolicy::kLastWins,
+                                &notes[i]);
+    });
+    for (int i = 0; i < shardCount; i++) {
+        if (rcs[i] != 0) {
+            error = "Shard " + to_string(i) + ": " + errors[i];
+            return 5;
+        }
+    }
+    if (dropped > 0) {
+        note += "; " + to_string(dropped) + " row(s) dropped (" +
+                duplicatePolicyName(policy) + ")";
+    }
+    for (int i = 0; i < shardCount; i++) {
+        if (!notes[i].empty()) note += "; shard " + to_string(i) + ": " + notes[i];
+    }
+    if (duplicates) *duplicates = note;
+
+    // ---- The manifest goes last -------------------------------------------------
+    if (!manifest.save(manifestFile)) {
+        error = manifest.lastError();
+        return 6;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ *  Scatter-gather analysis
+ * ============================================================================
+ */
+
+bool analyzeShards(const ShardManifest& manifest, unsigned threads,
+                   map<string, StateExtremes>& stateMap,
+                   long long& records, string& error) {
+    const vector<ShardEntry>& shards = manifest.shards();
+    vector<map<string, StateExtremes>> partial(shards.size());
+    vector<long long> counts(shards.size(), 0);
+    vector<string> errors(shards.size());
+
+    forEachShard(shards.size(), threads, [&](size_t i) {
+        ZipDataStore store;
+        if (!store.open(shards[i].lenFile, shards[i].idxFile, false)) {
+            errors[i] = store.lastError();
+            return;
+        }
+
+        // Live records only (after WAL replay), read in file order.
+        vector<long long> offsets;
+        offsets.reserve(store.liveRecords());
+        for (const auto& e : store.index()) offsets.push_back(e.second);
+        sort(offsets.begin(), offsets.end());
+
+        string text;
+        ZipCodeRecord rec;
+        for (long long offset : offsets) {
+            LenStatus st = store.readRecordAt(offset, text);
+            if (st != LenStatus::Ok) {
+                errors[i] = "record at offset " + to_string(offset)
+                            + " cannot be read (" + lenStatusText(st)
+                            + "); run --verify on " + shards[i].lenFile;
+                return;
+            }
+            if (!parseRecordText(text, rec)) continue;
+            updateStateExtremes(partial[i], rec);
+            counts[i]++;
+        }
+    });
+
+    // Gather in shard order; mergeStateExtremes() breaks every tie the same
+    // way, so the result does not depend on which thread finished first.
+    stateMap.clear();
+    records = 0;
+    for (size_t i = 0; i < shards.size(); i++) {
+        if (!errors[i].empty()) {
+            error = "Shard " + to_string(i) + ": " + errors[i];
+            return false;
+        }
+        mergeStateExtremes(stateMap, partial[i]);
+        records += counts[i];
+    }
+    return true;
+}
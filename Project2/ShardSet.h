@@ -0,0 +1,158 @@
+/**
+ * @file ShardSet.h
+ * @brief A dataset stored as N .len shards, each with its own header and
+ *        index, described by a small manifest file.
+ * @date October 2026
+ *
+ * Manifest file (text, one shard per line after the first):
+ *   SHARDS,1,<scheme>,<shard count>
+ *   <id> <key> <shard .len file> <shard .idx file>
+ *
+ * Schemes:
+ * - zip:   shard i holds the ZIP range [i*100000/N, (i+1)*100000/N).
+ *          The key is that range ("00000-24999"), and a search goes
+ *          straight to the one shard that can hold the ZIP.
+ * - state: all ZIPs of a state go to the same shard (hash of the state).
+ *          The key lists the states in the shard ("AK|CA|WY"). A ZIP
+ *          cannot be routed from its digits alone, so a search asks each
+ *          shard, and the shard Bloom filters answer "not here" for all
+ *          but one without touching their indexes.
+ *
+ * Shard file names are relative to the manifest's directory. Every shard
+ * is a normal data/index pair, so --search, --update, --verify and
+ * --compact work on one shard by itself; an update only touches its shard.
+ *
+ * The manifest is published last (see AtomicFile.h), after every shard
+ * and its index, so a reader never finds a manifest naming missing files.
+ */
+#ifndef SHARDSET_H
+#define SHARDSET_H
+
+#include "DuplicateKeys.h"
+#include "StateExtremes.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @struct ShardEntry
+ * @brief One line of the manifest.
+ */
+struct ShardEntry {
+    int id;               ///< shard number, 0..N-1
+    std::string key;      ///< ZIP range or list of states
+    std::string lenFile;  ///< data file (path as resolved on load)
+    std::string idxFile;  ///< index file (path as resolved on load)
+};
+
+/**
+ * @class ShardManifest
+ * @brief Reads, writes and routes with a shard manifest.
+ */
+class ShardManifest {
+public:
+    ShardManifest();
+
+    /**
+     * @brief Reads a manifest; shard paths become relative to its directory.
+     * @param manifestFile Manifest path
+     * @return false if missing or malformed (see lastError())
+     */
+    bool load(const std::string& manifestFile);
+
+    /**
+     * @brief Writes the manifest crash-safely (temp file + rename).
+     *
+     * Shard paths are written relative to the manifest's directory.
+     * @param manifestFile Manifest path
+     * @return false on error (see lastError())
+     */
+    bool save(const std::string& manifestFile);
+
+    /**
+     * @brief Shard that holds a ZIP, for the "zip" scheme.
+     * @param zip ZIP as text
+     * @return shard position in shards(), or -1 if the scheme cannot route
+     *         by ZIP (then every shard must be asked)
+     */
+    int shardForZip(const std::string& zip) const;
+
+    /// "zip" or "state"
+    const std::string& scheme() const { return scheme_; }
+    void setScheme(const std::string& scheme) { scheme_ = scheme; }
+
+    std::vector<ShardEntry>& shards() { return shards_; }
+    const std::vector<ShardEntry>& shards() const { return shards_; }
+
+    const std::string& lastError() const { return error_; }
+
+    /// Range partition used by the "zip" scheme
+    static int zipShard(int zip, int shardCount);
+
+    /// Hash partition used by the "state" scheme
+    static int stateShard(const std::string& state, int shardCount);
+
+    /// true for the scheme names makeShards() accepts
+    static bool validScheme(const std::string& scheme);
+
+private:
+    std::string scheme_;
+    std::vector<ShardEntry> shards_;
+    std::string error_;
+};
+
+/**
+ * @brief Splits a CSV file into N shard .len files, indexes them in
+ *        parallel and writes the manifest.
+ *
+ * The CSV is read twice: first the ZIPs alone, to find duplicated ones
+ * (see DuplicateKeys.h), then the records. Columns are found by header
+ * name (like ZipCodeBuffer), and every record is written in the usual
+ * field order ZipCode,PlaceName,State,County,Lat,Long so each shard can
+ * be indexed and searched like any other .len file. A duplicated ZIP may
+ * land in two shards under the "state" scheme, which is why the check
+ * runs over the whole CSV rather than per shard.
+ *
+ * @param csvFile Input CSV
+ * @param manifestFile Output manifest; shards are "<manifest>.shardNN.len"
+ * @param shardCount Number of shards (1..100)
+ * @param scheme "zip" or "state"
+ * @param withChecksum true to store a CRC32C after every record
+ * @param records Receives the number of records written
+ * @param error Receives a message when it fails
+ * @param policy What to do with the rows of a duplicated ZIP: with a
+ *        policy only one row of each is written; the shard indexes keep
+ *        the last one of any left in
+ * @param duplicates If given, receives a note on duplicated ZIPs
+ *        (empty when there are none)
+ * @return 0 on success, else an exit code (2 input, 3 output, 4 CSV
+ *         header, 5 index build, 6 publish, 7 duplicate ZIPs under
+ *         DuplicatePolicy::kError)
+ */
+int makeShards(const std::string& csvFile, const std::string& manifestFile,
+               int shardCount, const std::string& scheme, bool withChecksum,
+               long long& records, std::string& error,
+               DuplicatePolicy policy = DuplicatePolicy::kKeepAll,
+               std::string* duplicates = nullptr);
+
+/**
+ * @brief Scatter-gather state extremes over all shards of a manifest.
+ *
+ * Each shard is analyzed on its own thread: the store is opened (so WAL
+ * updates and deletes are seen) and its live records are read in file
+ * order. The per-shard tables are merged in shard order with
+ * mergeStateExtremes(), which gives the same table as one serial pass.
+ *
+ * @param manifest Loaded manifest
+ * @param threads Worker threads (0 = one per core)
+ * @param stateMap Receives the merged table
+ * @param records Receives the number of live records analyzed
+ * @param error Receives a message when it fails
+ * @return true on success
+ */
+bool analyzeShards(const ShardManifest& manifest, unsigned threads,
+                   std::map<std::string, StateExtremes>& stateMap,
+                   long long& records, std::string& error);
+
+#endif
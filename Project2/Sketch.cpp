@@ -0,0 +1,185 @@
+/**
+ * @file Sketch.cpp
+ * @brief Implementation of the streaming sketches.
+ * @date October 2026
+ */
+#include "Sketch.h"
+#include "BloomFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+using namespace std;
+
+static const uint64_t kSketchSeed = 0x9E3779B97F4A7C15ULL;
+
+KllSketch::KllSketch(unsigned k)
+    : k_(max(k, 8u)), count_(0), min_(0), max_(0), levels_(1), random_(kSketchSeed) {}
+
+size_t KllSketch::capacity(size_t level) const {
+    // k (2/3)^depth, depth counted down from the top level.
+    const size_t depth = levels_.size() - 1 - level;
+    return max(kMinLevel, static_cast<size_t>(ceil(k_ * pow(2.0 / 3.0, depth))));
+}
+
+size_t KllSketch::retained() const {
+    size_t n = 0;
+    for (const auto& level : levels_) n += level.size();
+    return n;
+}
+
+void KllSketch::add(double value) {
+    if (count_ == 0) {
+        min_ = max_ = value;
+    } else {
+        min_ = min(min_, value);
+        max_ = max(max_, value);
+    }
+    count_++;
+    levels_[0].push_back(value);
+    if (levels_[0].size() >= capacity(0)) compress();
+}
+
+void KllSketch::compress() {
+    // Compact the lowest full level; promoting can fill the next one.
+    for (size_t h = 0; h < levels_.size(); h++) {
+        if (levels_[h].size() < capacity(h)) continue;
+        if (h + 1 == levels_.size()) levels_.emplace_back();
+
+        vector<double>& level = levels_[h];
+        sort(level.begin(), level.end());
+        // An odd value out stays behind, so the promoted ones pair up.
+        double leftover = 0;
+        const bool odd = level.size() % 2 == 1;
+        if (odd) {
+            leftover = level.back();
+            level.pop_back();
+        }
+        random_ ^= random_ << 13;
+        random_ ^= random_ >> 7;
+        random_ ^= random_ << 17;
+        const size_t offset = random_ & 1;
+        vector<double>& up = levels_[h + 1];
+        for (size_t i = offset; i < level.size(); i += 2) up.push_back(level[i]);
+        level.clear();
+        if (odd) level.push_back(leftover);
+    }
+}
+
+void KllSketch::merge(const KllSketch& other) {
+    if (other.count_ == 0) return;
+    if (count_ == 0) {
+        min_ = other.min_;
+        max_ = other.max_;
+    } else {
+        min_ = min(min_, other.min_);
+        max_ = max(max_, other.max_);
+    }
+    count_ += other.count_;
+    if (levels_.size() < other.levels_.size()) levels_.resize(other.levels_.size());
+    for (size_t h = 0; h < other.levels_.size(); h++)
+        levels_[h].insert(levels_[h].end(), other.levels_[h].begin(), other.levels_[h].end());
+
+    // Compact until every level fits again.
+    for (bool full = true; full;) {
+        full = false;
+        for (size_t h = 0; h < levels_.size() && !full; h++)
+            full = levels_[h].size() >= capacity(h);
+        if (full) compress();
+    }
+}
+
+double KllSketch::quantile(double q) const {
+    if (count_ == 0) return 0;
+    if (q <= 0) return min_;
+    if (q >= 1) return max_;
+
+    vector<pair<double, uint64_t>> weighted;
+    weighted.reserve(retained());
+    uint64_t total = 0;
+    for (size_t h = 0; h < levels_.size(); h++) {
+        for (double v : levels_[h]) weighted.emplace_back(v, 1ULL << h);
+        total += levels_[h].size() << h;
+    }
+    sort(weighted.begin(), weighted.end());
+
+    // The first value whose cumulative weight reaches q of the total.
+    const double target = q * static_cast<double>(total);
+    uint64_t seen = 0;
+    for (const auto& w : weighted) {
+        seen += w.second;
+        if (static_cast<double>(seen) >= target) return w.first;
+    }
+    return max_;
+}
+
+// ---------------------------------------------------------------------------
+// HyperLogLog
+// ---------------------------------------------------------------------------
+
+static const char kHllMagic[4] = {'H', 'L', 'L', '1'};
+
+HyperLogLog::HyperLogLog(unsigned precision)
+    : precision_(min(max(precision, unsigned(kMinPrecision)), unsigned(kMaxPrecision))),
+      registers_(size_t(1) << precision_, 0) {}
+
+void HyperLogLog::add(const string& value) {
+    addHash(BloomFilter::hashKey(value));
+}
+
+void HyperLogLog::addHash(uint64_t hash) {
+    const size_t index = static_cast<size_t>(hash >> (64 - precision_));
+    // Leading zeros of the other bits; a sentinel bit caps the run.
+    const uint64_t rest = (hash << precision_) | (uint64_t(1) << (precision_ - 1));
+    const uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    if (rank > registers_[index]) registers_[index] = rank;
+}
+
+bool HyperLogLog::merge(const HyperLogLog& other) {
+    if (other.precision_ != precision_) return false;
+    for (size_t i = 0; i < registers_.size(); i++)
+        registers_[i] = max(registers_[i], other.registers_[i]);
+    return true;
+}
+
+double HyperLogLog::estimate() const {
+    const double m = static_cast<double>(registers_.size());
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t r : registers_) {
+        sum += ldexp(1.0, -static_cast<int>(r));
+        if (r == 0) zeros++;
+    }
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+    const double raw = alpha * m * m / sum;
+    if (raw <= 2.5 * m && zeros > 0) return m * log(m / static_cast<double>(zeros));
+    return raw;
+}
+
+void HyperLogLog::serialize(string& out) const {
+    out.append(kHllMagic, sizeof(kHllMagic));
+    out.push_back(static_cast<char>(precision_));
+    out.append(reinterpret_cast<const char*>(registers_.data()), registers_.size());
+}
+
+bool HyperLogLog::deserialize(const char*& p, const char* end) {
+    if (end - p < static_cast<ptrdiff_t>(sizeof(kHllMagic) + 1) ||
+        memcmp(p, kHllMagic, sizeof(kHllMagic)) != 0)
+        return false;
+    const unsigned precision = static_cast<uint8_t>(p[sizeof(kHllMagic)]);
+    if (precision < kMinPrecision || precision > kMaxPrecision) return false;
+    const size_t m = size_t(1) << precision;
+    const char* registers = p + sizeof(kHllMagic) + 1;
+    if (static_cast<size_t>(end - registers) < m) return false;
+    // A register never exceeds the 64 - p + 1 leading-zero rank.
+    for (size_t i = 0; i < m; i++)
+        if (static_cast<uint8_t>(registers[i]) > 65 - precision) return false;
+
+    precision_ = precision;
+    registers_.assign(reinterpret_cast<const uint8_t*>(registers),
+                      reinterpret_cast<const uint8_t*>(registers) + m);
+    p = registers + m;
+    return true;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file StateExtremes.cpp
+ * @brief Implementation of the state extremes analysis.
+ * @date October 2026
+ */
+#include "StateExtremes.h"
+
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+/**
+ * @brief If coordinate ties, choose the smaller ZIP.
+ * @param candidate ZIP we are considering
+ * @param current ZIP already stored
+ * @return true if candidate should replace current
+ */
+static bool smallerZipWins(int candidate, int current) {
+    if (current == 0) return true;  // current not set yet
+    return candidate < current;
+}
+
+/**
+ * @brief Update state extremes using one record.
+ * @param stateMap Map of state → extremes (updates inside)
+ * @param record One ZIP record
+ */
+void updateStateExtremes(map<string, StateExtremes>& stateMap,
+                                const ZipCodeRecord& record) {
+    const string& state = record.state;
+    StateExtremes& ex = stateMap[state]; // creates entry if missing
+
+    // EASTERNMOST (min longitude)
+    if (record.longitude < ex.minLongitude) {
+        ex.minLongitude = record.longitude;
+        ex.easternmost = record.zipCode;
+    } else if (record.longitude == ex.minLongitude &&
+               smallerZipWins(record.zipCode, ex.easternmost)) {
+        ex.easternmost = record.zipCode;
+    }
+
+    // WESTERNMOST (max longitude)
+    if (record.longitude > ex.maxLongitude) {
+        ex.maxLongitude = record.longitude;
+        ex.westernmost = record.zipCode;
+    } else if (record.longitude == ex.maxLongitude &&
+               smallerZipWins(record.zipCode, ex.westernmost)) {
+        ex.westernmost = record.zipCode;
+    }
+
+    // NORTHERNMOST (max latitude)
+    if (record.latitude > ex.maxLatitude) {
+        ex.maxLatitude = record.latitude;
+        ex.northernmost = record.zipCode;
+    } else if (record.latitude == ex.maxLatitude &&
+               smallerZipWins(record.zipCode, ex.northernmost)) {
+        ex.northernmost = record.zipCode;
+    }
+
+    // SOUTHERNMOST (min latitude)
+    if (record.latitude < ex.minLatitude) {
+        ex.minLatitude = record.latitude;
+        ex.southernmost = record.zipCode;
+    } else if (record.latitude == ex.minLatitude &&
+               smallerZipWins(record.zipCode, ex.southernmost)) {
+        ex.southernmost = record.zipCode;
+    }
+}
+
+/**
+ * @brief Merge partial results (e.g. from one shard) into a total.
+ *
+ * Each direction uses the same rule as updateStateExtremes(): the better
+ * coordinate wins, and on a tie the smaller ZIP wins.
+ *
+ * @param into Running total (updated)
+ * @param from Partial result to fold in
+ */
+void mergeStateExtremes(map<string, StateExtremes>& into,
+                        const map<string, StateExtremes>& from) {
+    for (const auto& entry : from) {
+        const StateExtremes& b = entry.second;
+        auto it = into.find(entry.first);
+        if (it == into.end()) {
+            into[entry.first] = b;
+            continue;
+        }
+        StateExtremes& a = it->second;
+
+        // EASTERNMOST (min longitude)
+        if (b.minLongitude < a.minLongitude ||
+            (b.minLongitude == a.minLongitude &&
+             smallerZipWins(b.easternmost, a.easternmost))) {
+            a.minLongitude = b.minLongitude;
+            a.easternmost = b.easternmost;
+        }
+
+        // WESTERNMOST (max longitude)
+        if (b.maxLongitude > a.maxLongitude ||
+            (b.maxLongitude == a.maxLongitude &&
+             smallerZipWins(b.westernmost, a.westernmost))) {
+            a.maxLongitude = b.maxLongitude;
+            a.westernmost = b.westernmost;
+        }
+
+        // NORTHERNMOST (max latitude)
+        if (b.maxLatitude > a.maxLatitude ||
+            (b.maxLatitude == a.maxLatitude &&
+             smallerZipWins(b.northernmost, a.northernmost))) {
+            a.maxLatitude = b.maxLatitude;
+            a.northernmost = b.northernmost;
+        }
+
+        // SOUTHERNMOST (min latitude)
+        if (b.minLatitude < a.minLatitude ||
+            (b.minLatitude == a.minLatitude &&
+             smallerZipWins(b.southernmost, a.southernmost))) {
+            a.minLatitude = b.minLatitude;
+            a.southernmost = b.southernmost;
+        }
+    }
+}
+
+/**
+ * @brief Print the state extremes table (same idea as Project 1).
+ * @param stateMap Map of state → extremes
+ */
+void printStateExtremesTable(const map<string, StateExtremes>& stateMap) {
+    cout << left;
+    cout << setw(8)  << "State"
+         << setw(15) << "Easternmost"
+         << setw(15) << "Westernmost"
+         << setw(15) << "Northernmost"
+         << setw(15) << "Southernmost"
+         << "\n";
+    cout << string(68, '-') << "\n";
+
+    for (const auto& entry : stateMap) {
+        const string& state = entry.first;
+        const StateExtremes& ex = entry.second;
+
+        cout << setw(8) << state;
+
+        cout << setfill('0') << setw(5) << ex.easternmost
+             << setfill(' ') << setw(10) << " ";
+
+        cout << setfill('0') << setw(5) << ex.westernmost
+             << setfill(' ') << setw(10) << " ";
+
+        cout << setfill('0') << setw(5) << ex.northernmost
+             << setfill(' ') << setw(10) << " ";
+
+        cout << setfill('0') << setw(5) << ex.southernmost
+             << setfill(' ') << "\n";
+    }
+
+    cout << "\nTotal states/territories: " << stateMap.size() << "\n";
+}
@@ -0,0 +1,78 @@
+/**
+ * @file StateExtremes.h
+ * @brief Per-state easternmost/westernmost/northernmost/southernmost ZIPs.
+ * @date October 2026
+ *
+ * Moved out of main.cpp so that several inputs (for example the shards of
+ * a sharded dataset, see ShardSet.h) can each be analyzed on their own
+ * thread and the partial results merged.
+ *
+ * Because ties are broken by the smaller ZIP, every extreme is decided by
+ * a total order. Merging partial results therefore gives exactly the same
+ * table as one pass over all records, whatever the merge order.
+ */
+#ifndef STATEEXTREMES_H
+#define STATEEXTREMES_H
+
+#include "ZipCodeBuffer.h"
+
+#include <limits>
+#include <map>
+#include <string>
+
+using namespace std;
+
+/**
+ * @struct StateExtremes
+ * @brief Keeps the most extreme ZIP codes for one state (east/west/north/south).
+ *
+ * We store:
+ * - Which ZIP code is easternmost / westernmost / northernmost / southernmost
+ * - The coordinate values used to compare
+ *
+ * Tie-breaking rule:
+ * - If two ZIPs tie on coordinate, choose the smaller ZIP so results are stable
+ *   even if the input rows are shuffled.
+ */
+struct StateExtremes {
+    int easternmost;
+    int westernmost;
+    int northernmost;
+    int southernmost;
+
+    double minLongitude;
+    double maxLongitude;
+    double maxLatitude;
+    double minLatitude;
+
+    StateExtremes()
+        : easternmost(0), westernmost(0), northernmost(0), southernmost(0),
+          minLongitude(numeric_limits<double>::max()),
+          maxLongitude(numeric_limits<double>::lowest()),
+          maxLatitude(numeric_limits<double>::lowest()),
+          minLatitude(numeric_limits<double>::max()) {}
+};
+
+/**
+ * @brief Update state extremes using one record.
+ * @param stateMap Map of state → extremes (updates inside)
+ * @param record One ZIP record
+ */
+void updateStateExtremes(map<string, StateExtremes>& stateMap,
+                         const ZipCodeRecord& record);
+
+/**
+ * @brief Merge partial results (e.g. from one shard) into a total.
+ * @param into Running total (updated)
+ * @param from Partial result to fold in
+ */
+void mergeStateExtremes(map<string, StateExtremes>& into,
+                        const map<string, StateExtremes>& from);
+
+/**
+ * @brief Print the state extremes table (same idea as Project 1).
+ * @param stateMap Map of state → extremes
+ */
+void printStateExtremesTable(const map<string, StateExtremes>& stateMap);
+
+#endif
@@ -0,0 +1,244 @@
+/**
+ * @file StateHull.cpp
+ * @brief Implementation of the per-state convex hulls.
+ * @date October 2026
+ */
+#include "StateHull.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using namespace std;
+
+/// > 0 if c is left of the line a → b, 0 on it, < 0 right of it
+static double cross(const HullPoint& a, const HullPoint& b, const HullPoint& c) {
+    return (b.longitude - a.longitude) * (c.latitude - a.latitude) -
+           (b.latitude - a.latitude) * (c.longitude - a.longitude);
+}
+
+/**
+ * @brief true if p is strictly inside the quadrilateral of the extreme points.
+ *
+ * The corners are in counter-clockwise order, so inside means left of every
+ * edge. A corner that coincides with the next gives a zero cross product,
+ * so a degenerate quadrilateral rejects nothing.
+ */
+static bool insideCorners(const HullPoint corners[4], const HullPoint& p) {
+    for (int i = 0; i < 4; i++) {
+        if (cross(corners[i], corners[(i + 1) % 4], p) <= 0) return false;
+    }
+    return true;
+}
+
+/// Drops the candidates strictly inside the corners' quadrilateral
+static void prune(vector<HullPoint>& candidates, const HullPoint corners[4]) {
+    candidates.erase(remove_if(candidates.begin(), candidates.end(),
+                               [&](const HullPoint& p) { return insideCorners(corners, p); }),
+                     candidates.end());
+}
+
+/**
+ * @brief Andrew's monotone chain.
+ * @param points Candidates (sorted and deduplicated here)
+ * @return Hull vertices counter-clockwise from the lowest-left point;
+ *         1 or 2 points if they do not span an area
+ */
+static vector<HullPoint> convexHull(vector<HullPoint> points) {
+    sort(points.begin(), points.end(), [](const HullPoint& a, const HullPoint& b) {
+        if (a.longitude != b.longitude) return a.longitude < b.longitude;
+        if (a.latitude != b.latitude) return a.latitude < b.latitude;
+        return a.zipCode < b.zipCode;
+    });
+    // The smallest ZIP stands for each spot.
+    points.erase(unique(points.begin(), points.end(),
+                        [](const HullPoint& a, const HullPoint& b) {
+                            return a.longitude == b.longitude && a.latitude == b.latitude;
+                        }),
+                 points.end());
+    const size_t n = points.size();
+    if (n < 3) return points;
+
+    // Lower chain left to right, then upper chain back; collinear points
+    // (cross == 0) are not vertices.
+    vector<HullPoint> hull(2 * n);
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) k--;
+        hull[k++] = points[i];
+    }
+    for (size_t i = n - 1, lower = k + 1; i-- > 0;) {
+        while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) k--;
+        hull[k++] = points[i];
+    }
+    hull.resize(k - 1);   // the last point is the first again
+    return hull;
+}
+
+void StateHullBuilder::add(const ZipCodeRecord& record) {
+    records_++;
+    updateStateExtremes(extremes_, record);
+    const StateExtremes& ex = extremes_[record.state];
+
+    const HullPoint p{record.longitude, record.latitude, record.zipCode};
+    auto found = states_.find(record.state);
+    if (found == states_.end()) {
+        Pending fresh;
+        for (HullPoint& c : fresh.corners) c = p;
+        fresh.points = 0;
+        fresh.nextPrune = kFirstPrune;
+        found = states_.emplace(record.state, fresh).first;
+    }
+    Pending& s = found->second;
+    s.points++;
+
+    // The record is a corner if updateStateExtremes() just chose it, by the
+    // same tie rules as the extremes table.
+    bool corner = false;
+    if (ex.easternmost == record.zipCode && ex.minLongitude == record.longitude) {
+        s.corners[0] = p;
+        corner = true;
+    }
+    if (ex.southernmost == record.zipCode && ex.minLatitude == record.latitude) {
+        s.corners[1] = p;
+        corner = true;
+    }
+    if (ex.westernmost == record.zipCode && ex.maxLongitude == record.longitude) {
+        s.corners[2] = p;
+        corner = true;
+    }
+    if (ex.northernmost == record.zipCode && ex.maxLatitude == record.latitude) {
+        s.corners[3] = p;
+        corner = true;
+    }
+    if (!corner && insideCorners(s.corners, p)) return;
+
+    s.candidates.push_back(p);
+    if (s.candidates.size() >= s.nextPrune) {
+        prune(s.candidates, s.corners);
+        s.nextPrune = 2 * s.candidates.size();
+        if (s.nextPrune < kFirstPrune) s.nextPrune = kFirstPrune;
+    }
+}
+
+void StateHullBuilder::finish(unsigned threads, map<string, StateHull>& hulls) const {
+    hulls.clear();
+    vector<const Pending*> pending;
+    vector<StateHull*> out;
+    for (const auto& entry : states_) {
+        StateHull& h = hulls[entry.first];
+        const StateExtremes& ex = extremes_.at(entry.first);
+        h.minLongitude = ex.minLongitude;
+        h.maxLongitude = ex.maxLongitude;
+        h.minLatitude = ex.minLatitude;
+        h.maxLatitude = ex.maxLatitude;
+        h.points = entry.second.points;
+        pending.push_back(&entry.second);
+        out.push_back(&h);
+    }
+
+    // States differ a lot in size, so threads take the next state from a
+    // shared counter.
+    atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t i = next++; i < pending.size(); i = next++) {
+            vector<HullPoint> candidates = pending[i]->candidates;
+            prune(candidates, pending[i]->corners);
+            out[i]->candidates = candidates.size();
+            out[i]->hull = convexHull(std::move(candidates));
+        }
+    };
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    threads = static_cast<unsigned>(min<size_t>(threads, pending.size()));
+    if (threads <= 1) {
+        work();
+        return;
+    }
+    vector<thread> pool;
+    for (unsigned t = 0; t < threads; t++) pool.emplace_back(work);
+    for (thread& th : pool) th.join();
+}
+
+/* ============================================================================
+ *  Output
+ * ============================================================================
+ */
+
+/// s as a JSON string literal
+static string jsonString(const string& s) {
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out + "\"";
+}
+
+/// "[lon,lat]"
+static void writeJsonPosition(ostream& out, const HullPoint& p) {
+    out << '[' << p.longitude << ',' << p.latitude << ']';
+}
+
+void writeHullsGeoJson(ostream& out, const map<string, StateHull>& hulls) {
+    const streamsize oldPrecision = out.precision(10);
+    out << "{\"type\":\"FeatureCollection\",\"features\":[\n";
+    bool first = true;
+    for (const auto& entry : hulls) {
+        const StateHull& h = entry.second;
+        if (h.hull.empty()) continue;
+        if (!first) out << ",\n";
+        first = false;
+
+        out << "{\"type\":\"Feature\",\"bbox\":[" << h.minLongitude << ',' << h.minLatitude
+            << ',' << h.maxLongitude << ',' << h.maxLatitude << "],\"properties\":{\"state\":"
+            << jsonString(entry.first) << ",\"zips\":" << h.points
+            << ",\"vertices\":" << h.hull.size() << "},\"geometry\":";
+        if (h.hull.size() == 1) {
+            out << "{\"type\":\"Point\",\"coordinates\":";
+            writeJsonPosition(out, h.hull[0]);
+        } else if (h.hull.size() == 2) {
+            out << "{\"type\":\"LineString\",\"coordinates\":[";
+            writeJsonPosition(out, h.hull[0]);
+            out << ',';
+            writeJsonPosition(out, h.hull[1]);
+            out << ']';
+        } else {
+            // A linear ring ends where it starts.
+            out << "{\"type\":\"Polygon\",\"coordinates\":[[";
+            for (const HullPoint& p : h.hull) {
+                writeJsonPosition(out, p);
+                out << ',';
+            }
+            writeJsonPosition(out, h.hull[0]);
+            out << "]]";
+        }
+        out << "}}";
+    }
+    out << "\n]}\n";
+    out.precision(oldPrecision);
+}
+
+void writeHullsWkt(ostream& out, const map<string, StateHull>& hulls) {
+    const streamsize oldPrecision = out.precision(10);
+    for (const auto& entry : hulls) {
+        const StateHull& h = entry.second;
+        if (h.hull.empty()) continue;
+
+        out << entry.first << '\t';
+        if (h.hull.size() == 1) {
+            out << "POINT(" << h.hull[0].longitude << ' ' << h.hull[0].latitude << ')';
+        } else if (h.hull.size() == 2) {
+            out << "LINESTRING(" << h.hull[0].longitude << ' ' << h.hull[0].latitude << ", "
+                << h.hull[1].longitude << ' ' << h.hull[1].latitude << ')';
+        } else {
+            out << "POLYGON((";
+            for (const HullPoint& p : h.hull) out << p.longitude << ' ' << p.latitude << ", ";
+            out << h.hull[0].longitude << ' ' << h.hull[0].latitude << "))";
+        }
+        out << "\tPOLYGON((" << h.minLongitude << ' ' << h.minLatitude << ", " << h.maxLongitude
+            << ' ' << h.minLatitude << ", " << h.maxLongitude << ' ' << h.maxLatitude << ", "
+            << h.minLongitude << ' ' << h.maxLatitude << ", " << h.minLongitude << ' '
+            << h.minLatitude << "))\n";
+    }
+    out.precision(oldPrecision);
+}
@@ -0,0 +1,123 @@
+/**
+ * @file StateHull.h
+ * @brief Per-state convex hull and bounding box of the ZIP centroids, as
+ *        GeoJSON or WKT.
+ * @date October 2026
+ *
+ * The extremes table (see StateExtremes.h) gives four points per state; map
+ * tiles want the whole outline. Records are streamed once:
+ *
+ * - updateStateExtremes() keeps each state's extremes current, and the four
+ *   extreme points span a quadrilateral inside the final hull. A point
+ *   strictly inside it can never be a hull vertex, so it is dropped at once
+ *   (the Akl-Toussaint heuristic). The quadrilateral only grows, so early
+ *   points are checked again whenever a state's candidates have doubled,
+ *   and once more at the end. An earlier quadrilateral is inside the hull
+ *   but not always inside the final one, so how many points survive
+ *   depends on the input order; the hull does not.
+ * - finish() then runs Andrew's monotone chain on each state's remaining
+ *   candidates, states in parallel. Each state's hull only depends on its
+ *   own points, so the thread count does not change the result.
+ *
+ * Longitude is x and latitude is y: the hull is taken on the flat map, the
+ * way the tiles draw it. That is fine for US data, which does not cross
+ * the date line. Hull vertices are counter-clockwise, as GeoJSON wants for
+ * an outer ring. Among ZIPs at the same spot the smallest one is kept, so
+ * shuffled input gives the same output.
+ */
+#ifndef STATEHULL_H
+#define STATEHULL_H
+
+#include "StateExtremes.h"
+#include "ZipCodeBuffer.h"
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// One ZIP centroid
+struct HullPoint {
+    double longitude;
+    double latitude;
+    int zipCode;
+};
+
+/**
+ * @struct StateHull
+ * @brief Outline of one state's ZIP centroids.
+ */
+struct StateHull {
+    vector<HullPoint> hull;    ///< counter-clockwise, first vertex not repeated
+    double minLongitude;       ///< bounding box
+    double maxLongitude;
+    double minLatitude;
+    double maxLatitude;
+    size_t points;             ///< records of the state
+    size_t candidates;         ///< points left after pruning (depends on input order)
+
+    StateHull()
+        : minLongitude(0), maxLongitude(0), minLatitude(0), maxLatitude(0), points(0),
+          candidates(0) {}
+};
+
+/**
+ * @class StateHullBuilder
+ * @brief Collects hull candidates from a stream of records.
+ */
+class StateHullBuilder {
+public:
+    /// A state's candidates are pruned again when they reach this many, and
+    /// then every time they have doubled
+    static const size_t kFirstPrune = 64;
+
+    /**
+     * @brief Take one record into account.
+     * @param record One ZIP record
+     */
+    void add(const ZipCodeRecord& record);
+
+    /**
+     * @brief Compute every state's hull.
+     * @param threads Worker threads (0 = one per core)
+     * @param hulls Receives state → hull
+     */
+    void finish(unsigned threads, map<string, StateHull>& hulls) const;
+
+    /// Extremes of every state so far (the same table as analyzeCsvStreaming's)
+    const map<string, StateExtremes>& extremes() const { return extremes_; }
+
+    /// Records taken so far
+    size_t records() const { return records_; }
+
+private:
+    struct Pending {
+        vector<HullPoint> candidates;
+        HullPoint corners[4];   ///< min longitude, min latitude, max longitude, max latitude
+        size_t points;
+        size_t nextPrune;
+    };
+
+    map<string, StateExtremes> extremes_;
+    map<string, Pending> states_;
+    size_t records_ = 0;
+};
+
+/**
+ * @brief Write the hulls as a GeoJSON FeatureCollection: one Polygon per
+ *        state (a Point or LineString if its ZIPs do not span an area), with
+ *        the bounding box as "bbox" and the counts as properties.
+ */
+void writeHullsGeoJson(ostream& out, const map<string, StateHull>& hulls);
+
+/**
+ * @brief Write the hulls as WKT, one line per state: the state, the hull
+ *        (POLYGON, or POINT / LINESTRING) and the bounding box (POLYGON),
+ *        separated by tabs.
+ */
+void writeHullsWkt(ostream& out, const map<string, StateHull>& hulls);
+
+#endif
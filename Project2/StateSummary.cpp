@@ -0,0 +1,98 @@
+/**
+ * @file StateSummary.cpp
+ * @brief Implementation of the per-state top-k and quantile summaries.
+ * @date October 2026
+ */
+#include "StateSummary.h"
+
+#include <algorithm>
+
+using namespace std;
+
+TopK::TopK(size_t k, bool largest) : k_(max<size_t>(k, 1)), largest_(largest) {}
+
+void TopK::add(double coord, int zipCode) {
+    // With better() as the heap order, the heap top is the worst kept ZIP.
+    auto order = [this](const RankedZip& a, const RankedZip& b) { return better(a, b); };
+    const RankedZip z{coord, zipCode};
+    if (heap_.size() < k_) {
+        heap_.push_back(z);
+        push_heap(heap_.begin(), heap_.end(), order);
+    } else if (better(z, heap_[0])) {
+        pop_heap(heap_.begin(), heap_.end(), order);
+        heap_.back() = z;
+        push_heap(heap_.begin(), heap_.end(), order);
+    }
+}
+
+void TopK::merge(const TopK& other) {
+    for (const RankedZip& z : other.heap_) add(z.coord, z.zipCode);
+}
+
+vector<RankedZip> TopK::sorted() const {
+    vector<RankedZip> out = heap_;
+    sort(out.begin(), out.end(),
+         [this](const RankedZip& a, const RankedZip& b) { return better(a, b); });
+    return out;
+}
+
+StateSummaries::StateSummaries(size_t k, bool quantiles, unsigned sketchK)
+    : k_(max<size_t>(k, 1)), quantiles_(quantiles), sketchK_(sketchK) {}
+
+void StateSummaries::add(const ZipCodeRecord& record) {
+    auto it = states_.find(record.state);
+    if (it == states_.end())
+        it = states_.emplace(record.state, StateSummary(k_, sketchK_)).first;
+    StateSummary& s = it->second;
+    s.records++;
+    s.maxLatitude.add(record.latitude, record.zipCode);
+    s.minLatitude.add(record.latitude, record.zipCode);
+    s.minLongitude.add(record.longitude, record.zipCode);
+    s.maxLongitude.add(record.longitude, record.zipCode);
+    if (quantiles_) {
+        s.latitude.add(record.latitude);
+        s.longitude.add(record.longitude);
+    }
+}
+
+void StateSummaries::merge(const StateSummaries& other) {
+    for (const auto& entry : other.states_) {
+        auto it = states_.find(entry.first);
+        if (it == states_.end())
+            it = states_.emplace(entry.first, StateSummary(k_, sketchK_)).first;
+        StateSummary& s = it->second;
+        const StateSummary& o = entry.second;
+        s.records += o.records;
+        s.maxLatitude.merge(o.maxLatitude);
+        s.minLatitude.merge(o.minLatitude);
+        s.minLongitude.merge(o.minLongitude);
+        s.maxLongitude.merge(o.maxLongitude);
+        if (quantiles_) {
+            s.latitude.merge(o.latitude);
+            s.longitude.merge(o.longitude);
+        }
+    }
+}
+
+void StateSummaries::toStateExtremes(map<string, StateExtremes>& out) const {
+    out.clear();
+    for (const auto& entry : states_) {
+        const StateSummary& s = entry.second;
+        if (s.records == 0) continue;
+        const RankedZip minLon = s.minLongitude.sorted()[0];
+        const RankedZip maxLon = s.maxLongitude.sorted()[0];
+        const RankedZip maxLat = s.maxLatitude.sorted()[0];
+        const RankedZip minLat = s.minLatitude.sorted()[0];
+
+        // Same field meaning as updateStateExtremes().
+        StateExtremes& ex = out[entry.first];
+        ex.minLongitude = minLon.coord;
+        ex.easternmost = minLon.zipCode;
+        ex.maxLongitude = maxLon.coord;
+        ex.westernmost = maxLon.zipCode;
+        ex.maxLatitude = maxLat.coord;
+        ex.northernmost = maxLat.zipCode;
+        ex.minLatitude = minLat.coord;
+        ex.southernmost = minLat.zipCode;
+    }
+}
@@ -0,0 +1,124 @@
+/**
+ * @file StateSummary.h
+ * @brief Per-state top-k extremes and coordinate quantiles, in one pass
+ *        and mergeable.
+ * @date October 2026
+ *
+ * For every state:
+ * - four bounded heaps keep the k ZIPs with the largest / smallest
+ *   latitude and longitude. The worst kept ZIP is on top, so a new record
+ *   costs one comparison, or O(log k) if it gets in.
+ * - two KLL sketches (see Sketch.h) give approximate latitude and
+ *   longitude quantiles.
+ *
+ * Ties go to the smaller ZIP, as in updateStateExtremes(). Merging
+ * summaries of separate inputs (threads, shards) therefore gives exactly
+ * the top-k of one pass over all of them, and the extremes table is the
+ * k = 1 case: toStateExtremes() gives the table updateStateExtremes() would.
+ */
+#ifndef STATESUMMARY_H
+#define STATESUMMARY_H
+
+#include "Sketch.h"
+#include "StateExtremes.h"
+#include "ZipCodeBuffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// One ZIP and the coordinate it was ranked by
+struct RankedZip {
+    double coord;
+    int zipCode;
+};
+
+/**
+ * @class TopK
+ * @brief The k ZIPs with the largest (or smallest) coordinate.
+ */
+class TopK {
+public:
+    TopK(size_t k, bool largest);
+
+    /// Offers one ZIP
+    void add(double coord, int zipCode);
+
+    /// Offers every ZIP kept by another TopK of the same kind
+    void merge(const TopK& other);
+
+    /// The kept ZIPs, best first
+    vector<RankedZip> sorted() const;
+
+    size_t size() const { return heap_.size(); }
+
+private:
+    /// true if a ranks before b
+    bool better(const RankedZip& a, const RankedZip& b) const {
+        if (a.coord != b.coord) return largest_ ? a.coord > b.coord : a.coord < b.coord;
+        return a.zipCode < b.zipCode;
+    }
+
+    size_t k_;
+    bool largest_;
+    vector<RankedZip> heap_;   ///< worst on top (heap_[0])
+};
+
+/**
+ * @struct StateSummary
+ * @brief Top-k and quantiles of one state.
+ */
+struct StateSummary {
+    TopK maxLatitude;     ///< northernmost
+    TopK minLatitude;     ///< southernmost
+    TopK minLongitude;
+    TopK maxLongitude;
+    KllSketch latitude;
+    KllSketch longitude;
+    uint64_t records;
+
+    StateSummary(size_t k, unsigned sketchK)
+        : maxLatitude(k, true), minLatitude(k, false), minLongitude(k, false),
+          maxLongitude(k, true), latitude(sketchK), longitude(sketchK), records(0) {}
+};
+
+/**
+ * @class StateSummaries
+ * @brief StateSummary of every state in a stream of records.
+ */
+class StateSummaries {
+public:
+    /**
+     * @param k ZIPs kept per state and direction
+     * @param quantiles false to skip the sketches (top-k only)
+     * @param sketchK KLL accuracy parameter
+     */
+    explicit StateSummaries(size_t k, bool quantiles = true,
+                            unsigned sketchK = KllSketch::kDefaultK);
+
+    /// Takes one record into account
+    void add(const ZipCodeRecord& record);
+
+    /// Folds in the summaries of another input (same k)
+    void merge(const StateSummaries& other);
+
+    const map<string, StateSummary>& states() const { return states_; }
+
+    size_t k() const { return k_; }
+    bool hasQuantiles() const { return quantiles_; }
+
+    /// The extremes table: the first ZIP of each direction
+    void toStateExtremes(map<string, StateExtremes>& out) const;
+
+private:
+    size_t k_;
+    bool quantiles_;
+    unsigned sketchK_;
+    map<string, StateSummary> states_;
+};
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file StoreReloader.cpp
+ * @brief Implementation of the StoreReloader class.
+ * @date October 2026
+ */
+#include "StoreReloader.h"
+
+#include <vector>
+
+using namespace std;
+
+StoreReloader::StoreReloader()
+    : reloads_(0), warmIndex_(false), lockIndex_(false) {}
+
+shared_ptr<const ZipDataStore> StoreReloader::current() const {
+    return atomic_load(&current_);
+}
+
+bool StoreReloader::validate(const ZipDataStore& store, string& warning, string& error) {
+    warning.clear();
+    if (!store.headerParsed()) {
+        warning = "old header format: record count not checked";
+        return true;
+    }
+    const FileHeader& h = store.header();
+
+    // Record count: every live ZIP was one of the records written; without
+    // updates or deletes the numbers are equal.
+    long long live = static_cast<long long>(store.liveRecords());
+    if (live == 0 || live > h.recordCount ||
+        (!store.usingSegment() && store.deadRecords() == 0 && live != h.recordCount)) {
+        error = "header says " + to_string(h.recordCount) + " records but the index has "
+                + to_string(live);
+        return false;
+    }
+
+    // The records at the lowest and highest offsets must be readable and
+    // belong to their ZIPs (catches an index from a different file that
+    // happens to carry no generation).
+    vector<pair<string, long long>> probes;
+    if (store.usingSegment()) {
+        string zip;
+        long long offset;
+        if (store.segment().entry(0, zip, offset)) probes.push_back({zip, offset});
+        if (store.segment().entry(store.segment().size() - 1, zip, offset))
+            probes.push_back({zip, offset});
+    } else {
+        const pair<const string, long long>* lo = nullptr;
+        const pair<const string, long long>* hi = nullptr;
+        for (const auto& e : store.index()) {
+            if (!lo || e.second < lo->second) lo = &e;
+            if (!hi || e.second > hi->second) hi = &e;
+        }
+        if (lo) probes.push_back(*lo);
+        if (hi) probes.push_back(*hi);
+    }
+    string text;
+    for (const auto& p : probes) {
+        if (store.isDeleted(p.first)) continue;
+        LenStatus st = store.readRecordAt(p.second, text);
+        if (st != LenStatus::Ok) {
+            error = "record for ZIP " + p.first + " cannot be read (" + lenStatusText(st) + ")";
+            return false;
+        }
+        if (text.compare(0, p.first.size() + 1, p.first + ",") != 0) {
+            error = "index entry for ZIP " + p.first + " points at another record";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StoreReloader::prepare(shared_ptr<const ZipDataStore>& store, string& warning,
+                            string& error) const {
+    shared_ptr<ZipDataStore> fresh = make_shared<ZipDataStore>();
+    if (!fresh->open(lenFile_, idxFile_, false)) {
+        error = fresh->lastError();
+        return false;
+    }
+    if (!validate(*fresh, warning, error)) return false;
+    if (warmIndex_ && !fresh->warmIndex(lockIndex_))
+        warning += (warning.empty() ? "" : "; ") + fresh->lastError();
+    store = fresh;
+    return true;
+}
+
+void StoreReloader::install(shared_ptr<const ZipDataStore> store, const string& warning) {
+    // Holders of the old pointer keep the old store open until they finish.
+    atomic_store(&current_, store);
+    warning_ = warning;
+    reloads_++;
+}
+
+bool StoreReloader::open(const string& lenFile, const string& idxFile) {
+    lenFile_ = lenFile;
+    idxFile_ = idxFile;
+    shared_ptr<const ZipDataStore> store;
+    if (!prepare(store, warning_, error_)) return false;
+    atomic_store(&current_, store);
+    return true;
+}
+
+bool StoreReloader::reload() {
+    shared_ptr<const ZipDataStore> store;
+    string warning;
+    if (!prepare(store, warning, error_)) return false;
+    install(store, warning);
+    return true;
+}
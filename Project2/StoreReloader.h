@@ -0,0 +1,111 @@
+/**
+ * @file StoreReloader.h
+ * @brief Swaps a newly generated data/index pair into a running process.
+ * @date October 2026
+ *
+ * A long-running reader (the TCP server) holds its ZipDataStore through a
+ * shared_ptr. reload() opens the pair again into a NEW store, checks it,
+ * and only then replaces the pointer with one atomic store. Requests that
+ * already took the old pointer finish on the old store; it is closed when
+ * the last of them lets go. If the new pair fails the checks, nothing
+ * changes and the old pair keeps serving.
+ *
+ * reload() is prepare() followed by install(). Opening a pair parses its
+ * whole index, so a caller that must not block (the server's event loop)
+ * runs prepare() on another thread and calls install() itself once the
+ * new store is ready.
+ *
+ * Checks on the new pair (besides the generation check that open() does):
+ * - the header parses and its record count agrees with the index: equal
+ *   when nothing was updated, never smaller than the live records;
+ * - the first and last indexed records can be read and carry their ZIP.
+ *
+ * With setIndexWarmup() every pair is warmed (and optionally locked in
+ * RAM, see ZipDataStore::warmIndex()) before it is swapped in.
+ */
+#ifndef STORERELOADER_H
+#define STORERELOADER_H
+
+#include "ZipDataStore.h"
+
+#include <memory>
+#include <string>
+
+/**
+ * @class StoreReloader
+ * @brief Owns the current store and replaces it atomically.
+ *
+ * current() may be called from any thread, and prepare() from another
+ * thread while it is; install() and reload() from one thread at a time.
+ */
+class StoreReloader {
+public:
+    StoreReloader();
+
+    /**
+     * @brief Opens and checks the first pair.
+     * @return false if it cannot be opened or fails a check (see lastError())
+     */
+    bool open(const std::string& lenFile, const std::string& idxFile);
+
+    /**
+     * @brief Opens and checks the pair again, then swaps it in.
+     * @return false if the new pair was rejected; the old one stays in use
+     */
+    bool reload();
+
+    /**
+     * @brief Opens and checks the pair into a new store, without using it.
+     *        Changes nothing in the reloader.
+     * @param store Receives the new store
+     * @param warning Receives a non-fatal remark ("" if none)
+     * @param error Receives the reason for rejecting the pair
+     * @return false if the pair was rejected
+     */
+    bool prepare(std::shared_ptr<const ZipDataStore>& store, std::string& warning,
+                 std::string& error) const;
+
+    /// Swaps in a store from prepare(); counts as a reload
+    void install(std::shared_ptr<const ZipDataStore> store, const std::string& warning);
+
+    /// The store new requests should use (kept alive while held)
+    std::shared_ptr<const ZipDataStore> current() const;
+
+    /**
+     * @brief Warm (and optionally lock) the index of every pair opened.
+     * @param lock true to mlock it; a refused lock is only a warning
+     */
+    void setIndexWarmup(bool lock) {
+        warmIndex_ = true;
+        lockIndex_ = lock;
+    }
+
+    /// Successful reloads so far
+    long long reloads() const { return reloads_; }
+
+    /// Warning from the last successful open/reload ("" if none)
+    const std::string& lastWarning() const { return warning_; }
+
+    const std::string& lastError() const { return error_; }
+
+    /**
+     * @brief The checks listed above.
+     * @param store Freshly opened store
+     * @param warning Receives a non-fatal remark
+     * @param error Receives the reason for rejecting it
+     * @return true if the pair may be used
+     */
+    static bool validate(const ZipDataStore& store, std::string& warning, std::string& error);
+
+private:
+    std::string lenFile_;
+    std::string idxFile_;
+    std::shared_ptr<const ZipDataStore> current_;
+    long long reloads_;
+    bool warmIndex_;
+    bool lockIndex_;
+    std::string warning_;
+    std::string error_;
+};
+
+#endif
@@ -0,0 +1,194 @@
+/**
+ * @file Succinct.cpp
+ * @brief Implementation of the Elias-Fano and packed integer sequences.
+ * @date October 2026
+ */
+#include "Succinct.h"
+
+#include <algorithm>
+
+using namespace std;
+
+/// Words for a number of bits
+static size_t wordsFor(uint64_t bits) {
+    return static_cast<size_t>((bits + 63) / 64);
+}
+
+/// ORs a value of the given width into a bit array at bit position pos
+static void putBits(uint64_t* words, uint64_t pos, unsigned width, uint64_t value) {
+    if (width == 0) return;
+    const size_t w = static_cast<size_t>(pos >> 6);
+    const unsigned shift = static_cast<unsigned>(pos & 63);
+    words[w] |= value << shift;
+    if (shift + width > 64) words[w + 1] |= value >> (64 - shift);
+}
+
+/**
+ * @brief Position of the k-th set bit at or after bit position pos.
+ */
+static uint64_t selectFrom(const uint64_t* words, uint64_t pos, size_t k, bool ones) {
+    size_t w = static_cast<size_t>(pos >> 6);
+    uint64_t bits = (ones ? words[w] : ~words[w]) & (~0ULL << (pos & 63));
+    while (true) {
+        const size_t c = static_cast<size_t>(__builtin_popcountll(bits));
+        if (k < c) break;
+        k -= c;
+        w++;
+        bits = ones ? words[w] : ~words[w];
+    }
+    while (k-- > 0) bits &= bits - 1;
+    return (static_cast<uint64_t>(w) << 6) + static_cast<uint64_t>(__builtin_ctzll(bits));
+}
+
+// ---------------------------------------------------------------------------
+// EliasFano
+// ---------------------------------------------------------------------------
+
+EliasFano::EliasFano()
+    : count_(0), lowBits_(0), highBitCount_(0), words_(0), low_(nullptr),
+      high_(nullptr), ones_(nullptr), zeros_(nullptr) {}
+
+void EliasFano::encode(const uint64_t* values, size_t count, vector<uint64_t>& out) {
+    const uint64_t universe = count ? values[count - 1] : 0;
+    unsigned lowBits = 0;
+    if (count > 0 && universe / count > 0)
+        lowBits = 63u - static_cast<unsigned>(__builtin_clzll(universe / count));
+    const uint64_t highBits = count + (universe >> lowBits) + 1;
+
+    const size_t lowWords = wordsFor(static_cast<uint64_t>(count) * lowBits);
+    const size_t highWords = wordsFor(highBits);
+    const size_t oneSamples = (count + kSampleStep - 1) / kSampleStep;
+    const size_t zeroSamples =
+        static_cast<size_t>((highBits - count + kSampleStep - 1) / kSampleStep);
+
+    out.assign(3 + lowWords + highWords + oneSamples + zeroSamples, 0);
+    out[0] = count;
+    out[1] = lowBits;
+    out[2] = highBits;
+    uint64_t* low = out.data() + 3;
+    uint64_t* high = low + lowWords;
+    uint64_t* ones = high + highWords;
+    uint64_t* zeros = ones + oneSamples;
+
+    const uint64_t mask = (lowBits == 0) ? 0 : (1ULL << lowBits) - 1;
+    for (size_t i = 0; i < count; i++) {
+        putBits(low, static_cast<uint64_t>(i) * lowBits, lowBits, values[i] & mask);
+        const uint64_t bit = (values[i] >> lowBits) + i;
+        high[bit >> 6] |= 1ULL << (bit & 63);
+    }
+
+    uint64_t seenOnes = 0, seenZeros = 0;
+    for (uint64_t p = 0; p < highBits; p++) {
+        if ((high[p >> 6] >> (p & 63)) & 1) {
+            if (seenOnes % kSampleStep == 0) ones[seenOnes / kSampleStep] = p;
+            seenOnes++;
+        } else {
+            if (seenZeros % kSampleStep == 0) zeros[seenZeros / kSampleStep] = p;
+            seenZeros++;
+        }
+    }
+}
+
+bool EliasFano::attach(const uint64_t* words, size_t wordCount) {
+    *this = EliasFano();
+    if (wordCount < 3) return false;
+    const uint64_t count = words[0];
+    const uint64_t lowBits = words[1];
+    const uint64_t highBits = words[2];
+    if (lowBits > 63 || highBits <= count || count > (1ULL << 40)) return false;
+
+    const size_t lowWords = wordsFor(count * lowBits);
+    const size_t highWords = wordsFor(highBits);
+    const size_t oneSamples = static_cast<size_t>((count + kSampleStep - 1) / kSampleStep);
+    const size_t zeroSamples =
+        static_cast<size_t>((highBits - count + kSampleStep - 1) / kSampleStep);
+    const size_t total = 3 + lowWords + highWords + oneSamples + zeroSamples;
+    if (total > wordCount) return false;
+
+    count_ = static_cast<size_t>(count);
+    lowBits_ = static_cast<unsigned>(lowBits);
+    highBitCount_ = highBits;
+    words_ = total;
+    low_ = words + 3;
+    high_ = low_ + lowWords;
+    ones_ = high_ + highWords;
+    zeros_ = ones_ + oneSamples;
+    return true;
+}
+
+uint64_t EliasFano::select1(size_t i) const {
+    return selectFrom(high_, ones_[i / kSampleStep], i % kSampleStep, true);
+}
+
+uint64_t EliasFano::select0(size_t i) const {
+    return selectFrom(high_, zeros_[i / kSampleStep], i % kSampleStep, false);
+}
+
+size_t EliasFano::lowerBound(uint64_t x) const {
+    if (count_ == 0) return 0;
+    // One zero ends each high part 0..max, so the zero count is max + 1.
+    const uint64_t hx = x >> lowBits_;
+    if (hx >= highBitCount_ - count_) return count_;
+
+    // Values with a smaller high part are the ones before zero hx - 1.
+    uint64_t p = (hx == 0) ? 0 : select0(static_cast<size_t>(hx - 1)) + 1;
+    size_t i = static_cast<size_t>(p - hx);
+
+    // Then the values sharing x's high part, up to the next zero.
+    const uint64_t lowX = x & ((1ULL << lowBits_) - 1);
+    while ((high_[p >> 6] >> (p & 63)) & 1) {
+        if (low(i) >= lowX) return i;
+        i++;
+        p++;
+    }
+    return i;
+}
+
+EliasFano::Cursor EliasFano::at(size_t i) const {
+    if (i >= count_) return Cursor(this, count_, 0);
+    return Cursor(this, i, select1(i));
+}
+
+void EliasFano::Cursor::next() {
+    if (++i_ >= ef_->count_) return;
+    const uint64_t p = pos_ + 1;
+    size_t w = static_cast<size_t>(p >> 6);
+    uint64_t bits = ef_->high_[w] & (~0ULL << (p & 63));
+    while (bits == 0) bits = ef_->high_[++w];
+    pos_ = (static_cast<uint64_t>(w) << 6) + static_cast<uint64_t>(__builtin_ctzll(bits));
+}
+
+// ---------------------------------------------------------------------------
+// PackedArray
+// ---------------------------------------------------------------------------
+
+PackedArray::PackedArray() : count_(0), width_(0), words_(0), bits_(nullptr) {}
+
+void PackedArray::encode(const uint64_t* values, size_t count, vector<uint64_t>& out) {
+    uint64_t largest = 0;
+    for (size_t i = 0; i < count; i++) largest = max(largest, values[i]);
+    const unsigned width =
+        largest ? 64u - static_cast<unsigned>(__builtin_clzll(largest)) : 0u;
+
+    out.assign(2 + wordsFor(static_cast<uint64_t>(count) * width) + 1, 0);
+    out[0] = count;
+    out[1] = width;
+    for (size_t i = 0; i < count; i++)
+        putBits(out.data() + 2, static_cast<uint64_t>(i) * width, width, values[i]);
+}
+
+bool PackedArray::attach(const uint64_t* words, size_t wordCount) {
+    *this = PackedArray();
+    if (wordCount < 2) return false;
+    const uint64_t count = words[0];
+    const uint64_t width = words[1];
+    if (width > 64 || count > (1ULL << 40)) return false;
+    const size_t total = 2 + wordsFor(count * width) + 1;
+    if (total > wordCount) return false;
+
+    count_ = static_cast<size_t>(count);
+    width_ = static_cast<unsigned>(width);
+    words_ = total;
+    bits_ = words + 2;
+    return true;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file Succinct.h
+ * @brief Compressed integer sequences that are read in place: Elias-Fano
+ *        for sorted values, fixed-width bit packing for the rest.
+ * @date October 2026
+ *
+ * Both are encoded into a block of u64 words once and then used through a
+ * read-only view of those words, so they work straight out of a mapped
+ * file (see IndexSegment.h) without being copied or parsed.
+ *
+ * Elias-Fano stores n sorted values below U in about n * (2 + log2(U/n))
+ * bits. Each value is split into its low L = log2(U/n) bits, packed side
+ * by side, and its high part, written in unary into a bit vector: the
+ * value at position i sets bit (high part + i). Reading value i means
+ * finding the i-th one bit (select1). The first value >= x is found from
+ * the (x >> L)-th zero bit (select0), followed by a scan over the few
+ * values that share x's high part. Every 256th one and every 256th zero
+ * is sampled, so select only has to scan from the nearest sample. A
+ * Cursor walks the values in order, one bit scan per value.
+ *
+ * Encoded Elias-Fano block (u64 words):
+ *   n | L | high bit count | low bits | high bits | one samples | zero samples
+ * Encoded packed block (u64 words):
+ *   n | width | values, width bits each | one spare word
+ */
+#ifndef SUCCINCT_H
+#define SUCCINCT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class EliasFano
+ * @brief Read-only view of an Elias-Fano encoded sorted sequence.
+ */
+class EliasFano {
+public:
+    /// Ones (and zeros) between select samples
+    static const size_t kSampleStep = 256;
+
+    EliasFano();
+
+    /**
+     * @brief Encodes non-decreasing values.
+     * @param values The values
+     * @param count Their number
+     * @param out Receives the encoded words
+     */
+    static void encode(const uint64_t* values, size_t count, std::vector<uint64_t>& out);
+
+    /**
+     * @brief Uses encoded words (which must stay valid while in use).
+     * @param words Encoded block
+     * @param wordCount Words available
+     * @return false if the block is damaged or longer than wordCount
+     */
+    bool attach(const uint64_t* words, size_t wordCount);
+
+    size_t size() const { return count_; }
+
+    /// Words used by the encoded block
+    size_t wordCount() const { return words_; }
+
+    /// Value at position i (i < size())
+    uint64_t access(size_t i) const {
+        return ((select1(i) - i) << lowBits_) | low(i);
+    }
+
+    /// Position of the first value >= x (size() if there is none)
+    size_t lowerBound(uint64_t x) const;
+
+    /**
+     * @class Cursor
+     * @brief Walks the values in order.
+     */
+    class Cursor {
+    public:
+        bool valid() const { return i_ < ef_->count_; }
+        size_t index() const { return i_; }
+        uint64_t value() const { return ((pos_ - i_) << ef_->lowBits_) | ef_->low(i_); }
+        void next();
+
+    private:
+        friend class EliasFano;
+        Cursor(const EliasFano* ef, size_t i, uint64_t pos) : ef_(ef), i_(i), pos_(pos) {}
+
+        const EliasFano* ef_;
+        size_t i_;
+        uint64_t pos_;   ///< position of the i-th one in the high bits
+    };
+
+    /// Cursor at position i
+    Cursor at(size_t i) const;
+
+private:
+    size_t count_;
+    unsigned lowBits_;
+    uint64_t highBitCount_;
+    size_t words_;
+    const uint64_t* low_;
+    const uint64_t* high_;
+    const uint64_t* ones_;    ///< position of every kSampleStep-th one
+    const uint64_t* zeros_;   ///< position of every kSampleStep-th zero
+
+    uint64_t low(size_t i) const {
+        if (lowBits_ == 0) return 0;
+        const uint64_t bit = static_cast<uint64_t>(i) * lowBits_;
+        const size_t w = static_cast<size_t>(bit >> 6);
+        const unsigned shift = static_cast<unsigned>(bit & 63);
+        uint64_t v = low_[w] >> shift;
+        if (shift + lowBits_ > 64) v |= low_[w + 1] << (64 - shift);
+        return v & ((1ULL << lowBits_) - 1);
+    }
+
+    uint64_t select1(size_t i) const;
+    uint64_t select0(size_t i) const;
+};
+
+/**
+ * @class PackedArray
+ * @brief Read-only view of unsigned values packed at a fixed bit width.
+ */
+class PackedArray {
+public:
+    PackedArray();
+
+    /**
+     * @brief Packs values at the width of the largest one.
+     * @param values The values
+     * @param count Their number
+     * @param out Receives the encoded words
+     */
+    static void encode(const uint64_t* values, size_t count, std::vector<uint64_t>& out);
+
+    /// Uses encoded words; false if damaged or longer than wordCount
+    bool attach(const uint64_t* words, size_t wordCount);
+
+    size_t size() const { return count_; }
+    unsigned width() const { return width_; }
+    size_t wordCount() const { return words_; }
+
+    /// Value at position i (i < size())
+    uint64_t get(size_t i) const {
+        if (width_ == 0) return 0;
+        const uint64_t bit = static_cast<uint64_t>(i) * width_;
+        const size_t w = static_cast<size_t>(bit >> 6);
+        const unsigned shift = static_cast<unsigned>(bit & 63);
+        uint64_t v = bits_[w] >> shift;
+        if (shift + width_ > 64) v |= bits_[w + 1] << (64 - shift);
+        return width_ == 64 ? v : v & ((1ULL << width_) - 1);
+    }
+
+private:
+    size_t count_;
+    unsigned width_;
+    size_t words_;
+    const uint64_t* bits_;
+};
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ * @file WarmupProfile.cpp
+ * @brief Implementation of the WarmupProfile class.
+ * @date October 2026
+ */
+#include "WarmupProfile.h"
+#include "AtomicFile.h"
+#include "HeaderBuffer.h"
+#include "ZipDataStore.h"
+
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+WarmupProfile::WarmupProfile() : generation_(0), dataBytes_(0), blocks_(0) {}
+
+void WarmupProfile::reset(unsigned long long generation, long long dataBytes) {
+    generation_ = generation;
+    dataBytes_ = dataBytes;
+    blocks_ = (static_cast<uint64_t>(dataBytes) + (1ULL << kBlockShift) - 1) >> kBlockShift;
+    bits_.assign((blocks_ + 63) / 64, 0);
+}
+
+size_t WarmupProfile::hotBlocks() const {
+    size_t n = 0;
+    for (uint64_t w : bits_) n += static_cast<size_t>(__builtin_popcountll(w));
+    return n;
+}
+
+bool WarmupProfile::save(const string& path) const {
+    string tmp = tempPathFor(path);
+    {
+        ofstream out(tmp);
+        if (!out) return false;
+        out << "WARM,1," << HeaderBuffer::generationText(generation_) << ","
+            << (1u << kBlockShift) << "," << dataBytes_ << "\n";
+
+        // Runs of hot blocks, so a hot region costs one line.
+        for (uint64_t b = 0; b < blocks_; ) {
+            if (!hot(b)) {
+                b++;
+                continue;
+            }
+            uint64_t first = b;
+            while (b < blocks_ && hot(b)) b++;
+            out << first << " " << (b - first) << "\n";
+        }
+        if (!out) {
+            out.close();
+            discardTemp(tmp);
+            return false;
+        }
+    }
+    if (!publishFile(tmp, path)) {
+        discardTemp(tmp);
+        return false;
+    }
+    return true;
+}
+
+bool WarmupProfile::load(const string& path, unsigned long long generation) {
+    ifstream in(path);
+    if (!in) return false;
+
+    string head;
+    getline(in, head);
+    vector<string> f;
+    string tok;
+    istringstream ss(head);
+    while (getline(ss, tok, ',')) f.push_back(tok);
+    if (f.size() != 5 || f[0] != "WARM" || f[1] != "1" ||
+        HeaderBuffer::parseGeneration(f[2]) != generation ||
+        f[3] != to_string(1u << kBlockShift))
+        return false;
+
+    try {
+        reset(generation, stoll(f[4]));
+    } catch (const exception&) {
+        return false;
+    }
+    uint64_t first, count;
+    while (in >> first >> count) {
+        for (uint64_t b = first; b < first + count && b < blocks_; b++)
+            bits_[b >> 6] |= (1ULL << (b & 63));
+    }
+    return true;
+}
+
+long long WarmupProfile::prefetch(const ZipDataStore& store) const {
+    const long long blockBytes = 1LL << kBlockShift;
+    long long requested = 0;
+    for (uint64_t b = 0; b < blocks_; ) {
+        if (!hot(b)) {
+            b++;
+            continue;
+        }
+        uint64_t first = b;
+        while (b < blocks_ && hot(b)) b++;
+        long long offset = static_cast<long long>(first) * blockBytes;
+        long long length = static_cast<long long>(b - first) * blockBytes;
+        store.prefetchData(offset, length);
+        requested += length;
+    }
+    return requested;
+}
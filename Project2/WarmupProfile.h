@@ -0,0 +1,99 @@
+/**
+ * @file WarmupProfile.h
+ * @brief Remembers which parts of the data file were hot, so the next
+ *        start can read them in before the first request.
+ * @date October 2026
+ *
+ * After a reboot the page cache is empty and the first lookups each wait
+ * for the disk. While --serve runs it notes every 64 KB block of the data
+ * file it reads a record from. On a clean stop the blocks are saved, with
+ * those of earlier runs, to a small profile next to the data file
+ * ("<data>.len.warm"); a new data file generation starts it over. On the next
+ * start (or with --warmup, e.g. from a boot script) the saved blocks are
+ * handed to the kernel with posix_fadvise(WILLNEED), which reads them in
+ * the background while the server starts accepting connections.
+ *
+ * The index side needs no profile: an .idx is parsed into RAM at start,
+ * and a shared segment is read in whole (see ZipDataStore::warmIndex()),
+ * because every binary search passes through pages all over the key array,
+ * not only the page it ends on.
+ *
+ * Profile file (text):
+ *   WARM,1,<generation>,<block bytes>,<data file bytes>
+ *   <first block> <block count>        one line per run of hot blocks
+ *
+ * A profile is only used with the data file generation it was made for.
+ */
+#ifndef WARMUPPROFILE_H
+#define WARMUPPROFILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ZipDataStore;
+
+/**
+ * @class WarmupProfile
+ * @brief Bitmap of hot data blocks, saved and replayed across restarts.
+ */
+class WarmupProfile {
+public:
+    /// log2 of the block size (64 KB)
+    static const unsigned kBlockShift = 16;
+
+    WarmupProfile();
+
+    /**
+     * @brief Empties the profile for a data file.
+     * @param generation Data file generation
+     * @param dataBytes Data file size
+     */
+    void reset(unsigned long long generation, long long dataBytes);
+
+    /// Marks the block holding offset as hot
+    void noteRead(long long offset) {
+        uint64_t block = static_cast<uint64_t>(offset) >> kBlockShift;
+        if (block < blocks_) bits_[block >> 6] |= (1ULL << (block & 63));
+    }
+
+    /// Number of hot blocks
+    size_t hotBlocks() const;
+
+    /**
+     * @brief Writes the profile (temp file + rename).
+     * @return false on error
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief Reads a profile made for the given generation.
+     * @return false if missing, malformed or for another generation
+     */
+    bool load(const std::string& path, unsigned long long generation);
+
+    /**
+     * @brief Asks the kernel to read every hot block of the store's data file.
+     * @return bytes requested
+     */
+    long long prefetch(const ZipDataStore& store) const;
+
+    unsigned long long generation() const { return generation_; }
+
+    /// The usual profile name for a data file
+    static std::string pathFor(const std::string& lenFile) {
+        return lenFile + ".warm";
+    }
+
+private:
+    unsigned long long generation_;
+    long long dataBytes_;
+    uint64_t blocks_;
+    std::vector<uint64_t> bits_;
+
+    bool hot(uint64_t block) const {
+        return (bits_[block >> 6] >> (block & 63)) & 1;
+    }
+};
+
+#endif
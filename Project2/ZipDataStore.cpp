@@ -0,0 +1,621 @@
+/**
+ * @file ZipDataStore.cpp
+ * @brief Implementation of the ZipDataStore class (index + WAL updates).
+ * @date October 2026
+ */
+#include "ZipDataStore.h"
+#include "AtomicFile.h"
+#include "LenFileWriter.h"
+#include "Crc32c.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * @brief Splits text on commas (no quoting; used for our own metadata).
+ */
+static vector<string> splitCommas(const string& text) {
+    vector<string> parts;
+    string tok;
+    istringstream ss(text);
+    while (getline(ss, tok, ',')) parts.push_back(tok);
+    return parts;
+}
+
+/**
+ * @brief Parses a count from our own metadata without throwing.
+ * @return false unless text is one whole non-negative number
+ */
+static bool parseCount(const string& text, long long& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    value = strtoll(text.c_str(), &end, 10);
+    return *end == '\0' && errno == 0 && value >= 0;
+}
+
+/**
+ * @brief Builds the bytes of one length-indicated record in memory.
+ */
+static string lenRecordBytes(const string& text, bool withChecksum) {
+    ostringstream os;
+    writeLenRecord(os, text, withChecksum);
+    return os.str();
+}
+
+/**
+ * @brief Writes all bytes at a file offset (retries short writes).
+ */
+static bool pwriteAll(int fd, const string& bytes, long long offset) {
+    size_t done = 0;
+    while (done < bytes.size()) {
+        ssize_t n = pwrite(fd, bytes.data() + done, bytes.size() - done,
+                           static_cast<off_t>(offset + done));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+ZipDataStore::ZipDataStore()
+    : dataFd_(-1), walFd_(-1), lockFd_(-1), forUpdate_(false),
+      syncEachUpdate_(true), generationMismatch_(false), headerParsed_(false),
+      hasChecksum_(false),
+      generation_(0), indexGeneration_(0), parsed_(nullptr), dataEnd_(0), lastSeq_(0),
+      deadRecords_(0), deadBytes_(0), walReplayed_(0), walPending_(0) {}
+
+ZipDataStore::~ZipDataStore() {
+    close();
+}
+
+bool ZipDataStore::fail(const string& message) {
+    error_ = message;
+    return false;
+}
+
+void ZipDataStore::close() {
+    if (dataFd_ >= 0) ::close(dataFd_);
+    if (walFd_ >= 0) ::close(walFd_);
+    if (lockFd_ >= 0) ::close(lockFd_);   // also releases the flock
+    dataFd_ = walFd_ = lockFd_ = -1;
+    index_.clear();
+    tombstones_.clear();
+    bloom_ = BloomFilter();
+    segment_.detach();
+    forUpdate_ = false;
+    headerParsed_ = false;
+    hasChecksum_ = false;
+    generation_ = indexGeneration_ = 0;
+    dataEnd_ = lastSeq_ = deadRecords_ = deadBytes_ = 0;
+    walReplayed_ = walPending_ = 0;
+}
+
+bool ZipDataStore::open(const string& lenFile, const string& idxFile,
+                        bool forUpdate, const ParsedIndex* parsed) {
+    // An index newer than the data file means a compaction swapped the
+    // pair after the data file was opened here; opening again gets the new
+    // data file and its index (see loadIndex()).
+    parsed_ = parsed;
+    bool ok = false;
+    for (int attempt = 0; ; attempt++) {
+        generationMismatch_ = false;
+        ok = openOnce(lenFile, idxFile, forUpdate);
+        if (ok || !generationMismatch_ || attempt == 1) break;
+    }
+    parsed_ = nullptr;
+    return ok;
+}
+
+bool ZipDataStore::openOnce(const string& lenFile, const string& idxFile,
+                            bool forUpdate) {
+    close();
+    lenFile_ = lenFile;
+    idxFile_ = idxFile;
+    walFile_ = lenFile + ".wal";
+    forUpdate_ = forUpdate;
+
+    // Only one updater (or compaction) at a time.
+    if (forUpdate) {
+        lockFd_ = ::open((lenFile + ".lock").c_str(), O_RDWR | O_CREAT, 0644);
+        if (lockFd_ < 0 || flock(lockFd_, LOCK_EX) != 0)
+            return fail("Cannot lock " + lenFile + ".lock");
+    }
+
+    dataFd_ = ::open(lenFile.c_str(), forUpdate ? O_RDWR : O_RDONLY);
+    if (dataFd_ < 0) return fail("Cannot open LEN data file: " + lenFile);
+
+    struct stat st;
+    if (fstat(dataFd_, &st) != 0) return fail("Cannot stat " + lenFile);
+    dataEnd_ = static_cast<long long>(st.st_size);
+
+    // Header record (never has a checksum).
+    LenRecordView hv;
+    if (frameAt(0, hv, &headerText_) != LenStatus::Ok)
+        return fail("LEN data file header missing or corrupted.");
+    headerParsed_ = hbuf_.parse(headerText_);
+    hasChecksum_ = headerParsed_ && hbuf_.hasChecksum();
+    generation_ = headerParsed_ ? hbuf_.getHeader().generation : 0;
+
+    if (!forUpdate && IndexSegment::isSegmentFile(idxFile)) {
+        if (!attachSegment()) return false;
+    } else if (!loadIndex()) {
+        return false;
+    }
+    if (!replayWal()) return false;
+
+    if (forUpdate) {
+        // Drop bytes appended by an update whose WAL entry never made it.
+        if (static_cast<long long>(st.st_size) > dataEnd_ &&
+            ftruncate(dataFd_, static_cast<off_t>(dataEnd_)) != 0)
+            return fail("Cannot truncate uncommitted data in " + lenFile);
+        if (walFd_ < 0 && !startNewWal()) return false;
+    }
+    return true;
+}
+
+/// Generation in the first line of an .idx file (0 if none)
+static unsigned long long indexFileGeneration(const string& path) {
+    ifstream in(path);
+    string firstLine;
+    if (!in || !getline(in, firstLine)) return 0;
+    vector<string> parts = splitCommas(firstLine);
+    if (parts.size() >= 3 && parts[0] == "IDX" && parts[1] == "2")
+        return HeaderBuffer::parseGeneration(parts[2]);
+    return 0;
+}
+
+string ZipDataStore::indexPathFor(const string& idxFile, unsigned long long generation) {
+    // A compaction publishes the new index under the pending name, then
+    // the data file, then renames the index into place. If the data file
+    // is already the new one, so is the pending index: roll forward to it.
+    const string pending = pendingPathFor(idxFile);
+    if (generation != 0 && access(pending.c_str(), F_OK) == 0 &&
+        indexFileGeneration(pending) == generation &&
+        indexFileGeneration(idxFile) != generation)
+        return pending;
+    return idxFile;
+}
+
+bool ZipDataStore::loadIndex() {
+    // An updater holds the lock the compaction swaps under, so a pending
+    // index here is from a compaction that stopped halfway: finish it.
+    string path = indexPathFor(idxFile_, generation_);
+    const string bloomPath = BloomFilter::pathFor(idxFile_);
+    if (path != idxFile_ && forUpdate_) {
+        const string eyt = IndexSegment::eytzingerPathFor(idxFile_);
+        IndexSegment next;
+        if (next.attach(pendingPathFor(eyt)) && next.generation() == generation_)
+            publishFile(pendingPathFor(eyt), eyt);
+        BloomFilter nextBloom;
+        if (nextBloom.load(pendingPathFor(bloomPath), generation_))
+            publishFile(pendingPathFor(bloomPath), bloomPath);
+        if (publishFile(path, idxFile_)) path = idxFile_;
+    }
+
+    // The caller's copy of this very file saves parsing it again.
+    const bool reuse = parsed_ != nullptr && parsed_->path == path;
+    ifstream in;
+    string firstLine;
+    if (reuse) {
+        firstLine = parsed_->firstLine;
+    } else {
+        in.open(path);
+        if (!in) return fail("Index file could not be read: " + idxFile_);
+        getline(in, firstLine);
+    }
+
+    // IDX,1  or  IDX,2,<generation>[,<dead records>,<dead bytes>,<last seq>]
+    vector<string> parts = splitCommas(firstLine);
+    if (parts.size() >= 3 && parts[0] == "IDX" && parts[1] == "2")
+        indexGeneration_ = HeaderBuffer::parseGeneration(parts[2]);
+    if (parts.size() >= 6 &&
+        (!parseCount(parts[3], deadRecords_) || !parseCount(parts[4], deadBytes_) ||
+         !parseCount(parts[5], lastSeq_)))
+        return fail("Index header of " + path + " is damaged: " + firstLine);
+
+    // O(1) check that this index was built from this exact data file.
+    if (generation_ != 0 && indexGeneration_ != 0 &&
+        indexGeneration_ != generation_) {
+        generationMismatch_ = true;
+        return fail("index generation " + HeaderBuffer::generationText(indexGeneration_)
+                    + " does not match data file generation "
+                    + HeaderBuffer::generationText(generation_)
+                    + ". Rebuild the index with --build-index.");
+    }
+
+    if (reuse) {
+        index_.reserve(parsed_->entries.size());
+        for (const auto& e : parsed_->entries) index_[e.first] = e.second;
+    } else {
+        string zip;
+        long long pos;
+        while (in >> zip >> pos) {
+            index_[zip] = pos;
+        }
+    }
+    if (index_.empty()) return fail("Index file is empty: " + idxFile_);
+
+    // Optional; a missing or old filter just means no early rejection.
+    // Between a compaction's commit and its last rename the filter for
+    // this generation may still be under the pending name.
+    if (!bloom_.load(bloomPath, generation_))
+        bloom_.load(pendingPathFor(bloomPath), generation_);
+    return true;
+}
+
+bool ZipDataStore::attachSegment() {
+    if (!segment_.attach(idxFile_)) return fail(segment_.lastError());
+
+    // As in loadIndex(): the segment of a compaction whose data file is
+    // already in place may still be under the pending name.
+    const string pending = pendingPathFor(idxFile_);
+    if (generation_ != 0 && segment_.generation() != generation_ &&
+        access(pending.c_str(), F_OK) == 0) {
+        IndexSegment next;
+        if (next.attach(pending) && next.generation() == generation_ &&
+            !segment_.attach(pending))
+            return fail(segment_.lastError());
+    }
+
+    indexGeneration_ = segment_.generation();
+    if (generation_ != 0 && indexGeneration_ != generation_) {
+        generationMismatch_ = true;
+        return fail("index segment generation " + HeaderBuffer::generationText(indexGeneration_)
+                    + " does not match data file generation "
+                    + HeaderBuffer::generationText(generation_)
+                    + ". Publish the segment again (--publish-segment, or"
+                    " --build-index for an .eyt segment).");
+    }
+    // WAL entries up to here are already in the segment.
+    lastSeq_ = segment_.lastSeq();
+    return true;
+}
+
+bool ZipDataStore::replayWal() {
+    ifstream wal(walFile_, ios::binary);
+    if (!wal) return true;   // no WAL yet: nothing to replay
+
+    // A WAL from another generation belongs to an older data file.
+    string text;
+    if (readLenRecordChecked(wal, text, true) != LenStatus::Ok) return true;
+    vector<string> head = splitCommas(text);
+    if ((head.size() != 4 && head.size() != 5) || head[0] != "WAL" ||
+        HeaderBuffer::parseGeneration(head[2]) != generation_)
+        return true;
+
+    // Entries up to the base went into the .idx at the checkpoint that
+    // started this WAL. A segment published before that misses them, and
+    // replaying the rest on top of it would serve the old records.
+    const long long baseSeq = (head.size() == 5) ? stoll(head[4]) : 0;
+    if (segment_.attached() && segment_.lastSeq() < baseSeq)
+        return fail("index segment holds WAL entries up to " + to_string(segment_.lastSeq())
+                    + ", but a checkpoint has since folded entries up to "
+                    + to_string(baseSeq) + " into the index."
+                    " Publish the segment again (--publish-segment, or"
+                    " --build-index for an .eyt segment).");
+
+    // Data written after the WAL started counts only once a WAL entry
+    // refers to it.
+    dataEnd_ = min(dataEnd_, stoll(head[3]));
+    streampos validTail = wal.tellg();
+
+    while (true) {
+        LenStatus st = readLenRecordChecked(wal, text, true);
+        if (st != LenStatus::Ok) break;   // end of WAL, or a torn last entry
+
+        // D,<seq>,<zip>,<old offset>,<old bytes>  (tombstone)
+        vector<string> f = splitCommas(text);
+        if (f.size() == 5 && f[0] == "D") {
+            long long seq = stoll(f[1]);
+            validTail = wal.tellg();
+            walPending_++;
+            if (seq <= lastSeq_) continue;
+            index_.erase(f[2]);
+            tombstones_.insert(f[2]);
+            deadRecords_++;
+            deadBytes_ += stoll(f[4]);
+            lastSeq_ = seq;
+            walReplayed_++;
+            continue;
+        }
+
+        // U,<seq>,<zip>,<new offset>,<old offset>,<old bytes>
+        if (f.size() != 6 || f[0] != "U") break;
+        long long seq = stoll(f[1]);
+        long long newOffset = stoll(f[3]);
+
+        LenRecordView v;
+        string record;
+        if (frameAt(newOffset, v, &record) != LenStatus::Ok ||
+            record.compare(0, f[2].size() + 1, f[2] + ",") != 0)
+            break;   // record missing: treat like a torn entry
+
+        dataEnd_ = max(dataEnd_, static_cast<long long>(v.next));
+        validTail = wal.tellg();
+        walPending_++;
+
+        if (seq <= lastSeq_) continue;   // already in the index (checkpoint)
+        index_[f[2]] = newOffset;
+        tombstones_.erase(f[2]);
+        deadRecords_++;
+        deadBytes_ += stoll(f[5]);
+        lastSeq_ = seq;
+        walReplayed_++;
+    }
+
+    if (forUpdate_) {
+        wal.close();
+        if (truncate(walFile_.c_str(), static_cast<off_t>(validTail)) != 0)
+            return fail("Cannot truncate torn WAL tail: " + walFile_);
+        walFd_ = ::open(walFile_.c_str(), O_WRONLY | O_APPEND);
+        if (walFd_ < 0) return fail("Cannot open WAL: " + walFile_);
+    }
+    return true;
+}
+
+bool ZipDataStore::startNewWal() {
+    if (walFd_ >= 0) ::close(walFd_);
+    walFd_ = -1;
+
+    string tmp = tempPathFor(walFile_);
+    {
+        ofstream out(tmp, ios::binary);
+        string head = "WAL,1," + HeaderBuffer::generationText(generation_)
+                    + "," + to_string(dataEnd_) + "," + to_string(lastSeq_);
+        if (!out || !writeLenRecord(out, head, true))
+            return fail("Cannot create WAL: " + tmp);
+    }
+    if (!publishFile(tmp, walFile_)) {
+        discardTemp(tmp);
+        return fail("Cannot publish WAL: " + walFile_);
+    }
+
+    walFd_ = ::open(walFile_.c_str(), O_WRONLY | O_APPEND);
+    if (walFd_ < 0) return fail("Cannot open WAL: " + walFile_);
+    walPending_ = 0;
+    return true;
+}
+
+LenStatus ZipDataStore::frameAt(long long offset, LenRecordView& view,
+                                string* recordText) const {
+    if (offset < 0) return LenStatus::EndOfFile;
+
+    // One read normally covers the whole record; a second one is needed
+    // only for records longer than the first read.
+    string buf(512, '\0');
+    ssize_t got = pread(dataFd_, &buf[0], buf.size(), static_cast<off_t>(offset));
+    if (got <= 0) return LenStatus::EndOfFile;
+    buf.resize(static_cast<size_t>(got));
+
+    LenStatus st = frameLenRecord(buf.data(), buf.size(), 0, hasChecksum_ && offset > 0, view);
+    if (st == LenStatus::Truncated && buf.size() == 512) {
+        size_t need = 11 + view.textLength + 9 + 2;
+        buf.assign(need, '\0');
+        got = pread(dataFd_, &buf[0], need, static_cast<off_t>(offset));
+        if (got <= 0) return LenStatus::Truncated;
+        buf.resize(static_cast<size_t>(got));
+        st = frameLenRecord(buf.data(), buf.size(), 0, hasChecksum_ && offset > 0, view);
+    }
+    if (st != LenStatus::Ok) return st;
+
+    if (hasChecksum_ && offset > 0) {
+        if (!view.crcReadable ||
+            crc32c(buf.data() + view.textOffset, view.textLength) != view.storedCrc)
+            return LenStatus::BadChecksum;
+    }
+    if (recordText) recordText->assign(buf, view.textOffset, view.textLength);
+
+    view.start += offset;
+    view.textOffset += offset;
+    view.next += offset;
+    return LenStatus::Ok;
+}
+
+bool ZipDataStore::find(const string& zip, long long& offset) const {
+    // Cheapest answers first: the filter, then recent deletes.
+    if (!bloom_.mayContain(zip)) return false;
+    if (!tombstones_.empty() && tombstones_.count(zip)) return false;
+
+    auto it = index_.find(zip);
+    if (it != index_.end()) {
+        offset = it->second;
+        return true;
+    }
+    // With a segment, index_ only holds the changes made after it.
+    return segment_.attached() && segment_.find(zip, offset);
+}
+
+void ZipDataStore::findBatch(const vector<string>& zips, vector<long long>& offsets) const {
+    offsets.assign(zips.size(), -1);
+    if (!segment_.attached()) {
+        for (size_t i = 0; i < zips.size(); i++) find(zips[i], offsets[i]);
+        return;
+    }
+
+    // Filter, deletes and post-segment changes first, as in find(); the
+    // rest go to the segment together.
+    vector<string> pending;
+    vector<size_t> which;
+    for (size_t i = 0; i < zips.size(); i++) {
+        const string& zip = zips[i];
+        if (!bloom_.mayContain(zip)) continue;
+        if (!tombstones_.empty() && tombstones_.count(zip)) continue;
+        auto it = index_.find(zip);
+        if (it != index_.end()) {
+            offsets[i] = it->second;
+            continue;
+        }
+        pending.push_back(zip);
+        which.push_back(i);
+    }
+    vector<long long> found;
+    segment_.findBatch(pending, found);
+    for (size_t j = 0; j < pending.size(); j++) offsets[which[j]] = found[j];
+}
+
+LenStatus ZipDataStore::readRecordAt(long long offset, string& recordText) const {
+    LenRecordView v;
+    return frameAt(offset, v, &recordText);
+}
+
+void ZipDataStore::prefetchData(long long offset, long long length) const {
+    if (dataFd_ >= 0 && length > 0)
+        posix_fadvise(dataFd_, static_cast<off_t>(offset), static_cast<off_t>(length),
+                      POSIX_FADV_WILLNEED);
+}
+
+bool ZipDataStore::warmIndex(bool lock) {
+    if (segment_.attached()) {
+        segment_.prefetch();
+        if (lock && !segment_.lock())
+            return fail(string("Cannot lock index segment in RAM: ") + strerror(errno)
+                        + " (see ulimit -l)");
+        return true;
+    }
+    if (lock && mlockall(MCL_CURRENT) != 0)
+        return fail(string("Cannot lock index in RAM: ") + strerror(errno)
+                    + " (see ulimit -l)");
+    return true;
+}
+
+bool ZipDataStore::update(const string& recordText) {
+    if (!forUpdate_) return fail("Store was not opened for update.");
+
+    size_t comma = recordText.find(',');
+    if (comma == string::npos || comma == 0)
+        return fail("Record has no ZIP field: " + recordText);
+    string zip = recordText.substr(0, comma);
+
+    auto it = index_.find(zip);
+    if (it == index_.end())
+        return fail("ZIP " + zip + " is not in the index; only existing ZIPs can be updated.");
+
+    LenRecordView old;
+    if (frameAt(it->second, old, nullptr) != LenStatus::Ok)
+        return fail("Current record for ZIP " + zip + " cannot be read.");
+    long long oldBytes = static_cast<long long>(old.next - old.start);
+
+    // 1) New record version at the end of the data file.
+    string bytes = lenRecordBytes(recordText, hasChecksum_);
+    long long newOffset = dataEnd_;
+    if (!pwriteAll(dataFd_, bytes, newOffset))
+        return fail(string("Cannot append to data file: ") + strerror(errno));
+    if (syncEachUpdate_ && fdatasync(dataFd_) != 0)
+        return fail(string("Cannot sync data file: ") + strerror(errno));
+
+    // 2) WAL entry: this is the commit point.
+    long long seq = lastSeq_ + 1;
+    if (!appendWal("U," + to_string(seq) + "," + zip + "," + to_string(newOffset)
+                   + "," + to_string(it->second) + "," + to_string(oldBytes)))
+        return false;
+
+    // 3) In-memory index and dead space bookkeeping.
+    it->second = newOffset;
+    dataEnd_ = newOffset + static_cast<long long>(bytes.size());
+    lastSeq_ = seq;
+    deadRecords_++;
+    deadBytes_ += oldBytes;
+    walPending_++;
+    return true;
+}
+
+bool ZipDataStore::remove(const string& zip) {
+    if (!forUpdate_) return fail("Store was not opened for update.");
+
+    auto it = index_.find(zip);
+    if (it == index_.end()) return fail("ZIP " + zip + " not found in file");
+
+    LenRecordView old;
+    if (frameAt(it->second, old, nullptr) != LenStatus::Ok)
+        return fail("Current record for ZIP " + zip + " cannot be read.");
+    long long oldBytes = static_cast<long long>(old.next - old.start);
+
+    long long seq = lastSeq_ + 1;
+    if (!appendWal("D," + to_string(seq) + "," + zip + ","
+                   + to_string(it->second) + "," + to_string(oldBytes)))
+        return false;
+
+    index_.erase(it);
+    tombstones_.insert(zip);
+    lastSeq_ = seq;
+    deadRecords_++;
+    deadBytes_ += oldBytes;
+    walPending_++;
+    return true;
+}
+
+bool ZipDataStore::appendWal(const string& entry) {
+    string walBytes = lenRecordBytes(entry, true);
+    if (write(walFd_, walBytes.data(), walBytes.size()) !=
+        static_cast<ssize_t>(walBytes.size()))
+        return fail(string("Cannot append to WAL: ") + strerror(errno));
+    if (syncEachUpdate_ && fdatasync(walFd_) != 0)
+        return fail(string("Cannot sync WAL: ") + strerror(errno));
+    return true;
+}
+
+bool ZipDataStore::checkpoint() {
+    if (!forUpdate_) return fail("Store was not opened for update.");
+
+    // Same order as the data file, like --build-index writes it.
+    vector<pair<long long, const string*>> entries;
+    entries.reserve(index_.size());
+    for (const auto& e : index_) entries.push_back({e.second, &e.first});
+    sort(entries.begin(), entries.end());
+
+    string tmp = tempPathFor(idxFile_);
+    {
+        ofstream out(tmp);
+        if (!out) return fail("Cannot create index file: " + tmp);
+        out << "IDX,2," << HeaderBuffer::generationText(generation_) << ","
+            << deadRecords_ << "," << deadBytes_ << "," << lastSeq_ << "\n";
+        for (const auto& e : entries) out << *e.second << " " << e.first << "\n";
+        if (!out) {
+            out.close();
+            discardTemp(tmp);
+            return fail("Cannot write index file: " + tmp);
+        }
+    }
+    if (!publishFile(tmp, idxFile_)) {
+        discardTemp(tmp);
+        return fail("Cannot publish index file: " + idxFile_);
+    }
+
+    // Filter over exactly the live keys; deleted ZIPs drop out of it here.
+    bloom_.reset(index_.size());
+    for (const auto& e : index_) bloom_.add(e.first);
+    if (!bloom_.save(BloomFilter::pathFor(idxFile_), generation_))
+        return fail("Cannot write Bloom filter: " + BloomFilter::pathFor(idxFile_));
+    tombstones_.clear();
+
+    // An Eytzinger segment of the old index would miss what the WAL held.
+    const string eyt = IndexSegment::eytzingerPathFor(idxFile_);
+    unsigned long long version = 0;
+    string error;
+    if (access(eyt.c_str(), F_OK) == 0 &&
+        !IndexSegment::publish(index_, generation_, lastSeq_, eyt, version, error,
+                               IndexSegment::kEytzinger)) {
+        ::unlink(eyt.c_str());
+        return fail(error + " (removed " + eyt + ")");
+    }
+
+    // The index now holds everything up to lastSeq_; start an empty WAL.
+    return startNewWal();
+}
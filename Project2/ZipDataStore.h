@@ -0,0 +1,267 @@
+/**
+ * @file ZipDataStore.h
+ * @brief A .len data file plus its index, with online updates through a
+ *        write-ahead log (WAL).
+ * @date October 2026
+ *
+ * Files used (for data file "zipcode_data.len"):
+ * - zipcode_data.len      data records (new versions are appended)
+ * - zipcode_index.idx     ZIP -> offset index, rewritten at checkpoint
+ * - zipcode_data.len.wal  log of index changes since the last checkpoint
+ * - zipcode_data.len.lock lock file; only one updater at a time
+ *
+ * How an update works (no rewrite of the data file or index):
+ * 1) The new version of the record is appended to the end of the .len file.
+ * 2) One WAL entry is appended: "U,<seq>,<zip>,<new offset>,<old offset>,
+ *    <old record bytes>". It is a length-indicated record with a CRC32C,
+ *    so a half-written entry is detected.
+ * 3) The in-memory index now points the ZIP at the new offset. The old
+ *    record becomes dead space, counted for a later compaction.
+ *
+ * A delete only writes a WAL entry, "D,<seq>,<zip>,<old offset>,<old record
+ * bytes>". This is the tombstone. The ZIP leaves the in-memory index and is
+ * kept in a small tombstone set, so later lookups answer "not found"
+ * without reading the data file. The record becomes dead space.
+ *
+ * Lookups ask the Bloom filter (see BloomFilter.h) first, then the
+ * tombstone set, and only then the index.
+ *
+ * The WAL entry is the commit point. On open the WAL is replayed on top of
+ * the index. A torn WAL tail is ignored, and when opened for update, any
+ * data appended after the last committed record is cut off.
+ *
+ * checkpoint() writes the index with all WAL changes applied (crash-safe,
+ * see AtomicFile.h), rebuilds the Bloom filter over the live keys (and the
+ * "<index>.eyt" segment, if there is one) and starts a new, empty WAL. The index header keeps the
+ * last applied WAL sequence number, so replaying an old WAL after a crash
+ * in the middle of a checkpoint is harmless.
+ *
+ * A read-only open may be given a shared index segment (see IndexSegment.h)
+ * in place of the .idx. The segment is mapped instead of parsing the index,
+ * and WAL entries newer than the segment are replayed on top of it. The
+ * Eytzinger segment --build-index writes next to the index ("<index>.eyt")
+ * is used the same way. The WAL head records the sequence number the
+ * index held when the WAL started; a segment older than that (published
+ * before the last checkpoint) is rejected, since the entries it lacks are
+ * no longer in the WAL.
+ *
+ * Index header line: IDX,2,<generation>,<dead records>,<dead bytes>,<last seq>
+ * WAL first entry:   WAL,1,<generation>,<data file size when WAL started>,
+ *                    <last seq in the index then> (older WALs lack it)
+ */
+#ifndef ZIPDATASTORE_H
+#define ZIPDATASTORE_H
+
+#include "HeaderBuffer.h"
+#include "LenFileReader.h"
+#include "BloomFilter.h"
+#include "IndexSegment.h"
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @class ZipDataStore
+ * @brief Opens a data/index pair, answers lookups and applies updates.
+ *
+ * Lookups use pread() and do not change any state, so they may be called
+ * from several threads at once. update() and checkpoint() must only be
+ * called by one thread.
+ */
+class ZipDataStore {
+public:
+    ZipDataStore();
+    ~ZipDataStore();
+
+    ZipDataStore(const ZipDataStore&) = delete;
+    ZipDataStore& operator=(const ZipDataStore&) = delete;
+
+    /**
+     * @brief An .idx file the caller has already read (--verify reads it
+     *        for its own line checks): its first line and its entries in
+     *        file order.
+     */
+    struct ParsedIndex {
+        std::string path;        ///< file the entries were read from
+        std::string firstLine;   ///< "IDX,..." header line
+        std::vector<std::pair<std::string, long long>> entries;
+    };
+
+    /**
+     * @brief Opens the pair, checks generations and replays the WAL.
+     *
+     * A compaction that has published its data file but not yet renamed
+     * its index into place left that index under pendingPathFor(); the
+     * open uses it (and, for update, finishes the rename). If the data
+     * file turns out older than the index, a compaction finished between
+     * the two opens, and the open starts over once (see LenCompactor.h).
+     * @param lenFile Data file (.len)
+     * @param idxFile Index file (.idx), or an index segment when !forUpdate
+     * @param forUpdate true to take the update lock and allow update()
+     * @param parsed The index, if the caller already read it; used instead
+     *        of reading the file again when its path is the one opened
+     * @return false on error (see lastError())
+     */
+    bool open(const std::string& lenFile, const std::string& idxFile,
+              bool forUpdate, const ParsedIndex* parsed = nullptr);
+
+    /// Closes all files and releases the update lock
+    void close();
+
+    /// Where a compaction puts the new index (or segment) until the new
+    /// data file is in place
+    static std::string pendingPathFor(const std::string& idxFile) { return idxFile + ".next"; }
+
+    /**
+     * @brief The index file that goes with a data file of this generation:
+     *        idxFile, or its pending copy when a compaction has renamed the
+     *        data file but not yet the index.
+     */
+    static std::string indexPathFor(const std::string& idxFile, unsigned long long generation);
+
+    /**
+     * @brief Looks up the data file offset of a ZIP.
+     * @param zip ZIP as stored in the data file (no leading zeros)
+     * @param offset Receives the record offset
+     * @return true if the ZIP is in the index (and not deleted)
+     */
+    bool find(const std::string& zip, long long& offset) const;
+
+    /**
+     * @brief Looks up many ZIPs at once; same answers as find().
+     *
+     * With a sorted index segment the segment probes are batched (see
+     * IndexSegment::findBatch()); otherwise this is a loop over find().
+     *
+     * @param zips ZIPs to look up
+     * @param offsets Receives one record offset per ZIP, -1 if not found
+     */
+    void findBatch(const std::vector<std::string>& zips,
+                   std::vector<long long>& offsets) const;
+
+    /// true if the ZIP was deleted since the last checkpoint
+    bool isDeleted(const std::string& zip) const {
+        return tombstones_.count(zip) != 0;
+    }
+
+    /**
+     * @brief Reads the record that starts at offset (checksum checked).
+     * @param offset Record start
+     * @param recordText Receives the record text
+     * @return LenStatus::Ok, or why the record could not be read
+     */
+    LenStatus readRecordAt(long long offset, std::string& recordText) const;
+
+    /**
+     * @brief Stores a new version of a record (its ZIP must exist).
+     * @param recordText Complete CSV record text, ZIP first
+     * @return false on error (see lastError())
+     */
+    bool update(const std::string& recordText);
+
+    /**
+     * @brief Deletes a ZIP by logging a tombstone (the data file is untouched).
+     * @param zip ZIP to delete
+     * @return false on error (see lastError())
+     */
+    bool remove(const std::string& zip);
+
+    /**
+     * @brief Writes the index with all WAL changes and empties the WAL.
+     * @return false on error (see lastError())
+     */
+    bool checkpoint();
+
+    /**
+     * @brief Asks the kernel to read part of the data file into the page
+     *        cache now (posix_fadvise WILLNEED); returns immediately.
+     */
+    void prefetchData(long long offset, long long length) const;
+
+    /**
+     * @brief Makes index lookups independent of the disk.
+     *
+     * A shared segment is read in with MADV_WILLNEED and, with lock,
+     * mlock'ed. An index parsed from an .idx is already in RAM; lock then
+     * pins the whole process's current memory (mlockall(MCL_CURRENT)) so
+     * it cannot be swapped out.
+     * @param lock true to lock the pages in RAM
+     * @return false if the lock was refused (see lastError())
+     */
+    bool warmIndex(bool lock);
+
+    /// Turns fdatasync after every update on (default) or off
+    void setSyncEachUpdate(bool sync) { syncEachUpdate_ = sync; }
+
+    const std::string& lastError() const { return error_; }
+    const std::string& headerText() const { return headerText_; }
+    const FileHeader& header() const { return hbuf_.getHeader(); }
+    bool headerParsed() const { return headerParsed_; }
+    unsigned long long indexGeneration() const { return indexGeneration_; }
+    size_t liveRecords() const {
+        return segment_.attached() ? segment_.size() - tombstones_.size()
+                                   : index_.size();
+    }
+    long long deadRecords() const { return deadRecords_; }
+    long long deadBytes() const { return deadBytes_; }
+    long long lastSequence() const { return lastSeq_; }
+    long long dataSize() const { return dataEnd_; }
+    long long walEntriesReplayed() const { return walReplayed_; }
+    long long pendingWalEntries() const { return walPending_; }
+    bool hasBloomFilter() const { return !bloom_.empty(); }
+
+    /// true if the index is a shared segment instead of an .idx file
+    bool usingSegment() const { return segment_.attached(); }
+    const IndexSegment& segment() const { return segment_; }
+
+    /// The whole in-memory index (ZIP -> offset), after WAL replay.
+    /// With a segment it only holds the WAL changes made after the segment.
+    const std::unordered_map<std::string, long long>& index() const {
+        return index_;
+    }
+
+private:
+    std::string lenFile_;
+    std::string idxFile_;
+    std::string walFile_;
+    int dataFd_;
+    int walFd_;
+    int lockFd_;
+    bool forUpdate_;
+    bool syncEachUpdate_;
+    bool generationMismatch_;
+    bool headerParsed_;
+    bool hasChecksum_;
+    unsigned long long generation_;
+    unsigned long long indexGeneration_;
+    HeaderBuffer hbuf_;
+    std::string headerText_;
+    std::string error_;
+    const ParsedIndex* parsed_;   ///< set during open() only
+
+    std::unordered_map<std::string, long long> index_;
+    std::unordered_set<std::string> tombstones_;
+    BloomFilter bloom_;
+    IndexSegment segment_;
+    long long dataEnd_;      ///< end of the last committed record
+    long long lastSeq_;      ///< last WAL sequence number applied
+    long long deadRecords_;
+    long long deadBytes_;
+    long long walReplayed_;
+    long long walPending_;   ///< WAL entries since the last checkpoint
+
+    bool fail(const std::string& message);
+    bool openOnce(const std::string& lenFile, const std::string& idxFile,
+                  bool forUpdate);
+    bool loadIndex();
+    bool attachSegment();
+    bool replayWal();
+    bool startNewWal();
+    bool appendWal(const std::string& entry);
+    LenStatus frameAt(long long offset, LenRecordView& view,
+                      std::string* recordText) const;
+};
+
+#endif
@@ -0,0 +1,254 @@
+/**
+ * @file ZipLoadGen.cpp
+ * @brief Implementation of the load generator.
+ * @date October 2026
+ */
+#include "ZipLoadGen.h"
+#include "ZipProtocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+/**
+ * @brief Reads the ZIP column of an index file.
+ */
+static bool loadKeys(const string& idxFile, vector<string>& keys) {
+    ifstream in(idxFile);
+    if (!in) return false;
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line.compare(0, 3, "IDX") == 0) continue;
+        istringstream fields(line);
+        string zip;
+        if (fields >> zip) keys.push_back(zip);
+    }
+    return !keys.empty();
+}
+
+/**
+ * @brief Connects to 127.0.0.1:port (blocking socket, Nagle off).
+ * @return socket, or -1
+ */
+static int connectLoopback(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+/**
+ * @brief Sends all bytes.
+ */
+static bool sendAll(int fd, const string& data) {
+    size_t pos = 0;
+    while (pos < data.size()) {
+        ssize_t n = send(fd, data.data() + pos, data.size() - pos, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        pos += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * @class FrameReader
+ * @brief Reads whole frames from a blocking socket through a buffer.
+ */
+class FrameReader {
+public:
+    explicit FrameReader(int fd) : fd_(fd), pos_(0) {}
+
+    /// Receives the next frame body; false on error or closed connection
+    bool next(string& body) {
+        while (true) {
+            size_t have = buf_.size() - pos_;
+            if (have >= 4) {
+                uint32_t len = getU32(buf_.data() + pos_);
+                if (len > kMaxFrameBody) return false;
+                if (have - 4 >= len) {
+                    body.assign(buf_, pos_ + 4, len);
+                    pos_ += 4 + len;
+                    if (pos_ == buf_.size()) {
+                        buf_.clear();
+                        pos_ = 0;
+                    }
+                    return true;
+                }
+            }
+            if (pos_ > 0) {
+                buf_.erase(0, pos_);
+                pos_ = 0;
+            }
+            char chunk[64 * 1024];
+            ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            buf_.append(chunk, static_cast<size_t>(n));
+        }
+    }
+
+private:
+    int fd_;
+    string buf_;
+    size_t pos_;
+};
+
+/// What one connection measured
+struct WorkerResult {
+    vector<double> latencyUs;
+    long long lookups = 0;
+    long long found = 0;
+    long long errors = 0;
+    string error;
+};
+
+/**
+ * @brief One connection: keeps `depth` requests in flight until time is up.
+ */
+static void runConnection(const LoadGenOptions& options,
+                          const vector<string>& keys, unsigned seed,
+                          Clock::time_point deadline, WorkerResult& result) {
+    int fd = connectLoopback(options.port);
+    if (fd < 0) {
+        result.error = "cannot connect to 127.0.0.1:" + to_string(options.port)
+                       + ": " + strerror(errno);
+        return;
+    }
+
+    mt19937 rng(seed);
+    uniform_int_distribution<size_t> pickKey(0, keys.size() - 1);
+    bernoulli_distribution pickMiss(options.missRatio);
+
+    FrameReader reader(fd);
+    deque<pair<uint32_t, Clock::time_point>> inFlight;   // answered in order
+    uint32_t nextId = 0;
+    vector<string> batch;
+    vector<LookupResult> answers;
+    string frame, body;
+
+    while (true) {
+        // Top up the pipeline, sending the new requests in one write.
+        frame.clear();
+        Clock::time_point now = Clock::now();
+        while (inFlight.size() < options.depth && now < deadline) {
+            batch.clear();
+            for (unsigned i = 0; i < options.batch; i++) {
+                const string& key = keys[pickKey(rng)];
+                // A leading zero is never stored, so "0"+ZIP always misses.
+                batch.push_back(pickMiss(rng) ? "0" + key : key);
+            }
+            appendLookupRequest(frame, nextId, batch);
+            inFlight.emplace_back(nextId++, now);
+        }
+        if (!frame.empty() && !sendAll(fd, frame)) {
+            result.error = "send failed";
+            break;
+        }
+        if (inFlight.empty()) break;   // time is up and everything answered
+
+        if (!reader.next(body)) {
+            result.error = "connection closed by server";
+            break;
+        }
+        Clock::time_point done = Clock::now();
+
+        uint32_t id;
+        uint8_t status;
+        if (!parseLookupReply(body.data(), body.size(), id, status, answers) ||
+            status != kReplyOk || id != inFlight.front().first ||
+            answers.size() != options.batch) {
+            result.errors++;
+        }
+        for (const LookupResult& a : answers) {
+            if (a.result == kResultFound) result.found++;
+        }
+        result.lookups += options.batch;
+        result.latencyUs.push_back(
+            chrono::duration<double, micro>(done - inFlight.front().second).count());
+        inFlight.pop_front();
+    }
+    ::close(fd);
+}
+
+bool runLoadGen(const LoadGenOptions& options, LoadGenReport& report,
+                string& error) {
+    report = LoadGenReport();
+    if (options.connections == 0 || options.depth == 0 || options.batch == 0 ||
+        options.batch > kMaxLookupKeys) {
+        error = "connections, depth and batch must be positive (batch at most "
+                + to_string(kMaxLookupKeys) + ").";
+        return false;
+    }
+
+    vector<string> keys;
+    if (!loadKeys(options.idxFile, keys)) {
+        error = "Cannot read ZIPs from index file '" + options.idxFile + "'";
+        return false;
+    }
+
+    vector<WorkerResult> results(options.connections);
+    vector<thread> pool;
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + chrono::duration_cast<Clock::duration>(
+                                             chrono::duration<double>(options.seconds));
+    for (unsigned i = 0; i < options.connections; i++) {
+        pool.emplace_back(runConnection, cref(options), cref(keys), 12345u + i,
+                          deadline, ref(results[i]));
+    }
+    for (thread& t : pool) t.join();
+    report.seconds = chrono::duration<double>(Clock::now() - start).count();
+
+    vector<double> all;
+    for (const WorkerResult& r : results) {
+        if (!r.error.empty() && error.empty()) error = r.error;
+        all.insert(all.end(), r.latencyUs.begin(), r.latencyUs.end());
+        report.lookups += r.lookups;
+        report.found += r.found;
+        report.errors += r.errors;
+    }
+    report.requests = static_cast<long long>(all.size());
+    if (!error.empty()) return false;
+    if (all.empty()) {
+        error = "No requests were answered.";
+        return false;
+    }
+
+    sort(all.begin(), all.end());
+    auto pct = [&](double p) {
+        size_t i = static_cast<size_t>(p * (all.size() - 1) + 0.5);
+        return all[min(i, all.size() - 1)];
+    };
+    report.p50Us = pct(0.50);
+    report.p90Us = pct(0.90);
+    report.p99Us = pct(0.99);
+    report.p999Us = pct(0.999);
+    report.maxUs = all.back();
+    return true;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file ZipLoadGen.h
+ * @brief Load generator for the TCP query server (see ZipServer.h).
+ * @date October 2026
+ *
+ * Opens several connections to 127.0.0.1:<port>. Each one runs on its own
+ * thread and keeps a fixed number of requests in flight (the pipeline
+ * depth), each asking for `batch` random ZIPs taken from an index file.
+ * Every request's latency is measured from just before it is sent until
+ * its whole answer has been read.
+ *
+ * The report gives requests and lookups per second and the latency
+ * percentiles over all requests. With depth 1 the latency is the plain
+ * round trip; a deeper pipeline trades latency for throughput.
+ */
+#ifndef ZIPLOADGEN_H
+#define ZIPLOADGEN_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @struct LoadGenOptions
+ * @brief What to run.
+ */
+struct LoadGenOptions {
+    uint16_t port;         ///< server port on 127.0.0.1
+    std::string idxFile;   ///< index whose ZIPs are asked for
+    unsigned connections;  ///< client connections (one thread each)
+    double seconds;        ///< how long to send
+    unsigned depth;        ///< requests in flight per connection
+    unsigned batch;        ///< ZIPs per request
+    double missRatio;      ///< share of ZIPs that do not exist (0..1)
+
+    LoadGenOptions()
+        : port(0), connections(4), seconds(5.0), depth(16), batch(1),
+          missRatio(0.0) {}
+};
+
+/**
+ * @struct LoadGenReport
+ * @brief What was measured.
+ */
+struct LoadGenReport {
+    long long requests;    ///< answered requests
+    long long lookups;     ///< ZIPs asked for in those requests
+    long long found;       ///< ZIPs answered with a record
+    long long errors;      ///< bad or unexpected answers
+    double seconds;        ///< wall time from first send to last answer
+    double p50Us;          ///< latency percentiles in microseconds
+    double p90Us;
+    double p99Us;
+    double p999Us;
+    double maxUs;
+
+    LoadGenReport()
+        : requests(0), lookups(0), found(0), errors(0), seconds(0),
+          p50Us(0), p90Us(0), p99Us(0), p999Us(0), maxUs(0) {}
+};
+
+/**
+ * @brief Runs the load and fills in the report.
+ * @param options What to run
+ * @param report Receives the measurements
+ * @param error Receives a message when it fails
+ * @return false if the index cannot be read or a connection fails
+ */
+bool runLoadGen(const LoadGenOptions& options, LoadGenReport& report,
+                std::string& error);
+
+#endif
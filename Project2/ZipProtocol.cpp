@@ -0,0 +1,116 @@
+/**
+ * @file ZipProtocol.cpp
+ * @brief Encoding and decoding of the TCP query server frames.
+ * @date October 2026
+ */
+#include "ZipProtocol.h"
+
+using namespace std;
+
+void putU16(string& out, uint16_t v) {
+    out.push_back(static_cast<char>(v >> 8));
+    out.push_back(static_cast<char>(v));
+}
+
+void putU32(string& out, uint32_t v) {
+    out.push_back(static_cast<char>(v >> 24));
+    out.push_back(static_cast<char>(v >> 16));
+    out.push_back(static_cast<char>(v >> 8));
+    out.push_back(static_cast<char>(v));
+}
+
+uint16_t getU16(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<uint16_t>((u[0] << 8) | u[1]);
+}
+
+uint32_t getU32(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return (static_cast<uint32_t>(u[0]) << 24) | (static_cast<uint32_t>(u[1]) << 16) |
+           (static_cast<uint32_t>(u[2]) << 8) | u[3];
+}
+
+void finishFrame(string& out, size_t frameStart) {
+    uint32_t body = static_cast<uint32_t>(out.size() - frameStart - 4);
+    string len;
+    putU32(len, body);
+    out.replace(frameStart, 4, len);
+}
+
+bool appendLookupRequest(string& out, uint32_t requestId,
+                         const vector<string>& keys) {
+    if (keys.size() > kMaxLookupKeys) return false;
+    for (const string& k : keys) {
+        if (k.size() > 255) return false;
+    }
+
+    size_t start = out.size();
+    putU32(out, 0);   // body length, filled in below
+    out.push_back(kMsgLookup);
+    putU32(out, requestId);
+    putU16(out, static_cast<uint16_t>(keys.size()));
+    for (const string& k : keys) {
+        out.push_back(static_cast<char>(k.size()));
+        out += k;
+    }
+    finishFrame(out, start);
+    return true;
+}
+
+bool parseLookupRequest(const char* body, size_t size, uint32_t& requestId,
+                        vector<string>& keys) {
+    keys.clear();
+    if (size < 7 || body[0] != kMsgLookup) return false;
+    requestId = getU32(body + 1);
+    size_t count = getU16(body + 5);
+    if (count > kMaxLookupKeys) return false;
+
+    size_t pos = 7;
+    for (size_t i = 0; i < count; i++) {
+        if (pos >= size) return false;
+        size_t len = static_cast<unsigned char>(body[pos++]);
+        if (pos + len > size) return false;
+        keys.emplace_back(body + pos, len);
+        pos += len;
+    }
+    return pos == size;
+}
+
+void beginLookupReply(string& out, uint32_t requestId, uint8_t status,
+                      uint16_t count) {
+    putU32(out, 0);   // body length, see finishFrame()
+    out.push_back(kMsgLookupReply);
+    putU32(out, requestId);
+    out.push_back(static_cast<char>(status));
+    putU16(out, count);
+}
+
+void appendLookupResult(string& out, uint8_t result, const char* text,
+                        size_t length) {
+    out.push_back(static_cast<char>(result));
+    putU32(out, static_cast<uint32_t>(length));
+    out.append(text, length);
+}
+
+bool parseLookupReply(const char* body, size_t size, uint32_t& requestId,
+                      uint8_t& status, vector<LookupResult>& results) {
+    results.clear();
+    if (size < 8 || body[0] != kMsgLookupReply) return false;
+    requestId = getU32(body + 1);
+    status = static_cast<uint8_t>(body[5]);
+    size_t count = getU16(body + 6);
+
+    size_t pos = 8;
+    for (size_t i = 0; i < count; i++) {
+        if (pos + 5 > size) return false;
+        LookupResult r;
+        r.result = static_cast<uint8_t>(body[pos]);
+        size_t len = getU32(body + pos + 1);
+        pos += 5;
+        if (len > size - pos) return false;
+        r.text.assign(body + pos, len);
+        pos += len;
+        results.push_back(std::move(r));
+    }
+    return pos == size;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file ZipProtocol.h
+ * @brief Binary request/response format of the TCP query server.
+ * @date October 2026
+ *
+ * Every message is a frame: a 4-byte body length followed by the body.
+ * All integers are big-endian (network order).
+ *
+ * Lookup request body:
+ *   u8 'L' | u32 request id | u16 key count |
+ *   key count x (u8 key length | key bytes)
+ *
+ * Lookup response body:
+ *   u8 'l' | u32 request id | u8 status | u16 result count |
+ *   result count x (u8 result | u32 text length | record text)
+ *
+ * status: 0 = ok, 1 = bad request (no results follow)
+ * result: 0 = found, 1 = not found, 2 = found but the record is unreadable
+ *
+ * A client may send many requests without waiting (pipelining); the
+ * server answers them in the order they were sent on that connection.
+ * The request id is echoed back so a client can match them anyway.
+ */
+#ifndef ZIPPROTOCOL_H
+#define ZIPPROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const char kMsgLookup = 'L';
+const char kMsgLookupReply = 'l';
+
+const uint8_t kReplyOk = 0;
+const uint8_t kReplyBadRequest = 1;
+
+const uint8_t kResultFound = 0;
+const uint8_t kResultNotFound = 1;
+const uint8_t kResultUnreadable = 2;
+
+/// Largest frame body either side accepts (16 MB)
+const uint32_t kMaxFrameBody = 16u << 20;
+
+/// Most keys in one lookup request
+const size_t kMaxLookupKeys = 4096;
+
+/// One answer in a lookup response
+struct LookupResult {
+    uint8_t result;    ///< kResultFound, kResultNotFound or kResultUnreadable
+    std::string text;  ///< record text when found
+};
+
+void putU16(std::string& out, uint16_t v);
+void putU32(std::string& out, uint32_t v);
+uint16_t getU16(const char* p);
+uint32_t getU32(const char* p);
+
+/**
+ * @brief Appends one complete lookup request frame.
+ * @return false if there are too many keys or a key is longer than 255
+ */
+bool appendLookupRequest(std::string& out, uint32_t requestId,
+                         const std::vector<std::string>& keys);
+
+/**
+ * @brief Parses a lookup request body (the bytes after the length).
+ * @return false if the body is malformed
+ */
+bool parseLookupRequest(const char* body, size_t size, uint32_t& requestId,
+                        std::vector<std::string>& keys);
+
+/// Appends the frame header and fixed part of a lookup response
+void beginLookupReply(std::string& out, uint32_t requestId, uint8_t status,
+                      uint16_t count);
+
+/// Appends one result of a lookup response
+void appendLookupResult(std::string& out, uint8_t result,
+                        const char* text, size_t length);
+
+/// Fills in the body length of a frame started at frameStart
+void finishFrame(std::string& out, size_t frameStart);
+
+/**
+ * @brief Parses a lookup response body.
+ * @return false if the body is malformed
+ */
+bool parseLookupReply(const char* body, size_t size, uint32_t& requestId,
+                      uint8_t& status, std::vector<LookupResult>& results);
+
+#endif
@@ -0,0 +1,508 @@
+/**
+ * @file ZipServer.cpp
+ * @brief Implementation of the ZipServer class.
+ * @date October 2026
+ */
+#include "ZipServer.h"
+#include "ZipProtocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+/// Stop reading a connection when this much output is waiting
+static const size_t kOutputHighWater = 4u << 20;
+
+/// Start reading it again when the waiting output drops below this
+static const size_t kOutputLowWater = 1u << 20;
+
+/// Stop one read pass when this much unhandled input is buffered
+static const size_t kInputChunkLimit = 1u << 20;
+
+/// Most requests answered in one batch
+static const size_t kMaxBatchRequests = 1024;
+
+/// Quiet time after a file event before reloading
+static const long kReloadDelayMs = 200;
+
+/**
+ * @brief Directory part of a path ("." if none).
+ */
+static string dirOf(const string& path) {
+    size_t slash = path.rfind('/');
+    if (slash == string::npos) return ".";
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+/**
+ * @brief File name part of a path.
+ */
+static string baseName(const string& path) {
+    size_t slash = path.rfind('/');
+    return (slash == string::npos) ? path : path.substr(slash + 1);
+}
+
+ZipServer::ZipServer()
+    : warmup_(false), listenFd_(-1), epollFd_(-1), wakeFd_(-1), reloadFd_(-1), watchFd_(-1),
+      timerFd_(-1), reloadDoneFd_(-1), reloading_(false), reloadOk_(false), port_(0),
+      accepted_(0), requests_(0), lookups_(0) {}
+
+ZipServer::~ZipServer() {
+    if (reloader_.joinable()) reloader_.join();
+    for (auto& e : conns_) ::close(e.first);
+    conns_.clear();
+    if (listenFd_ >= 0) ::close(listenFd_);
+    if (epollFd_ >= 0) ::close(epollFd_);
+    if (wakeFd_ >= 0) ::close(wakeFd_);
+    if (reloadFd_ >= 0) ::close(reloadFd_);
+    if (watchFd_ >= 0) ::close(watchFd_);
+    if (timerFd_ >= 0) ::close(timerFd_);
+    if (reloadDoneFd_ >= 0) ::close(reloadDoneFd_);
+}
+
+bool ZipServer::fail(const string& message) {
+    error_ = message;
+    return false;
+}
+
+void ZipServer::enableWarmup(bool lockIndex) {
+    warmup_ = true;
+    stores_.setIndexWarmup(lockIndex);
+}
+
+bool ZipServer::start(const string& lenFile, const string& idxFile,
+                      uint16_t port, bool watch) {
+    lenFile_ = lenFile;
+    idxFile_ = idxFile;
+    if (!stores_.open(lenFile, idxFile)) return fail(stores_.lastError());
+    if (!stores_.lastWarning().empty())
+        cerr << "Warning: " << stores_.lastWarning() << "\n";
+
+    if (warmup_) {
+        shared_ptr<const ZipDataStore> store = stores_.current();
+        const unsigned long long generation = store->header().generation;
+        const string path = WarmupProfile::pathFor(lenFile);
+        if (profile_.load(path, generation)) {
+            long long bytes = profile_.prefetch(*store);
+            cout << "Warmup: " << profile_.hotBlocks() << " hot blocks ("
+                 << bytes / 1024 << " KB) requested from " << path << "\n";
+        } else {
+            profile_.reset(generation, store->dataSize());
+        }
+        // This run's reads are added to the loaded blocks, so a short run
+        // does not throw away what earlier ones learned.
+    }
+
+    listenFd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) return fail(string("socket: ") + strerror(errno));
+
+    int one = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    // Loopback only: this is a same-host service.
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+        return fail("bind 127.0.0.1:" + to_string(port) + ": " + strerror(errno));
+    if (listen(listenFd_, SOMAXCONN) != 0)
+        return fail(string("listen: ") + strerror(errno));
+
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    reloadFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    reloadDoneFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0 || reloadFd_ < 0 || reloadDoneFd_ < 0)
+        return fail(string("epoll/eventfd: ") + strerror(errno));
+
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &ev);
+    ev.data.fd = wakeFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+    ev.data.fd = reloadFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, reloadFd_, &ev);
+    ev.data.fd = reloadDoneFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, reloadDoneFd_, &ev);
+
+    return !watch || watchFiles();
+}
+
+bool ZipServer::watchFiles() {
+    watchFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (watchFd_ < 0 || timerFd_ < 0)
+        return fail(string("inotify/timerfd: ") + strerror(errno));
+
+    // Watch the directories: the files themselves are replaced by rename,
+    // so a watch on the old inode would never fire again.
+    const uint32_t mask = IN_MOVED_TO | IN_CLOSE_WRITE;
+    if (inotify_add_watch(watchFd_, dirOf(lenFile_).c_str(), mask) < 0 ||
+        inotify_add_watch(watchFd_, dirOf(idxFile_).c_str(), mask) < 0)
+        return fail(string("inotify_add_watch: ") + strerror(errno));
+
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = watchFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, watchFd_, &ev);
+    ev.data.fd = timerFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, timerFd_, &ev);
+    return true;
+}
+
+void ZipServer::fileEvents() {
+    alignas(inotify_event) char buf[4096];
+    const string lenName = baseName(lenFile_);
+    const string idxName = baseName(idxFile_);
+    bool ours = false;
+
+    ssize_t got;
+    while ((got = read(watchFd_, buf, sizeof(buf))) > 0) {
+        for (ssize_t pos = 0; pos < got; ) {
+            const inotify_event* e = reinterpret_cast<const inotify_event*>(buf + pos);
+            if (e->len > 0 && (lenName == e->name || idxName == e->name)) ours = true;
+            pos += static_cast<ssize_t>(sizeof(inotify_event) + e->len);
+        }
+    }
+
+    // (Re)start the quiet period; the reload runs when the timer fires.
+    if (ours) {
+        itimerspec t;
+        memset(&t, 0, sizeof(t));
+        t.it_value.tv_nsec = kReloadDelayMs * 1000000L;
+        timerfd_settime(timerFd_, 0, &t, nullptr);
+    }
+}
+
+void ZipServer::reloadNow(const char* why) {
+    // One at a time; the files may have changed again since it started.
+    if (reloading_) {
+        reloadNext_ = why;
+        return;
+    }
+    reloading_ = true;
+    reloadWhy_ = why;
+    reloader_ = thread([this]() {
+        reloaded_.reset();
+        reloadWarning_.clear();
+        reloadOk_ = stores_.prepare(reloaded_, reloadWarning_, reloadError_);
+        uint64_t one = 1;
+        ssize_t r = write(reloadDoneFd_, &one, sizeof(one));
+        (void)r;
+    });
+}
+
+void ZipServer::reloadDone() {
+    reloader_.join();
+    reloading_ = false;
+    if (!reloadOk_) {
+        cerr << "Reload (" << reloadWhy_ << ") rejected, still serving the old files: "
+             << reloadError_ << "\n";
+    } else {
+        stores_.install(reloaded_, reloadWarning_);
+        reloaded_.reset();
+        shared_ptr<const ZipDataStore> store = stores_.current();
+        if (warmup_) profile_.reset(store->header().generation, store->dataSize());
+        cout << "Reloaded (" << reloadWhy_ << "): " << store->liveRecords()
+             << " records, generation "
+             << HeaderBuffer::generationText(store->header().generation) << "\n" << flush;
+        if (!stores_.lastWarning().empty())
+            cerr << "Warning: " << stores_.lastWarning() << "\n";
+    }
+    if (!reloadNext_.empty()) {
+        const string why = reloadNext_;
+        reloadNext_.clear();
+        reloadNow(why.c_str());
+    }
+}
+
+void ZipServer::requestReload() {
+    uint64_t one = 1;
+    ssize_t r = write(reloadFd_, &one, sizeof(one));   // async-signal-safe
+    (void)r;
+}
+
+void ZipServer::requestStop() {
+    uint64_t one = 1;
+    ssize_t r = write(wakeFd_, &one, sizeof(one));   // async-signal-safe
+    (void)r;
+}
+
+bool ZipServer::run() {
+    vector<epoll_event> events(128);
+    while (true) {
+        int n = epoll_wait(epollFd_, events.data(), static_cast<int>(events.size()), -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return fail(string("epoll_wait: ") + strerror(errno));
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            uint32_t ev = events[i].events;
+
+            if (fd == wakeFd_) {
+                if (warmup_ && !profile_.save(WarmupProfile::pathFor(lenFile_)))
+                    cerr << "Warning: cannot save warmup profile\n";
+                return true;
+            }
+            if (fd == reloadFd_ || fd == timerFd_) {
+                uint64_t count;
+                ssize_t r = read(fd, &count, sizeof(count));
+                (void)r;
+                reloadNow(fd == reloadFd_ ? "signal" : "files changed");
+                continue;
+            }
+            if (fd == reloadDoneFd_) {
+                uint64_t count;
+                ssize_t r = read(fd, &count, sizeof(count));
+                (void)r;
+                reloadDone();
+                continue;
+            }
+            if (fd == watchFd_) {
+                fileEvents();
+                continue;
+            }
+            if (fd == listenFd_) {
+                acceptClients();
+                continue;
+            }
+
+            auto it = conns_.find(fd);
+            if (it == conns_.end()) continue;
+            Connection& c = it->second;
+
+            bool ok = true;
+            if (ev & (EPOLLIN | EPOLLHUP | EPOLLERR)) ok = readInput(c);
+
+            // Answer everything that is complete, as long as the client keeps
+            // taking the output; the rest waits for the next EPOLLOUT.
+            while (ok) {
+                ok = handleRequests(c) && flushOutput(c);
+                size_t pending = c.out.size() - c.outPos;
+                size_t buffered = c.in.size() - c.inPos;
+                if (pending >= kOutputLowWater || buffered < 4 ||
+                    buffered - 4 < getU32(c.in.data() + c.inPos))
+                    break;
+            }
+
+            if (!ok || (c.peerClosed && c.out.size() == c.outPos)) {
+                closeConnection(fd);
+                continue;
+            }
+            updateInterest(c);
+        }
+    }
+}
+
+void ZipServer::acceptClients() {
+    while (true) {
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;   // EAGAIN: no more waiting clients
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            ::close(fd);
+            continue;
+        }
+
+        Connection c;
+        c.fd = fd;
+        c.inPos = 0;
+        c.outPos = 0;
+        c.events = EPOLLIN;
+        c.peerClosed = false;
+        conns_[fd] = std::move(c);
+        accepted_++;
+    }
+}
+
+bool ZipServer::readInput(Connection& c) {
+    char buf[64 * 1024];
+    while (c.in.size() - c.inPos < kInputChunkLimit) {
+        ssize_t got = recv(c.fd, buf, sizeof(buf), 0);
+        if (got > 0) {
+            c.in.append(buf, static_cast<size_t>(got));
+            continue;
+        }
+        if (got == 0) {
+            c.peerClosed = true;
+            return true;
+        }
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    return true;
+}
+
+bool ZipServer::handleRequests(Connection& c) {
+    /// One request of the batch; its results are slots[first, first+count)
+    struct Request {
+        uint32_t id;
+        bool bad;
+        size_t first;
+        size_t count;
+    };
+    /// One lookup of the batch
+    struct Slot {
+        long long offset;
+        uint8_t result;
+        string text;
+    };
+
+    vector<Request> batch;
+    vector<Slot> slots;
+    vector<string> keys;
+    vector<string> batchKeys;
+    vector<long long> offsets;
+    vector<size_t> order;
+
+    while (c.out.size() - c.outPos < kOutputHighWater) {
+        // The whole batch uses one store, even if a reload swaps it meanwhile.
+        shared_ptr<const ZipDataStore> store = stores_.current();
+        batch.clear();
+        slots.clear();
+        batchKeys.clear();
+
+        // ---- 1) Take every complete request; probe the index ----------------
+        while (batch.size() < kMaxBatchRequests && c.in.size() - c.inPos >= 4) {
+            uint32_t len = getU32(c.in.data() + c.inPos);
+            if (len > kMaxFrameBody) return false;   // not our protocol
+            if (c.in.size() - c.inPos - 4 < len) break;
+            const char* body = c.in.data() + c.inPos + 4;
+
+            Request r;
+            r.first = slots.size();
+            r.bad = !parseLookupRequest(body, len, r.id, keys);
+            if (r.bad) {
+                r.id = (len >= 5) ? getU32(body + 1) : 0;
+            } else {
+                batchKeys.insert(batchKeys.end(), keys.begin(), keys.end());
+                slots.resize(slots.size() + keys.size());
+            }
+            r.count = slots.size() - r.first;
+            batch.push_back(r);
+            c.inPos += 4 + len;
+        }
+        if (batch.empty()) break;
+
+        // All keys of the batch in one call, so a segment can probe them
+        // in lockstep (see BatchSearch.h).
+        store->findBatch(batchKeys, offsets);
+        for (size_t i = 0; i < slots.size(); i++) {
+            slots[i].offset = offsets[i];
+            slots[i].result = (offsets[i] >= 0) ? kResultFound : kResultNotFound;
+        }
+
+        // ---- 2) Read the found records in file order ---------------------------
+        order.clear();
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (slots[i].result == kResultFound) order.push_back(i);
+        }
+        sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return slots[a].offset < slots[b].offset;
+        });
+        for (size_t i : order) {
+            if (warmup_) profile_.noteRead(slots[i].offset);
+            if (store->readRecordAt(slots[i].offset, slots[i].text) != LenStatus::Ok) {
+                slots[i].result = kResultUnreadable;
+                slots[i].text.clear();
+            }
+        }
+
+        // ---- 3) Answers in request order -----------------------------------------
+        for (const Request& r : batch) {
+            size_t start = c.out.size();
+            beginLookupReply(c.out, r.id, r.bad ? kReplyBadRequest : kReplyOk,
+                             static_cast<uint16_t>(r.count));
+            for (size_t i = r.first; i < r.first + r.count; i++) {
+                appendLookupResult(c.out, slots[i].result, slots[i].text.data(),
+                                   slots[i].text.size());
+            }
+            finishFrame(c.out, start);
+        }
+        requests_ += static_cast<long long>(batch.size());
+        lookups_ += static_cast<long long>(slots.size());
+    }
+
+    // Drop the handled input now and then, not after every request.
+    if (c.inPos == c.in.size()) {
+        c.in.clear();
+        c.inPos = 0;
+    } else if (c.inPos > 64 * 1024) {
+        c.in.erase(0, c.inPos);
+        c.inPos = 0;
+    }
+    return true;
+}
+
+bool ZipServer::flushOutput(Connection& c) {
+    while (c.outPos < c.out.size()) {
+        ssize_t sent = send(c.fd, c.out.data() + c.outPos, c.out.size() - c.outPos,
+                            MSG_NOSIGNAL);
+        if (sent > 0) {
+            c.outPos += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        return false;
+    }
+    c.out.clear();
+    c.outPos = 0;
+    return true;
+}
+
+void ZipServer::updateInterest(Connection& c) {
+    size_t pending = c.out.size() - c.outPos;
+    uint32_t want = 0;
+    if (pending > 0) want |= EPOLLOUT;
+    // Reading stops at the high-water mark and resumes only below the low one.
+    const size_t limit = (c.events & EPOLLIN) ? kOutputHighWater : kOutputLowWater;
+    if (!c.peerClosed && pending < limit) want |= EPOLLIN;
+    if (want == c.events) return;
+
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = want;
+    ev.data.fd = c.fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, c.fd, &ev);
+    c.events = want;
+}
+
+void ZipServer::closeConnection(int fd) {
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    conns_.erase(fd);
+}
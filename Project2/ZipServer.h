@@ -0,0 +1,158 @@
+/**
+ * @file ZipServer.h
+ * @brief Loopback TCP query server over one data/index pair.
+ * @date October 2026
+ *
+ * One process keeps the index warm (see ZipDataStore.h) and answers
+ * lookups from other processes on the same host over 127.0.0.1. The
+ * message format is in ZipProtocol.h.
+ *
+ * The server is a single-threaded epoll event loop with non-blocking
+ * sockets:
+ * - Pipelining: a client may send many requests without waiting. Each
+ *   time a connection becomes readable, every complete request in its
+ *   input buffer is handled, and all the answers go out in one send().
+ * - Batching: the lookups of all those requests are resolved together.
+ *   The index is probed first, then the records are read in file offset
+ *   order, so a batch reads the data file mostly forward.
+ * - Back-pressure: a connection whose unsent output grows past 4 MB is not
+ *   read again until the client has taken most of it.
+ *
+ * Stop it with SIGINT/SIGTERM; the handler only calls requestStop().
+ *
+ * Hot reload (see StoreReloader.h): SIGHUP, or with watching on, a new
+ * data or index file renamed into place, makes the server open and check
+ * the pair again and swap it in. The new pair is opened and checked on a
+ * thread of its own, so the event loop keeps answering from the old store
+ * meanwhile; an eventfd hands the new store back to the loop, which swaps
+ * it in. A batch that is being answered keeps the store it started with.
+ * File events are collected for 200 ms first, because a regenerated pair
+ * arrives as two renames; a request that comes while a reload is running
+ * starts another one when it is done. A pair that fails the checks is not
+ * used and the old one keeps serving.
+ *
+ * Warmup (see WarmupProfile.h): with enableWarmup() the server replays the
+ * hot data blocks saved by its previous run before it starts listening,
+ * reads the index in (optionally locking it in RAM), notes the blocks it
+ * reads while running and saves them again when it stops.
+ */
+#ifndef ZIPSERVER_H
+#define ZIPSERVER_H
+
+#include "StoreReloader.h"
+#include "WarmupProfile.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/**
+ * @class ZipServer
+ * @brief epoll loop that answers length-prefixed lookup requests.
+ */
+class ZipServer {
+public:
+    ZipServer();
+    ~ZipServer();
+
+    ZipServer(const ZipServer&) = delete;
+    ZipServer& operator=(const ZipServer&) = delete;
+
+    /**
+     * @brief Opens the data/index pair and listens on 127.0.0.1:port.
+     * @param lenFile Data file (.len)
+     * @param idxFile Index file (.idx)
+     * @param port TCP port (0 picks a free one, see port())
+     * @param watch true to reload when the files are replaced
+     * @return false on error (see lastError())
+     */
+    bool start(const std::string& lenFile, const std::string& idxFile,
+               uint16_t port, bool watch = false);
+
+    /**
+     * @brief Turns warmup on; call before start().
+     * @param lockIndex true to also lock the index in RAM
+     */
+    void enableWarmup(bool lockIndex);
+
+    /**
+     * @brief Runs the event loop until requestStop() is called.
+     * @return false if the loop failed (see lastError())
+     */
+    bool run();
+
+    /// Makes run() return; safe to call from a signal handler
+    void requestStop();
+
+    /// Makes run() reload the pair; safe to call from a signal handler
+    void requestReload();
+
+    /// Port actually listened on
+    uint16_t port() const { return port_; }
+
+    /// Records in the loaded index
+    size_t liveRecords() const { return stores_.current()->liveRecords(); }
+
+    long long connectionsAccepted() const { return accepted_; }
+    long long requestsServed() const { return requests_; }
+    long long lookupsServed() const { return lookups_; }
+    long long reloads() const { return stores_.reloads(); }
+
+    const std::string& lastError() const { return error_; }
+
+private:
+    /// One client connection
+    struct Connection {
+        int fd;
+        std::string in;      ///< received bytes not yet handled
+        size_t inPos;        ///< start of the unhandled part of `in`
+        std::string out;     ///< answers not yet sent
+        size_t outPos;       ///< start of the unsent part of `out`
+        uint32_t events;     ///< events currently registered with epoll
+        bool peerClosed;     ///< client shut down its side
+    };
+
+    StoreReloader stores_;
+    std::string lenFile_;
+    std::string idxFile_;
+    bool warmup_;
+    WarmupProfile profile_;   ///< hot blocks of the current data file
+    int listenFd_;
+    int epollFd_;
+    int wakeFd_;
+    int reloadFd_;   ///< eventfd written by requestReload()
+    int watchFd_;    ///< inotify on the files' directories, or -1
+    int timerFd_;    ///< delays a file-triggered reload, or -1
+    int reloadDoneFd_;   ///< eventfd written by the reload thread when done
+    std::thread reloader_;   ///< opens and checks the new pair
+    bool reloading_;         ///< reloader_ is running
+    std::string reloadWhy_;  ///< what started the running reload
+    std::string reloadNext_; ///< a reload requested while one ran
+    // Result of the reload thread; read after joining it
+    std::shared_ptr<const ZipDataStore> reloaded_;
+    bool reloadOk_;
+    std::string reloadWarning_;
+    std::string reloadError_;
+    uint16_t port_;
+    std::unordered_map<int, Connection> conns_;
+    long long accepted_;
+    long long requests_;
+    long long lookups_;
+    std::string error_;
+
+    bool fail(const std::string& message);
+    void acceptClients();
+    bool readInput(Connection& c);
+    bool handleRequests(Connection& c);
+    bool flushOutput(Connection& c);
+    void updateInterest(Connection& c);
+    void closeConnection(int fd);
+    bool watchFiles();
+    void fileEvents();
+    void reloadNow(const char* why);
+    void reloadDone();
+};
+
+#endif
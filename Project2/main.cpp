@@ -10,16 +10,121 @@
  *
  * 1) Project 1 style CSV analysis (streaming / no vector)
  *    ./zipprog <csv_file>
+ *    (also distinct places / counties per state, from HyperLogLog sketches)
  *
  * 2) Convert CSV → length-indicated data file (.len)
- *    ./zipprog --make-len <input.csv> <output.len>
+ *    ./zipprog --make-len <input.csv> <output.len> [--checksum]
+ *              [--dedup first|last|error]
+ *    (--checksum appends a CRC32C to every record; duplicated ZIPs are
+ *    reported, and --dedup keeps one row of each or rejects the input)
  *
  * 3) Build primary-key index from .len
- *    ./zipprog --build-index <data.len> <index.idx>
+ *    ./zipprog --build-index <data.len> <index.idx> [--dedup first|last|error]
+ *    (one entry per ZIP; of duplicated ones the last record by default)
  *
  * 4) Search ZIP(s) using index (flags like -Z56301)
  *    ./zipprog --search <data.len> <index.idx> -Z56301 -Z99546 -Z99999
  *
+ * 5) Verify header, record checksums and index consistency
+ *    ./zipprog --verify <data.len> <index.idx> [threads]
+ *
+ * 6) Update one ZIP without rebuilding (appends + WAL), and checkpoint
+ *    ./zipprog --update <data.len> <index.idx> -Z56301 [--place P]
+ *              [--state S] [--county C] [--lat X] [--long Y] [--no-sync]
+ *    ./zipprog --checkpoint <data.len> <index.idx>
+ *
+ * 7) Compact: rewrite only live records, swap new files in atomically
+ *    ./zipprog --compact <data.len> <index.idx>
+ *
+ * 8) Delete ZIP(s): a tombstone in the WAL, data file untouched
+ *    ./zipprog --delete <data.len> <index.idx> -Z56301 [-Z...]
+ *
+ * 9) Sharded dataset: N .len shards plus a manifest (see ShardSet.h)
+ *    ./zipprog --make-shards <input.csv> <data.shards> <N> [--by zip|state]
+ *              [--checksum] [--dedup first|last|error]
+ *    ./zipprog --search <data.shards> -Z56301 -Z99546
+ *    ./zipprog --analyze-shards <data.shards> [threads]
+ *
+ * 10) Loopback TCP query server and its load generator (see ZipServer.h)
+ *    ./zipprog --serve <data.len> <index.idx> [port] [--watch] [--warm]
+ *              [--mlock]
+ *    (SIGHUP, or with --watch a replaced data/index file, reloads the pair;
+ *    --warm replays and saves <data.len>.warm, see WarmupProfile.h)
+ *    ./zipprog --loadgen <port> <index.idx> [--connections N] [--seconds S]
+ *              [--depth D] [--batch B] [--miss R]
+ *
+ * 11) Publish the index as a shared, memory-mapped segment (see IndexSegment.h)
+ *    ./zipprog --publish-segment <data.len> <index.idx> </dev/shm/zip.seg>
+ *              [--eytzinger | --compressed]
+ *    The segment can then be given wherever a read-only mode takes an
+ *    index: --search, --serve. --build-index also writes <index.idx>.eyt,
+ *    a segment in Eytzinger order that can be used the same way.
+ *    --compressed stores the keys and offsets Elias-Fano / bit-packed.
+ *
+ * 12) Read the hot parts of a pair into the page cache (e.g. at boot)
+ *    ./zipprog --warmup <data.len> <index.idx> [--mlock]
+ *    (--mlock needs a segment; the lock ends with the process, so it only
+ *    checks that --serve --mlock will get it)
+ *
+ * 13) Benchmark the in-memory index layouts (see IndexBench.h)
+ *    ./zipprog --bench-index [keys ...]     (default 41000 1000000 100000000)
+ *
+ * 14) Type-ahead over place names (see PlaceTrie.h)
+ *    ./zipprog --complete <data.len> <index.idx> "Sai" [--state MN] [--top K]
+ *    (builds <index.idx>.trie on first use and after any change to the pair)
+ *
+ * 15) Records by state / county / place, from an inverted index (see
+ *     InvertedIndex.h); predicates are ANDed, or ORed with --any
+ *    ./zipprog --where <data.len> <index.idx> [--state MN] [--county C ...]
+ *              [--place P ...] [--any] [--count]
+ *    (builds <index.idx>.inv on first use and after any change to the pair)
+ *
+ * 16) Records within R km of a point, from a Hilbert cell index (see GeoIndex.h)
+ *    ./zipprog --near <data.len> <index.idx> <lat> <long> <km> [--count]
+ *    ./zipprog --nearest <data.len> <index.idx> <lat> <long> [k]
+ *    (--build-index writes <index.idx>.geo; it is rebuilt after any change)
+ *
+ * 17) Benchmark the SIMD distance kernels (see GeoKernel.h, GeoBench.h)
+ *    ./zipprog --bench-geo [points]          (default 1000000)
+ *
+ * 18) Convex hull and bounding box of every state's ZIPs (see StateHull.h)
+ *    ./zipprog --hulls <file.csv> [--wkt] [--threads N]
+ *    ./zipprog --hulls <data.len> <index.idx> [--wkt] [--threads N]
+ *    (GeoJSON on stdout by default, WKT with --wkt; a summary on stderr)
+ *
+ * 19) State extremes table of a pair (see IncrementalExtremes.h)
+ *    ./zipprog --extremes <data.len> <index.idx>
+ *    (builds <index.idx>.ext on first use; --update and --delete keep it
+ *    current in O(log n) per change instead of a rescan)
+ *
+ * 20) Top-k ZIPs per state and direction, and coordinate quantiles
+ *     (see StateSummary.h); the extremes table of mode 1 is the k = 1 case
+ *    ./zipprog --top <file.csv> [--k K] [--quantiles 0.1,0.5,0.9] [--state S]
+ *    ./zipprog --top <data.len> <index.idx> [same options] [--threads N]
+ *
+ * 21) Column profile in bounded memory: null rate, approximate distinct
+ *     count, min / max (see DataProfile.h)
+ *    ./zipprog --profile <input> [<input> ...] [--save <out.profile>]
+ *    (an input is a CSV file, "<data.len> <index.idx>", or a profile saved
+ *    with --save; all inputs are merged)
+ *
+ * 22) Prefix-compressed copy of a CSV (see DeltaFile.h): every record
+ *     stored as its difference to the previous one, restart points in its
+ *     index; compresses best when the CSV is sorted by key
+ *    ./zipprog --make-delta <input.csv> <output.dlen> [--restart N]
+ *              [--dedup first|last|error]
+ *    ./zipprog --search-delta <data.dlen> -Z56301 [-Z...]
+ *    ./zipprog --scan-delta <data.dlen> [--print]
+ *
+ * 23) Dictionary-encoded copy of a CSV (see DictFile.h): place, state and
+ *     county stored as ids into dictionaries that are read in place
+ *    ./zipprog --make-dict <input.csv> <output.dict> [--dedup first|last|error]
+ *    ./zipprog --search-dict <data.dict> -Z56301 [-Z...]
+ *    ./zipprog --scan-dict <data.dict> [--print]
+ *
+ * Build:
+ *    g++ -std=c++17 -Wall -Wextra -O2 -pthread -o zip2 *.cpp
+ *
  * Notes:
  * - For Project 2 RAM rule during searching:
  *   We only keep:
@@ -27,6 +132,11 @@
  *     (2) one record string / one ZipCodeRecord at a time
  * - This file uses the fixed-width ASCII length format:
  *     [10 digits][space][recordText][newline]
+ * - Output files are written to a temp file, fsync'ed and renamed into place
+ *   (see AtomicFile.h), so readers never see a half-written .len or .idx.
+ * - The .len header and the .idx first line share a generation id. Search
+ *   compares them when it opens the pair, so a mismatched index is caught
+ *   immediately instead of showing up as unreadable records.
  *
  * @author Dristi Barnwal
  * @date March 2026
@@ -34,6 +144,33 @@
 
 #include "ZipCodeBuffer.h"
 #include "HeaderBuffer.h"
+#include "StateExtremes.h"
+#include "AtomicFile.h"
+#include "LenFileReader.h"
+#include "LenFileWriter.h"
+#include "LenVerifier.h"
+#include "ZipDataStore.h"
+#include "LenCompactor.h"
+#include "IndexBuilder.h"
+#include "ShardSet.h"
+#include "ZipServer.h"
+#include "ZipLoadGen.h"
+#include "IndexSegment.h"
+#include "BloomFilter.h"
+#include "WarmupProfile.h"
+#include "IndexBench.h"
+#include "BatchSearch.h"
+#include "PlaceTrie.h"
+#include "InvertedIndex.h"
+#include "GeoIndex.h"
+#include "GeoBench.h"
+#include "StateHull.h"
+#include "IncrementalExtremes.h"
+#include "StateSummary.h"
+#include "DataProfile.h"
+#include "DuplicateKeys.h"
+#include "DeltaFile.h"
+#include "DictFile.h"
 
 #include <iostream>
 #include <fstream>
@@ -41,209 +178,21 @@
 #include <string>
 #include <vector>
 #include <map>
-#include <unordered_map>
+#include <algorithm>
 #include <iomanip>
 #include <limits>
 #include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <csignal>
+#include <iterator>
+#include <malloc.h>
 
 using namespace std;
 
-/* ============================================================================
- *  STRUCTS USED FOR PROJECT 1 ANALYSIS (STATE EXTREMES)
- * ============================================================================
- */
-
-/**
- * @struct StateExtremes
- * @brief Keeps the most extreme ZIP codes for one state (east/west/north/south).
- *
- * We store:
- * - Which ZIP code is easternmost / westernmost / northernmost / southernmost
- * - The coordinate values used to compare
- *
- * Tie-breaking rule:
- * - If two ZIPs tie on coordinate, choose the smaller ZIP so results are stable
- *   even if the input rows are shuffled.
- */
-struct StateExtremes {
-    int easternmost;
-    int westernmost;
-    int northernmost;
-    int southernmost;
-
-    double minLongitude;
-    double maxLongitude;
-    double maxLatitude;
-    double minLatitude;
-
-    StateExtremes()
-        : easternmost(0), westernmost(0), northernmost(0), southernmost(0),
-          minLongitude(numeric_limits<double>::max()),
-          maxLongitude(numeric_limits<double>::lowest()),
-          maxLatitude(numeric_limits<double>::lowest()),
-          minLatitude(numeric_limits<double>::max()) {}
-};
-
-/**
- * @brief If coordinate ties, choose the smaller ZIP.
- * @param candidate ZIP we are considering
- * @param current ZIP already stored
- * @return true if candidate should replace current
- */
-static bool smallerZipWins(int candidate, int current) {
-    if (current == 0) return true;  // current not set yet
-    return candidate < current;
-}
-
-/**
- * @brief Update state extremes using one record.
- * @param stateMap Map of state → extremes (updates inside)
- * @param record One ZIP record
- */
-static void updateStateExtremes(map<string, StateExtremes>& stateMap,
-                                const ZipCodeRecord& record) {
-    const string& state = record.state;
-    StateExtremes& ex = stateMap[state]; // creates entry if missing
-
-    // EASTERNMOST (min longitude)
-    if (record.longitude < ex.minLongitude) {
-        ex.minLongitude = record.longitude;
-        ex.easternmost = record.zipCode;
-    } else if (record.longitude == ex.minLongitude &&
-               smallerZipWins(record.zipCode, ex.easternmost)) {
-        ex.easternmost = record.zipCode;
-    }
-
-    // WESTERNMOST (max longitude)
-    if (record.longitude > ex.maxLongitude) {
-        ex.maxLongitude = record.longitude;
-        ex.westernmost = record.zipCode;
-    } else if (record.longitude == ex.maxLongitude &&
-               smallerZipWins(record.zipCode, ex.westernmost)) {
-        ex.westernmost = record.zipCode;
-    }
-
-    // NORTHERNMOST (max latitude)
-    if (record.latitude > ex.maxLatitude) {
-        ex.maxLatitude = record.latitude;
-        ex.northernmost = record.zipCode;
-    } else if (record.latitude == ex.maxLatitude &&
-               smallerZipWins(record.zipCode, ex.northernmost)) {
-        ex.northernmost = record.zipCode;
-    }
-
-    // SOUTHERNMOST (min latitude)
-    if (record.latitude < ex.minLatitude) {
-        ex.minLatitude = record.latitude;
-        ex.southernmost = record.zipCode;
-    } else if (record.latitude == ex.minLatitude &&
-               smallerZipWins(record.zipCode, ex.southernmost)) {
-        ex.southernmost = record.zipCode;
-    }
-}
-
-/**
- * @brief Print the state extremes table (same idea as Project 1).
- * @param stateMap Map of state → extremes
- */
-static void printStateExtremesTable(const map<string, StateExtremes>& stateMap) {
-    cout << left;
-    cout << setw(8)  << "State"
-         << setw(15) << "Easternmost"
-         << setw(15) << "Westernmost"
-         << setw(15) << "Northernmost"
-         << setw(15) << "Southernmost"
-         << "\n";
-    cout << string(68, '-') << "\n";
-
-    for (const auto& entry : stateMap) {
-        const string& state = entry.first;
-        const StateExtremes& ex = entry.second;
-
-        cout << setw(8) << state;
-
-        cout << setfill('0') << setw(5) << ex.easternmost
-             << setfill(' ') << setw(10) << " ";
-
-        cout << setfill('0') << setw(5) << ex.westernmost
-             << setfill(' ') << setw(10) << " ";
-
-        cout << setfill('0') << setw(5) << ex.northernmost
-             << setfill(' ') << setw(10) << " ";
-
-        cout << setfill('0') << setw(5) << ex.southernmost
-             << setfill(' ') << "\n";
-    }
-
-    cout << "\nTotal states/territories: " << stateMap.size() << "\n";
-}
-
-/* ============================================================================
- *  LENGTH-INDICATED FILE HELPERS (ASCII fixed-width length = 10 digits)
- * ============================================================================
- */
-
-/**
- * @brief Write one “length-indicated” record to an output stream.
- *
- * Format:
- *   [10 digits length][space][text][newline]
- *
- * Example:
- *   0000000042 56301,St Cloud,MN,Stearns,45.5579,-94.1632
- *
- * @param out Output stream
- * @param text Record text (still CSV inside)
- * @return true if write succeeded
- */
-static bool writeLenLine(ostream& out, const string& text) {
-    if (text.empty()) return false;
-
-    out << setw(10) << setfill('0') << text.size()
-        << ' ' << text << '\n';
-
-    return static_cast<bool>(out);
-}
-
-/**
- * @brief Read one “length-indicated” record from an input stream.
- *
- * Steps:
- * 1) Read 10 chars (must be digits)
- * 2) Read one space
- * 3) Read exactly <length> chars into textOut
- * 4) Consume newline if present
- *
- * @param in Input stream
- * @param textOut Output record text (CSV-like)
- * @return true if record was read, false if EOF or format error
- */
-static bool readLenLine(istream& in, string& textOut) {
-    textOut.clear();
-
-    char lenBuf[10];
-    if (!in.read(lenBuf, 10)) return false; // EOF or error
-
-    for (int i = 0; i < 10; i++) {
-        if (!isdigit(static_cast<unsigned char>(lenBuf[i]))) return false;
-    }
-
-    char space;
-    if (!in.get(space) || space != ' ') return false;
-
-    int len = stoi(string(lenBuf, 10));
-    if (len < 0) return false;
-
-    textOut.resize(len);
-    if (len > 0 && !in.read(&textOut[0], len)) return false;
-
-    // Consume newline if present
-    if (in.peek() == '\n') in.get();
-    else if (in.peek() == '\r') { in.get(); if (in.peek() == '\n') in.get(); }
-
-    return true;
-}
-
 /* ============================================================================
  *  SIMPLE CSV FIELD SPLIT (handles basic quotes)
  * ============================================================================
@@ -273,6 +222,23 @@ static vector<string> splitCsvSimple(const string& line) {
     return fields;
 }
 
+/**
+ * @brief Fill a ZipCodeRecord from the fields of a record.
+ * @param f Fields (ZIP, place, state, county, lat, long)
+ * @param rec Receives the record
+ * @return false if there are fewer than 6 fields
+ */
+static bool recordFromFields(const vector<string>& f, ZipCodeRecord& rec) {
+    if (f.size() < 6) return false;
+    rec.zipCode = atoi(f[0].c_str());
+    rec.placeName = f[1];
+    rec.state = f[2];
+    rec.county = f[3];
+    rec.latitude = atof(f[4].c_str());
+    rec.longitude = atof(f[5].c_str());
+    return true;
+}
+
 /**
  * @brief Print one record with labels on ONE line (Part II requirement).
  * @param csvLine The record data (CSV text inside LEN)
@@ -328,17 +294,25 @@ static int analyzeCsvStreaming(const string& csvFile) {
         return 2;
     }
 
-    map<string, StateExtremes> stateMap;
+    // The extremes table is the k = 1 case of the per-state top-k.
+    StateSummaries summaries(1, false);
+    // Distinct places / counties per state, without keeping the names.
+    map<string, pair<HyperLogLog, HyperLogLog>> distinct;
 
     ZipCodeRecord rec;
     long long count = 0;
 
     while (buffer.readRecord(rec)) {
-        updateStateExtremes(stateMap, rec);
+        summaries.add(rec);
+        pair<HyperLogLog, HyperLogLog>& d = distinct[rec.state];
+        d.first.add(rec.placeName);
+        d.second.add(rec.county);
         count++;
     }
 
     buffer.close();
+    map<string, StateExtremes> stateMap;
+    summaries.toStateExtremes(stateMap);
 
     if (count == 0) {
         cerr << "Error: No valid records found.\n";
@@ -350,6 +324,18 @@ static int analyzeCsvStreaming(const string& csvFile) {
     cout << "Analysis Results:\n=================\n\n";
     printStateExtremesTable(stateMap);
 
+    cout << "\nDistinct places and counties (HyperLogLog, about "
+         << fixed << setprecision(1)
+         << 104.0 / sqrt(static_cast<double>(1u << HyperLogLog::kDefaultPrecision))
+         << "% error):\n";
+    cout << left << setw(8) << "State" << right << setw(10) << "Places" << setw(10)
+         << "Counties" << "\n";
+    cout << string(28, '-') << "\n";
+    for (const auto& entry : distinct) {
+        cout << left << setw(8) << entry.first << right << setw(10)
+             << llround(entry.second.first.estimate()) << setw(10)
+             << llround(entry.second.second.estimate()) << "\n";
+    }
     return 0;
 }
 
@@ -362,23 +348,35 @@ static int analyzeCsvStreaming(const string& csvFile) {
  * @brief Convert CSV → LEN file.
  *
  * We skip the CSV header row, then write:
- * 1) a LEN header record (simple placeholder text)
+ * 1) a LEN header record (record count 0 for now)
  * 2) each CSV record as a length-indicated record
+ * 3) the header again, in place, with the real record count
+ *
+ * Everything goes to a temp file which is published with publishFile()
+ * only after it is complete.
+ *
+ * The CSV is read twice: first the ZIPs alone, to find duplicated ones
+ * (see DuplicateKeys.h). They are reported; with a policy only one row of
+ * each is written, or under DuplicatePolicy::kError nothing is.
  *
  * @param csvFile Input CSV
  * @param lenFile Output LEN
+ * @param withChecksum true to store a CRC32C after every record
+ * @param policy What to do with the rows of a duplicated ZIP
  * @return exit code
  */
-static int makeLenFromCsv(const string& csvFile, const string& lenFile) {
+static int makeLenFromCsv(const string& csvFile, const string& lenFile,
+                          bool withChecksum, DuplicatePolicy policy) {
     ifstream in(csvFile);
     if (!in) {
         cerr << "Error: Cannot open CSV file '" << csvFile << "'\n";
         return 2;
     }
 
-    ofstream out(lenFile);
+    string tmpFile = tempPathFor(lenFile);
+    ofstream out(tmpFile);
     if (!out) {
-        cerr << "Error: Cannot create LEN file '" << lenFile << "'\n";
+        cerr << "Error: Cannot create LEN file '" << tmpFile << "'\n";
         return 3;
     }
 
@@ -386,30 +384,75 @@ static int makeLenFromCsv(const string& csvFile, const string& lenFile) {
     string header;
     if (!getline(in, header)) {
         cerr << "Error: CSV file is empty.\n";
+        out.close();
+        discardTemp(tmpFile);
         return 4;
     }
 
+    // Pass 1: the ZIP (first field) of every row.
+    const streampos dataStart = in.tellg();
+    DuplicateKeys keys;
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty()) keys.add(line.substr(0, line.find(',')));
+    }
+    keys.finish();
+    if (keys.duplicateKeys() > 0) {
+        cerr << (policy == DuplicatePolicy::kError ? "Error: " : "Warning: ")
+             << keys.duplicateKeys() << " duplicate ZIP(s), " << keys.extraRows()
+             << " extra row(s): " << keys.examples() << "\n";
+        if (policy == DuplicatePolicy::kError) {
+            out.close();
+            discardTemp(tmpFile);
+            return 7;
+        }
+    }
+    in.clear();
+    in.seekg(dataStart);
+
     // Write full header record using HeaderBuffer class
+    unsigned long long generation = HeaderBuffer::newGeneration();
     HeaderBuffer hbuf;
-    hbuf.buildDefault(lenFile + ".idx", 0);
+    const string checksumType = withChecksum ? "crc32c" : "none";
+    hbuf.buildDefault(lenFile + ".idx", 0, generation, checksumType);
     if (!hbuf.write(out)) {
         cerr << "Error: Failed to write LEN header.\n";
+        out.close();
+        discardTemp(tmpFile);
         return 5;
     }
 
     long long recCount = 0;
-    string line;
+    long long dropped = 0;
     while (getline(in, line)) {
         if (line.empty()) continue;
-        if (!writeLenLine(out, line)) {
+        if (!keys.keep(line.substr(0, line.find(',')), policy)) {
+            dropped++;
+            continue;
+        }
+        if (!writeLenRecord(out, line, withChecksum)) {
             cerr << "Warning: skipped a line that could not be written.\n";
             continue;
         }
         recCount++;
     }
 
+    // Rewrite the header with the final count (same size, see serialize()).
+    hbuf.buildDefault(lenFile + ".idx", static_cast<long>(recCount),
+                      generation, checksumType);
+    out.seekp(0);
+    bool ok = hbuf.write(out);
+    out.close();
+    if (!ok || !out || !publishFile(tmpFile, lenFile)) {
+        cerr << "Error: Failed to publish LEN file '" << lenFile << "'\n";
+        discardTemp(tmpFile);
+        return 6;
+    }
+
     cout << "Created LEN file: " << lenFile << "\n";
     cout << "Records written: " << recCount << "\n";
+    if (dropped > 0)
+        cout << "Duplicate rows dropped (" << duplicatePolicyName(policy) << "): " << dropped << "\n";
     return 0;
 }
 
@@ -425,50 +468,34 @@ static int makeLenFromCsv(const string& csvFile, const string& lenFile) {
  * That position is the “start of record” (the 10-digit length field).
  *
  * Index file format (simple):
- *   IDX,1
+ *   IDX,2,<generation of the .len file, 16 hex digits>
  *   56301 128
  *   02139 412
  *
+ * Older "IDX,1" files have no generation and are still accepted by search.
+ *
+ * A Bloom filter over all ZIPs is saved next to the index (<index>.bloom)
+ * so searches for missing ZIPs can stop before the index lookup, and an
+ * Eytzinger-ordered segment (<index>.eyt) for branch-free binary search.
+ *
+ * Each ZIP gets one entry; policy says which record a duplicated one gets
+ * (or rejects the file).
+ *
  * @param lenFile Input LEN data file
  * @param idxFile Output index file
+ * @param policy What to do with the records of a duplicated ZIP
  * @return exit code
  */
-static int buildIndexFromLen(const string& lenFile, const string& idxFile) {
-    ifstream in(lenFile);
-    if (!in) {
-        cerr << "Error: Cannot open LEN file '" << lenFile << "'\n";
-        return 2;
-    }
-
-    ofstream out(idxFile);
-    if (!out) {
-        cerr << "Error: Cannot create index file '" << idxFile << "'\n";
-        return 3;
-    }
-
-    string header;
-    if (!readLenLine(in, header)) {
-        cerr << "Error: LEN file is missing header or is corrupted.\n";
-        return 4;
-    }
-
-    out << "IDX,1\n";
-
+static int buildIndexFromLen(const string& lenFile, const string& idxFile,
+                             DuplicatePolicy policy) {
     long long entries = 0;
-    while (true) {
-        streampos pos = in.tellg();
-
-        string record;
-        if (!readLenLine(in, record)) break;
-
-        // ZIP is first field before comma
-        size_t comma = record.find(',');
-        if (comma == string::npos) continue;
-
-        string zip = record.substr(0, comma); // keep leading zeros if any
-        out << zip << " " << static_cast<long long>(pos) << "\n";
-        entries++;
+    string error, duplicates;
+    int rc = buildIndexFile(lenFile, idxFile, entries, error, policy, &duplicates);
+    if (rc != 0) {
+        cerr << "Error: " << error << "\n";
+        return rc;
     }
+    if (!duplicates.empty()) cerr << "Warning: " << duplicates << "\n";
 
     cout << "Created index file: " << idxFile << "\n";
     cout << "Index entries: " << entries << "\n";
@@ -480,30 +507,12 @@ static int buildIndexFromLen(const string& lenFile, const string& idxFile) {
  * ============================================================================
  */
 
-/**
- * @brief Load an index file into RAM.
- * @param idxFile Index filename
- * @return map ZIP(string) → offset
- */
-static unordered_map<string, streampos> loadIndex(const string& idxFile) {
-    unordered_map<string, streampos> idx;
-
-    ifstream in(idxFile);
-    if (!in) return idx;
-
-    string firstLine;
-    getline(in, firstLine); // IDX,1
-
-    string zip;
-    long long pos;
-    while (in >> zip >> pos) {
-        idx[zip] = static_cast<streampos>(pos);
-    }
-    return idx;
-}
-
 /**
  * @brief Search all -Z flags provided and print results.
+ *
+ * The index (plus any updates still in the WAL) is loaded into RAM by
+ * ZipDataStore; each record is then read straight from its offset.
+ *
  * @param lenFile Data file (.len)
  * @param idxFile Index file (.idx)
  * @param zips List of ZIP strings to search
@@ -512,42 +521,51 @@ static unordered_map<string, streampos> loadIndex(const string& idxFile) {
 static int searchZips(const string& lenFile,
                       const string& idxFile,
                       const vector<string>& zips) {
-    unordered_map<string, streampos> idx = loadIndex(idxFile);
-    if (idx.empty()) {
-        cerr << "Error: Index file could not be read or is empty: " << idxFile << "\n";
+    ZipDataStore store;
+    if (!store.open(lenFile, idxFile, false)) {
+        cerr << "Error: " << store.lastError() << "\n";
         return 2;
     }
-
-    ifstream data(lenFile);
-    if (!data) {
-        cerr << "Error: Cannot open LEN data file: " << lenFile << "\n";
-        return 3;
+    // An old header (like the committed zipcode_data.len) is only not
+    // checked, as in StoreReloader::validate(); any other header that does
+    // not parse is damage.
+    if (!store.headerParsed()) {
+        if (!HeaderBuffer::isOldFormat(store.headerText())) {
+            cerr << "Error: LEN data file header missing or corrupted.\n";
+            return 2;
+        }
+        cerr << "Warning: old header format; header not checked.\n";
     }
 
-    // Read and keep header in RAM (allowed)
-    string header;
-    if (!readLenLine(data, header)) {
-        cerr << "Error: LEN data file header missing or corrupted.\n";
-        return 4;
+    if (store.header().generation != 0 && store.indexGeneration() == 0) {
+        cerr << "Warning: index has no generation id; "
+             << "it cannot be checked against the data file.\n";
     }
 
     cout << "Using data file: " << lenFile << "\n";
     cout << "Using index file: " << idxFile << "\n";
-    cout << "Header: " << header << "\n\n";
-
-    for (const string& zip : zips) {
-        auto it = idx.find(zip);
-        if (it == idx.end()) {
+    if (store.usingSegment())
+        cout << "Index segment: version " << store.segment().version() << ", "
+             << store.segment().size() << " keys (shared mapping)\n";
+    if (store.walEntriesReplayed() > 0)
+        cout << "WAL updates applied: " << store.walEntriesReplayed() << "\n";
+    cout << "Header: " << store.headerText() << "\n\n";
+
+    vector<long long> offsets;
+    store.findBatch(zips, offsets);
+    for (size_t i = 0; i < zips.size(); i++) {
+        const string& zip = zips[i];
+        const long long offset = offsets[i];
+        if (offset < 0) {
             cout << "ZIP " << zip << " not found in file\n";
             continue;
         }
 
-        data.clear();
-        data.seekg(it->second);
-
         string recordLine;
-        if (!readLenLine(data, recordLine)) {
-            cout << "ZIP " << zip << " found in index but record could not be read (stale index)\n";
+        LenStatus status = store.readRecordAt(offset, recordLine);
+        if (status != LenStatus::Ok) {
+            cout << "ZIP " << zip << " found in index but record could not be read ("
+                 << lenStatusText(status) << ")\n";
             continue;
         }
 
@@ -558,55 +576,2145 @@ static int searchZips(const string& lenFile,
 }
 
 /* ============================================================================
- *  USAGE MESSAGE
+ *  MODE 6: UPDATE ONE RECORD IN PLACE (WAL) / CHECKPOINT
  * ============================================================================
  */
 
 /**
- * @brief Print usage instructions (simple).
- * @param prog program name
+ * @brief Join fields back into one CSV record (quotes fields with commas).
+ * @param fields Field values
+ * @return CSV text
  */
-static void printUsage(const string& prog) {
-    cerr << "USAGE:\n";
-    cerr << "  1) Analyze CSV (Project 1 style):\n";
-    cerr << "     " << prog << " <file.csv>\n\n";
-    cerr << "  2) Make LEN from CSV:\n";
-    cerr << "     " << prog << " --make-len <in.csv> <out.len>\n\n";
-    cerr << "  3) Build index from LEN:\n";
-    cerr << "     " << prog << " --build-index <data.len> <out.idx>\n\n";
-    cerr << "  4) Search ZIPs using LEN + IDX:\n";
-    cerr << "     " << prog << " --search <data.len> <data.idx> -Z56301 -Z99546 -Z99999\n";
+static string joinCsv(const vector<string>& fields) {
+    string out;
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (i > 0) out += ',';
+        if (fields[i].find(',') != string::npos) out += '"' + fields[i] + '"';
+        else out += fields[i];
+    }
+    return out;
+}
+
+/**
+ * @brief Change some fields of one ZIP's record without rebuilding files.
+ *
+ * The new version is appended to the data file and logged in the WAL
+ * (see ZipDataStore.h). Fields not given keep their current value.
+ *
+ * @param lenFile Data file (.len)
+ * @param idxFile Index file (.idx)
+ * @param zip ZIP to change
+ * @param changes Field number (1=Place ... 5=Long) → new value
+ * @param sync false to skip fdatasync (faster, not crash-safe)
+ * @return exit code
+ */
+static int updateZip(const string& lenFile, const string& idxFile,
+                     const string& zip, const map<int, string>& changes,
+                     bool sync) {
+    ZipDataStore store;
+    if (!store.open(lenFile, idxFile, true)) {
+        cerr << "Error: " << store.lastError() << "\n";
+        return 2;
+    }
+    store.setSyncEachUpdate(sync);
+
+    long long offset;
+    string recordLine;
+    if (!store.find(zip, offset)) {
+        cerr << "Error: ZIP " << zip << " not found in file\n";
+        return 3;
+    }
+    LenStatus status = store.readRecordAt(offset, recordLine);
+    if (status != LenStatus::Ok) {
+        cerr << "Error: current record could not be read ("
+             << lenStatusText(status) << ")\n";
+        return 4;
+    }
+
+    vector<string> f = splitCsvSimple(recordLine);
+    if (f.size() != 6) {
+        cerr << "Error: current record does not have 6 fields: " << recordLine << "\n";
+        return 4;
+    }
+    for (const auto& c : changes) f[c.first] = c.second;
+
+    // Extremes that are current now follow the change instead of going stale.
+    const string extFile = IncrementalExtremes::pathFor(idxFile);
+    IncrementalExtremes extremes;
+    bool haveExtremes = extremes.load(extFile, store.header().generation, store.lastSequence(),
+                                      store.liveRecords());
+
+    auto start = chrono::steady_clock::now();
+    if (!store.update(joinCsv(f))) {
+        cerr << "Error: " << store.lastError() << "\n";
+        return 5;
+    }
+    double micros = chrono::duration<double, micro>(
+        chrono::steady_clock::now() - start).count();
+
+    store.find(zip, offset);
+    cout << "Updated ZIP " << zip << " (new record at offset " << offset
+         << ", " << fixed << setprecision(1) << micros << " us"
+         << (sync ? "" : ", not synced") << ")\n" << defaultfloat;
+    cout << "Dead records: " << store.deadRecords() << " ("
+         << store.deadBytes() << " bytes), WAL entries since checkpoint: "
+         << store.pendingWalEntries() << "\n";
+    printLabeledOneLine(joinCsv(f));
+
+    ZipCodeRecord rec;
+    if (haveExtremes && recordFromFields(f, rec)) {
+        extremes.insert(rec);
+        if (extremes.save(extFile, store.header().generation, store.lastSequence(),
+                          store.liveRecords()))
+            cout << "State extremes updated: " << extFile << "\n";
+        else
+            cerr << "Warning: could not write state extremes " << extFile << "\n";
+    }
+    return 0;
+}
+
+/**
+ * @brief Delete ZIPs by writing tombstones to the WAL.
+ * @param lenFile Data file (.len)
+ * @param idxFile Index file (.idx)
+ * @param zips ZIPs to delete
+ * @return exit code
+ */
+static int deleteZips(const string& lenFile, const string& idxFile,
+                      const vector<string>& zips) {
+    ZipDataStore store;
+    if (!store.open(lenFile, idxFile, true)) {
+        cerr << "Error: " << store.lastError() << "\n";
+        return 2;
+    }
+
+    const string extFile = IncrementalExtremes::pathFor(idxFile);
+    IncrementalExtremes extremes;
+    bool haveExtremes = extremes.load(extFile, store.header().generation, store.lastSequence(),
+                                      store.liveRecords());
+
+    int rc = 0;
+    for (const string& zip : zips) {
+        if (store.remove(zip)) {
+            cout << "Deleted ZIP " << zip << "\n";
+            extremes.erase(atoi(zip.c_str()));
+        } else {
+            cerr << "Error: " << store.lastError() << "\n";
+            rc = 3;
+        }
+    }
+    cout << "Dead records: " << store.deadRecords() << " ("
+         << store.deadBytes() << " bytes), WAL entries since checkpoint: "
+         << store.pendingWalEntries() << "\n";
+    if (haveExtremes) {
+        if (extremes.save(extFile, store.header().generation, store.lastSequence(),
+                          store.liveRecords()))
+            cout << "State extremes updated: " << extFile << "\n";
+        else
+            cerr << "Warning: could not write state extremes " << extFile << "\n";
+    }
+    return rc;
+}
+
+/**
+ * @brief Fold the WAL into the index file and start an empty WAL.
+ * @param lenFile Data file (.len)
+ * @param idxFile Index file (.idx)
+ * @return exit code
+ */
+static int checkpointStore(const string& lenFile, const string& idxFile) {
+    ZipDataStore store;
+    if (!store.open(lenFile, idxFile, true)) {
+        cerr << "Error: " << store.lastError() << "\n";
+        return 2;
+    }
+    long long pending = store.pendingWalEntries();
+    if (!store.checkpoint()) {
+        cerr << "Error: " << store.lastError() << "\n";
+        return 3;
+    }
+    cout << "Checkpoint written: " << idxFile << " (" << pending
+         << " WAL entries folded in, " << store.liveRecords() << " entries)\n";
+    cout << "Dead records: " << store.deadRecords() << " ("
+         << store.deadBytes() << " bytes)\n";
+    return 0;
 }
 
 /* ============================================================================
- *  MAIN
+ *  MODE 7: COMPACTION
  * ============================================================================
  */
 
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        printUsage(argv[0]);
-        return 1;
+/**
+ * @brief Rewrite the data file with only live records (see LenCompactor.h).
+ *
+ * The copy runs on a background thread; searches by other processes keep
+ * using the old files until the new pair is renamed into place.
+ *
+ * @param lenFile Data file (.len)
+ * @param idxFile Index file (.idx)
+ * @return exit code
+ */
+static int compactStore(const string& lenFile, const string& idxFile) {
+    LenCompactor compactor;
+    if (!compactor.start(lenFile, idxFile)) {
+        cerr << "Error: " << compactor.lastError() << "\n";
+        return 2;
     }
 
-    string cmd = argv[1];
-
-    // MODE: --make-len in.csv out.len
-    if (cmd == "--make-len") {
-        if (argc != 4) {
-            printUsage(argv[0]);
-            return 1;
+    // Progress report while the background thread works.
+    while (compactor.running()) {
+        this_thread::sleep_for(chrono::milliseconds(200));
+        if (compactor.running() && compactor.recordsTotal() > 0) {
+            cout << "  copied " << compactor.recordsCopied() << " / "
+                 << compactor.recordsTotal() << " records\n";
         }
-        return makeLenFromCsv(argv[2], argv[3]);
     }
 
-    // MODE: --build-index data.len out.idx
-    if (cmd == "--build-index") {
-        if (argc != 4) {
-            printUsage(argv[0]);
-            return 1;
+    if (!compactor.wait()) {
+        cerr << "Error: " << compactor.lastError() << "\n";
+        return 3;
+    }
+
+    cout << "Compacted: " << lenFile << " and " << idxFile << "\n";
+    cout << "Live records: " << compactor.recordsTotal()
+         << " (" << compactor.recordsCaughtUp()
+         << " updated during compaction)\n";
+    cout << "Data file size: " << compactor.bytesBefore() << " -> "
+         << compactor.bytesAfter() << " bytes\n";
+    return 0;
+}
+
+/* ============================================================================
+ *  MODE 9: SHARDED DATASET
+ * ============================================================================
+ */
+
+/**
+ * @brief Split a CSV into N shards, index them and write the manifest.
+ * @param csvFile Input CSV
+ * @param manifestFile Output manifest
+ * @param shardCount Number of shards
+ * @param scheme "zip" (ZIP ranges) or "state"
+ * @param withChecksum true to store a CRC32C after every record
+ * @param policy What to do with the rows of a duplicated ZIP
+ * @return exit code
+ */
+static int makeShardSet(const string& csvFile, const string& manifestFile,
+                        int shardCount, const string& scheme,
+                        bool withChecksum, DuplicatePolicy policy) {
+    long long records = 0;
+    string error, duplicates;
+    int rc = makeShards(csvFile, manifestFile, shardCount, scheme,
+                        withChecksum, records, error, policy, &duplicates);
+    if (rc != 0) {
+        cerr << "Error: " << error << "\n";
+        return rc;
+    }
+    if (!duplicates.empty()) cerr << "Warning: " << duplicates << "\n";
+
+    ShardManifest manifest;
+    manifest.load(manifestFile);
+    cout << "Created shard manifest: " << manifestFile << " (" << shardCount
+         << " shards by " << scheme << ")\n";
+    for (const ShardEntry& e : manifest.shards())
+        cout << "  " << e.lenFile << "  " << e.key << "\n";
+    cout << "Records written: " << records << "\n";
+    return 0;
+}
+
+/**
+ * @brief Search ZIPs in a sharded dataset.
+ *
+ * With the "zip" scheme each ZIP goes to the one shard whose range holds
+ * it. With the "state" scheme every shard is asked; the Bloom filters
+ * turn away the shards that do not have it. Shards are opened the first
+ * time a ZIP needs them.
+ *
+ * @param manifestFile Shard manifest
+ * @param zips List of ZIP strings to search
+ * @return exit code
+ */
+static int searchShards(const string& manifestFile, const vector<string>& zips) {
+    ShardManifest manifest;
+    if (!manifest.load(manifestFile)) {
+        cerr << "Error: " << manifest.lastError() << "\n";
+        return 2;
+    }
+    const vector<ShardEntry>& shards = manifest.shards();
+
+    cout << "Using shard manifest: " << manifestFile << " (" << shards.size()
+         << " shards by " << manifest.scheme() << ")\n\n";
+
+    vector<unique_ptr<ZipDataStore>> stores(shards.size());
+    for (const string& zip : zips) {
+        vector<size_t> candidates;
+        int routed = manifest.shardForZip(zip);
+        if (routed >= 0) {
+            candidates.push_back(static_cast<size_t>(routed));
+        } else {
+            for (size_t i = 0; i < shards.size(); i++) candidates.push_back(i);
+        }
+
+        bool found = false;
+        for (size_t i : candidates) {
+            if (!stores[i]) {
+                stores[i].reset(new ZipDataStore());
+                if (!stores[i]->open(shards[i].lenFile, shards[i].idxFile, false)) {
+                    cerr << "Error: shard " << i << ": "
+                         << stores[i]->lastError() << "\n";
+                    return 2;
+                }
+            }
+
+            long long offset;
+            if (!stores[i]->find(zip, offset)) continue;
+            found = true;
+
+            string recordLine;
+            LenStatus status = stores[i]->readRecordAt(offset, recordLine);
+            if (status != LenStatus::Ok) {
+                cout << "ZIP " << zip << " found in shard " << i
+                     << " index but record could not be read ("
+                     << lenStatusText(status) << ")\n";
+            } else {
+                printLabeledOneLine(recordLine);
+            }
+            break;
+        }
+        if (!found) cout << "ZIP " << zip << " not found in file\n";
+    }
+    return 0;
+}
+
+/**
+ * @brief State extremes over all shards, one thread per shard.
+ * @param manifestFile Shard manifest
+ * @param threads Worker threads (0 = one per core)
+ * @return exit code
+ */
+static int analyzeShardSet(const string& manifestFile, unsigned threads) {
+    ShardManifest manifest;
+    if (!manifest.load(manifestFile)) {
+        cerr << "Error: " << manifest.lastError() << "\n";
+        return 2;
+    }
+
+    map<string, StateExtremes> stateMap;
+    long long count = 0;
+    string error;
+    if (!analyzeShards(manifest, threads, stateMap, count, error)) {
+        cerr << "Error: " << error << "\n";
+        return 4;
+    }
+    if (count == 0) {
+        cerr << "Error: No valid records found.\n";
+        return 3;
+    }
+
+    cout << "Reading ZIP code data from: " << manifestFile << " ("
+         << manifest.shards().size() << " shards)\n";
+    cout << "Total records read: " << count << "\n\n";
+    cout << "Analysis Results:\n=================\n\n";
+    printStateExtremesTable(stateMap);
+    return 0;
+}
+
+/* ============================================================================
+ *  MODE 10: TCP QUERY SERVER / LOAD GENERATOR
+ * ============================================================================
+ */
+
+/// Server the signal handler stops (only one runs per process)
+static ZipServer* runningServer = nullptr;
+
+/**
+ * @brief SIGINT/SIGTERM handler: asks the event loop to return.
+ *        SIGHUP handler: asks it to reload the data/index pair.
+ */
+static void serverSignal(int sig) {
+    if (!runningServer) return;
+    if (sig == SIGHUP) runningServer->requestReload();
+    else runningServer->requestStop();
+}
+
+/**
+ * @brief Serve lookups for one data/index pair on 127.0.0.1:port.
+ * @param lenFile Data file (.len)
+ * @param idxFile Index file (.idx)
+ * @param port TCP port
+ * @param watch true to reload when the files are replaced
+ * @param warm true to replay and record the warmup profile
+ * @param lockIndex true to lock the index in RAM (implies warm)
+ * @return exit code
+ */
+static int serveZips(const string& lenFile, const string& idxFile, uint16_t port,
+                     bool watch, bool warm, bool lockIndex) {
+    ZipServer server;
+    if (warm || lockIndex) server.enableWarmup(lockIndex);
+    if (!server.start(lenFile, idxFile, port, watch)) {
+        cerr << "Error: " << server.lastError() << "\n";
+        return 2;
+    }
+
+    runningServer = &server;
+    signal(SIGINT, serverSignal);
+    signal(SIGTERM, serverSignal);
+    signal(SIGHUP, serverSignal);
+
+    cout << "Serving " << lenFile << " (" << server.liveRecords()
+         << " records) on 127.0.0.1:" << server.port() << "\n";
+    cout << "Stop with Ctrl-C; reload with SIGHUP"
+         << (watch ? " or by replacing the files" : "") << ".\n" << flush;
+
+    bool ok = server.run();
+    runningServer = nullptr;
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGHUP, SIG_DFL);
+
+    cout << "Connections: " << server.connectionsAccepted()
+         << ", requests: " << server.requestsServed()
+         << ", lookups: " << server.lookupsServed()
+         << ", reloads: " << server.reloads() << "\n";
+    if (!ok) {
+        cerr << "Error: " << server.lastError() << "\n";
+        return 3;
+    }
+    return 0;
+}
+
+/**
+ * @brief Drive a running server and report QPS and tail latency.
+ * @param options Connections, duration, pipeline depth, batch size
+ * @return exit code
+ */
+static int loadGenerator(const LoadGenOptions& options) {
+    LoadGenReport r;
+    string error;
+    if (!runLoadGen(options, r, error)) {
+        cerr << "Error: " << error << "\n";
+        return 2;
+    }
+
+    cout << "Connections: " << options.connections << ", pipeline depth: "
+         << options.depth << ", ZIPs per request: " << options.batch << "\n";
+    cout << fixed << setprecision(0);
+    cout << "Requests: " << r.requests << " in " << setprecision(2) << r.seconds
+         << " s" << setprecision(0) << " (" << r.requests / r.seconds
+         << " req/s, " << r.lookups / r.seconds << " lookups/s)\n";
+    cout << "Found: " << r.found << " of " << r.lookups;
+    if (r.errors > 0) cout << ", bad answers: " << r.errors;
+    cout << "\n" << setprecision(1);
+    cout << "Latency us: p50 " << r.p50Us << "  p90 " << r.p90Us << "  p99 "
+         << r.p99Us << "  p99.9 " << r.p999Us << "  max " << r.maxUs << "\n";
+    return r.errors > 0 ? 3 : 0;
+}
+
+/* ============================================================================
+ *  MODE 11: SHARED INDEX SEGMENT
+ * ============================================================================
+ */
+
+/**
+ * @brief Bytes currently allocated on the heap (0 where not known).
+ */
+static size_t heapInUse() {
+#ifdef __GLIBC__
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Load the index (with the WAL) once and publish it as a segment.
+ *
+ * Worker processes then map the segment instead of each parsing the .idx
+ * into their own hash map.
+ *
+ * @param lenFile Data file (.len)
+ * @param idxFile Index file (.idx)
+ * @param segmentFile Output segment (e.g. under /dev/shm)
+ * @param layout Order of the keys in the segment
+ * @return exit code
+ */
+static int publishSegment(const string& lenFile, const string& idxFile,
+                          const string& segmentFile, IndexSegment::Layout layout) {
+    // Heap taken by the parsed index, to compare with the segment's size.
+    const size_t heapBefore = heapInUse();
+    ZipDataStore store;
+    if (!store.open(lenFile, idxFile, false)) {
+        cerr << "Error: " << store.lastError() << "\n";
+        return 2;
+    }
+    const size_t heapIndex = heapInUse() - heapBefore;
+
+    unsigned long long version = 0;
+    string error;
+    if (!IndexSegment::publish(store.index(), store.header().generation,
+                               store.lastSequence(), segmentFile, version, error, layout)) {
+        cerr << "Error: " << error << "\n";
+        return 3;
+    }
+
+    // Time a worker's attach, to show what the segment saves.
+    auto t0 = chrono::steady_clock::now();
+    IndexSegment probe;
+    bool attached = probe.attach(segmentFile);
+    double attachUs = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+
+    cout << "Published index segment: " << segmentFile << " (version " << version
+         << ", " << store.liveRecords() << " keys)\n";
+    if (attached) {
+        const double keys = static_cast<double>(max<size_t>(1, probe.size()));
+        cout << "Attach time: " << fixed << setprecision(1) << attachUs << " us\n";
+        cout << "Index memory: hash map " << heapIndex / 1024 << " KB ("
+             << heapIndex / keys << " bytes/key), segment " << probe.mappedBytes() / 1024
+             << " KB (" << probe.mappedBytes() / keys << " bytes/key)\n";
+    }
+    if (attached && !probe.model().empty())
+        cout << "Learned model: " << LearnedIndex::pathFor(segmentFile) << " ("
+             << probe.model().segmentCount() << " segments, " << probe.model().levelCount()
+             << " levels, " << probe.model().sizeBytes() << " bytes)\n";
+    return 0;
+}
+
+/* ============================================================================
+ *  MODE 12: WARMUP
+ * ============================================================================
+ */
+
+/**
+ * @brief Read the index and the profiled hot data blocks into the page cache.
+ *
+ * Meant for a boot script, before --serve (or other readers) start. The
+ * reads are only requested; the kernel does them in the background.
+ *
+ * @param lenFile Data file (.len)
+ * @param idxFile Index file (.idx) or segment
+ * @param lockIndex true to also try to lock a segment in RAM (held only
+ *        while this process runs, so only a check of the limits)
+ * @return exit code
+ */
+static int warmupPair(const string& lenFile, const string& idxFile, bool lockIndex) {
+    ZipDataStore store;
+    if (!store.open(lenFile, idxFile, false)) {
+        cerr << "Error: " << store.lastError() << "\n";
+        return 2;
+    }
+    // A parsed .idx lives in this process only; locking it here (mlockall)
+    // would end at exit and leave nothing pinned. --serve --mlock locks it.
+    if (lockIndex && !store.usingSegment()) {
+        cerr << "Error: --warmup --mlock needs an index segment; a plain .idx is "
+             << "only locked by the process that serves it (--serve --mlock).\n";
+        return 1;
+    }
+
+    auto t0 = chrono::steady_clock::now();
+    bool indexOk = store.warmIndex(lockIndex);
+    if (!indexOk) cerr << "Warning: " << store.lastError() << "\n";
+
+    const string path = WarmupProfile::pathFor(lenFile);
+    WarmupProfile profile;
+    long long bytes = 0;
+    bool haveProfile = profile.load(path, store.header().generation);
+    if (haveProfile) bytes = profile.prefetch(store);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    if (store.usingSegment())
+        cout << "Index segment: " << store.segment().mappedBytes() / 1024 << " KB read in"
+             << (lockIndex && indexOk ? " and locked" : "") << "\n";
+    else
+        cout << "Index: " << store.liveRecords() << " keys loaded\n";
+    if (haveProfile)
+        cout << "Data: " << profile.hotBlocks() << " hot blocks (" << bytes / 1024
+             << " KB) requested from " << path << "\n";
+    else
+        cout << "Data: no profile for this generation (" << path
+             << " is written by --serve ... --warm)\n";
+    cout << "Time: " << fixed << setprecision(1) << ms << " ms\n";
+    return indexOk ? 0 : 3;
+}
+
+/* ============================================================================
+ *  MODE 13: INDEX LAYOUT BENCHMARK
+ * ============================================================================
+ */
+
+/**
+ * @brief Time hash map, lower_bound and Eytzinger lookups for each key count.
+ * @param sizes Key counts
+ * @return exit code
+ */
+static int benchIndex(const vector<size_t>& sizes) {
+    const size_t lookups = 5000000;
+    cout << "Random hits, " << lookups << " lookups per structure (ns per lookup)\n";
+    cout << "Batch: " << kBatchLanes << " lower_bounds in lockstep ("
+         << (batchSearchAvx2() ? "AVX2" : "scalar") << ")\n";
+    cout << left << setw(12) << "Keys" << right << setw(16) << "unordered_map"
+         << setw(14) << "lower_bound" << setw(12) << "Eytzinger" << setw(10) << "Learned"
+         << setw(12) << "Elias-Fano" << setw(10) << "Batch"
+         << "   Learned model; Elias-Fano size, in-order scan\n";
+    cout << fixed << setprecision(1);
+    for (size_t keys : sizes) {
+        IndexBenchResult r;
+        if (!benchIndexLayouts(keys, lookups, r)) {
+            cerr << "Error: lookups disagree at " << keys << " keys\n";
+            return 2;
+        }
+        cout << left << setw(12) << keys << right << setw(16);
+        if (r.mapSkipped) cout << "(too big)";
+        else cout << r.mapNs;
+        cout << setw(14) << r.sortedNs << setw(12) << r.eytzingerNs << setw(10) << r.learnedNs
+             << setw(12) << r.eliasFanoNs << setw(10) << r.batchNs << "   "
+             << r.modelSegments << " segments, " << r.modelBytes << " bytes; "
+             << r.eliasFanoBitsPerKey << " bits/key, " << r.eliasFanoScanNs << " ns/key\n"
+             << flush;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ *  MODE 14: PLACE NAME COMPLETION
+ * ============================================================================
+ */
+
+/**
+ * @brief Call fn(offset, fields) for every live record of a pair.
+ * @param store Opened pair (with an .idx, so all live ZIPs are in RAM)
+ * @return false (after a message) if a record could not be read
+ */
+template <typename Fn>
+static bool forEachLiveRecord(const ZipDataStore& store, Fn fn) {
+    for (const auto& entry : store.index()) {
+        string recordLine;
+        LenStatus status = store.readRecordAt(entry.second, recordLine);
+        if (status != LenStatus::Ok) {
+            cerr << "Error: record of ZIP " << entry.first << " could not be read ("
+                 << lenStatusText(status) << ")\n";
+            return false;
+        }
+        vector<string> f = splitCsvSimple(recordLine);
+        if (f.size() >= 4) fn(entry.second, f);
+    }
+    return true;
+}
+
+/**
+ * @brief Load the place trie of a pair, or build (and save) it if stale.
+ * @param store Opened pair (with an .idx, so all live ZIPs are in RAM)
+ * @param idxFile Index file; the trie is <idxFile>.trie
+ * @param trie Receives the trie
+ * @return false if records could not be read
+ */
+static bool loadPlaceTrie(const ZipDataStore& store, const string& idxFile, PlaceTrie& trie) {
+    const string path = PlaceTrie::pathFor(idxFile);
+    if (trie.load(path, store.header().generation, store.lastSequence(), store.liveRecords())) {
+        cout << "Place trie: " << path << "\n";
+        return true;
+    }
+
+    auto t0 = chrono::steady_clock::now();
+    vector<PlaceTrie::PlaceZip> records;
+    records.reserve(store.liveRecords());
+    bool ok = forEachLiveRecord(store, [&](long long, const vector<string>& f) {
+        records.push_back(PlaceTrie::PlaceZip{f[1], f[2], static_cast<uint32_t>(atol(f[0].c_str()))});
+    });
+    if (!ok) return false;
+    trie.build(records);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    cout << "Place trie built: " << trie.placeCount() << " places, " << trie.nodeCount()
+         << " nodes, " << trie.sizeBytes() / 1024 << " KB in " << fixed << setprecision(1)
+         << ms << " ms\n";
+    if (!trie.save(path, store.header().generation, store.lastSequence(), store.liveRecords()))
+        cerr << "Warning: could not write place trie " << path << "\n";
+    return true;
+}
+
+/**
+ * @brief Print the top places whose names start with a prefix, with their ZIPs.
+ * @param lenFile Data file (.len)
+ * @param idxFile Index file (.idx; a segment does not list the ZIPs)
+ * @param prefix Typed text
+ * @param state Only this state ("" for all)
+ * @param top Number of places to show
+ * @return exit code
+ */
+static int completePlace(const string& lenFile, const string& idxFile, const string& prefix,
+                         const string& state, size_t top) {
+    ZipDataStore store;
+    if (!store.open(lenFile, idxFile, false)) {
+        cerr << "Error: " << store.lastError() << "\n";
+        return 2;
+    }
+    if (store.usingSegment()) {
+        cerr << "Error: --complete needs the .idx file, not an index segment\n";
+        return 2;
+    }
+
+    PlaceTrie trie;
+    if (!loadPlaceTrie(store, idxFile, trie)) return 3;
+
+    vector<PlaceTrie::Completion> matches;
+    size_t places = 0, zips = 0;
+    auto t0 = chrono::steady_clock::now();
+    trie.complete(prefix, state, top, matches, places, zips);
+    double us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+
+    cout << "Prefix \"" << PlaceTrie::normalize(prefix, true) << "\": " << places
+         << " places, " << zips << " ZIPs (" << fixed << setprecision(1) << us << " us)\n";
+    const size_t shownZips = 10;
+    for (const auto& m : matches) {
+        cout << "  " << m.name << ", " << m.state << " (" << m.zipCount << "):";
+        for (size_t i = 0; i < m.zipCount && i < shownZips; i++) cout << " " << m.zips[i];
+        if (m.zipCount > shownZips) cout << " ... +" << m.zipCount - shownZips << " more";
+        cout << "\n";
+    }
+    return 0;
+}
+
+/* ============================================================================
+ *  MODE 15: INVERTED INDEX QUERIES
+ * ============================================================================
+ */
+
+/**
+ * @brief Load the inverted index of a pair, or build (and save) it if stale.
+ * @param store Opened pair (with an .idx)
+ * @param idxFile Index file; the inverted index is <idxFile>.inv
+ * @param inv Receives the index
+ * @return false if records could not be read
+ */
+static bool loadInvertedIndex(const ZipDataStore& store, const string& idxFile,
+                              InvertedIndex& inv) {
+    const string path = InvertedIndex::pathFor(idxFile);
+    if (inv.load(path, store.header().generation, store.lastSequence(), store.liveRecords())) {
+        cout << "Inverted index: " << path << "\n";
+        return true;
+    }
+
+    auto t0 = chrono::steady_clock::now();
+    vector<InvertedIndex::Record> records;
+    records.reserve(store.liveRecords());
+    bool ok = forEachLiveRecord(store, [&](long long offset, const vector<string>& f) {
+        records.push_back(InvertedIndex::Record{f[2], f[3], f[1], static_cast<uint64_t>(offset)});
+    });
+    if (!ok) return false;
+    inv.build(records);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    cout << "Inverted index built: " << inv.termCount() << " terms, " << inv.postingTotal()
+         << " postings, " << inv.sizeBytes() / 1024 << " KB in " << fixed << setprecision(1)
+         << ms << " ms\n";
+    if (!inv.save(path, store.header().generation, store.lastSequence(), store.liveRecords()))
+        cerr << "Warning: could not write inverted index " << path << "\n";
+    return true;
+}
+
+/**
+ * @brief Print the records that match state / county / place predicates.
+ * @param lenFile Data file (.len)
+ * @param idxFile Index file (.idx)
+ * @param state State, or "" (a county needs one)
+ * @param counties Counties of that state
+ * @param places Place names
+ * @param any true to OR the predicates instead of ANDing them
+ * @param countOnly true to print only the number of matches
+ * @return exit code
+ */
+static int whereQuery(const string& lenFile, const string& idxFile, const string& state,
+                      const vector<string>& counties, const vector<string>& places,
+                      bool any, bool countOnly) {
+    ZipDataStore store;
+    if (!store.open(lenFile, idxFile, false)) {
+        cerr << "Error: " << store.lastError() << "\n";
+        return 2;
+    }
+    if (store.usingSegment()) {
+        cerr << "Error: --where needs the .idx file, not an index segment\n";
+        return 2;
+    }
+
+    InvertedIndex inv;
+    if (!loadInvertedIndex(store, idxFile, inv)) return 3;
+
+    // A county term already names its state.
+    vector<string> terms;
+    for (const string& county : counties) terms.push_back(InvertedIndex::countyTerm(state, county));
+    if (!state.empty() && counties.empty()) terms.push_back(InvertedIndex::stateTerm(state));
+    for (const string& place : places) terms.push_back(InvertedIndex::placeTerm(place));
+
+    vector<uint64_t> offsets;
+    size_t steps = 0;
+    auto t0 = chrono::steady_clock::now();
+    if (any) inv.unite(terms, offsets, steps);
+    else inv.intersect(terms, offsets, steps);
+    double us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+
+    size_t postings = 0;
+    for (const string& term : terms) {
+        size_t n = inv.postingCount(term);
+        cout << "  " << term << ": " << n << " records\n";
+        postings += n;
+    }
+    cout << offsets.size() << " matching records (" << (any ? "any" : "all") << " of "
+         << terms.size() << " terms; " << steps << " cursor moves over " << postings
+         << " postings; " << fixed << setprecision(1) << us << " us)\n";
+    if (countOnly) return 0;
+
+    // Offsets are sorted, so the records are read front to back.
+    for (uint64_t offset : offsets) {
+        string recordLine;
+        LenStatus status = store.readRecordAt(static_cast<long long>(offset), recordLine);
+        if (status != LenStatus::Ok) {
+            cout << "Record at " << offset << " could not be read (" << lenStatusText(status)
+                 << ")\n";
+            continue;
+        }
+        printLabeledOneLine(recordLine);
+    }
+    return 0;
+}
+
+/* ============================================================================
+ *  MODE 16: RADIUS / NEAREST SEARCH
+ * ============================================================================
+ */
+
+/**
+ * @brief Parse a number that must lie in [low, high].
+ * @param text Command line argument
+ * @param low Smallest value allowed
+ * @param high Largest value allowed
+ * @param value Receives the number
+ * @return false if text is not one finite number in range
+ */
+static bool parseNumberIn(const char* text, double low, double high, double& value) {
+    char* end = nullptr;
+    value = strtod(text, &end);
+    return end != text && *end == '\0' && isfinite(value) && value >= low && value <= high;
+}
+
+/**
+ * @brief Records within a radius of a point (or the k nearest), nearest first.
+ * @param lenFile Data file (.len)
+ * @param idxFile Index file (.idx); the cell index is <idxFile>.geo
+ * @param latitude Center latitude
+ * @param longitude Center longitude
+ * @param radiusKm Radius in km (when nearestK is 0)
+ * @param nearestK Number of nearest records, or 0 for a radius query
+ * @param countOnly true to print only the number of matches
+ * @return exit code
+ */
+static int nearQuery(const string& lenFile, const string& idxFile, double latitude,
+                     double longitude, double radiusKm, size_t nearestK, bool countOnly) {
+    ZipDataStore store;
+    if (!store.open(lenFile, idxFile, false)) {
+        cerr << "Error: " << store.lastError() << "\n";
+        return 2;
+    }
+    if (store.usingSegment()) {
+        cerr << "Error: --near / --nearest need the .idx file, not an index segment\n";
+        return 2;
+    }
+
+    const string path = GeoIndex::pathFor(idxFile);
+    GeoIndex geo;
+    if (geo.load(path, store.header().generation, store.lastSequence(), store.liveRecords())) {
+        cout << "Geo index: " << path << "\n";
+    } else {
+        vector<GeoIndex::Record> records;
+        records.reserve(store.liveRecords());
+        bool ok = forEachLiveRecord(store, [&](long long offset, const vector<string>& f) {
+            if (f.size() < 6) return;
+            char* latEnd = nullptr;
+            char* lonEnd = nullptr;
+            double lat = strtod(f[4].c_str(), &latEnd);
+            double lon = strtod(f[5].c_str(), &lonEnd);
+            if (latEnd != f[4].c_str() && lonEnd != f[5].c_str())
+                records.push_back(GeoIndex::Record{lat, lon, static_cast<uint64_t>(offset)});
+        });
+        if (!ok) return 3;
+        geo.build(records);
+        cout << "Geo index built: " << geo.size() << " records, " << geo.sizeBytes() / 1024
+             << " KB\n";
+        if (!geo.save(path, store.header().generation, store.lastSequence(), store.liveRecords()))
+            cerr << "Warning: could not write geo index " << path << "\n";
+    }
+
+    vector<GeoIndex::Hit> hits;
+    GeoIndex::QueryStats stats;
+    auto t0 = chrono::steady_clock::now();
+    if (nearestK > 0) geo.nearest(latitude, longitude, nearestK, hits, stats);
+    else geo.near(latitude, longitude, radiusKm, hits, stats);
+    double us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+
+    if (nearestK > 0) cout << hits.size() << " nearest records (";
+    else cout << hits.size() << " records within " << radiusKm << " km (";
+    cout << stats.ranges << " cell ranges, " << stats.candidates << " candidates, "
+         << geoIsaName(geoKernelIsa()) << " distances; " << fixed << setprecision(1) << us
+         << " us)\n";
+    if (countOnly) return 0;
+
+    for (const GeoIndex::Hit& hit : hits) {
+        string recordLine;
+        LenStatus status = store.readRecordAt(static_cast<long long>(hit.offset), recordLine);
+        if (status != LenStatus::Ok) {
+            cout << "Record at " << hit.offset << " could not be read ("
+                 << lenStatusText(status) << ")\n";
+            continue;
+        }
+        cout << setw(8) << hit.distanceKm << " km  ";
+        printLabeledOneLine(recordLine);
+    }
+    return 0;
+}
+
+/* ============================================================================
+ *  MODE 17: DISTANCE KERNEL BENCHMARK
+ * ============================================================================
+ */
+
+/**
+ * @brief Time libm and the SIMD distance kernels over random points.
+ * @param points Points per scan
+ * @return exit code
+ */
+static int benchGeo(size_t points) {
+    const size_t queries = 10;
+    GeoBenchResult r;
+    benchGeoKernels(points, queries, r);
+
+    cout << points << " random points, " << queries << " query points (ns per distance)\n";
+    cout << fixed << setprecision(2);
+    cout << left << setw(10) << "Kernel" << right << setw(12) << "Haversine" << setw(18)
+         << "Equirectangular" << "   Max error vs libm (m): all, <= 1000 km\n";
+    cout << left << setw(10) << "libm" << right << setw(12) << r.libmNs << setw(18) << "-"
+         << "\n";
+    for (const GeoBenchRow& row : r.rows) {
+        cout << left << setw(10) << geoIsaName(row.isa) << right << setw(12) << row.haversineNs
+             << setw(18) << row.equirectangularNs << "   " << scientific << setprecision(1)
+             << row.maxErrorM << ", " << row.maxErrorNearM << fixed << setprecision(2) << "\n";
+    }
+    return 0;
+}
+
+/* ============================================================================
+ *  MODE 18: STATE HULLS
+ * ============================================================================
+ */
+
+/**
+ * @brief Print the convex hull and bounding box of every state's ZIPs.
+ * @param file CSV file, or data file (.len) of a pair
+ * @param idxFile Index file of the pair ("" for a CSV file)
+ * @param wkt WKT instead of GeoJSON
+ * @param threads Hull threads (0 = one per core)
+ * @return exit code
+ */
+static int stateHulls(const string& file, const string& idxFile, bool wkt, unsigned threads) {
+    auto t0 = chrono::steady_clock::now();
+    StateHullBuilder builder;
+    if (idxFile.empty()) {
+        ZipCodeBuffer buffer;
+        if (!buffer.open(file)) {
+            cerr << "Error: Could not open CSV file '" << file << "'\n";
+            return 2;
+        }
+        ZipCodeRecord rec;
+        while (buffer.readRecord(rec)) builder.add(rec);
+        buffer.close();
+    } else {
+        ZipDataStore store;
+        if (!store.open(file, idxFile, false)) {
+            cerr << "Error: " << store.lastError() << "\n";
+            return 2;
+        }
+        ZipCodeRecord rec;
+        bool ok = forEachLiveRecord(store, [&](long long, const vector<string>& f) {
+            if (recordFromFields(f, rec)) builder.add(rec);
+        });
+        if (!ok) return 4;
+    }
+    if (builder.records() == 0) {
+        cerr << "Error: No valid records found.\n";
+        return 3;
+    }
+    auto t1 = chrono::steady_clock::now();
+
+    map<string, StateHull> hulls;
+    builder.finish(threads, hulls);
+    auto t2 = chrono::steady_clock::now();
+
+    if (wkt) writeHullsWkt(cout, hulls);
+    else writeHullsGeoJson(cout, hulls);
+
+    size_t candidates = 0, vertices = 0;
+    for (const auto& entry : hulls) {
+        candidates += entry.second.candidates;
+        vertices += entry.second.hull.size();
+    }
+    cerr << hulls.size() << " states, " << builder.records() << " records, " << candidates
+         << " hull candidates after pruning, " << vertices << " hull vertices; read "
+         << fixed << setprecision(1)
+         << chrono::duration<double, milli>(t1 - t0).count() << " ms, hulls "
+         << chrono::duration<double, milli>(t2 - t1).count() << " ms\n";
+    return 0;
+}
+
+/* ============================================================================
+ *  MODE 19: STATE EXTREMES OF A PAIR
+ * ============================================================================
+ */
+
+/**
+ * @brief Print the state extremes table of a pair's live records.
+ * @param lenFile Data file (.len)
+ * @param idxFile Index file (.idx); the extremes are <idxFile>.ext
+ * @return exit code
+ */
+static int pairExtremes(const string& lenFile, const string& idxFile) {
+    ZipDataStore store;
+    if (!store.open(lenFile, idxFile, false)) {
+        cerr << "Error: " << store.lastError() << "\n";
+        return 2;
+    }
+
+    const string path = IncrementalExtremes::pathFor(idxFile);
+    IncrementalExtremes extremes;
+    auto t0 = chrono::steady_clock::now();
+    if (extremes.load(path, store.header().generation, store.lastSequence(),
+                      store.liveRecords())) {
+        cout << "State extremes: " << path << "\n";
+    } else {
+        ZipCodeRecord rec;
+        bool ok = forEachLiveRecord(store, [&](long long, const vector<string>& f) {
+            if (recordFromFields(f, rec)) extremes.insert(rec);
+        });
+        if (!ok) return 4;
+        cout << "State extremes built from " << extremes.size() << " records\n";
+        if (!extremes.save(path, store.header().generation, store.lastSequence(),
+                           store.liveRecords()))
+            cerr << "Warning: could not write state extremes " << path << "\n";
+    }
+    map<string, StateExtremes> stateMap;
+    extremes.snapshot(stateMap);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    if (stateMap.empty()) {
+        cerr << "Error: No valid records found.\n";
+        return 3;
+    }
+
+    cout << "Total records: " << extremes.size() << " (" << fixed << setprecision(1) << ms
+         << " ms)\n\n";
+    cout << "Analysis Results:\n=================\n\n";
+    printStateExtremesTable(stateMap);
+    return 0;
+}
+
+/* ============================================================================
+ *  MODE 20: TOP-K AND QUANTILES PER STATE
+ * ============================================================================
+ */
+
+/**
+ * @brief Summarize the live records of a pair, split over threads.
+ *
+ * Each thread reads its own contiguous run of records (in file order) into
+ * its own summaries; they are merged in run order.
+ *
+ * @param store Opened pair
+ * @param threads Worker threads (0 = one per core)
+ * @param summaries Receives the merged summaries
+ * @return false (after a message) if a record could not be read
+ */
+static bool summarizePair(const ZipDataStore& store, unsigned threads,
+                          StateSummaries& summaries) {
+    vector<long long> offsets;
+    offsets.reserve(store.liveRecords());
+    for (const auto& e : store.index()) offsets.push_back(e.second);
+    sort(offsets.begin(), offsets.end());
+
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    threads = static_cast<unsigned>(max<size_t>(1, min<size_t>(threads, offsets.size())));
+    vector<StateSummaries> partial(threads, StateSummaries(summaries.k(),
+                                                           summaries.hasQuantiles()));
+    vector<string> errors(threads);
+    auto work = [&](unsigned t) {
+        const size_t begin = offsets.size() * t / threads;
+        const size_t end = offsets.size() * (t + 1) / threads;
+        string text;
+        ZipCodeRecord rec;
+        for (size_t i = begin; i < end; i++) {
+            LenStatus status = store.readRecordAt(offsets[i], text);
+            if (status != LenStatus::Ok) {
+                errors[t] = "record at offset " + to_string(offsets[i]) +
+                            " could not be read (" + lenStatusText(status) + ")";
+                return;
+            }
+            if (recordFromFields(splitCsvSimple(text), rec)) partial[t].add(rec);
+        }
+    };
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads; t++) pool.emplace_back(work, t);
+    work(0);
+    for (thread& th : pool) th.join();
+
+    for (unsigned t = 0; t < threads; t++) {
+        if (!errors[t].empty()) {
+            cerr << "Error: " << errors[t] << "\n";
+            return false;
+        }
+        summaries.merge(partial[t]);
+    }
+    return true;
+}
+
+/**
+ * @brief Print the k most extreme ZIPs and coordinate quantiles per state.
+ * @param file CSV file, or data file (.len) of a pair
+ * @param idxFile Index file of the pair ("" for a CSV file)
+ * @param k ZIPs per state and direction
+ * @param quantiles Quantiles to print (0..1)
+ * @param state Only this state ("" for all)
+ * @param threads Reader threads for a pair (0 = one per core)
+ * @return exit code
+ */
+static int topPerState(const string& file, const string& idxFile, size_t k,
+                       const vector<double>& quantiles, const string& state, unsigned threads) {
+    auto t0 = chrono::steady_clock::now();
+    StateSummaries summaries(k, !quantiles.empty());
+    if (idxFile.empty()) {
+        ZipCodeBuffer buffer;
+        if (!buffer.open(file)) {
+            cerr << "Error: Could not open CSV file '" << file << "'\n";
+            return 2;
+        }
+        ZipCodeRecord rec;
+        while (buffer.readRecord(rec)) summaries.add(rec);
+        buffer.close();
+    } else {
+        ZipDataStore store;
+        if (!store.open(file, idxFile, false)) {
+            cerr << "Error: " << store.lastError() << "\n";
+            return 2;
+        }
+        if (!summarizePair(store, threads, summaries)) return 4;
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    if (summaries.states().empty()) {
+        cerr << "Error: No valid records found.\n";
+        return 3;
+    }
+
+    auto printTop = [](const char* label, const TopK& top) {
+        cout << "  " << left << setw(15) << label << right;
+        for (const RankedZip& z : top.sorted())
+            cout << " " << setfill('0') << setw(5) << z.zipCode << setfill(' ') << " ("
+                 << z.coord << ")";
+        cout << "\n";
+    };
+    auto printQuantiles = [&](const char* label, const KllSketch& sketch) {
+        cout << "  " << left << setw(15) << label << right;
+        for (double q : quantiles)
+            cout << " p" << q * 100 << "=" << sketch.quantile(q);
+        cout << "\n";
+    };
+
+    cout << setprecision(10);
+    size_t shown = 0;
+    for (const auto& entry : summaries.states()) {
+        if (!state.empty() && entry.first != state) continue;
+        const StateSummary& s = entry.second;
+        cout << entry.first << ": " << s.records << " ZIPs\n";
+        printTop("Northernmost", s.maxLatitude);
+        printTop("Southernmost", s.minLatitude);
+        printTop("Min longitude", s.minLongitude);
+        printTop("Max longitude", s.maxLongitude);
+        if (!quantiles.empty()) {
+            printQuantiles("Latitude", s.latitude);
+            printQuantiles("Longitude", s.longitude);
+        }
+        shown++;
+    }
+    if (shown == 0) {
+        cerr << "Error: no records for state " << state << "\n";
+        return 3;
+    }
+    cout << "\n" << summaries.states().size() << " states summarized in " << fixed
+         << setprecision(1) << ms << " ms\n";
+    return 0;
+}
+
+/* ============================================================================
+ *  MODE 21: COLUMN PROFILE
+ * ============================================================================
+ */
+
+/**
+ * @brief Profile one input: a CSV file, a pair, or a saved profile.
+ * @param file CSV file, data file (.len), or saved profile
+ * @param idxFile Index file of the pair ("" otherwise)
+ * @param profile Receives the profile
+ * @return false (after a message) on error
+ */
+static bool profileInput(const string& file, const string& idxFile, DataProfile& profile) {
+    if (!idxFile.empty()) {
+        ZipDataStore store;
+        if (!store.open(file, idxFile, false)) {
+            cerr << "Error: " << store.lastError() << "\n";
+            return false;
+        }
+        // A header that could not be parsed still has the usual fields.
+        const vector<string>& names = store.header().fieldNames;
+        profile.setColumns(!names.empty() ? names
+                                          : vector<string>{"ZipCode", "PlaceName", "State",
+                                                           "County", "Latitude", "Longitude"});
+        return forEachLiveRecord(store, [&](long long, const vector<string>& f) {
+            profile.addRow(f);
+        });
+    }
+
+    ifstream in(file, ios::binary);
+    if (!in) {
+        cerr << "Error: Could not open '" << file << "'\n";
+        return false;
+    }
+    string line;
+    if (!getline(in, line)) {
+        cerr << "Error: '" << file << "' is empty\n";
+        return false;
+    }
+    if (DataProfile::looksSerialized(line)) {
+        in.seekg(0);
+        string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        if (!profile.deserialize(data)) {
+            cerr << "Error: '" << file << "' is not a valid saved profile\n";
+            return false;
+        }
+        return true;
+    }
+    profile.setColumns(splitCsvSimple(line));
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) profile.addRow(splitCsvSimple(line));
+    }
+    return true;
+}
+
+/**
+ * @brief Print the merged column profile of some inputs.
+ * @param inputs (file, index file or "") per input
+ * @param saveFile Where to save the merged profile ("" to skip)
+ * @return exit code
+ */
+static int profileInputs(const vector<pair<string, string>>& inputs, const string& saveFile) {
+    auto t0 = chrono::steady_clock::now();
+    DataProfile total;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        DataProfile one;
+        if (!profileInput(inputs[i].first, inputs[i].second, one)) return 2;
+        if (i == 0) {
+            total = one;
+        } else if (!total.merge(one)) {
+            cerr << "Error: '" << inputs[i].first
+                 << "' does not have as many columns as the first input\n";
+            return 3;
+        }
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    if (!saveFile.empty()) {
+        string data;
+        total.serialize(data);
+        string tmp = tempPathFor(saveFile);
+        bool ok;
+        {
+            ofstream out(tmp, ios::binary);
+            ok = static_cast<bool>(out.write(data.data(), static_cast<streamsize>(data.size())));
+        }
+        if (!ok || !publishFile(tmp, saveFile)) {
+            discardTemp(tmp);
+            cerr << "Error: could not write " << saveFile << "\n";
+            return 4;
+        }
+    }
+
+    auto clip = [](const string& s) { return s.size() <= 18 ? s : s.substr(0, 15) + "..."; };
+    cout << "Profile of " << total.rows() << " rows from " << inputs.size() << " input(s), "
+         << total.sizeBytes() / 1024 << " KB held, " << fixed << setprecision(1) << ms
+         << " ms\n\n";
+    cout << left << setw(14) << "Column" << right << setw(10) << "Nulls" << setw(9)
+         << "Null %" << setw(11) << "Distinct" << "   " << left << setw(20) << "Min" << "Max\n";
+    cout << string(86, '-') << "\n";
+    for (const ColumnProfile& c : total.columns()) {
+        const uint64_t rows = c.values + c.nulls;
+        cout << left << setw(14) << clip(c.name) << right << setw(10) << c.nulls << setw(9)
+             << setprecision(2) << (rows ? 100.0 * c.nulls / rows : 0.0) << setw(11)
+             << llround(c.distinct.estimate()) << "   " << left;
+        if (c.numeric()) {
+            cout << setprecision(10) << defaultfloat << setw(20) << c.minNumber << c.maxNumber
+                 << fixed;
+        } else {
+            cout << setw(20) << clip(c.minText) << clip(c.maxText);
+        }
+        cout << right << "\n";
+    }
+    cout << "\nDistinct counts are HyperLogLog estimates (about " << setprecision(1)
+         << 104.0 / sqrt(static_cast<double>(1u << HyperLogLog::kDefaultPrecision))
+         << "% error).\n";
+    if (!saveFile.empty()) cout << "Saved: " << saveFile << "\n";
+    return 0;
+}
+
+/* ============================================================================
+ *  MODE 22: PREFIX-COMPRESSED (DELTA) FILE
+ * ============================================================================
+ */
+
+/**
+ * @brief Encode a CSV as a .dlen file plus its restart point index.
+ * @param csvFile Input CSV
+ * @param deltaFile Output .dlen file
+ * @param restartInterval Records per restart interval
+ * @param policy What to do with the rows of a duplicated ZIP
+ * @return exit code
+ */
+static int makeDeltaFile(const string& csvFile, const string& deltaFile,
+                         unsigned restartInterval, DuplicatePolicy policy) {
+    DeltaFile::BuildStats stats;
+    string error;
+    if (!DeltaFile::build(csvFile, deltaFile, restartInterval, stats, error, policy)) {
+        cerr << "Error: " << error << "\n";
+        return stats.duplicateKeys > 0 ? 7 : 2;
+    }
+    if (!stats.duplicates.empty()) cerr << "Warning: " << stats.duplicates << "\n";
+    // What --make-len would write: length, space, text and newline.
+    const uint64_t lenBytes = stats.textBytes + 12 * stats.records;
+    cout << "Created delta file: " << deltaFile << " (index "
+         << DeltaFile::indexPathFor(deltaFile) << ")\n";
+    cout << "Records: " << stats.records << ", restart every " << restartInterval << "\n";
+    if (stats.sparseIndex)
+        cout << "Index: " << stats.indexEntries << " restart points (ZIPs in order)\n";
+    else
+        cout << "Index: " << stats.indexEntries << " entries, one per record (ZIPs not in order)\n";
+    if (stats.dropped > 0)
+        cout << "Duplicate rows dropped (" << duplicatePolicyName(policy) << "): " << stats.dropped
+             << "\n";
+    cout << fixed << setprecision(1) << "Size: " << stats.fileBytes << " bytes, "
+         << (lenBytes ? 100.0 * stats.fileBytes / lenBytes : 0.0) << "% of the "
+         << lenBytes << " bytes of the same records in a .len file\n";
+    return 0;
+}
+
+/**
+ * @brief Open a .dlen file and, for lookups, its index.
+ * @return false (after a message) on error
+ */
+static bool openDeltaFile(const string& deltaFile, bool withIndex, DeltaFile& file) {
+    if (!file.open(deltaFile) || (withIndex && !file.loadIndex())) {
+        cerr << "Error: " << file.lastError() << "\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Look ZIPs up in a .dlen file; each decodes at most one restart
+ *        interval.
+ * @param deltaFile The .dlen file
+ * @param zips ZIPs to find
+ * @return exit code
+ */
+static int searchDeltaFile(const string& deltaFile, const vector<string>& zips) {
+    DeltaFile file;
+    if (!openDeltaFile(deltaFile, true, file)) return 2;
+
+    for (const string& zip : zips) {
+        string record;
+        unsigned decoded = 0;
+        if (file.find(zip, record, decoded)) {
+            printLabeledOneLine(record);
+            cout << "  (decoded " << decoded << " of " << file.restartInterval()
+                 << " records in its restart interval)\n";
+        } else if (!file.lastError().empty()) {
+            cerr << "Error: " << file.lastError() << "\n";
+            return 3;
+        } else {
+            cout << "ZIP " << zip << " not found in file\n";
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Decode a whole .dlen file and report the rate, or print every
+ *        record (then the numbers go to stderr).
+ * @param deltaFile The .dlen file
+ * @param print true to write the records to stdout, one per line
+ * @return exit code
+ */
+static int scanDeltaFile(const string& deltaFile, bool print) {
+    DeltaFile file;
+    if (!openDeltaFile(deltaFile, false, file)) return 2;
+
+    uint64_t records = 0, bytes = 0;
+    auto start = chrono::steady_clock::now();
+    bool ok = file.scan([&](const char* text, size_t length) {
+        records++;
+        bytes += length;
+        if (print) {
+            cout.write(text, static_cast<streamsize>(length));
+            cout.put('\n');
+        }
+    });
+    const double seconds =
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (!ok) {
+        cerr << "Error: " << file.lastError() << "\n";
+        return 3;
+    }
+
+    ostream& report = print ? cerr : cout;
+    report << "Records decoded: " << records << " (" << bytes << " bytes of text from "
+           << file.fileBytes() << " in the file)\n";
+    report << fixed << setprecision(3) << "Time: " << seconds * 1000 << " ms, "
+           << setprecision(1) << (seconds > 0 ? bytes / seconds / 1e6 : 0.0) << " MB/s\n";
+    return 0;
+}
+
+/* ============================================================================
+ *  MODE 23: DICTIONARY-ENCODED FILE
+ * ============================================================================
+ */
+
+/**
+ * @brief Encode a CSV as a .dict file plus its index.
+ * @param csvFile Input CSV
+ * @param dictFile Output .dict file
+ * @param policy What to do with the rows of a duplicated ZIP
+ * @return exit code
+ */
+static int makeDictFile(const string& csvFile, const string& dictFile, DuplicatePolicy policy) {
+    DictFile::BuildStats stats;
+    string error;
+    if (!DictFile::build(csvFile, dictFile, stats, error, policy)) {
+        cerr << "Error: " << error << "\n";
+        return stats.duplicateKeys > 0 ? 7 : 2;
+    }
+    if (!stats.duplicates.empty()) cerr << "Warning: " << stats.duplicates << "\n";
+    // What --make-len would write: length, space, text and newline.
+    const uint64_t lenBytes = stats.textBytes + 12 * stats.records;
+    cout << "Created dictionary file: " << dictFile << " (index "
+         << DictFile::indexPathFor(dictFile) << ")\n";
+    for (const DictFile::DictionaryStats& d : stats.dictionaries)
+        cout << "Dictionary " << d.column << ": " << d.entries << " values, " << d.bytes
+             << " bytes\n";
+    cout << fixed << setprecision(1) << "Records: " << stats.records << ", "
+         << stats.recordBytes << " bytes ("
+         << (stats.records ? double(stats.recordBytes) / stats.records : 0.0)
+         << " per record)\n";
+    if (stats.dropped > 0)
+        cout << "Duplicate rows dropped (" << duplicatePolicyName(policy) << "): " << stats.dropped
+             << "\n";
+    cout << "Size: " << stats.fileBytes << " bytes, "
+         << (lenBytes ? 100.0 * stats.fileBytes / lenBytes : 0.0) << "% of the " << lenBytes
+         << " bytes of the same records in a .len file\n";
+    return 0;
+}
+
+/**
+ * @brief Open a .dict file and, for lookups, its index.
+ * @return false (after a message) on error
+ */
+static bool openDictFile(const string& dictFile, bool withIndex, DictFile& file) {
+    if (!file.open(dictFile) || (withIndex && !file.loadIndex())) {
+        cerr << "Error: " << file.lastError() << "\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Look ZIPs up in a .dict file.
+ * @param dictFile The .dict file
+ * @param zips ZIPs to find
+ * @return exit code
+ */
+static int searchDictFile(const string& dictFile, const vector<string>& zips) {
+    DictFile file;
+    if (!openDictFile(dictFile, true, file)) return 2;
+
+    DictRecord record;
+    for (const string& zip : zips) {
+        if (file.find(zip, record)) {
+            printLabeledOneLine(record.text());
+        } else if (!file.lastError().empty()) {
+            cerr << "Error: " << file.lastError() << "\n";
+            return 3;
+        } else {
+            cout << "ZIP " << zip << " not found in file\n";
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Decode a whole .dict file and report the rate, or print every
+ *        record (then the numbers go to stderr).
+ * @param dictFile The .dict file
+ * @param print true to write the records to stdout, one per line
+ * @return exit code
+ */
+static int scanDictFile(const string& dictFile, bool print) {
+    DictFile file;
+    if (!openDictFile(dictFile, false, file)) return 2;
+
+    uint64_t records = 0, bytes = 0;
+    auto start = chrono::steady_clock::now();
+    bool ok = file.scan([&](const DictRecord& r) {
+        records++;
+        for (size_t i = 0; i < r.fields; i++) {
+            bytes += r.field[i].size() + (i > 0);
+            if (print) {
+                if (i > 0) cout.put(',');
+                cout.write(r.field[i].data(), static_cast<streamsize>(r.field[i].size()));
+            }
+        }
+        if (print) cout.put('\n');
+    });
+    const double seconds =
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (!ok) {
+        cerr << "Error: " << file.lastError() << "\n";
+        return 3;
+    }
+
+    ostream& report = print ? cerr : cout;
+    report << "Records decoded: " << records << " (" << bytes << " bytes of text from "
+           << file.fileBytes() << " in the file)\n";
+    report << fixed << setprecision(3) << "Time: " << seconds * 1000 << " ms, "
+           << setprecision(1) << (seconds > 0 ? bytes / seconds / 1e6 : 0.0) << " MB/s\n";
+    return 0;
+}
+
+/* ============================================================================
+ *  USAGE MESSAGE
+ * ============================================================================
+ */
+
+/**
+ * @brief Print usage instructions (simple).
+ * @param prog program name
+ */
+static void printUsage(const string& prog) {
+    cerr << "USAGE:\n";
+    cerr << "  1) Analyze CSV (Project 1 style):\n";
+    cerr << "     " << prog << " <file.csv>\n\n";
+    cerr << "  2) Make LEN from CSV (optionally with record checksums):\n";
+    cerr << "     " << prog << " --make-len <in.csv> <out.len> [--checksum]\n";
+    cerr << "                [--dedup first|last|error]\n\n";
+    cerr << "  3) Build index from LEN (one entry per ZIP):\n";
+    cerr << "     " << prog << " --build-index <data.len> <out.idx> [--dedup first|last|error]\n\n";
+    cerr << "  4) Search ZIPs using LEN + IDX:\n";
+    cerr << "     " << prog << " --search <data.len> <data.idx> -Z56301 -Z99546 -Z99999\n\n";
+    cerr << "  5) Verify LEN header, checksums and index:\n";
+    cerr << "     " << prog << " --verify <data.len> <data.idx> [threads]\n\n";
+    cerr << "  6) Update one ZIP (WAL), fold WAL into index:\n";
+    cerr << "     " << prog << " --update <data.len> <data.idx> -Z56301 [--place P] [--state S]\n";
+    cerr << "        [--county C] [--lat X] [--long Y] [--no-sync]\n";
+    cerr << "     " << prog << " --checkpoint <data.len> <data.idx>\n\n";
+    cerr << "  7) Compact LEN file (drop dead records, rebuild index):\n";
+    cerr << "     " << prog << " --compact <data.len> <data.idx>\n\n";
+    cerr << "  8) Delete ZIPs (tombstones in the WAL):\n";
+    cerr << "     " << prog << " --delete <data.len> <data.idx> -Z56301 [-Z...]\n\n";
+    cerr << "  9) Sharded dataset (build, search, analyze):\n";
+    cerr << "     " << prog << " --make-shards <in.csv> <data.shards> <N> [--by zip|state] [--checksum]\n";
+    cerr << "                [--dedup first|last|error]\n";
+    cerr << "     " << prog << " --search <data.shards> -Z56301 -Z99546\n";
+    cerr << "     " << prog << " --analyze-shards <data.shards> [threads]\n\n";
+    cerr << "  10) TCP query server on 127.0.0.1, and a load generator for it:\n";
+    cerr << "     " << prog << " --serve <data.len> <data.idx> [port] [--watch] [--warm] [--mlock]\n";
+    cerr << "     " << prog << " --loadgen <port> <data.idx> [--connections N] [--seconds S]\n";
+    cerr << "        [--depth D] [--batch B] [--miss R]\n\n";
+    cerr << "  11) Publish shared index segment (use it as <data.idx> in 4 and 10):\n";
+    cerr << "     " << prog << " --publish-segment <data.len> <data.idx> <segment>\n";
+    cerr << "        [--eytzinger | --compressed]\n\n";
+    cerr << "  12) Warm the page cache (index + hot data blocks from --serve --warm):\n";
+    cerr << "     " << prog << " --warmup <data.len> <data.idx> [--mlock]\n";
+    cerr << "        (--mlock: segment only; checks the lock --serve --mlock holds)\n\n";
+    cerr << "  13) Benchmark index layouts (hash map, lower_bound, Eytzinger, learned,\n";
+    cerr << "      Elias-Fano, batch):\n";
+    cerr << "     " << prog << " --bench-index [keys ...]\n\n";
+    cerr << "  14) Complete a place name (top places and their ZIPs):\n";
+    cerr << "     " << prog << " --complete <data.len> <data.idx> <prefix> [--state S] [--top K]\n\n";
+    cerr << "  15) Records by state / county / place (inverted index; ANDed, or ORed with --any):\n";
+    cerr << "     " << prog << " --where <data.len> <data.idx> [--state S] [--county C ...]\n";
+    cerr << "        [--place P ...] [--any] [--count]\n\n";
+    cerr << "  16) Records within a radius (km) of a point (lat -90..90, long -180..180):\n";
+    cerr << "     " << prog << " --near <data.len> <data.idx> <lat> <long> <km> [--count]\n";
+    cerr << "     " << prog << " --nearest <data.len> <data.idx> <lat> <long> [k]\n\n";
+    cerr << "  17) Benchmark the SIMD distance kernels:\n";
+    cerr << "     " << prog << " --bench-geo [points]\n\n";
+    cerr << "  18) Convex hull and bounding box per state (GeoJSON, or WKT):\n";
+    cerr << "     " << prog << " --hulls <file.csv> [--wkt] [--threads N]\n";
+    cerr << "     " << prog << " --hulls <data.len> <data.idx> [--wkt] [--threads N]\n\n";
+    cerr << "  19) State extremes table of a pair (kept current by --update / --delete):\n";
+    cerr << "     " << prog << " --extremes <data.len> <data.idx>\n\n";
+    cerr << "  20) Top-k ZIPs per state and direction, and coordinate quantiles:\n";
+    cerr << "     " << prog << " --top <file.csv> [--k K] [--quantiles 0.1,0.5,0.9] [--state S]\n";
+    cerr << "     " << prog << " --top <data.len> <data.idx> [same options] [--threads N]\n\n";
+    cerr << "  21) Column profile (nulls, approximate distinct counts, min / max), merged\n";
+    cerr << "      over CSV files, <data.len> <data.idx> pairs and saved profiles:\n";
+    cerr << "     " << prog << " --profile <input> [<input> ...] [--save <out.profile>]\n\n";
+    cerr << "  22) Prefix-compressed copy of a (key-sorted) CSV, lookups and scans:\n";
+    cerr << "     " << prog << " --make-delta <in.csv> <out.dlen> [--restart N]\n";
+    cerr << "                [--dedup first|last|error]\n";
+    cerr << "     " << prog << " --search-delta <data.dlen> -Z56301 [-Z...]\n";
+    cerr << "     " << prog << " --scan-delta <data.dlen> [--print]\n\n";
+    cerr << "  23) Dictionary-encoded copy of a CSV (place / state / county ids):\n";
+    cerr << "     " << prog << " --make-dict <in.csv> <out.dict> [--dedup first|last|error]\n";
+    cerr << "     " << prog << " --search-dict <data.dict> -Z56301 [-Z...]\n";
+    cerr << "     " << prog << " --scan-dict <data.dict> [--print]\n";
+}
+
+/* ============================================================================
+ *  MAIN
+ * ============================================================================
+ */
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    string cmd = argv[1];
+
+    // MODE: --make-len in.csv out.len [--checksum] [--dedup first|last|error]
+    if (cmd == "--make-len") {
+        if (argc < 4) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        bool withChecksum = false;
+        DuplicatePolicy policy = DuplicatePolicy::kKeepAll;
+        for (int i = 4; i < argc; i++) {
+            string a = argv[i];
+            if (a == "--checksum") {
+                withChecksum = true;
+            } else if (a == "--dedup" && i + 1 < argc && parseDuplicatePolicy(argv[i + 1], policy)) {
+                i++;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        return makeLenFromCsv(argv[2], argv[3], withChecksum, policy);
+    }
+
+    // MODE: --build-index data.len out.idx [--dedup first|last|error]
+    if (cmd == "--build-index") {
+        DuplicatePolicy policy = DuplicatePolicy::kLastWins;
+        if (argc == 6 && string(argv[4]) == "--dedup" && parseDuplicatePolicy(argv[5], policy)) {
+            return buildIndexFromLen(argv[2], argv[3], policy);
+        }
+        if (argc != 4) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return buildIndexFromLen(argv[2], argv[3], policy);
+    }
+
+    // MODE: --verify data.len data.idx [threads]
+    if (cmd == "--verify") {
+        if (argc != 4 && argc != 5) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        unsigned threads = (argc == 5) ? static_cast<unsigned>(atoi(argv[4])) : 0;
+        return verifyLenFile(argv[2], argv[3], threads);
+    }
+
+    // MODE: --update data.len data.idx -Zxxxxx [--place P] ... [--no-sync]
+    if (cmd == "--update") {
+        if (argc < 6) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        string zip;
+        map<int, string> changes;
+        bool sync = true;
+        const map<string, int> fieldFlags = {
+            {"--place", 1}, {"--state", 2}, {"--county", 3},
+            {"--lat", 4}, {"--long", 5}};
+        for (int i = 4; i < argc; i++) {
+            string arg = argv[i];
+            if (arg.rfind("-Z", 0) == 0 && arg.size() > 2) {
+                zip = arg.substr(2);
+            } else if (arg == "--no-sync") {
+                sync = false;
+            } else if (fieldFlags.count(arg) && i + 1 < argc) {
+                const int field = fieldFlags.at(arg);
+                const string value = argv[++i];
+                double number;
+                if (field == 4 && !parseNumberIn(value.c_str(), -90, 90, number)) {
+                    cerr << "Error: --lat must be a number in -90..90.\n";
+                    return 1;
+                }
+                if (field == 5 && !parseNumberIn(value.c_str(), -180, 180, number)) {
+                    cerr << "Error: --long must be a number in -180..180.\n";
+                    return 1;
+                }
+                if (field < 4 && (value.empty() || value.find(',') != string::npos)) {
+                    cerr << "Error: " << arg << " must not be empty or contain a comma.\n";
+                    return 1;
+                }
+                changes[field] = value;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        if (zip.empty() || changes.empty()) {
+            cerr << "Error: need one -Z flag and at least one field to change.\n";
+            return 1;
+        }
+        return updateZip(argv[2], argv[3], zip, changes, sync);
+    }
+
+    // MODE: --checkpoint data.len data.idx
+    if (cmd == "--checkpoint") {
+        if (argc != 4) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return checkpointStore(argv[2], argv[3]);
+    }
+
+    // MODE: --delete data.len data.idx -Zxxxxx ...
+    if (cmd == "--delete") {
+        vector<string> zips;
+        for (int i = 4; i < argc; i++) {
+            string arg = argv[i];
+            if (arg.rfind("-Z", 0) == 0 && arg.size() > 2) zips.push_back(arg.substr(2));
+        }
+        if (argc < 5 || zips.empty()) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return deleteZips(argv[2], argv[3], zips);
+    }
+
+    // MODE: --compact data.len data.idx
+    if (cmd == "--compact") {
+        if (argc != 4) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return compactStore(argv[2], argv[3]);
+    }
+
+    // MODE: --make-shards in.csv out.shards N [--by zip|state] [--checksum]
+    //       [--dedup first|last|error]
+    if (cmd == "--make-shards") {
+        if (argc < 5) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        string scheme = "zip";
+        bool withChecksum = false;
+        DuplicatePolicy policy = DuplicatePolicy::kKeepAll;
+        for (int i = 5; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--by" && i + 1 < argc) {
+                scheme = argv[++i];
+            } else if (arg == "--checksum") {
+                withChecksum = true;
+            } else if (arg == "--dedup" && i + 1 < argc && parseDuplicatePolicy(argv[i + 1], policy)) {
+                i++;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        return makeShardSet(argv[2], argv[3], atoi(argv[4]), scheme, withChecksum, policy);
+    }
+
+    // MODE: --analyze-shards data.shards [threads]
+    if (cmd == "--analyze-shards") {
+        if (argc != 3 && argc != 4) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        unsigned threads = (argc == 4) ? static_cast<unsigned>(atoi(argv[3])) : 0;
+        return analyzeShardSet(argv[2], threads);
+    }
+
+    // MODE: --publish-segment data.len data.idx segment [--eytzinger|--compressed]
+    if (cmd == "--publish-segment") {
+        IndexSegment::Layout layout = IndexSegment::kSorted;
+        if (argc == 6 && string(argv[5]) == "--eytzinger") layout = IndexSegment::kEytzinger;
+        else if (argc == 6 && string(argv[5]) == "--compressed") layout = IndexSegment::kCompressed;
+        else if (argc != 5) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return publishSegment(argv[2], argv[3], argv[4], layout);
+    }
+
+    // MODE: --bench-index [keys ...]
+    if (cmd == "--bench-index") {
+        vector<size_t> sizes;
+        for (int i = 2; i < argc; i++) {
+            long long n = atoll(argv[i]);
+            if (n <= 0) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            sizes.push_back(static_cast<size_t>(n));
+        }
+        if (sizes.empty()) sizes = {41000, 1000000, 100000000};
+        return benchIndex(sizes);
+    }
+
+    // MODE: --complete data.len data.idx prefix [--state S] [--top K]
+    if (cmd == "--complete") {
+        if (argc < 5 || argc % 2 == 0) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        string state;
+        long long top = 10;
+        for (int i = 5; i + 1 < argc; i += 2) {
+            string arg = argv[i];
+            if (arg == "--state") state = argv[i + 1];
+            else if (arg == "--top") top = atoll(argv[i + 1]);
+            else top = 0;
+        }
+        if (top <= 0) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return completePlace(argv[2], argv[3], argv[4], state, static_cast<size_t>(top));
+    }
+
+    // MODE: --where data.len data.idx [--state S] [--county C] [--place P] [--any] [--count]
+    if (cmd == "--where") {
+        if (argc < 6) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        string state;
+        vector<string> counties, places;
+        bool any = false, countOnly = false;
+        for (int i = 4; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--any") any = true;
+            else if (arg == "--count") countOnly = true;
+            else if (i + 1 < argc && arg == "--state") state = argv[++i];
+            else if (i + 1 < argc && arg == "--county") counties.push_back(argv[++i]);
+            else if (i + 1 < argc && arg == "--place") places.push_back(argv[++i]);
+            else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        if ((!counties.empty() && state.empty()) || (state.empty() && places.empty())) {
+            cerr << "Error: give --state (needed with --county) and/or --place\n";
+            return 1;
+        }
+        return whereQuery(argv[2], argv[3], state, counties, places, any, countOnly);
+    }
+
+    // MODE: --near data.len data.idx lat long km [--count]
+    if (cmd == "--near") {
+        bool countOnly = (argc == 8 && string(argv[7]) == "--count");
+        double lat = 0, lon = 0, km = 0;
+        if ((argc != 7 && !countOnly) || !parseNumberIn(argv[4], -90, 90, lat) ||
+            !parseNumberIn(argv[5], -180, 180, lon) ||
+            !parseNumberIn(argv[6], 0, numeric_limits<double>::max(), km)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return nearQuery(argv[2], argv[3], lat, lon, km, 0, countOnly);
+    }
+
+    // MODE: --nearest data.len data.idx lat long [k]
+    if (cmd == "--nearest") {
+        long long k = (argc == 7) ? atoll(argv[6]) : 10;
+        double lat = 0, lon = 0;
+        if ((argc != 6 && argc != 7) || k <= 0 || !parseNumberIn(argv[4], -90, 90, lat) ||
+            !parseNumberIn(argv[5], -180, 180, lon)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return nearQuery(argv[2], argv[3], lat, lon, 0, static_cast<size_t>(k), false);
+    }
+
+    // MODE: --bench-geo [points]
+    if (cmd == "--bench-geo") {
+        long long points = (argc == 3) ? atoll(argv[2]) : 1000000;
+        if (argc > 3 || points <= 0) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return benchGeo(static_cast<size_t>(points));
+    }
+
+    // MODE: --hulls file.csv | data.len data.idx [--wkt] [--threads N]
+    if (cmd == "--hulls") {
+        if (argc < 3) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        int i = 3;
+        string idxFile;
+        if (argc > 3 && string(argv[3]).rfind("--", 0) != 0) idxFile = argv[i++];
+        bool wkt = false;
+        long long threads = 0;
+        for (; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--wkt") wkt = true;
+            else if (arg == "--threads" && i + 1 < argc) threads = atoll(argv[++i]);
+            else threads = -1;
+        }
+        if (threads < 0) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return stateHulls(argv[2], idxFile, wkt, static_cast<unsigned>(threads));
+    }
+
+    // MODE: --extremes data.len data.idx
+    if (cmd == "--extremes") {
+        if (argc != 4) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return pairExtremes(argv[2], argv[3]);
+    }
+
+    // MODE: --top file.csv | data.len data.idx [--k K] [--quantiles q,...] [--state S]
+    //       [--threads N]
+    if (cmd == "--top") {
+        if (argc < 3) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        int i = 3;
+        string idxFile;
+        if (argc > 3 && string(argv[3]).rfind("--", 0) != 0) idxFile = argv[i++];
+        long long k = 10, threads = 0;
+        string state;
+        vector<double> quantiles = {0.1, 0.25, 0.5, 0.75, 0.9};
+        bool ok = true;
+        for (; i < argc && ok; i++) {
+            string arg = argv[i];
+            if (i + 1 >= argc) ok = false;
+            else if (arg == "--k") k = atoll(argv[++i]);
+            else if (arg == "--threads") threads = atoll(argv[++i]);
+            else if (arg == "--state") state = argv[++i];
+            else if (arg == "--quantiles") {
+                quantiles.clear();
+                stringstream list(argv[++i]);
+                string item;
+                while (getline(list, item, ',')) {
+                    double q = atof(item.c_str());
+                    if (item.empty() || q < 0 || q > 1) ok = false;
+                    quantiles.push_back(q);
+                }
+            } else ok = false;
+        }
+        if (!ok || k <= 0 || threads < 0) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return topPerState(argv[2], idxFile, static_cast<size_t>(k), quantiles, state,
+                           static_cast<unsigned>(threads));
+    }
+
+    // MODE: --profile input ... [--save out.profile]
+    if (cmd == "--profile") {
+        vector<pair<string, string>> inputs;
+        string saveFile;
+        for (int i = 2; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--save" && i + 1 < argc) {
+                saveFile = argv[++i];
+            } else if (arg.size() > 4 && arg.compare(arg.size() - 4, 4, ".len") == 0 &&
+                       i + 1 < argc) {
+                inputs.emplace_back(arg, argv[++i]);
+            } else {
+                inputs.emplace_back(arg, "");
+            }
+        }
+        if (inputs.empty()) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return profileInputs(inputs, saveFile);
+    }
+
+    // MODE: --make-delta in.csv out.dlen [--restart N] [--dedup first|last|error]
+    if (cmd == "--make-delta") {
+        if (argc < 4) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        unsigned restart = DeltaFile::kDefaultRestartInterval;
+        DuplicatePolicy policy = DuplicatePolicy::kKeepAll;
+        for (int i = 4; i < argc; i++) {
+            string a = argv[i];
+            if (a == "--restart" && i + 1 < argc) {
+                restart = static_cast<unsigned>(atoi(argv[++i]));
+            } else if (a == "--dedup" && i + 1 < argc && parseDuplicatePolicy(argv[i + 1], policy)) {
+                i++;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        return makeDeltaFile(argv[2], argv[3], restart, policy);
+    }
+
+    // MODE: --search-delta data.dlen -Z...
+    if (cmd == "--search-delta") {
+        vector<string> zips;
+        for (int i = 3; i < argc; i++) {
+            string arg = argv[i];
+            if (arg.rfind("-Z", 0) == 0 && arg.size() > 2) zips.push_back(arg.substr(2));
+        }
+        if (argc < 4 || zips.empty()) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return searchDeltaFile(argv[2], zips);
+    }
+
+    // MODE: --scan-delta data.dlen [--print]
+    if (cmd == "--scan-delta") {
+        bool print = (argc == 4 && string(argv[3]) == "--print");
+        if (argc != 3 && !print) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return scanDeltaFile(argv[2], print);
+    }
+
+    // MODE: --make-dict in.csv out.dict [--dedup first|last|error]
+    if (cmd == "--make-dict") {
+        DuplicatePolicy policy = DuplicatePolicy::kKeepAll;
+        if (argc == 6 && string(argv[4]) == "--dedup" && parseDuplicatePolicy(argv[5], policy)) {
+            return makeDictFile(argv[2], argv[3], policy);
+        }
+        if (argc != 4) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return makeDictFile(argv[2], argv[3], policy);
+    }
+
+    // MODE: --search-dict data.dict -Z...
+    if (cmd == "--search-dict") {
+        vector<string> zips;
+        for (int i = 3; i < argc; i++) {
+            string arg = argv[i];
+            if (arg.rfind("-Z", 0) == 0 && arg.size() > 2) zips.push_back(arg.substr(2));
+        }
+        if (argc < 4 || zips.empty()) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return searchDictFile(argv[2], zips);
+    }
+
+    // MODE: --scan-dict data.dict [--print]
+    if (cmd == "--scan-dict") {
+        bool print = (argc == 4 && string(argv[3]) == "--print");
+        if (argc != 3 && !print) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return scanDictFile(argv[2], print);
+    }
+
+    // MODE: --warmup data.len data.idx [--mlock]
+    if (cmd == "--warmup") {
+        if (argc < 4 || argc > 5 || (argc == 5 && string(argv[4]) != "--mlock")) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return warmupPair(argv[2], argv[3], argc == 5);
+    }
+
+    // MODE: --serve data.len data.idx [port] [--watch] [--warm] [--mlock]
+    if (cmd == "--serve") {
+        if (argc < 4 || argc > 8) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        int port = 7301;
+        bool watch = false;
+        bool warm = false;
+        bool lockIndex = false;
+        for (int i = 4; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--watch") {
+                watch = true;
+            } else if (arg == "--warm") {
+                warm = true;
+            } else if (arg == "--mlock") {
+                lockIndex = true;
+            } else {
+                port = atoi(argv[i]);
+                if (port <= 0 || port > 65535) {
+                    cerr << "Error: bad port " << arg << "\n";
+                    return 1;
+                }
+            }
+        }
+        return serveZips(argv[2], argv[3], static_cast<uint16_t>(port), watch, warm, lockIndex);
+    }
+
+    // MODE: --loadgen port data.idx [--connections N] [--seconds S] ...
+    if (cmd == "--loadgen") {
+        if (argc < 4) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        LoadGenOptions options;
+        options.port = static_cast<uint16_t>(atoi(argv[2]));
+        options.idxFile = argv[3];
+        for (int i = 4; i + 1 < argc; i += 2) {
+            string arg = argv[i];
+            if (arg == "--connections") options.connections = static_cast<unsigned>(atoi(argv[i + 1]));
+            else if (arg == "--seconds") options.seconds = atof(argv[i + 1]);
+            else if (arg == "--depth") options.depth = static_cast<unsigned>(atoi(argv[i + 1]));
+            else if (arg == "--batch") options.batch = static_cast<unsigned>(atoi(argv[i + 1]));
+            else if (arg == "--miss") options.missRatio = atof(argv[i + 1]);
+            else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        if ((argc - 4) % 2 != 0) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        return loadGenerator(options);
+    }
+
+    // MODE: --search data.shards -Zxxxxx ... (shard manifest instead of a pair)
+    if (cmd == "--search" && argc >= 4 && string(argv[3]).rfind("-Z", 0) == 0) {
+        vector<string> zips;
+        for (int i = 3; i < argc; i++) {
+            string arg = argv[i];
+            if (arg.rfind("-Z", 0) == 0 && arg.size() > 2) zips.push_back(arg.substr(2));
         }
-        return buildIndexFromLen(argv[2], argv[3]);
+        return searchShards(argv[2], zips);
     }
 
     // MODE: --search data.len data.idx -Zxxxxx ...
@@ -0,0 +1,55 @@
+#!/bin/sh
+# Regression check for --compact with updates and deletes while it runs.
+# Usage: ./test_compact.sh [path/to/zip2]   (run from Project2)
+#
+# Builds a pair large enough that the copy takes a while, changes records
+# once the compaction has taken its snapshot, and checks that --verify accepts
+# the result (the copies replaced during catch-up are counted as dead).
+
+ZIP2=${1:-./zip2}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+awk 'BEGIN { print "ZipCode,PlaceName,State,County,Lat,Long";
+             for (i = 1; i <= 1000000; i++)
+                 printf "%d,Place%d,MN,County%d,45.5,-94.1\n", i, i % 997, i % 89 }' \
+    > "$WORK/big.csv"
+"$ZIP2" --make-len "$WORK/big.csv" "$WORK/z.len" > /dev/null || exit 1
+"$ZIP2" --build-index "$WORK/z.len" "$WORK/z.idx" > /dev/null || exit 1
+
+"$ZIP2" --compact "$WORK/z.len" "$WORK/z.idx" > "$WORK/compact.out" 2>&1 &
+pid=$!
+tries=0
+# The copy goes to <data>.tmp.<pid>, created after the snapshot is taken.
+until [ -e "$WORK/z.len.tmp.$pid" ]; do
+    if ! kill -0 "$pid" 2> /dev/null || [ "$tries" -ge 300 ]; then
+        echo "FAIL: compaction finished before it could be updated"
+        exit 1
+    fi
+    sleep 0.05
+    tries=$((tries + 1))
+done
+"$ZIP2" --update "$WORK/z.len" "$WORK/z.idx" -Z56301 --lat 45.6 > /dev/null || exit 1
+"$ZIP2" --delete "$WORK/z.len" "$WORK/z.idx" -Z99546 > /dev/null || exit 1
+wait "$pid" || { echo "FAIL: --compact"; cat "$WORK/compact.out"; exit 1; }
+
+failures=0
+if ! grep -q "(1 updated during compaction)" "$WORK/compact.out"; then
+    echo "FAIL: the update was not caught up"; cat "$WORK/compact.out"
+    failures=$((failures + 1))
+fi
+out=$("$ZIP2" --verify "$WORK/z.len" "$WORK/z.idx" 2>&1)
+if [ $? -ne 0 ] || ! printf '%s\n' "$out" | grep -qF "OK: no problems found"; then
+    echo "FAIL: --verify after an update during compaction"
+    printf '%s\n' "$out" | sed 's/^/    /'
+    failures=$((failures + 1))
+fi
+out=$("$ZIP2" --search "$WORK/z.len" "$WORK/z.idx" -Z56301 -Z99546 2>&1)
+if ! printf '%s\n' "$out" | grep -qF "Lat=45.6" ||
+   ! printf '%s\n' "$out" | grep -qF "ZIP 99546 not found in file"; then
+    echo "FAIL: --search after compaction"
+    printf '%s\n' "$out" | sed 's/^/    /'
+    failures=$((failures + 1))
+fi
+
+[ "$failures" -eq 0 ] && echo "All compaction checks passed." || exit 1
@@ -0,0 +1,64 @@
+#!/bin/sh
+# Regression checks for --verify and --search on damaged and old files.
+# Usage: ./test_verify.sh [path/to/zip2]   (run from Project2)
+#
+# Builds a small pair from the first rows of us_postal_codes.csv, damages
+# a copy of it and checks what --verify and --search report.
+
+ZIP2=${1:-./zip2}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+failures=0
+
+check() {   # check <description> <expected exit> <expected text> <command...>
+    desc=$1; want=$2; text=$3; shift 3
+    out=$("$@" 2>&1); got=$?
+    if [ "$got" -ne "$want" ] || ! printf '%s\n' "$out" | grep -qF -e "$text"; then
+        echo "FAIL: $desc (exit $got, expected $want and \"$text\")"
+        printf '%s\n' "$out" | sed 's/^/    /'
+        failures=$((failures + 1))
+    else
+        echo "ok:   $desc"
+    fi
+}
+
+head -200 us_postal_codes.csv > "$WORK/s.csv"
+"$ZIP2" --make-len "$WORK/s.csv" "$WORK/z.len" > /dev/null || exit 1
+"$ZIP2" --build-index "$WORK/z.len" "$WORK/z.idx" > /dev/null || exit 1
+check "clean pair verifies" 0 "OK: no problems found" \
+    "$ZIP2" --verify "$WORK/z.len" "$WORK/z.idx"
+
+# The committed pair has a version 1 header ("Name:type" fields).
+check "committed pair with an old header searches" 0 "ZIP=56301" \
+    "$ZIP2" --search zipcode_data.len zipcode_index.idx -Z56301
+
+# A header number field that is not a number.
+sed '1s/^\(.\{11\}HDR,ZipLenFile,\)[0-9]*/\1x/' "$WORK/z.len" > "$WORK/hdr.len"
+check "corrupted header is reported" 6 "header record cannot be parsed" \
+    "$ZIP2" --verify "$WORK/hdr.len" "$WORK/z.idx"
+check "corrupted header stops --search" 2 "header missing or corrupted" \
+    "$ZIP2" --search "$WORK/hdr.len" "$WORK/z.idx" -Z501
+
+# Dead-record counts in the index header that are not numbers.
+sed '1s/^\(IDX,2,[0-9a-f]*\).*/\1,x,y,z/' "$WORK/z.idx" > "$WORK/hdr.idx"
+check "damaged index header stops --search" 2 "Index header of" \
+    "$ZIP2" --search "$WORK/z.len" "$WORK/hdr.idx" -Z501
+check "damaged index header is reported" 6 "Index header of" \
+    "$ZIP2" --verify "$WORK/z.len" "$WORK/hdr.idx"
+
+# The length field of the first record (right after the header line).
+hdrEnd=$(head -1 "$WORK/z.len" | wc -c)
+cp "$WORK/z.len" "$WORK/rec.len"
+printf 'xxxxxxxxxx' | dd of="$WORK/rec.len" bs=1 seek="$hdrEnd" conv=notrunc 2> /dev/null
+check "damaged first record is not in the header" 6 \
+    "offset $hdrEnd points into damaged bytes" \
+    "$ZIP2" --verify "$WORK/rec.len" "$WORK/z.idx"
+
+# A latitude that is not a number: --update refuses it, --verify finds it.
+check "--update rejects a non-numeric --lat" 1 "--lat must be a number" \
+    "$ZIP2" --update "$WORK/z.len" "$WORK/z.idx" -Z501 --lat abc
+sed 's/40\.8154/4x.8154/' "$WORK/z.len" > "$WORK/lat.len"
+check "non-numeric latitude is reported" 6 "latitude field is not a number" \
+    "$ZIP2" --verify "$WORK/lat.len" "$WORK/z.idx"
+
+[ "$failures" -eq 0 ] && echo "All verify checks passed." || exit 1